@@ -0,0 +1,179 @@
+// Compares the frustum queries of CBVH with a linear scan of the same bounds, and measures what keeping the tree up to
+// date costs per frame. Built by build.bat as bvh_benchmark.exe, optional arguments: number of objects and of views.
+
+#include <renderer/core/bvh.hpp>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+namespace
+{
+    // Objects spread over a square of this side, one or two units big, as in a level.
+    constexpr float WORLD_SIZE = 1000.0f;
+    constexpr float FOV_Y = 1.0f;
+    constexpr float NEAR_PLANE = 0.1f;
+    // Share of the objects moving every frame, and how far.
+    constexpr float MOVING_SHARE = 0.1f;
+    constexpr float MOVE_DISTANCE = 0.05f;
+
+    double GetTimeMs()
+    {
+        using namespace std::chrono;
+        return duration<double, std::milli>(steady_clock::now().time_since_epoch()).count();
+    }
+
+    // Same projection as CCamera::GetProjection(): reversed-Z with an infinite far plane.
+    glm::mat4 GetProjection(float aAspectRatio)
+    {
+        const float Focal = 1.0f / std::tan(FOV_Y * 0.5f);
+
+        glm::mat4 Projection(0.0f);
+        Projection[0][0] = Focal / aAspectRatio;
+        Projection[1][1] = Focal;
+        Projection[2][3] = -1.0f;
+        Projection[3][2] = NEAR_PLANE;
+        return Projection;
+    }
+
+    // Same test as the BVH nodes, without the SIMD.
+    bool IsOutside(const sAABB& aBounds, const sFrustum& aFrustum)
+    {
+        const glm::vec3 Center = aBounds.GetCenter();
+        const glm::vec3 Extents = aBounds.GetExtents();
+        for (uint32 i = 0; i < sFrustum::NUM_PLANES; ++i)
+        {
+            const glm::vec3 Normal(aFrustum.NormalX[i], aFrustum.NormalY[i], aFrustum.NormalZ[i]);
+            const float Distance = aFrustum.Distance[i] + glm::dot(Normal, Center);
+            const float Radius = glm::dot(glm::abs(Normal), Extents);
+            if (Distance + Radius < 0.0f)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    sAABB MakeBounds(std::mt19937& aRandom)
+    {
+        std::uniform_real_distribution<float> Position(-WORLD_SIZE * 0.5f, WORLD_SIZE * 0.5f);
+        std::uniform_real_distribution<float> Height(0.0f, 20.0f);
+        std::uniform_real_distribution<float> Size(0.5f, 1.0f);
+
+        const glm::vec3 Center(Position(aRandom), Height(aRandom), Position(aRandom));
+        const glm::vec3 Extents(Size(aRandom), Size(aRandom), Size(aRandom));
+        return sAABB(Center - Extents, Center + Extents);
+    }
+
+    void RunBenchmark(uint32 aNumObjects, uint32 aNumViews)
+    {
+        std::mt19937 Random(1234);
+
+        std::vector<CBVH::sBuildItem> Items(aNumObjects);
+        for (uint32 i = 0; i < aNumObjects; ++i)
+        {
+            Items[i].Bounds = MakeBounds(Random);
+            Items[i].Entity.Index = i;
+        }
+
+        CBVH BVH;
+        std::vector<uint32> Proxies;
+        double StartMs = GetTimeMs();
+        BVH.Build(Items, Proxies);
+        const double BuildMs = GetTimeMs() - StartMs;
+
+        // The linear scan tests the enlarged bounds stored in the leaves, so both report the same objects.
+        std::vector<sAABB> LeafBounds(aNumObjects);
+        for (uint32 i = 0; i < aNumObjects; ++i)
+        {
+            LeafBounds[i] = BVH.GetBounds(Proxies[i]);
+        }
+
+        // A camera turning around the center of the world, looking slightly down.
+        std::vector<sFrustum> Frustums(aNumViews);
+        const glm::mat4 Projection = GetProjection(16.0f / 9.0f);
+        for (uint32 i = 0; i < aNumViews; ++i)
+        {
+            const float Angle = 6.2831853f * static_cast<float>(i) / static_cast<float>(aNumViews);
+            const glm::vec3 Eye(0.0f, 10.0f, 0.0f);
+            const glm::vec3 Target = Eye + glm::vec3(std::cos(Angle), -0.2f, std::sin(Angle));
+            Frustums[i] = sFrustum::FromViewProj(Projection * glm::lookAt(Eye, Target, glm::vec3(0.0f, 1.0f, 0.0f)));
+        }
+
+        uint64_t LinearVisible = 0;
+        StartMs = GetTimeMs();
+        for (const sFrustum& Frustum : Frustums)
+        {
+            for (const sAABB& Bounds : LeafBounds)
+            {
+                LinearVisible += IsOutside(Bounds, Frustum) ? 0 : 1;
+            }
+        }
+        const double LinearMs = GetTimeMs() - StartMs;
+
+        uint64_t BVHVisible = 0;
+        StartMs = GetTimeMs();
+        for (const sFrustum& Frustum : Frustums)
+        {
+            BVH.QueryFrustum(Frustum, [&BVHVisible](uint32, sEntity)
+            {
+                ++BVHVisible;
+                return true;
+            });
+        }
+        const double QueryMs = GetTimeMs() - StartMs;
+
+        // Frames where some of the objects move a little, most stay inside their enlarged bounds.
+        const uint32 NumMoving = static_cast<uint32>(aNumObjects * MOVING_SHARE);
+        std::uniform_real_distribution<float> Move(-MOVE_DISTANCE, MOVE_DISTANCE);
+        uint32 NumRefitted = 0;
+        StartMs = GetTimeMs();
+        for (uint32 View = 0; View < aNumViews; ++View)
+        {
+            for (uint32 i = 0; i < NumMoving; ++i)
+            {
+                sAABB& Bounds = Items[i].Bounds;
+                const glm::vec3 Offset(Move(Random), 0.0f, Move(Random));
+                Bounds = sAABB(Bounds.Min + Offset, Bounds.Max + Offset);
+                NumRefitted += BVH.Update(Proxies[i], Bounds) ? 1 : 0;
+            }
+        }
+        const double UpdateMs = GetTimeMs() - StartMs;
+
+        std::printf("%u objects, %u views\n", aNumObjects, aNumViews);
+        std::printf("  build:        %8.3f ms, height %u, SAH cost %.2f\n", BuildMs, BVH.GetHeight(), BVH.GetSAHCost());
+        std::printf("  linear scan:  %8.4f ms per view, %llu visible\n", LinearMs / aNumViews, static_cast<unsigned long long>(LinearVisible));
+        std::printf("  BVH query:    %8.4f ms per view, %llu visible, %.1fx faster\n", QueryMs / aNumViews,
+            static_cast<unsigned long long>(BVHVisible), QueryMs > 0.0 ? LinearMs / QueryMs : 0.0);
+        std::printf("  update:       %8.4f ms per frame, %u objects moving, %.1f%% of them refitted\n", UpdateMs / aNumViews, NumMoving,
+            NumMoving > 0 ? 100.0 * NumRefitted / (static_cast<double>(NumMoving) * aNumViews) : 0.0);
+
+        // Boxes touching a plane can round differently in the SIMD tests, more than that is a bug.
+        const uint64_t Difference = LinearVisible > BVHVisible ? LinearVisible - BVHVisible : BVHVisible - LinearVisible;
+        if (Difference * 10000 > LinearVisible)
+        {
+            std::printf("  MISMATCH: the BVH and the linear scan disagree on %llu objects.\n", static_cast<unsigned long long>(Difference));
+        }
+    }
+}
+
+int main(int aArgc, char** aArgv)
+{
+    const uint32 NumViews = aArgc > 2 ? static_cast<uint32>(std::atoi(aArgv[2])) : 64;
+    if (aArgc > 1)
+    {
+        RunBenchmark(static_cast<uint32>(std::atoi(aArgv[1])), NumViews);
+        return 0;
+    }
+
+    for (uint32 NumObjects : { 1000u, 10000u, 100000u })
+    {
+        RunBenchmark(NumObjects, NumViews);
+    }
+    return 0;
+}
@@ -17,9 +17,18 @@ pushd .\shaders
 %VULKAN_SDK%/Bin/glslc.exe shader.frag -o frag.spv
 %VULKAN_SDK%/Bin/glslc.exe shader.vert -o vert.spv
 %VULKAN_SDK%/Bin/glslc.exe deferred.frag -o deferred_frag.spv
+%VULKAN_SDK%/Bin/glslc.exe deferred.frag -DCOMPACT_GBUFFER -o deferred_compact_frag.spv
 %VULKAN_SDK%/Bin/glslc.exe deferred.vert -o deferred_vert.spv
 %VULKAN_SDK%/Bin/glslc.exe light.frag -o light_frag.spv
+%VULKAN_SDK%/Bin/glslc.exe light.frag -DSUBPASS_INPUT -o light_subpass_frag.spv
+%VULKAN_SDK%/Bin/glslc.exe light.frag -DCOMPACT_GBUFFER -o light_compact_frag.spv
+%VULKAN_SDK%/Bin/glslc.exe light.frag -DSUBPASS_INPUT -DCOMPACT_GBUFFER -o light_subpass_compact_frag.spv
 %VULKAN_SDK%/Bin/glslc.exe light.vert -o light_vert.spv
+%VULKAN_SDK%/Bin/glslc.exe shadow.vert -o shadow_vert.spv
+%VULKAN_SDK%/Bin/glslc.exe upscale.vert -o upscale_vert.spv
+%VULKAN_SDK%/Bin/glslc.exe upscale.frag -o upscale_frag.spv
+%VULKAN_SDK%/Bin/glslc.exe cluster_culling.comp -o cluster_culling_comp.spv
+%VULKAN_SDK%/Bin/glslc.exe skinning.comp -o skinning_comp.spv
 popd
 
 mkdir ..\bin
@@ -27,4 +36,8 @@ mkdir ..\bin
 pushd ..\bin
 cl /EHsc /WX /Zi /std:c++17 %include_paths% /DDEBUG /c %SOURCES% ..\ThirdParty\VulkanBootstrap\*cpp /link C:\VulkanSDK\1.3.250.1\Lib\vulkan-1.lib ..\ThirdParty\glfw\lib-vc2022\glfw3.lib
 lib /out:engine.lib *.obj
+
+rem Benchmarks, optimized and with their own objects so they do not end up in the engine library.
+mkdir benchmarks
+cl /EHsc /WX /O2 /std:c++17 %include_paths% /Fobenchmarks\ /Febvh_benchmark.exe ..\Engine\benchmarks\bvh_benchmark.cpp ..\Engine\src\renderer\core\bvh.cpp
 popd
\ No newline at end of file
@@ -0,0 +1,134 @@
+// Clustered lighting resources, shared by the culling compute shader and the shading fragment shaders.
+// Must match CVulkanClusteredLighting (vk_clustered_lighting.cpp).
+//
+// The view frustum is split into GridSize.x * GridSize.y screen tiles and GridSize.z depth slices, spaced
+// exponentially between the near and far planes so every cluster is roughly as deep as it is wide.
+// cluster_culling.comp writes, for every cluster, how many point and spot lights touch it and their indices.
+//
+// Define LIGHTS_SET to the descriptor set the lights are bound to before including this file.
+// Shading functions need light_functions.glsl to be included first.
+
+#ifndef LIGHTS_SET
+#error "LIGHTS_SET must be defined before including clustered_lighting.glsl"
+#endif
+
+struct sPointLight
+{
+    vec4 PositionRadius;    // World position, radius.
+    vec4 ColorIntensity;
+};
+
+struct sSpotLight
+{
+    vec4 PositionRadius;    // World position, radius.
+    vec4 ColorIntensity;
+    vec4 Direction;         // World direction, unused.
+    vec4 Cone;              // Cosine of the inner angle, cosine of the outer angle, unused, unused.
+};
+
+layout(std140, set = LIGHTS_SET, binding = 0) uniform ClusterInfo {
+    mat4 View;
+    mat4 InvProj;
+    uvec4 GridSize;         // Clusters in x, y and z, max lights per cluster.
+    vec4 ZParams;           // Near, far, slice scale, slice bias.
+    vec4 TileSize;          // Tile width and height in pixels, screen width and height.
+    uvec4 LightCounts;      // Point lights, spot lights.
+} clusterInfo;
+
+layout(std430, set = LIGHTS_SET, binding = 1) readonly buffer PointLights {
+    sPointLight pointLights[];
+};
+
+layout(std430, set = LIGHTS_SET, binding = 2) readonly buffer SpotLights {
+    sSpotLight spotLights[];
+};
+
+#ifdef CLUSTER_CULLING
+#define CLUSTER_ACCESS writeonly
+#else
+#define CLUSTER_ACCESS readonly
+#endif
+
+// Point and spot light counts of every cluster.
+layout(std430, set = LIGHTS_SET, binding = 3) CLUSTER_ACCESS buffer ClusterGrid {
+    uvec2 clusterLightCounts[];
+};
+
+// GridSize.w entries per cluster: the point light indices followed by the spot light indices.
+layout(std430, set = LIGHTS_SET, binding = 4) CLUSTER_ACCESS buffer ClusterLightIndices {
+    uint clusterLightIndices[];
+};
+
+uint GetClusterIndex(uvec3 aCluster)
+{
+    return aCluster.x + clusterInfo.GridSize.x * (aCluster.y + clusterInfo.GridSize.y * aCluster.z);
+}
+
+// Depth slice of a positive view space depth. Inverse of GetSliceDepth().
+uint GetDepthSlice(float aViewDepth)
+{
+    float slice = log(max(aViewDepth, clusterInfo.ZParams.x)) * clusterInfo.ZParams.z + clusterInfo.ZParams.w;
+    return uint(clamp(slice, 0.0, float(clusterInfo.GridSize.z - 1u)));
+}
+
+float GetSliceDepth(uint aSlice)
+{
+    return clusterInfo.ZParams.x * pow(clusterInfo.ZParams.y / clusterInfo.ZParams.x, float(aSlice) / float(clusterInfo.GridSize.z));
+}
+
+#ifndef CLUSTER_CULLING
+
+uint GetClusterIndex(vec2 aFragCoord, vec3 aWorldPosition)
+{
+    float viewDepth = -(clusterInfo.View * vec4(aWorldPosition, 1.0)).z;
+    uvec2 tile = min(uvec2(aFragCoord / clusterInfo.TileSize.xy), clusterInfo.GridSize.xy - 1u);
+    return GetClusterIndex(uvec3(tile, GetDepthSlice(viewDepth)));
+}
+
+vec3 ShadeLight(vec3 aL, vec3 aN, vec3 aV, vec3 aRadiance, vec3 aAlbedo, vec3 aF0, float aMetallic, float aRoughness)
+{
+    vec3 H = normalize(aL + aV);
+    float NdotL = clamp(dot(aN, aL), 0.0, 1.0);
+    float NdotV = clamp(dot(aN, aV), 0.0, 1.0);
+    float NdotH = clamp(dot(aN, H), 0.0, 1.0);
+    float LdotH = clamp(dot(aL, H), 0.0, 1.0);
+
+    vec3 ks = SpecularBRDF(aRoughness, aF0, NdotH, NdotV, NdotL, LdotH);
+    vec3 kd = (1.0 - aMetallic) * aAlbedo;
+    return (kd + ks) * NdotL * aRadiance;
+}
+
+// Direct lighting from the point and spot lights of the cluster the fragment is in.
+vec3 ShadeClusteredLights(vec3 aPosition, vec3 aN, vec3 aV, vec3 aAlbedo, float aMetallic, float aRoughness, vec2 aFragCoord)
+{
+    vec3 f0 = aAlbedo * aMetallic + (vec3(0.5) * (1.0 - aMetallic));
+
+    uint cluster = GetClusterIndex(aFragCoord, aPosition);
+    uvec2 counts = clusterLightCounts[cluster];
+    uint offset = cluster * clusterInfo.GridSize.w;
+
+    vec3 color = vec3(0.0);
+    for (uint i = 0; i < counts.x; ++i)
+    {
+        sPointLight light = pointLights[clusterLightIndices[offset + i]];
+        vec3 toLight = light.PositionRadius.xyz - aPosition;
+        float attenuation = ComputeAttenuation(light.PositionRadius.xyz, aPosition, light.PositionRadius.w);
+        vec3 radiance = light.ColorIntensity.rgb * light.ColorIntensity.a * attenuation;
+        color += ShadeLight(normalize(toLight), aN, aV, radiance, aAlbedo, f0, aMetallic, aRoughness);
+    }
+
+    for (uint i = 0; i < counts.y; ++i)
+    {
+        sSpotLight light = spotLights[clusterLightIndices[offset + counts.x + i]];
+        vec3 L = normalize(light.PositionRadius.xyz - aPosition);
+        float cone = smoothstep(light.Cone.y, light.Cone.x, dot(-L, light.Direction.xyz));
+        float attenuation = ComputeAttenuation(light.PositionRadius.xyz, aPosition, light.PositionRadius.w) * cone;
+        vec3 radiance = light.ColorIntensity.rgb * light.ColorIntensity.a * attenuation;
+        color += ShadeLight(L, aN, aV, radiance, aAlbedo, f0, aMetallic, aRoughness);
+    }
+
+    // Constant ambient so surfaces outside every light are not pitch black.
+    return color + aAlbedo * 0.03;
+}
+
+#endif
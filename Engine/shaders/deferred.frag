@@ -1,17 +1,47 @@
 #version 460
 
+#extension GL_GOOGLE_include_directive : require
+#include "gbuffer.glsl"
+
+layout(set = 2, binding = 0) uniform MaterialConstants {
+    vec4 Color;
+    float RoughnessFactor;
+    float MetallicFactor;
+    float TillingFactor;
+    vec3 EmissiveFactor;
+    bool bIsTransparent;
+} materialConstants;
+
+layout(set = 2, binding = 1) uniform sampler2D albedoSampler;
+layout(set = 2, binding = 2) uniform sampler2D metalRoughnessSampler;
+
 layout (location = 0) in vec3 inPosition;
 layout (location = 1) in vec3 inNormal;
 layout (location = 2) in vec2 texCoord;
 
+#ifdef COMPACT_GBUFFER
+layout (location = 0) out vec4 outNormal;
+layout (location = 1) out vec4 outFragColor;
+#else
 layout (location = 0) out vec4 outPosition;
 layout (location = 1) out vec4 outNormal;
 layout (location = 2) out vec4 outFragColor;
+#endif
 
 void main() 
 {	
-	vec3 color = vec3(1.0, 0.0, 0.0);
-	outPosition = vec4(inPosition, 1.0f);
-	outNormal = vec4(inNormal, 1.0f);
+	vec3 color = texture(albedoSampler, texCoord).xyz;
+	vec3 metalRoughness = texture(metalRoughnessSampler, texCoord).xyz;
+	float metallic = metalRoughness.z * materialConstants.MetallicFactor;
+	float roughness = metalRoughness.y * materialConstants.RoughnessFactor;
+	vec3 normal = normalize(inNormal);
+
+#ifdef COMPACT_GBUFFER
+	outNormal = vec4(EncodeOctahedral(normal), roughness, 0.0f);
+	outFragColor = vec4(color, metallic);
+#else
+	outPosition = vec4(inPosition, metallic);
+	outNormal = vec4(normal, roughness);
 	outFragColor = vec4(color, 1.0f);
-}
\ No newline at end of file
+#endif
+}
@@ -13,6 +13,8 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 view;
     mat4 proj;
     mat4 viewproj;
+    mat4 invviewproj;
+    vec3 pos;
 } ubo;
 
 struct ObjectData {
@@ -26,9 +28,9 @@ layout(std140, set = 1, binding = 0) readonly buffer ObjectBuffer {
 void main()
 {
     mat4 modelMatrix = objectBuffer.objects[gl_BaseInstance].model;
-	mat4 transformMatrix = (ubo.viewproj * modelMatrix);
-	gl_Position = transformMatrix * vec4(vPosition, 1.0f);
-	outPosition = vPosition;
-	outNormal = vNormal;
+	vec4 worldPosition = modelMatrix * vec4(vPosition, 1.0f);
+	gl_Position = ubo.viewproj * worldPosition;
+	outPosition = worldPosition.xyz;
+	outNormal = mat3(modelMatrix) * vNormal;
 	texCoord = vTexCoord;
-}
\ No newline at end of file
+}
@@ -0,0 +1,56 @@
+// G-Buffer encoding shared by the G-Buffer pass and the light pass.
+//
+// Standard layout (20 bytes per pixel):
+//   0: RGBA16F world position + metallic
+//   1: RGBA16F world normal + roughness
+//   2: RGBA8   albedo
+//
+// Compact layout, COMPACT_GBUFFER (8 bytes per pixel):
+//   The world position is reconstructed from the depth buffer and the inverse view projection.
+//   0: RGB10A2 octahedral normal + roughness
+//   1: RGBA8   albedo + metallic
+
+struct sGBufferData
+{
+    vec3 Position;
+    vec3 Normal;
+    vec3 Albedo;
+    float Metallic;
+    float Roughness;
+};
+
+vec2 OctWrap(vec2 v)
+{
+    return (1.0 - abs(v.yx)) * vec2(v.x >= 0.0 ? 1.0 : -1.0, v.y >= 0.0 ? 1.0 : -1.0);
+}
+
+// Maps a unit vector to [0, 1]^2 by projecting it onto an octahedron and unfolding it.
+vec2 EncodeOctahedral(vec3 n)
+{
+    n /= (abs(n.x) + abs(n.y) + abs(n.z));
+    n.xy = n.z >= 0.0 ? n.xy : OctWrap(n.xy);
+    return n.xy * 0.5 + 0.5;
+}
+
+vec3 DecodeOctahedral(vec2 f)
+{
+    f = f * 2.0 - 1.0;
+    vec3 n = vec3(f.x, f.y, 1.0 - abs(f.x) - abs(f.y));
+    float t = clamp(-n.z, 0.0, 1.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
+// Reversed-Z with an infinite far plane: nothing was drawn where the depth is still cleared to 0. That depth is at
+// infinity, w is 0 there and ReconstructWorldPosition() must not be called for it.
+bool IsBackgroundDepth(float depth)
+{
+    return depth == 0.0;
+}
+
+vec3 ReconstructWorldPosition(vec2 ndc, float depth, mat4 invViewProj)
+{
+    vec4 position = invViewProj * vec4(ndc, depth, 1.0);
+    return position.xyz / position.w;
+}
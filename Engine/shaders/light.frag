@@ -1,18 +1,92 @@
 #version 460
 
+#extension GL_GOOGLE_include_directive : require
+#include "light_functions.glsl"
+#include "gbuffer.glsl"
+
+#define LIGHTS_SET 2
+#include "clustered_lighting.glsl"
+
+// Variants, see build.bat:
+// SUBPASS_INPUT: the G-Buffer is written by the previous subpass and read with subpassLoad().
+// COMPACT_GBUFFER: binding 0 is the depth buffer instead of the position target (see gbuffer.glsl).
+
+layout(set = 0, binding = 0) uniform UniformBufferObject {
+    mat4 view;
+    mat4 proj;
+    mat4 viewproj;
+    mat4 invviewproj;
+    vec3 pos;
+} ubo;
+
+#include "shadows.glsl"
+
 //gbuffers input
-layout(set = 1, binding = 0) uniform sampler2D position;
-layout(set = 1, binding = 1) uniform sampler2D normal;
-layout(set = 1, binding = 2) uniform sampler2D albedo;
+#ifdef SUBPASS_INPUT
+layout(input_attachment_index = 0, set = 1, binding = 0) uniform subpassInput gbuffer0;
+layout(input_attachment_index = 1, set = 1, binding = 1) uniform subpassInput gbuffer1;
+layout(input_attachment_index = 2, set = 1, binding = 2) uniform subpassInput gbuffer2;
+#define READ_GBUFFER(target) subpassLoad(target)
+#else
+layout(set = 1, binding = 0) uniform sampler2D gbuffer0;
+layout(set = 1, binding = 1) uniform sampler2D gbuffer1;
+layout(set = 1, binding = 2) uniform sampler2D gbuffer2;
+#define READ_GBUFFER(target) texelFetch(target, ivec2(gl_FragCoord.xy), 0)
+#endif
 
 //output write
 layout (location = 0) out vec4 outFragColor;
 
 layout (location = 0) in vec2 uv;
+layout (location = 1) in vec2 ndc;
+
+// False for the background, where no surface was written.
+bool ReadGBuffer(out sGBufferData data)
+{
+	vec4 sample0 = READ_GBUFFER(gbuffer0);
+	vec4 sample1 = READ_GBUFFER(gbuffer1);
+	vec4 sample2 = READ_GBUFFER(gbuffer2);
+
+#ifdef COMPACT_GBUFFER
+	if (IsBackgroundDepth(sample0.r))
+	{
+		return false;
+	}
+
+	data.Position = ReconstructWorldPosition(ndc, sample0.r, ubo.invviewproj);
+	data.Normal = DecodeOctahedral(sample1.xy);
+	data.Roughness = sample1.z;
+	data.Albedo = sample2.xyz;
+	data.Metallic = sample2.w;
+#else
+	// The normal target is cleared to zero, surfaces always write a unit normal.
+	if (dot(sample1.xyz, sample1.xyz) == 0.0)
+	{
+		return false;
+	}
+
+	data.Position = sample0.xyz;
+	data.Metallic = sample0.w;
+	data.Normal = normalize(sample1.xyz);
+	data.Roughness = sample1.w;
+	data.Albedo = sample2.xyz;
+#endif
+	return true;
+}
 
 void main() 
 {	
-	vec3 color = texture(albedo, uv).xyz;
-	outFragColor = vec4(color, 1.0f);
-	//outFragColor = vec4(1.0f, 0.0f, 0.0f, 1.0f);
-}
\ No newline at end of file
+	sGBufferData gbuffer;
+	if (!ReadGBuffer(gbuffer))
+	{
+		// Same as the clear color of the forward path.
+		outFragColor = vec4(0.0f, 0.0f, 0.0f, 1.0f);
+		return;
+	}
+
+	vec3 V = normalize( ubo.pos - gbuffer.Position );
+	vec3 direct = ShadeClusteredLights( gbuffer.Position, gbuffer.Normal, V, gbuffer.Albedo, gbuffer.Metallic, gbuffer.Roughness, gl_FragCoord.xy );
+	direct += ShadeDirectionalLight( gbuffer.Position, gbuffer.Normal, V, gbuffer.Albedo, gbuffer.Metallic, gbuffer.Roughness );
+
+	outFragColor = vec4(direct, 1.0f);
+}
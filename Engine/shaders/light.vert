@@ -9,12 +9,16 @@ layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 view;
     mat4 proj;
     mat4 viewproj;
+    mat4 invviewproj;
+    vec3 pos;
 } ubo;
 
 layout (location = 0) out vec2 v_uv;
+layout (location = 1) out vec2 v_ndc;
 
 void main() 
 {	
 	v_uv = vTexCoord;
+	v_ndc = vPosition.xy;
 	gl_Position = vec4(vPosition, 1.0);
-}
\ No newline at end of file
+}
@@ -1,19 +1,13 @@
 #define RECIPROCAL_PI 0.3183098861837697
 #define PI 3.1415926535897932384626433832795
 
-vec3 light_position = vec3(0.0, 10.0, 4.0);
-vec3 light_color = vec3(1.0, 1.0, 1.0);
-
-// TODO: Place the real world_position of the fragment shader.
-vec3 world_position = vec3(0.0, 0.0, 0.0);
-
-vec3 Phong(in vec3 aNormal, in vec3 aPointPosition)
+vec3 Phong(in vec3 aNormal, in vec3 aPointPosition, in vec3 aLightPosition, in vec3 aLightColor)
 {
     vec3 N = normalize(aNormal);
-    vec3 L = normalize(light_position - aPointPosition);
+    vec3 L = normalize(aLightPosition - aPointPosition);
     float NdotL = dot(N, L);
     NdotL = clamp(NdotL, 0.0, 1.0);
-    return NdotL * light_color;
+    return NdotL * aLightColor;
 }
 
 float GetSpotFactor( in float aCosine, in float aExponent)
@@ -28,7 +22,7 @@ vec3 SpotDirection( in float aSpotCosine, in vec3 aSpotDirection, in vec3 aLight
 	float theta = dot( -L, normalize(aSpotDirection) );
 	if(theta >= aSpotCosine)
 	{
-		vec3 final_color = Phong( aNormal, world_position ) * GetSpotFactor( aSpotCosine, aSpotExponent );
+		vec3 final_color = Phong( aNormal, aWorldPosition, aLightPosition, aLightColor * aIntensity ) * GetSpotFactor( theta, aSpotExponent );
 		return final_color;
 	}	
 	return vec3(0.0);
@@ -3,13 +3,19 @@
 #extension GL_GOOGLE_include_directive : require
 #include "light_functions.glsl"
 
+#define LIGHTS_SET 3
+#include "clustered_lighting.glsl"
+
 layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 view;
     mat4 proj;
     mat4 viewproj;
+    mat4 invviewproj;
     vec3 pos;
 } ubo;
 
+#include "shadows.glsl"
+
 layout(set = 2, binding = 0) uniform MaterialConstants {
     vec4 Color;
     float RoughnessFactor;
@@ -31,35 +37,49 @@ layout(location = 3) in vec3 fragWorldPos;
 
 layout(location = 0) out vec4 outColor;
 
-// TODO: Pass lights into the shader.
+// The meshes have no tangents, the tangent frame comes from the screen space derivatives of the position and the
+// texture coordinates (same as the glTF sample viewer when the tangents are missing).
+vec3 ApplyNormalMap( vec3 N, vec3 worldPos, vec2 uv ) {
+    // Sampled before any branch, the implicit derivatives need the whole quad.
+    // The textures are uploaded as sRGB, the normal map holds linear values.
+    vec3 mapNormal = pow( texture( normalSampler, uv ).xyz, vec3( 1.0 / 2.2 ) ) * 2.0 - 1.0;
+
+    vec3 dPdx = dFdx( worldPos );
+    vec3 dPdy = dFdy( worldPos );
+    vec2 dUVdx = dFdx( uv );
+    vec2 dUVdy = dFdy( uv );
+
+    float det = dUVdx.x * dUVdy.y - dUVdy.x * dUVdx.y;
+    if ( abs( det ) < 1e-20 ) {
+        // No texture coordinates to follow.
+        return N;
+    }
+
+    // World space direction of increasing u, made orthogonal to the normal.
+    vec3 T = ( dUVdy.y * dPdx - dUVdx.y * dPdy ) / det;
+    T -= N * dot( N, T );
+    if ( dot( T, T ) < 1e-12 ) {
+        return N;
+    }
+    T = normalize( T );
+    vec3 B = cross( N, T );
+
+    return normalize( mat3( T, B, N ) * mapNormal );
+}
 
 void main() {
     vec3 color_texture = texture( albedoSampler, fragTexCoord ).xyz;
-    float metal = texture(metalRoughnessSampler, fragTexCoord).z;
-    float roughness = texture(metalRoughnessSampler, fragTexCoord).y;
-
-	//calculate f0 reflection based on the color and metalness
-	vec3 f0 = color_texture * metal + (vec3( 0.5 ) * ( 1.0 - metal ));
-
-	//Normal has to be converted to clip space again
-	vec3 N = texture( normalSampler, fragTexCoord ).xyz;
-    N = normalize( N * 2.0 - 1.0 );
-    
-    // normalize the Light, Vision and Half vector and compute some dot products
-	vec3 L = normalize( light_position - fragWorldPos );
-	vec3 V = normalize( ubo.pos - fragWorldPos );
-	vec3 H = normalize( L + V );
-	float NdotL = clamp( dot( N, L ), 0.0, 1.0 );
-	float NdotV = clamp( dot( N, V ), 0.0, 1.0 );
-	float NdotH = clamp( dot( N, H ), 0.0, 1.0 );
-	float LdotH = clamp( dot( L, H ), 0.0, 1.0 );
-
-    // calulate the specular and difusse
-	vec3 ks = SpecularBRDF( roughness, f0, NdotH, NdotV, NdotL, LdotH );
-	vec3 diffuse = ( 1.0 - metal ) * color_texture;	//the most metalness the less diffuse color
-	vec3 kd = diffuse * NdotL;
-	vec3 direct = kd + ks;
-
-    outColor = vec4(direct * color_texture, 1.0);
-    outColor = vec4(color_texture, 1.0);
+    vec3 metalRoughness = texture( metalRoughnessSampler, fragTexCoord ).xyz;
+    float metal = metalRoughness.z * materialConstants.MetallicFactor;
+    float roughness = metalRoughness.y * materialConstants.RoughnessFactor;
+
+    vec3 N = ApplyNormalMap( normalize( fragNormal ), fragWorldPos, fragTexCoord );
+    vec3 V = normalize( ubo.pos - fragWorldPos );
+
+    vec3 direct = ShadeClusteredLights( fragWorldPos, N, V, color_texture, metal, roughness, gl_FragCoord.xy );
+    direct += ShadeDirectionalLight( fragWorldPos, N, V, color_texture, metal, roughness );
+
+    vec3 emissive = texture( emissiveSampler, fragTexCoord ).xyz * materialConstants.EmissiveFactor;
+
+    outColor = vec4(direct + emissive, 1.0);
 }
\ No newline at end of file
@@ -10,10 +10,14 @@ layout(location = 1) out vec3 fragNormal;
 layout(location = 2) out vec2 fragTexCoord;
 layout(location = 3) out vec3 fragWorldPos;
 
+// The depth prepass draws with this shader too, the forward pass tests its depth for equality.
+invariant gl_Position;
+
 layout(set = 0, binding = 0) uniform UniformBufferObject {
     mat4 view;
     mat4 proj;
     mat4 viewproj;
+    mat4 invviewproj;
     vec3 pos;
 } ubo;
 
@@ -30,7 +34,7 @@ void main() {
     vec4 worldPosition = modelMatrix * vec4(inPosition, 1.0);
     gl_Position = ubo.viewproj * worldPosition;
     fragColor = inColor;
-    fragNormal = inNormal;
+    fragNormal = mat3(modelMatrix) * inNormal;
     fragTexCoord = inTexCoord;
     fragWorldPos = worldPosition.xyz;
 }
\ No newline at end of file
@@ -0,0 +1,22 @@
+#version 460
+
+// Depth only pass of the cascaded shadow maps, see CVulkanShadowMaps.
+
+layout(location = 0) in vec3 inPosition;
+
+layout(push_constant) uniform ShadowConstants {
+    mat4 viewproj;
+} constants;
+
+struct ObjectData {
+    mat4 model;
+};
+
+layout(std140, set = 1, binding = 0) readonly buffer ObjectBuffer {
+    ObjectData objects[];
+} objectBuffer;
+
+void main() {
+    mat4 modelMatrix = objectBuffer.objects[gl_BaseInstance].model;
+    gl_Position = constants.viewproj * modelMatrix * vec4(inPosition, 1.0);
+}
@@ -0,0 +1,60 @@
+// Directional light and its cascaded shadow maps, bound to the frame descriptor set.
+// Must match CVulkanShadowMaps (vk_shadow_maps.cpp).
+//
+// Needs the frame UBO (ubo.view) and clustered_lighting.glsl (ShadeLight) to be included first.
+
+#define NUM_SHADOW_CASCADES 4
+
+layout(std140, set = 0, binding = 1) uniform ShadowData {
+    mat4 CascadeViewProj[NUM_SHADOW_CASCADES];
+    vec4 CascadeSplits;     // View depth where every cascade ends.
+    vec4 CascadeTexelSizes; // World size of a texel of every cascade.
+    vec4 LightDirection;    // Direction the light travels, unused.
+    vec4 LightColor;        // Color, intensity.
+    vec4 ShadowParams;      // Texel size in uv, unused, unused, unused.
+} shadowData;
+
+layout(set = 0, binding = 2) uniform sampler2DArrayShadow shadowMap;
+
+// Fraction of the directional light reaching aPosition, 1 when it is past the last cascade.
+float SampleShadow(vec3 aPosition, vec3 aN)
+{
+    float viewDepth = -(ubo.view * vec4(aPosition, 1.0)).z;
+
+    uint cascade = 0;
+    while (cascade < NUM_SHADOW_CASCADES && viewDepth > shadowData.CascadeSplits[cascade])
+    {
+        ++cascade;
+    }
+
+    if (cascade == NUM_SHADOW_CASCADES)
+    {
+        return 1.0;
+    }
+
+    // Pushing the position along the normal by about a texel removes the acne on surfaces facing away from the light.
+    vec3 offsetPosition = aPosition + aN * shadowData.CascadeTexelSizes[cascade] * 1.5;
+    vec4 shadowPosition = shadowData.CascadeViewProj[cascade] * vec4(offsetPosition, 1.0);
+    shadowPosition.xyz /= shadowPosition.w;
+    vec2 uv = shadowPosition.xy * 0.5 + 0.5;
+
+    // 3x3 taps, each one already filtered 2x2 by the comparison sampler.
+    float texelSize = shadowData.ShadowParams.x;
+    float shadow = 0.0;
+    for (int x = -1; x <= 1; ++x)
+    {
+        for (int y = -1; y <= 1; ++y)
+        {
+            shadow += texture(shadowMap, vec4(uv + vec2(x, y) * texelSize, float(cascade), shadowPosition.z));
+        }
+    }
+    return shadow / 9.0;
+}
+
+vec3 ShadeDirectionalLight(vec3 aPosition, vec3 aN, vec3 aV, vec3 aAlbedo, float aMetallic, float aRoughness)
+{
+    vec3 f0 = aAlbedo * aMetallic + (vec3(0.5) * (1.0 - aMetallic));
+    vec3 L = -normalize(shadowData.LightDirection.xyz);
+    vec3 radiance = shadowData.LightColor.rgb * shadowData.LightColor.a * SampleShadow(aPosition, aN);
+    return ShadeLight(L, aN, aV, radiance, aAlbedo, f0, aMetallic, aRoughness);
+}
@@ -0,0 +1,20 @@
+#version 460
+
+// Stretches the rendered area of the scene color over the whole target, see CVulkanUpscalePass.
+
+layout(set = 0, binding = 0) uniform sampler2D sceneColor;
+
+layout(push_constant) uniform UpscaleConstants {
+	vec2 UVScale;
+	vec2 MaxUV;
+} constants;
+
+layout (location = 0) in vec2 inUV;
+
+layout (location = 0) out vec4 outFragColor;
+
+void main()
+{
+	vec2 uv = min(inUV * constants.UVScale, constants.MaxUV);
+	outFragColor = vec4(texture(sceneColor, uv).rgb, 1.0);
+}
@@ -0,0 +1,10 @@
+#version 460
+
+layout (location = 0) out vec2 outUV;
+
+void main()
+{
+	// Fullscreen triangle: (0, 0), (2, 0), (0, 2) in UV space, it covers the whole viewport.
+	outUV = vec2((gl_VertexIndex << 1) & 2, gl_VertexIndex & 2);
+	gl_Position = vec4(outUV * 2.0 - 1.0, 0.0, 1.0);
+}
@@ -0,0 +1,52 @@
+#include "asset_table.hpp"
+#include "logger.h"
+
+namespace
+{
+    struct sInternedNames
+    {
+        std::unordered_map<AssetID, std::string> Names;
+        std::mutex Mutex;
+    };
+
+    sInternedNames& GetInternedNames()
+    {
+        static sInternedNames InternedNames;
+        return InternedNames;
+    }
+
+    // 64-bit FNV-1a.
+    AssetID HashName(const std::string& aName)
+    {
+        uint64 Hash = 14695981039346656037ull;
+        for (const char Character : aName)
+        {
+            Hash ^= static_cast<uint8>(Character);
+            Hash *= 1099511628211ull;
+        }
+        return Hash != INVALID_ASSET_ID ? Hash : 1;
+    }
+}
+
+AssetID assets::Intern(const std::string& aName)
+{
+    const AssetID ID = HashName(aName);
+
+    sInternedNames& InternedNames = GetInternedNames();
+    std::lock_guard<std::mutex> Lock(InternedNames.Mutex);
+    const auto& Inserted = InternedNames.Names.insert({ ID, aName });
+    if (!Inserted.second && Inserted.first->second != aName)
+    {
+        SGSERROR("Asset names %s and %s have the same ID!", Inserted.first->second.c_str(), aName.c_str());
+    }
+
+    return ID;
+}
+
+std::string assets::GetName(AssetID aID)
+{
+    sInternedNames& InternedNames = GetInternedNames();
+    std::lock_guard<std::mutex> Lock(InternedNames.Mutex);
+    const auto& Found = InternedNames.Names.find(aID);
+    return Found != InternedNames.Names.cend() ? Found->second : std::string();
+}
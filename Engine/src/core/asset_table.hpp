@@ -0,0 +1,235 @@
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <exception>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+
+/**
+ * @brief 64-bit ID of an asset, the hash of its name. Names are only hashed at load time, everything after that
+ * works with the ID or, in hot paths, with the dense index the asset gets when it is registered in a CAssetTable.
+ */
+using AssetID = uint64;
+constexpr AssetID INVALID_ASSET_ID = 0;
+constexpr uint32 INVALID_ASSET_INDEX = UINT32_MAX;
+
+namespace assets
+{
+    /**
+     * @brief ID of aName. The name is remembered so it can be printed with GetName(), and two names hashing to the
+     * same ID are reported. Thread safe.
+     */
+    AssetID Intern(const std::string& aName);
+
+    /**
+     * @brief Name aID was interned from, empty if unknown. Thread safe.
+     */
+    std::string GetName(AssetID aID);
+}
+
+/**
+ * @brief Table of assets of type T. Every registered asset gets a dense index that never changes, so renderer data
+ * can be stored in plain arrays indexed by it.
+ *
+ * Registration and lookups by ID are thread safe. Get() by index takes no lock at all: the entries are stored in
+ * pages that never move, and an index is only handed out once its entry is written.
+ */
+template<class T>
+class CAssetTable
+{
+public:
+    CAssetTable() : m_Size(0)
+    {
+        for (std::atomic<T**>& Page : m_Pages)
+        {
+            Page.store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~CAssetTable()
+    {
+        for (std::atomic<T**>& Page : m_Pages)
+        {
+            delete[] Page.load(std::memory_order_relaxed);
+        }
+    }
+
+    CAssetTable(const CAssetTable&) = delete;
+    CAssetTable& operator=(const CAssetTable&) = delete;
+
+    /**
+     * @brief Adds apAsset with aID.
+     * @return Index of the asset, INVALID_ASSET_INDEX if aID is already registered.
+     */
+    uint32 Register(AssetID aID, T* apAsset)
+    {
+        std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+        return m_IndexByID.count(aID) > 0 ? INVALID_ASSET_INDEX : Add(aID, apAsset);
+    }
+
+    /**
+     * @brief Asset with aID, created with aCreate() and registered if it is not in the table yet. aCreate() runs without
+     * the lock, so assets with different IDs are created concurrently. Concurrent calls for the same ID wait for the
+     * first one, the asset is only created once. aOnRegistered(Asset, Index) runs under the lock right before the asset
+     * can be found, to store its index in it.
+     */
+    template<class F, class G>
+    T* FindOrCreate(AssetID aID, F&& aCreate, G&& aOnRegistered)
+    {
+        {
+            std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+            const auto& Found = m_IndexByID.find(aID);
+            if (Found != m_IndexByID.cend())
+            {
+                return Get(Found->second);
+            }
+        }
+
+        std::promise<T*> Promise;
+        {
+            std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+            const auto& Found = m_IndexByID.find(aID);
+            if (Found != m_IndexByID.cend())
+            {
+                return Get(Found->second);
+            }
+
+            const auto& Pending = m_Pending.find(aID);
+            if (Pending != m_Pending.cend())
+            {
+                std::shared_future<T*> Future = Pending->second;
+                Lock.unlock();
+                return Future.get();
+            }
+
+            m_Pending.insert({ aID, Promise.get_future().share() });
+        }
+
+        T* pAsset = nullptr;
+        try
+        {
+            pAsset = aCreate();
+        }
+        catch (...)
+        {
+            {
+                std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+                m_Pending.erase(aID);
+            }
+            Promise.set_exception(std::current_exception());
+            throw;
+        }
+
+        {
+            std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+            m_Pending.erase(aID);
+            if (pAsset)
+            {
+                aOnRegistered(pAsset, m_Size.load(std::memory_order_relaxed));
+                Add(aID, pAsset);
+            }
+        }
+        // A failed creation is not remembered, the next call tries again.
+        Promise.set_value(pAsset);
+        return pAsset;
+    }
+
+    template<class F>
+    T* FindOrCreate(AssetID aID, F&& aCreate)
+    {
+        return FindOrCreate(aID, std::forward<F>(aCreate), [](T*, uint32) {});
+    }
+
+    /**
+     * @brief Registers the asset of aOldID under aNewID. Its index does not change.
+     * @return False if aOldID is not registered or aNewID is already taken.
+     */
+    bool Rename(AssetID aOldID, AssetID aNewID)
+    {
+        std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+        const auto& Found = m_IndexByID.find(aOldID);
+        if (Found == m_IndexByID.cend() || m_IndexByID.count(aNewID) > 0)
+        {
+            return false;
+        }
+
+        const uint32 Index = Found->second;
+        m_IndexByID.erase(Found);
+        m_IndexByID.insert({ aNewID, Index });
+        return true;
+    }
+
+    uint32 FindIndex(AssetID aID) const
+    {
+        std::shared_lock<std::shared_mutex> Lock(m_Mutex);
+        const auto& Found = m_IndexByID.find(aID);
+        return Found != m_IndexByID.cend() ? Found->second : INVALID_ASSET_INDEX;
+    }
+
+    T* Find(AssetID aID) const
+    {
+        const uint32 Index = FindIndex(aID);
+        return Index != INVALID_ASSET_INDEX ? Get(Index) : nullptr;
+    }
+
+    T* Get(uint32 aIndex) const
+    {
+        assert(aIndex < m_Size.load(std::memory_order_acquire));
+        T** pPage = m_Pages[aIndex / PAGE_SIZE].load(std::memory_order_acquire);
+        return pPage[aIndex % PAGE_SIZE];
+    }
+
+    /**
+     * @brief Removes every asset from the table, without destroying them. No other thread can use the table meanwhile.
+     */
+    void Clear()
+    {
+        std::unique_lock<std::shared_mutex> Lock(m_Mutex);
+        m_IndexByID.clear();
+        m_Size.store(0, std::memory_order_release);
+    }
+
+    /**
+     * @brief Number of assets, valid indices go from 0 to GetSize() - 1.
+     */
+    uint32 GetSize() const { return m_Size.load(std::memory_order_acquire); }
+
+private:
+    static constexpr uint32 PAGE_SIZE = 1024;
+    static constexpr uint32 MAX_PAGES = 1024;
+
+    // m_Mutex must be held exclusively.
+    uint32 Add(AssetID aID, T* apAsset)
+    {
+        const uint32 Index = m_Size.load(std::memory_order_relaxed);
+        assert(Index < PAGE_SIZE * MAX_PAGES);
+
+        T** pPage = m_Pages[Index / PAGE_SIZE].load(std::memory_order_relaxed);
+        if (pPage == nullptr)
+        {
+            pPage = new T*[PAGE_SIZE]();
+            m_Pages[Index / PAGE_SIZE].store(pPage, std::memory_order_release);
+        }
+
+        pPage[Index % PAGE_SIZE] = apAsset;
+        m_IndexByID.insert({ aID, Index });
+        m_Size.store(Index + 1, std::memory_order_release);
+        return Index;
+    }
+
+    std::atomic<T**> m_Pages[MAX_PAGES];
+    std::atomic<uint32> m_Size;
+
+    std::unordered_map<AssetID, uint32> m_IndexByID;
+    // Assets being created by FindOrCreate(), the other callers asking for them wait on the future.
+    std::unordered_map<AssetID, std::shared_future<T*>> m_Pending;
+    mutable std::shared_mutex m_Mutex;
+};
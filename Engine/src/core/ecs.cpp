@@ -0,0 +1,90 @@
+#include "ecs.hpp"
+
+#include <atomic>
+
+uint32 ecs::NextComponentTypeID()
+{
+    static std::atomic<uint32> NextTypeID(0);
+    return NextTypeID.fetch_add(1, std::memory_order_relaxed);
+}
+
+CEntityRegistry::CEntityRegistry() :
+    m_NumAlive(0)
+{
+}
+
+CEntityRegistry::~CEntityRegistry()
+{
+    Clear();
+}
+
+sEntity CEntityRegistry::CreateEntity()
+{
+    sEntity Entity;
+    if (!m_FreeIndices.empty())
+    {
+        Entity.Index = m_FreeIndices.back();
+        m_FreeIndices.pop_back();
+    }
+    else
+    {
+        Entity.Index = static_cast<uint32>(m_Generations.size());
+        m_Generations.push_back(0);
+        m_Alive.push_back(false);
+    }
+
+    Entity.Generation = m_Generations[Entity.Index];
+    m_Alive[Entity.Index] = true;
+    ++m_NumAlive;
+    return Entity;
+}
+
+void CEntityRegistry::DestroyEntity(sEntity aEntity)
+{
+    if (!IsAlive(aEntity))
+    {
+        return;
+    }
+
+    for (const std::unique_ptr<IComponentArray>& pComponents : m_ComponentArrays)
+    {
+        if (pComponents)
+        {
+            pComponents->Remove(aEntity);
+        }
+    }
+
+    m_Alive[aEntity.Index] = false;
+    ++m_Generations[aEntity.Index];
+    m_FreeIndices.push_back(aEntity.Index);
+    --m_NumAlive;
+}
+
+bool CEntityRegistry::IsAlive(sEntity aEntity) const
+{
+    return aEntity.Index < m_Generations.size() && m_Alive[aEntity.Index] && m_Generations[aEntity.Index] == aEntity.Generation;
+}
+
+void CEntityRegistry::Clear()
+{
+    for (const std::unique_ptr<IComponentArray>& pComponents : m_ComponentArrays)
+    {
+        if (pComponents)
+        {
+            pComponents->Clear();
+        }
+    }
+
+    // The generations are kept, handles of the destroyed entities must not become alive again.
+    m_FreeIndices.clear();
+    for (uint32 i = 0; i < m_Generations.size(); ++i)
+    {
+        if (m_Alive[i])
+        {
+            m_Alive[i] = false;
+            ++m_Generations[i];
+        }
+        m_FreeIndices.push_back(i);
+    }
+    m_NumAlive = 0;
+}
@@ -0,0 +1,263 @@
+#pragma once
+
+#include "defines.h"
+#include "job_system.hpp"
+
+#include <cassert>
+#include <memory>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Identifies an entity of a CEntityRegistry. Like sPoolHandle, once the entity is destroyed its index gets a new
+ * generation and the old handles are no longer alive.
+ */
+struct sEntity
+{
+    uint32 Index = UINT32_MAX;
+    uint32 Generation = 0;
+
+    bool IsValid() const { return Index != UINT32_MAX; }
+    bool operator==(const sEntity& aOther) const { return Index == aOther.Index && Generation == aOther.Generation; }
+    bool operator!=(const sEntity& aOther) const { return !(*this == aOther); }
+};
+
+const sEntity INVALID_ENTITY = {};
+
+namespace ecs
+{
+    uint32 NextComponentTypeID();
+
+    /**
+     * @brief Index of the component array of T in the registries, assigned the first time it is asked for.
+     */
+    template<class T>
+    uint32 GetComponentTypeID()
+    {
+        static const uint32 TypeID = NextComponentTypeID();
+        return TypeID;
+    }
+}
+
+class IComponentArray
+{
+public:
+    virtual ~IComponentArray() = default;
+    virtual void Remove(sEntity aEntity) = 0;
+    virtual void Clear() = 0;
+};
+
+/**
+ * @brief Sparse set of the components of type T. The components are packed in a contiguous array, in the order they were
+ * added, and removing one moves the last component into its place. The sparse array maps entity indices to positions in it.
+ */
+template<class T>
+class CComponentArray : public IComponentArray
+{
+public:
+    template<class... Args>
+    T& Add(sEntity aEntity, Args&&... aArgs)
+    {
+        assert(!Has(aEntity));
+        if (aEntity.Index >= m_Sparse.size())
+        {
+            m_Sparse.resize(aEntity.Index + 1, UINT32_MAX);
+        }
+
+        m_Sparse[aEntity.Index] = static_cast<uint32>(m_Components.size());
+        m_Entities.push_back(aEntity);
+        m_Components.push_back(T{ std::forward<Args>(aArgs)... });
+        return m_Components.back();
+    }
+
+    void Remove(sEntity aEntity) override
+    {
+        if (!Has(aEntity))
+        {
+            return;
+        }
+
+        const uint32 Position = m_Sparse[aEntity.Index];
+        const uint32 Last = static_cast<uint32>(m_Components.size()) - 1;
+        if (Position != Last)
+        {
+            m_Components[Position] = std::move(m_Components[Last]);
+            m_Entities[Position] = m_Entities[Last];
+            m_Sparse[m_Entities[Position].Index] = Position;
+        }
+
+        m_Components.pop_back();
+        m_Entities.pop_back();
+        m_Sparse[aEntity.Index] = UINT32_MAX;
+    }
+
+    void Clear() override
+    {
+        m_Sparse.clear();
+        m_Entities.clear();
+        m_Components.clear();
+    }
+
+    bool Has(sEntity aEntity) const
+    {
+        return aEntity.Index < m_Sparse.size() && m_Sparse[aEntity.Index] != UINT32_MAX && m_Entities[m_Sparse[aEntity.Index]] == aEntity;
+    }
+
+    /**
+     * @brief The component of aEntity, nullptr if it has none.
+     */
+    T* Get(sEntity aEntity) { return Has(aEntity) ? &m_Components[m_Sparse[aEntity.Index]] : nullptr; }
+    const T* Get(sEntity aEntity) const { return Has(aEntity) ? &m_Components[m_Sparse[aEntity.Index]] : nullptr; }
+
+    uint32 GetSize() const { return static_cast<uint32>(m_Components.size()); }
+    T* GetData() { return m_Components.data(); }
+    const T* GetData() const { return m_Components.data(); }
+    sEntity GetEntity(uint32 aPosition) const { return m_Entities[aPosition]; }
+
+private:
+    std::vector<uint32> m_Sparse;
+    std::vector<sEntity> m_Entities;
+    std::vector<T> m_Components;
+};
+
+/**
+ * @brief Owns the entities and their components. Components are plain structs stored in one CComponentArray per type,
+ * so systems iterate contiguous arrays instead of chasing pointers through objects.
+ *
+ * Not thread safe: entities and components are added and removed from a single thread. ParallelForEach() may write the
+ * components it visits, as long as every invocation only touches its own entity.
+ */
+class CEntityRegistry
+{
+public:
+    CEntityRegistry();
+    ~CEntityRegistry();
+
+    CEntityRegistry(const CEntityRegistry&) = delete;
+    CEntityRegistry& operator=(const CEntityRegistry&) = delete;
+
+    sEntity CreateEntity();
+
+    /**
+     * @brief Removes every component of aEntity and frees its index.
+     */
+    void DestroyEntity(sEntity aEntity);
+
+    bool IsAlive(sEntity aEntity) const;
+
+    /**
+     * @brief Destroys every entity.
+     */
+    void Clear();
+
+    uint32 GetNumEntities() const { return m_NumAlive; }
+
+    template<class T, class... Args>
+    T& AddComponent(sEntity aEntity, Args&&... aArgs)
+    {
+        assert(IsAlive(aEntity));
+        return GetComponents<T>().Add(aEntity, std::forward<Args>(aArgs)...);
+    }
+
+    template<class T>
+    void RemoveComponent(sEntity aEntity) { GetComponents<T>().Remove(aEntity); }
+
+    template<class T>
+    bool HasComponent(sEntity aEntity) const
+    {
+        const CComponentArray<T>* pComponents = FindComponents<T>();
+        return pComponents && pComponents->Has(aEntity);
+    }
+
+    template<class T>
+    T* GetComponent(sEntity aEntity) { return GetComponents<T>().Get(aEntity); }
+
+    template<class T>
+    const T* GetComponent(sEntity aEntity) const
+    {
+        const CComponentArray<T>* pComponents = FindComponents<T>();
+        return pComponents ? pComponents->Get(aEntity) : nullptr;
+    }
+
+    template<class T>
+    CComponentArray<T>& GetComponents()
+    {
+        const uint32 TypeID = ecs::GetComponentTypeID<T>();
+        if (TypeID >= m_ComponentArrays.size())
+        {
+            m_ComponentArrays.resize(TypeID + 1);
+        }
+        if (!m_ComponentArrays[TypeID])
+        {
+            m_ComponentArrays[TypeID] = std::make_unique<CComponentArray<T>>();
+        }
+        return static_cast<CComponentArray<T>&>(*m_ComponentArrays[TypeID]);
+    }
+
+    /**
+     * @brief Calls aFunction(sEntity, T&, Others&...) for every entity having all the components. The array of T is walked
+     * in order and the other components are looked up, so T should be the rarest of them.
+     */
+    template<class T, class... Others, class F>
+    void ForEach(F&& aFunction)
+    {
+        CComponentArray<T>& Components = GetComponents<T>();
+        const std::tuple<CComponentArray<Others>*...> OtherComponents(&GetComponents<Others>()...);
+        for (uint32 i = 0; i < Components.GetSize(); ++i)
+        {
+            Visit(Components, OtherComponents, i, aFunction, std::index_sequence_for<Others...>());
+        }
+    }
+
+    /**
+     * @brief Same as ForEach() but split in groups of aGroupSize components executed by the job system. Returns once all
+     * of them are done.
+     */
+    template<class T, class... Others, class F>
+    void ParallelForEach(F&& aFunction, uint32 aGroupSize = 1024)
+    {
+        CComponentArray<T>& Components = GetComponents<T>();
+        const std::tuple<CComponentArray<Others>*...> OtherComponents(&GetComponents<Others>()...);
+
+        sJobCounter Counter;
+        jobs::Dispatch(Counter, Components.GetSize(), aGroupSize, [&](uint32 aIndex)
+        {
+            Visit(Components, OtherComponents, aIndex, aFunction, std::index_sequence_for<Others...>());
+        });
+        jobs::Wait(Counter);
+    }
+
+private:
+    template<class T>
+    const CComponentArray<T>* FindComponents() const
+    {
+        const uint32 TypeID = ecs::GetComponentTypeID<T>();
+        return TypeID < m_ComponentArrays.size() ? static_cast<const CComponentArray<T>*>(m_ComponentArrays[TypeID].get()) : nullptr;
+    }
+
+    template<class T, class Tuple, class F, size_t... Indices>
+    static void Visit(CComponentArray<T>& aComponents, const Tuple& aOtherComponents, uint32 aPosition, F& aFunction, std::index_sequence<Indices...>)
+    {
+        const sEntity Entity = aComponents.GetEntity(aPosition);
+        const std::tuple<decltype(std::get<Indices>(aOtherComponents)->Get(Entity))...> Others(std::get<Indices>(aOtherComponents)->Get(Entity)...);
+
+        bool bHasAll = true;
+        const bool bFound[] = { true, (std::get<Indices>(Others) != nullptr)... };
+        for (const bool bHas : bFound)
+        {
+            bHasAll &= bHas;
+        }
+
+        if (bHasAll)
+        {
+            aFunction(Entity, aComponents.GetData()[aPosition], *std::get<Indices>(Others)...);
+        }
+    }
+
+    std::vector<std::unique_ptr<IComponentArray>> m_ComponentArrays;
+    std::vector<uint32> m_Generations;
+    std::vector<bool> m_Alive;
+    std::vector<uint32> m_FreeIndices;
+    uint32 m_NumAlive;
+};
@@ -0,0 +1,179 @@
+#include "job_system.hpp"
+#include "logger.h"
+#include "profiler.hpp"
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace
+{
+    struct sJob
+    {
+        std::function<void()> Function;
+        sJobCounter* pCounter;
+    };
+
+    struct sJobSystemData
+    {
+        std::vector<std::thread> Workers;
+        std::deque<sJob> Queue;
+        std::mutex QueueMutex;
+        std::condition_variable WakeCondition;
+        bool bRunning = false;
+    } JobSystem;
+
+    bool PopJob(sJob& aOutJob)
+    {
+        std::lock_guard<std::mutex> Lock(JobSystem.QueueMutex);
+        if (JobSystem.Queue.empty())
+        {
+            return false;
+        }
+
+        aOutJob = std::move(JobSystem.Queue.front());
+        JobSystem.Queue.pop_front();
+        return true;
+    }
+
+    void RunJob(sJob& aJob)
+    {
+        aJob.Function();
+        aJob.pCounter->Pending.fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    void WorkerLoop()
+    {
+        profiler::SetThreadName("Job Worker");
+
+        while (true)
+        {
+            sJob Job;
+            {
+                std::unique_lock<std::mutex> Lock(JobSystem.QueueMutex);
+                JobSystem.WakeCondition.wait(Lock, [] { return !JobSystem.bRunning || !JobSystem.Queue.empty(); });
+
+                if (JobSystem.Queue.empty())
+                {
+                    // Not running anymore and nothing left to do.
+                    return;
+                }
+
+                Job = std::move(JobSystem.Queue.front());
+                JobSystem.Queue.pop_front();
+            }
+
+            RunJob(Job);
+        }
+    }
+}
+
+namespace jobs
+{
+    void Initialize(uint32 aNumWorkers)
+    {
+        if (JobSystem.bRunning)
+        {
+            SGSWARN("Job system already initialized!");
+            return;
+        }
+
+        if (aNumWorkers == 0)
+        {
+            const uint32 HardwareThreads = std::thread::hardware_concurrency();
+            aNumWorkers = std::max(1u, HardwareThreads > 1 ? HardwareThreads - 1 : 1u);
+        }
+
+        JobSystem.bRunning = true;
+        JobSystem.Workers.reserve(aNumWorkers);
+        for (uint32 i = 0; i < aNumWorkers; ++i)
+        {
+            JobSystem.Workers.emplace_back(WorkerLoop);
+        }
+
+        SGSINFO("Job system initialized with %u worker threads.", aNumWorkers);
+    }
+
+    void Shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> Lock(JobSystem.QueueMutex);
+            JobSystem.bRunning = false;
+        }
+        JobSystem.WakeCondition.notify_all();
+
+        for (std::thread& Worker : JobSystem.Workers)
+        {
+            Worker.join();
+        }
+        JobSystem.Workers.clear();
+    }
+
+    uint32 GetNumThreads()
+    {
+        return static_cast<uint32>(JobSystem.Workers.size()) + 1;
+    }
+
+    void Execute(sJobCounter& aCounter, std::function<void()>&& aJob)
+    {
+        aCounter.Pending.fetch_add(1, std::memory_order_relaxed);
+
+        // Without workers the job is run right away on the calling thread.
+        if (JobSystem.Workers.empty())
+        {
+            sJob Job{std::move(aJob), &aCounter};
+            RunJob(Job);
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> Lock(JobSystem.QueueMutex);
+            JobSystem.Queue.push_back({std::move(aJob), &aCounter});
+        }
+        JobSystem.WakeCondition.notify_one();
+    }
+
+    void Dispatch(sJobCounter& aCounter, uint32 aJobCount, uint32 aGroupSize, const std::function<void(uint32 aIndex)>& aJob)
+    {
+        if (aJobCount == 0)
+        {
+            return;
+        }
+
+        aGroupSize = std::max(1u, aGroupSize);
+
+        // Shared between all the groups, so the caller does not need to keep aJob alive.
+        auto pJob = std::make_shared<std::function<void(uint32)>>(aJob);
+        for (uint32 GroupStart = 0; GroupStart < aJobCount; GroupStart += aGroupSize)
+        {
+            const uint32 GroupEnd = std::min(GroupStart + aGroupSize, aJobCount);
+            Execute(aCounter, [pJob, GroupStart, GroupEnd]
+            {
+                for (uint32 i = GroupStart; i < GroupEnd; ++i)
+                {
+                    (*pJob)(i);
+                }
+            });
+        }
+    }
+
+    void Wait(sJobCounter& aCounter)
+    {
+        while (aCounter.Pending.load(std::memory_order_acquire) > 0)
+        {
+            sJob Job;
+            if (PopJob(Job))
+            {
+                RunJob(Job);
+            }
+            else
+            {
+                std::this_thread::yield();
+            }
+        }
+    }
+}
@@ -0,0 +1,53 @@
+#pragma once
+
+#include "defines.h"
+
+#include <atomic>
+#include <functional>
+
+/**
+ * @brief Tracks a group of jobs so the caller can wait until all of them have finished.
+ */
+struct sJobCounter
+{
+    std::atomic<uint32> Pending{0};
+};
+
+/**
+ * @brief Small fixed-size thread pool. Jobs are plain functions executed by the worker threads.
+ * Waiting on a counter keeps executing queued jobs on the calling thread, so jobs can safely
+ * launch and wait for other jobs (nested dispatches do not deadlock).
+ */
+namespace jobs
+{
+    /**
+     * @brief Spawns the worker threads. Passing 0 uses the number of hardware threads minus one.
+     */
+    void Initialize(uint32 aNumWorkers = 0);
+
+    /**
+     * @brief Waits for all the queued jobs and joins the worker threads.
+     */
+    void Shutdown();
+
+    /**
+     * @brief Number of threads that can execute jobs, including the calling thread.
+     */
+    uint32 GetNumThreads();
+
+    /**
+     * @brief Queues a single job.
+     */
+    void Execute(sJobCounter& aCounter, std::function<void()>&& aJob);
+
+    /**
+     * @brief Splits aJobCount invocations of aJob in groups of aGroupSize and queues one job per group.
+     * aJob receives the invocation index.
+     */
+    void Dispatch(sJobCounter& aCounter, uint32 aJobCount, uint32 aGroupSize, const std::function<void(uint32 aIndex)>& aJob);
+
+    /**
+     * @brief Blocks until every job tracked by aCounter has finished, helping with the queued work meanwhile.
+     */
+    void Wait(sJobCounter& aCounter);
+}
@@ -0,0 +1,108 @@
+#include "linear_allocator.hpp"
+#include "logger.h"
+
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    size_t AlignUp(size_t aValue, size_t aAlignment)
+    {
+        return (aValue + aAlignment - 1) & ~(aAlignment - 1);
+    }
+}
+
+CLinearAllocator::CLinearAllocator() :
+    m_pMemory(nullptr),
+    m_Capacity(0),
+    m_Offset(0),
+    m_OverflowBytes(0)
+{
+}
+
+CLinearAllocator::~CLinearAllocator()
+{
+    Shutdown();
+}
+
+void CLinearAllocator::Initialize(size_t aCapacity)
+{
+    assert(m_pMemory == nullptr);
+
+    m_Capacity = aCapacity;
+    m_Offset = 0;
+    // malloc aligns to max_align_t, bigger alignments are handled by aligning the offset.
+    m_pMemory = static_cast<uint8*>(std::malloc(m_Capacity));
+    if (m_pMemory == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+}
+
+void CLinearAllocator::Shutdown()
+{
+    FreeOverflow();
+
+    std::free(m_pMemory);
+    m_pMemory = nullptr;
+    m_Capacity = 0;
+    m_Offset = 0;
+}
+
+void* CLinearAllocator::Allocate(size_t aSize, size_t aAlignment)
+{
+    assert(aAlignment > 0 && (aAlignment & (aAlignment - 1)) == 0);
+
+    const uintptr_t Base = reinterpret_cast<uintptr_t>(m_pMemory);
+    const size_t Offset = AlignUp(Base + m_Offset, aAlignment) - Base;
+    if (m_pMemory == nullptr || Offset + aSize > m_Capacity)
+    {
+        return AllocateOverflow(aSize, aAlignment);
+    }
+
+    m_Offset = Offset + aSize;
+    return m_pMemory + Offset;
+}
+
+void CLinearAllocator::Reset()
+{
+    if (!m_OverflowBlocks.empty())
+    {
+        // Nothing is alive, the arena can be replaced by one that fits the peak usage.
+        const size_t NewCapacity = AlignUp(GetUsedBytes() + GetUsedBytes() / 2, 4096);
+        SGSWARN("Linear allocator overflowed (%zu of %zu bytes used), growing it to %zu bytes.", GetUsedBytes(), m_Capacity, NewCapacity);
+
+        Shutdown();
+        Initialize(NewCapacity);
+    }
+
+    m_Offset = 0;
+}
+
+void* CLinearAllocator::AllocateOverflow(size_t aSize, size_t aAlignment)
+{
+    // Over allocate so the block can be aligned, the original pointer is kept to free it.
+    const size_t BlockSize = aSize + aAlignment;
+    void* pBlock = std::malloc(BlockSize);
+    if (pBlock == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+
+    m_OverflowBlocks.push_back(pBlock);
+    m_OverflowBytes += BlockSize;
+
+    return reinterpret_cast<void*>(AlignUp(reinterpret_cast<uintptr_t>(pBlock), aAlignment));
+}
+
+void CLinearAllocator::FreeOverflow()
+{
+    for (void* pBlock : m_OverflowBlocks)
+    {
+        std::free(pBlock);
+    }
+    m_OverflowBlocks.clear();
+    m_OverflowBytes = 0;
+}
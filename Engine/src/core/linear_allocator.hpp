@@ -0,0 +1,97 @@
+#pragma once
+
+#include "defines.h"
+
+#include <cstddef>
+#include <vector>
+
+// Size of each per frame allocator (see sFrameData). It grows when a frame needs more, this only avoids the first
+// frames overflowing. Can be overridden at build time (/DSGS_FRAME_ALLOCATOR_SIZE=...).
+#ifndef SGS_FRAME_ALLOCATOR_SIZE
+#define SGS_FRAME_ALLOCATOR_SIZE (1024 * 1024)
+#endif
+
+/**
+ * @brief Arena for short lived data. Allocating bumps an offset and freeing does nothing, every allocation is
+ * released at once by Reset(). Not thread safe, each thread needs its own.
+ *
+ * When the arena is full the allocations fall back to the heap and the next Reset() grows the arena to the peak
+ * usage, so after a few frames the heap is not touched anymore.
+ */
+class CLinearAllocator
+{
+public:
+    CLinearAllocator();
+    ~CLinearAllocator();
+
+    CLinearAllocator(const CLinearAllocator&) = delete;
+    CLinearAllocator& operator=(const CLinearAllocator&) = delete;
+
+    void Initialize(size_t aCapacity);
+    void Shutdown();
+
+    /**
+     * @brief Returns aSize bytes aligned to aAlignment (a power of two). Never returns nullptr.
+     */
+    void* Allocate(size_t aSize, size_t aAlignment = alignof(std::max_align_t));
+
+    template<class T>
+    T* AllocateArray(size_t aCount)
+    {
+        return static_cast<T*>(Allocate(aCount * sizeof(T), alignof(T)));
+    }
+
+    /**
+     * @brief Releases every allocation. Nothing allocated since the last Reset() can be in use anymore.
+     */
+    void Reset();
+
+    size_t GetCapacity() const { return m_Capacity; }
+    size_t GetUsedBytes() const { return m_Offset + m_OverflowBytes; }
+
+private:
+    void* AllocateOverflow(size_t aSize, size_t aAlignment);
+    void FreeOverflow();
+
+    uint8* m_pMemory;
+    size_t m_Capacity;
+    size_t m_Offset;
+
+    // Heap blocks allocated once the arena was full, freed by Reset().
+    std::vector<void*> m_OverflowBlocks;
+    size_t m_OverflowBytes;
+};
+
+/**
+ * @brief STL allocator on top of a CLinearAllocator, e.g. LinearVector<uint32_t> Indices(CLinearAllocatorAdapter<uint32_t>(Allocator)).
+ * deallocate() does nothing, so containers that grow leave their old storage behind until the arena is reset:
+ * reserve() them when the size is known.
+ */
+template<class T>
+class CLinearAllocatorAdapter
+{
+public:
+    using value_type = T;
+
+    CLinearAllocatorAdapter(CLinearAllocator& aAllocator) noexcept : m_pAllocator(&aAllocator) {}
+
+    template<class U>
+    CLinearAllocatorAdapter(const CLinearAllocatorAdapter<U>& aOther) noexcept : m_pAllocator(aOther.m_pAllocator) {}
+
+    T* allocate(size_t aCount) { return m_pAllocator->AllocateArray<T>(aCount); }
+    void deallocate(T*, size_t) noexcept {}
+
+    template<class U>
+    bool operator==(const CLinearAllocatorAdapter<U>& aOther) const noexcept { return m_pAllocator == aOther.m_pAllocator; }
+    template<class U>
+    bool operator!=(const CLinearAllocatorAdapter<U>& aOther) const noexcept { return m_pAllocator != aOther.m_pAllocator; }
+
+private:
+    template<class U>
+    friend class CLinearAllocatorAdapter;
+
+    CLinearAllocator* m_pAllocator;
+};
+
+template<class T>
+using LinearVector = std::vector<T, CLinearAllocatorAdapter<T>>;
@@ -2,8 +2,228 @@
 #include "logger.h"
 #include "assertions.h"
 
+#include <chrono>
+#include <condition_variable>
+#include <cstdarg>
+#include <cstring>
+#include <fstream>
+#include <mutex>
+#include <thread>
+
+#ifdef _WIN32
 #include <windows.h>
-    
+#else
+#include <unistd.h>
+#endif
+
+// Number of messages the ring holds, must be a power of two.
+// Can be overridden at build time.
+#ifndef SGS_LOG_RING_SIZE
+#define SGS_LOG_RING_SIZE 1024
+#endif
+
+// Longer messages are truncated.
+#ifndef SGS_LOG_MESSAGE_SIZE
+#define SGS_LOG_MESSAGE_SIZE 1024
+#endif
+
+static_assert((SGS_LOG_RING_SIZE & (SGS_LOG_RING_SIZE - 1)) == 0, "SGS_LOG_RING_SIZE must be a power of two.");
+
+namespace
+{
+    const char* const LevelStrings[6] = { "[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: " };
+
+    // Time the writer sleeps when there is nothing to write. Errors wake it up right away.
+    constexpr std::chrono::milliseconds WRITER_IDLE_TIME(5);
+
+    struct sLogRecord
+    {
+        // Position the record can be written at (Sequence == position) or read at (Sequence == position + 1).
+        std::atomic<uint64> Sequence;
+        e_logLevel Level;
+        char Message[SGS_LOG_MESSAGE_SIZE];
+    };
+
+    // Bounded multi-producer single-consumer ring. Producers claim a position with a CAS and publish the record
+    // with its sequence, so they never wait for each other nor for the writer.
+    struct sLogger
+    {
+        sLogRecord Records[SGS_LOG_RING_SIZE];
+        alignas(64) std::atomic<uint64> EnqueuePos;
+        alignas(64) std::atomic<uint64> DequeuePos;
+        std::atomic<uint64> NumDropped;
+        // Producers that may be between their check of bRunning and the publication of their record. Shutdown()
+        // waits for them before the last drain, so no message is enqueued after it.
+        std::atomic<uint32> NumProducers;
+
+        std::thread Writer;
+        std::atomic<bool> bRunning;
+        std::atomic<bool> bStop;
+        std::mutex WakeMutex;
+        std::condition_variable WakeCondition;
+
+        // Serializes the output of the writer thread with the messages written right away.
+        std::mutex OutputMutex;
+        std::ofstream File;
+        bool bColoredOutput[2];
+    };
+
+    sLogger& GetLogger()
+    {
+        static sLogger* pLogger = []()
+        {
+            // Leaked on purpose, messages can be logged from static destructors.
+            sLogger* pNewLogger = new sLogger();
+            for (uint64 i = 0; i < SGS_LOG_RING_SIZE; ++i)
+            {
+                pNewLogger->Records[i].Sequence.store(i, std::memory_order_relaxed);
+            }
+            pNewLogger->EnqueuePos.store(0, std::memory_order_relaxed);
+            pNewLogger->DequeuePos.store(0, std::memory_order_relaxed);
+            pNewLogger->NumDropped.store(0, std::memory_order_relaxed);
+            pNewLogger->NumProducers.store(0, std::memory_order_relaxed);
+            pNewLogger->bRunning.store(false, std::memory_order_relaxed);
+            pNewLogger->bStop.store(false, std::memory_order_relaxed);
+            pNewLogger->bColoredOutput[0] = false;
+            pNewLogger->bColoredOutput[1] = false;
+#ifndef _WIN32
+            pNewLogger->bColoredOutput[0] = isatty(fileno(stdout)) != 0;
+            pNewLogger->bColoredOutput[1] = isatty(fileno(stderr)) != 0;
+#endif
+            return pNewLogger;
+        }();
+        return *pLogger;
+    }
+
+    // OutputMutex must be held.
+    void WriteMessage(sLogger& aLogger, e_logLevel aLevel, const char* apMessage)
+    {
+        const bool bIsError = aLevel < LOG_LEVEL_WARN;
+
+#ifdef _WIN32
+        char OutputMessage[SGS_LOG_MESSAGE_SIZE + 16];
+        snprintf(OutputMessage, sizeof(OutputMessage), "%s%s\n", LevelStrings[aLevel], apMessage);
+
+        HANDLE ConsoleHandle = GetStdHandle(bIsError ? STD_ERROR_HANDLE : STD_OUTPUT_HANDLE);
+        static uint8 Colors[6] = { 64, 4, 6, 2, 1, 8 };
+        SetConsoleTextAttribute(ConsoleHandle, Colors[aLevel]);
+        OutputDebugStringA(OutputMessage);
+        DWORD NumWritten = 0;
+        WriteConsoleA(ConsoleHandle, OutputMessage, (DWORD)strlen(OutputMessage), &NumWritten, 0);
+#else
+        static const char* const Colors[6] = { "\033[41m", "\033[31m", "\033[33m", "\033[32m", "\033[34m", "\033[90m" };
+        FILE* pStream = bIsError ? stderr : stdout;
+        if (aLogger.bColoredOutput[bIsError ? 1 : 0])
+        {
+            fprintf(pStream, "%s%s%s\033[0m\n", Colors[aLevel], LevelStrings[aLevel], apMessage);
+        }
+        else
+        {
+            fprintf(pStream, "%s%s\n", LevelStrings[aLevel], apMessage);
+        }
+#endif
+
+        if (aLogger.File.is_open())
+        {
+            aLogger.File << LevelStrings[aLevel] << apMessage << '\n';
+        }
+    }
+
+    bool Enqueue(sLogger& aLogger, e_logLevel aLevel, const char* apFormat, va_list aArgs)
+    {
+        uint64 Pos = aLogger.EnqueuePos.load(std::memory_order_relaxed);
+        sLogRecord* pRecord = nullptr;
+        for (;;)
+        {
+            pRecord = &aLogger.Records[Pos & (SGS_LOG_RING_SIZE - 1)];
+            const uint64 Sequence = pRecord->Sequence.load(std::memory_order_acquire);
+            const int64 Difference = static_cast<int64>(Sequence) - static_cast<int64>(Pos);
+            if (Difference == 0)
+            {
+                if (aLogger.EnqueuePos.compare_exchange_weak(Pos, Pos + 1, std::memory_order_relaxed))
+                {
+                    break;
+                }
+            }
+            else if (Difference < 0)
+            {
+                // Full, the writer is behind.
+                aLogger.NumDropped.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                Pos = aLogger.EnqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        pRecord->Level = aLevel;
+        vsnprintf(pRecord->Message, SGS_LOG_MESSAGE_SIZE, apFormat, aArgs);
+        pRecord->Sequence.store(Pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Only called from the writer thread, or from Shutdown() once it is joined.
+    bool WriteQueued(sLogger& aLogger)
+    {
+        bool bWroteAny = false;
+        uint64 Pos = aLogger.DequeuePos.load(std::memory_order_relaxed);
+
+        std::lock_guard<std::mutex> Lock(aLogger.OutputMutex);
+        for (;;)
+        {
+            sLogRecord& Record = aLogger.Records[Pos & (SGS_LOG_RING_SIZE - 1)];
+            if (Record.Sequence.load(std::memory_order_acquire) != Pos + 1)
+            {
+                break;
+            }
+
+            WriteMessage(aLogger, Record.Level, Record.Message);
+            Record.Sequence.store(Pos + SGS_LOG_RING_SIZE, std::memory_order_release);
+            ++Pos;
+            aLogger.DequeuePos.store(Pos, std::memory_order_release);
+            bWroteAny = true;
+        }
+
+        const uint64 NumDropped = aLogger.NumDropped.exchange(0, std::memory_order_relaxed);
+        if (NumDropped > 0)
+        {
+            char Message[64];
+            snprintf(Message, sizeof(Message), "%llu log messages were dropped.", static_cast<unsigned long long>(NumDropped));
+            WriteMessage(aLogger, LOG_LEVEL_WARN, Message);
+        }
+
+        if (bWroteAny || NumDropped > 0)
+        {
+            fflush(stdout);
+            if (aLogger.File.is_open())
+            {
+                aLogger.File.flush();
+            }
+        }
+        return bWroteAny;
+    }
+
+    void WriterLoop(sLogger& aLogger)
+    {
+        for (;;)
+        {
+            const bool bStop = aLogger.bStop.load(std::memory_order_acquire);
+            if (WriteQueued(aLogger))
+            {
+                continue;
+            }
+            else if (bStop)
+            {
+                return;
+            }
+
+            std::unique_lock<std::mutex> Lock(aLogger.WakeMutex);
+            aLogger.WakeCondition.wait_for(Lock, WRITER_IDLE_TIME);
+        }
+    }
+}
+
 void report_assertion_failure(const char* expression, const char* message, const char* file, int32 line)
 {
     logOutput(LOG_LEVEL_FATAL, "Assertion failure: %s, message '%s', in file %s, line: %d\n", expression, message, file, line);
@@ -11,38 +231,126 @@ void report_assertion_failure(const char* expression, const char* message, const
 
 void logOutput(e_logLevel level, const char* message, ...)
 {
-    const char* levelString[6] = { "[FATAL]: ", "[ERROR]: ", "[WARN]: ", "[INFO]: ", "[DEBUG]: ", "[TRACE]: " };
-    bool isError = level < LOG_LEVEL_WARN;
+    sLogger& Logger = GetLogger();
 
-    const int32 msgLength = 32000;
-    char outMessage[msgLength];
-    char outputMessage[msgLength];
-    memset(outMessage, 0, sizeof(outMessage));
+    // Sequentially consistent with the exchange of bRunning in Shutdown(): either this message sees the writer stopped
+    // and is written right away, or Shutdown() sees it in flight and waits for it.
+    Logger.NumProducers.fetch_add(1);
+    if (level != LOG_LEVEL_FATAL && Logger.bRunning.load())
+    {
+        va_list argPtr;
+        va_start(argPtr, message);
+        const bool bQueued = Enqueue(Logger, level, message, argPtr);
+        va_end(argPtr);
+        Logger.NumProducers.fetch_sub(1, std::memory_order_release);
 
+        if (level == LOG_LEVEL_ERROR)
+        {
+            Logger.WakeCondition.notify_one();
+        }
+
+        // Errors are never dropped, they are written right away when the ring is full.
+        if (bQueued || level != LOG_LEVEL_ERROR)
+        {
+            return;
+        }
+    }
+    else
+    {
+        Logger.NumProducers.fetch_sub(1, std::memory_order_release);
+    }
+
+    // Fatal messages usually precede a crash or a debug break, everything queued before them is written first.
+    if (level == LOG_LEVEL_FATAL && Logger.bRunning.load(std::memory_order_acquire))
+    {
+        logging::Flush();
+    }
+
+    char outMessage[SGS_LOG_MESSAGE_SIZE];
     va_list argPtr;
     va_start(argPtr, message);
-    vsnprintf(outMessage, msgLength, message, argPtr);
+    vsnprintf(outMessage, SGS_LOG_MESSAGE_SIZE, message, argPtr);
     va_end(argPtr);
 
-    sprintf_s(outputMessage, "%s%s\n", levelString[level], outMessage);
+    std::lock_guard<std::mutex> Lock(Logger.OutputMutex);
+    WriteMessage(Logger, level, outMessage);
+    fflush(stdout);
+    if (Logger.File.is_open())
+    {
+        Logger.File.flush();
+    }
+}
+
+bool logShouldEmit(std::atomic<int64>& aLastTime, int64 aIntervalMs)
+{
+    const int64 Now = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+    int64 LastTime = aLastTime.load(std::memory_order_relaxed);
+    if (Now < LastTime + aIntervalMs)
+    {
+        return false;
+    }
+
+    // Only one of the threads racing for the same call site logs.
+    return aLastTime.compare_exchange_strong(LastTime, Now, std::memory_order_relaxed);
+}
 
-    if (isError)
+void logging::Initialize(const char* apFilePath)
+{
+    sLogger& Logger = GetLogger();
+    if (Logger.bRunning.load(std::memory_order_acquire))
     {
-        HANDLE consoleHandle = GetStdHandle(STD_ERROR_HANDLE);
-        static uint8 levels[6] = { 64, 4, 6, 2, 1, 8 };
-        SetConsoleTextAttribute(consoleHandle, levels[level]);
-        OutputDebugStringA(outputMessage);
-        uint64 length = strlen(outputMessage);
-        LPDWORD number_written = 0;
-        WriteConsoleA(GetStdHandle(STD_ERROR_HANDLE), outputMessage, (DWORD)length, number_written, 0);
+        return;
     }
-    else {
-        HANDLE console_handle = GetStdHandle(STD_OUTPUT_HANDLE);
-        static uint8 levels[6] = { 64, 4, 6, 2, 1, 8 };
-        SetConsoleTextAttribute(console_handle, levels[level]);
-        OutputDebugStringA(outputMessage);
-        uint64 length = strlen(outputMessage);
-        LPDWORD number_written = 0;
-        WriteConsoleA(GetStdHandle(STD_OUTPUT_HANDLE), outputMessage, (DWORD)length, number_written, 0);
+
+    if (apFilePath)
+    {
+        std::lock_guard<std::mutex> Lock(Logger.OutputMutex);
+        Logger.File.open(apFilePath, std::ios::trunc);
+        if (!Logger.File.is_open())
+        {
+            WriteMessage(Logger, LOG_LEVEL_WARN, "Could not open the log file.");
+        }
     }
-}
\ No newline at end of file
+
+    Logger.bStop.store(false, std::memory_order_release);
+    Logger.Writer = std::thread(WriterLoop, std::ref(Logger));
+    Logger.bRunning.store(true, std::memory_order_release);
+}
+
+void logging::Shutdown()
+{
+    sLogger& Logger = GetLogger();
+    if (!Logger.bRunning.exchange(false))
+    {
+        return;
+    }
+
+    // Messages logged from now on are written right away. The ones of threads that saw the writer running are
+    // published before it is told to stop, it drains the ring before leaving.
+    while (Logger.NumProducers.load(std::memory_order_acquire) != 0)
+    {
+        std::this_thread::yield();
+    }
+
+    Logger.bStop.store(true, std::memory_order_release);
+    Logger.WakeCondition.notify_one();
+    Logger.Writer.join();
+    WriteQueued(Logger);
+
+    std::lock_guard<std::mutex> Lock(Logger.OutputMutex);
+    if (Logger.File.is_open())
+    {
+        Logger.File.close();
+    }
+}
+
+void logging::Flush()
+{
+    sLogger& Logger = GetLogger();
+    const uint64 Target = Logger.EnqueuePos.load(std::memory_order_acquire);
+    while (Logger.bRunning.load(std::memory_order_acquire) && Logger.DequeuePos.load(std::memory_order_acquire) < Target)
+    {
+        Logger.WakeCondition.notify_one();
+        std::this_thread::yield();
+    }
+}
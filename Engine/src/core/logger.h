@@ -1,9 +1,20 @@
 #pragma once
 
-#define LOG_WARN_ENABLED 1
-#define LOG_INFO_ENABLED 1
-#define LOG_DEBUG_ENABLED 1
-#define LOG_TRACE_ENABLED 1
+#include "defines.h"
+
+#include <atomic>
+#include <cstdint>
+
+// Messages above this level are compiled out (0 = FATAL ... 5 = TRACE).
+// Can be overridden at build time (e.g. /DSGS_LOG_LEVEL=3 keeps up to INFO).
+#ifndef SGS_LOG_LEVEL
+#define SGS_LOG_LEVEL 5
+#endif
+
+#define LOG_WARN_ENABLED (SGS_LOG_LEVEL >= 2)
+#define LOG_INFO_ENABLED (SGS_LOG_LEVEL >= 3)
+#define LOG_DEBUG_ENABLED (SGS_LOG_LEVEL >= 4)
+#define LOG_TRACE_ENABLED (SGS_LOG_LEVEL >= 5)
 
 typedef enum e_logLevel {
     LOG_LEVEL_FATAL = 0,
@@ -14,8 +25,40 @@ typedef enum e_logLevel {
     LOG_LEVEL_TRACE = 5
 }e_logLevel;
 
+/**
+ * @brief Formats the message and queues it for the writer thread, the caller never waits for the output.
+ * Fatal messages, and every message logged while the writer thread is not running, are written right away.
+ */
 void logOutput(e_logLevel level, const char* message, ...);
 
+/**
+ * @brief True at most once every aIntervalMs for the same aLastTime, used by the throttled macros.
+ */
+bool logShouldEmit(std::atomic<int64>& aLastTime, int64 aIntervalMs);
+
+/**
+ * @brief The writer thread of the logger. Messages are formatted by the calling thread into a lock-free ring, and
+ * written to stdout (and a file, if given) by a background thread. When the ring is full, messages are dropped and
+ * their count reported, logging never blocks.
+ */
+namespace logging
+{
+    /**
+     * @brief Starts the writer thread. apFilePath, if not null, receives a copy of the output.
+     */
+    void Initialize(const char* apFilePath = nullptr);
+
+    /**
+     * @brief Writes the queued messages and joins the writer thread.
+     */
+    void Shutdown();
+
+    /**
+     * @brief Blocks until every message queued so far is written.
+     */
+    void Flush();
+}
+
 #define SGSFATAL(message, ...) logOutput(LOG_LEVEL_FATAL, message, ##__VA_ARGS__);
 
 #ifndef SGSERROR
@@ -44,4 +87,31 @@ void logOutput(e_logLevel level, const char* message, ...);
 #define SGSTRACE(message, ...) logOutput(LOG_LEVEL_TRACE, message, ##__VA_ARGS__);
 #else
 #define SGSTRACE(message, ...)
-#endif
\ No newline at end of file
+#endif
+
+// Logs from a call site at most once every intervalMs, for hot paths (per frame, per upload...).
+#define SGS_LOG_THROTTLED(level, intervalMs, message, ...)                              \
+    {                                                                                   \
+        static std::atomic<int64> sgsLastLogTime(INT64_MIN);                            \
+        if (logShouldEmit(sgsLastLogTime, intervalMs)) {                                \
+            logOutput(level, message, ##__VA_ARGS__);                                   \
+        }                                                                               \
+    }
+
+#if LOG_WARN_ENABLED == 1
+#define SGSWARN_THROTTLED(intervalMs, message, ...) SGS_LOG_THROTTLED(LOG_LEVEL_WARN, intervalMs, message, ##__VA_ARGS__)
+#else
+#define SGSWARN_THROTTLED(intervalMs, message, ...)
+#endif
+
+#if LOG_INFO_ENABLED == 1
+#define SGSINFO_THROTTLED(intervalMs, message, ...) SGS_LOG_THROTTLED(LOG_LEVEL_INFO, intervalMs, message, ##__VA_ARGS__)
+#else
+#define SGSINFO_THROTTLED(intervalMs, message, ...)
+#endif
+
+#if LOG_DEBUG_ENABLED == 1
+#define SGSDEBUG_THROTTLED(intervalMs, message, ...) SGS_LOG_THROTTLED(LOG_LEVEL_DEBUG, intervalMs, message, ##__VA_ARGS__)
+#else
+#define SGSDEBUG_THROTTLED(intervalMs, message, ...)
+#endif
@@ -0,0 +1,195 @@
+#pragma once
+
+#include "defines.h"
+
+#include <cassert>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Reference to an object of a CPool. Unlike a pointer it can be checked: once the object is destroyed the
+ * slot gets a new generation and CPool::Get() returns nullptr for the old handles.
+ */
+struct sPoolHandle
+{
+    uint32 Index = UINT32_MAX;
+    uint32 Generation = 0;
+
+    bool IsValid() const { return Index != UINT32_MAX; }
+    bool operator==(const sPoolHandle& aOther) const { return Index == aOther.Index && Generation == aOther.Generation; }
+    bool operator!=(const sPoolHandle& aOther) const { return !(*this == aOther); }
+};
+
+/**
+ * @brief Slab allocator for objects of type T. Objects are stored in slabs of SlabSize slots, so objects created
+ * together are contiguous in memory, their addresses never change, and destroying the pool frees every slab at once.
+ * Freed slots are reused by the next Create(). Not thread safe.
+ */
+template<class T, uint32 SlabSize = 256>
+class CPool
+{
+public:
+    CPool() : m_FirstFree(UINT32_MAX), m_NumAlive(0) {}
+    ~CPool() { Clear(); }
+
+    CPool(const CPool&) = delete;
+    CPool& operator=(const CPool&) = delete;
+
+    CPool(CPool&& aOther) noexcept :
+        m_Slabs(std::move(aOther.m_Slabs)),
+        m_NumSlots(aOther.m_NumSlots),
+        m_FirstFree(aOther.m_FirstFree),
+        m_NumAlive(aOther.m_NumAlive)
+    {
+        aOther.Reset();
+    }
+
+    CPool& operator=(CPool&& aOther) noexcept
+    {
+        if (this != &aOther)
+        {
+            Clear();
+            m_Slabs = std::move(aOther.m_Slabs);
+            m_NumSlots = aOther.m_NumSlots;
+            m_FirstFree = aOther.m_FirstFree;
+            m_NumAlive = aOther.m_NumAlive;
+            aOther.Reset();
+        }
+        return *this;
+    }
+
+    template<class... Args>
+    T* Create(Args&&... aArgs)
+    {
+        if (m_FirstFree == UINT32_MAX)
+        {
+            AddSlab();
+        }
+
+        sSlot& Slot = GetSlot(m_FirstFree);
+        m_FirstFree = Slot.NextFree;
+
+        T* pObject = new (Slot.Storage) T(std::forward<Args>(aArgs)...);
+        Slot.bAlive = true;
+        ++m_NumAlive;
+        return pObject;
+    }
+
+    void Destroy(T* apObject)
+    {
+        if (apObject == nullptr)
+        {
+            return;
+        }
+
+        sSlot& Slot = GetSlot(apObject);
+        assert(Slot.bAlive);
+
+        apObject->~T();
+        Slot.bAlive = false;
+        ++Slot.Generation;
+        Slot.NextFree = m_FirstFree;
+        m_FirstFree = Slot.Index;
+        --m_NumAlive;
+    }
+
+    void Destroy(sPoolHandle aHandle) { Destroy(Get(aHandle)); }
+
+    /**
+     * @brief Destroys every object and frees the slabs.
+     */
+    void Clear()
+    {
+        if (m_NumAlive > 0)
+        {
+            ForEach([](T& aObject) { aObject.~T(); });
+        }
+        m_Slabs.clear();
+        Reset();
+    }
+
+    sPoolHandle GetHandle(const T* apObject) const
+    {
+        const sSlot& Slot = GetSlot(apObject);
+        return { Slot.Index, Slot.Generation };
+    }
+
+    /**
+     * @brief The object referenced by aHandle, nullptr if it was destroyed.
+     */
+    T* Get(sPoolHandle aHandle) const
+    {
+        if (aHandle.Index >= m_NumSlots)
+        {
+            return nullptr;
+        }
+
+        sSlot& Slot = GetSlot(aHandle.Index);
+        return Slot.bAlive && Slot.Generation == aHandle.Generation ? reinterpret_cast<T*>(Slot.Storage) : nullptr;
+    }
+
+    /**
+     * @brief Calls aFunction with every alive object, in memory order.
+     */
+    template<class F>
+    void ForEach(F&& aFunction) const
+    {
+        for (const std::unique_ptr<sSlot[]>& Slab : m_Slabs)
+        {
+            for (uint32 i = 0; i < SlabSize; ++i)
+            {
+                if (Slab[i].bAlive)
+                {
+                    aFunction(*reinterpret_cast<T*>(Slab[i].Storage));
+                }
+            }
+        }
+    }
+
+    uint32 GetSize() const { return m_NumAlive; }
+
+private:
+    // Storage comes first so an object and its slot share the same address.
+    struct sSlot
+    {
+        alignas(T) unsigned char Storage[sizeof(T)];
+        uint32 Index;
+        uint32 Generation;
+        uint32 NextFree;
+        bool bAlive;
+    };
+
+    void AddSlab()
+    {
+        std::unique_ptr<sSlot[]> Slab(new sSlot[SlabSize]);
+        for (uint32 i = 0; i < SlabSize; ++i)
+        {
+            Slab[i].Index = m_NumSlots + i;
+            Slab[i].Generation = 0;
+            Slab[i].NextFree = i + 1 < SlabSize ? m_NumSlots + i + 1 : UINT32_MAX;
+            Slab[i].bAlive = false;
+        }
+
+        m_FirstFree = m_NumSlots;
+        m_NumSlots += SlabSize;
+        m_Slabs.push_back(std::move(Slab));
+    }
+
+    void Reset()
+    {
+        m_NumSlots = 0;
+        m_FirstFree = UINT32_MAX;
+        m_NumAlive = 0;
+    }
+
+    sSlot& GetSlot(uint32 aIndex) const { return m_Slabs[aIndex / SlabSize][aIndex % SlabSize]; }
+    static sSlot& GetSlot(const T* apObject) { return *reinterpret_cast<sSlot*>(const_cast<T*>(apObject)); }
+
+    std::vector<std::unique_ptr<sSlot[]>> m_Slabs;
+    uint32 m_NumSlots = 0;
+    uint32 m_FirstFree;
+    uint32 m_NumAlive;
+};
@@ -0,0 +1,229 @@
+#include "profiler.hpp"
+#include "logger.h"
+
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace
+{
+    struct sZoneEvent
+    {
+        const char* Name;
+        uint64 StartNs;
+        uint64 EndNs;
+    };
+
+    // Zones of a thread. Only the owning thread writes it, events are published through Count.
+    struct sThreadBuffer
+    {
+        uint32 ThreadID = 0;
+        std::string Name;
+        // Capture the events belong to. The owning thread resets the buffer when a new capture starts.
+        std::atomic<uint32> CaptureID{0};
+        std::atomic<uint32> Count{0};
+        std::unique_ptr<sZoneEvent[]> Events;
+    };
+
+    struct sProfiler
+    {
+        std::atomic<bool> bCapturing{false};
+        std::atomic<uint32> CaptureID{0};
+
+        // Protects the list of buffers and the thread names, only taken when a thread records its first zone.
+        std::mutex BuffersMutex;
+        std::vector<std::unique_ptr<sThreadBuffer>> Buffers;
+
+        // GPU zones come from a single thread once per frame, a mutex is enough.
+        std::mutex GPUZonesMutex;
+        std::vector<sZoneEvent> GPUZones;
+    };
+
+    // Track the GPU zones are shown in.
+    constexpr uint32 GPU_THREAD_ID = 0;
+
+    sProfiler& GetProfiler()
+    {
+        static sProfiler Profiler;
+        return Profiler;
+    }
+
+    thread_local sThreadBuffer* tpThreadBuffer = nullptr;
+
+    sThreadBuffer& GetThreadBuffer()
+    {
+        if (tpThreadBuffer == nullptr)
+        {
+            sProfiler& Profiler = GetProfiler();
+            std::lock_guard<std::mutex> Lock(Profiler.BuffersMutex);
+            Profiler.Buffers.push_back(std::make_unique<sThreadBuffer>());
+            tpThreadBuffer = Profiler.Buffers.back().get();
+            tpThreadBuffer->ThreadID = static_cast<uint32>(Profiler.Buffers.size());
+            tpThreadBuffer->Name = "Thread " + std::to_string(tpThreadBuffer->ThreadID);
+        }
+        return *tpThreadBuffer;
+    }
+
+    void WriteEscaped(std::ofstream& aFile, const char* apString)
+    {
+        for (const char* pChar = apString; *pChar; ++pChar)
+        {
+            if (*pChar == '"' || *pChar == '\\')
+            {
+                aFile << '\\';
+            }
+            aFile << *pChar;
+        }
+    }
+
+    void WriteThreadName(std::ofstream& aFile, uint32 aThreadID, const char* apName, bool& abFirstEvent)
+    {
+        aFile << (abFirstEvent ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << aThreadID << ",\"args\":{\"name\":\"";
+        WriteEscaped(aFile, apName);
+        aFile << "\"}}";
+        abFirstEvent = false;
+    }
+
+    void WriteZone(std::ofstream& aFile, uint32 aThreadID, const sZoneEvent& aEvent, bool& abFirstEvent)
+    {
+        // The trace format counts in microseconds.
+        aFile << (abFirstEvent ? "\n" : ",\n") << "{\"name\":\"";
+        WriteEscaped(aFile, aEvent.Name);
+        aFile << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << aThreadID
+            << ",\"ts\":" << aEvent.StartNs / 1000.0
+            << ",\"dur\":" << (aEvent.EndNs - aEvent.StartNs) / 1000.0 << "}";
+        abFirstEvent = false;
+    }
+}
+
+uint64 profiler::GetTimeNs()
+{
+    static const std::chrono::steady_clock::time_point StartTime = std::chrono::steady_clock::now();
+    // Never 0, CProfileZone uses it for zones started outside of a capture.
+    return static_cast<uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - StartTime).count()) + 1;
+}
+
+void profiler::SetThreadName(const char* apName)
+{
+    sThreadBuffer& ThreadBuffer = GetThreadBuffer();
+    std::lock_guard<std::mutex> Lock(GetProfiler().BuffersMutex);
+    ThreadBuffer.Name = apName;
+}
+
+void profiler::BeginCapture()
+{
+    sProfiler& Profiler = GetProfiler();
+    {
+        std::lock_guard<std::mutex> Lock(Profiler.GPUZonesMutex);
+        Profiler.GPUZones.clear();
+    }
+
+    Profiler.CaptureID.fetch_add(1, std::memory_order_acq_rel);
+    Profiler.bCapturing.store(true, std::memory_order_release);
+    SGSINFO("Profiler capture started.");
+}
+
+bool profiler::EndCapture(const char* aFilePath)
+{
+    sProfiler& Profiler = GetProfiler();
+    Profiler.bCapturing.store(false, std::memory_order_release);
+    const uint32 CaptureID = Profiler.CaptureID.load(std::memory_order_acquire);
+
+    std::ofstream File(aFilePath, std::ios::trunc);
+    if (!File.is_open())
+    {
+        SGSERROR("Could not write the profiler capture to %s.", aFilePath);
+        return false;
+    }
+
+    File << std::fixed << std::setprecision(3) << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool bFirstEvent = true;
+    uint64 NumZones = 0;
+
+    {
+        std::lock_guard<std::mutex> Lock(Profiler.BuffersMutex);
+        for (const std::unique_ptr<sThreadBuffer>& ThreadBuffer : Profiler.Buffers)
+        {
+            WriteThreadName(File, ThreadBuffer->ThreadID, ThreadBuffer->Name.c_str(), bFirstEvent);
+            if (ThreadBuffer->CaptureID.load(std::memory_order_acquire) != CaptureID)
+            {
+                continue;
+            }
+
+            // Zones still being recorded by other threads are past Count and are left out.
+            const uint32 Count = ThreadBuffer->Count.load(std::memory_order_acquire);
+            for (uint32 i = 0; i < Count; ++i)
+            {
+                WriteZone(File, ThreadBuffer->ThreadID, ThreadBuffer->Events[i], bFirstEvent);
+            }
+            NumZones += Count;
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(Profiler.GPUZonesMutex);
+        WriteThreadName(File, GPU_THREAD_ID, "GPU", bFirstEvent);
+        for (const sZoneEvent& Zone : Profiler.GPUZones)
+        {
+            WriteZone(File, GPU_THREAD_ID, Zone, bFirstEvent);
+        }
+        NumZones += Profiler.GPUZones.size();
+    }
+
+    File << "\n]}\n";
+    SGSINFO("Profiler capture with %llu zones written to %s.", static_cast<unsigned long long>(NumZones), aFilePath);
+    return true;
+}
+
+bool profiler::IsCapturing()
+{
+    return GetProfiler().bCapturing.load(std::memory_order_relaxed);
+}
+
+void profiler::RecordZone(const char* apName, uint64 aStartNs, uint64 aEndNs)
+{
+    sProfiler& Profiler = GetProfiler();
+    if (!Profiler.bCapturing.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    sThreadBuffer& ThreadBuffer = GetThreadBuffer();
+    if (ThreadBuffer.Events == nullptr)
+    {
+        ThreadBuffer.Events = std::make_unique<sZoneEvent[]>(SGS_PROFILER_EVENTS_PER_THREAD);
+    }
+
+    const uint32 CaptureID = Profiler.CaptureID.load(std::memory_order_acquire);
+    if (ThreadBuffer.CaptureID.load(std::memory_order_relaxed) != CaptureID)
+    {
+        ThreadBuffer.Count.store(0, std::memory_order_relaxed);
+        ThreadBuffer.CaptureID.store(CaptureID, std::memory_order_release);
+    }
+
+    const uint32 Index = ThreadBuffer.Count.load(std::memory_order_relaxed);
+    if (Index >= SGS_PROFILER_EVENTS_PER_THREAD)
+    {
+        return;
+    }
+
+    ThreadBuffer.Events[Index] = { apName, aStartNs, aEndNs };
+    ThreadBuffer.Count.store(Index + 1, std::memory_order_release);
+}
+
+void profiler::AddGPUZone(const char* apName, uint64 aStartNs, uint64 aEndNs)
+{
+    sProfiler& Profiler = GetProfiler();
+    if (!Profiler.bCapturing.load(std::memory_order_acquire))
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> Lock(Profiler.GPUZonesMutex);
+    Profiler.GPUZones.push_back({ apName, aStartNs, aEndNs });
+}
@@ -0,0 +1,88 @@
+#pragma once
+
+#include "defines.h"
+
+// Compiles the profiling zones in. Can be overridden at build time (/DSGS_PROFILER=0 removes them).
+#ifndef SGS_PROFILER
+#define SGS_PROFILER 1
+#endif
+
+// Maximum number of zones a thread records during a capture, the rest are dropped.
+#ifndef SGS_PROFILER_EVENTS_PER_THREAD
+#define SGS_PROFILER_EVENTS_PER_THREAD 65536
+#endif
+
+/**
+ * @brief CPU profiler. Zones are timed with RAII objects and, while a capture is running, stored in a buffer owned by
+ * the thread that recorded them, so recording takes no lock. Captures are exported as Chrome trace_event JSON
+ * (open them in chrome://tracing or Perfetto), nested zones show up as a hierarchy.
+ *
+ * GPU work timed with timestamp queries can be added with AddGPUZone() once converted to the CPU clock.
+ */
+namespace profiler
+{
+    /**
+     * @brief Nanoseconds of the clock used by the zones.
+     */
+    uint64 GetTimeNs();
+
+    /**
+     * @brief Name the calling thread is shown with in the captures.
+     */
+    void SetThreadName(const char* apName);
+
+    void BeginCapture();
+
+    /**
+     * @brief Stops the capture and writes it to aFilePath.
+     * @return False if the file could not be written.
+     */
+    bool EndCapture(const char* aFilePath);
+
+    bool IsCapturing();
+
+    /**
+     * @brief Records a zone of CPU time. apName must outlive the capture (string literals, __FUNCTION__).
+     */
+    void RecordZone(const char* apName, uint64 aStartNs, uint64 aEndNs);
+
+    /**
+     * @brief Records a zone of GPU time, shown in its own track. The times must be converted to GetTimeNs().
+     */
+    void AddGPUZone(const char* apName, uint64 aStartNs, uint64 aEndNs);
+}
+
+/**
+ * @brief Times its scope. Use it through SGS_PROFILE_SCOPE / SGS_PROFILE_FUNCTION.
+ */
+class CProfileZone
+{
+public:
+    CProfileZone(const char* apName) : m_pName(apName), m_StartNs(profiler::IsCapturing() ? profiler::GetTimeNs() : 0) {}
+
+    ~CProfileZone()
+    {
+        if (m_StartNs != 0)
+        {
+            profiler::RecordZone(m_pName, m_StartNs, profiler::GetTimeNs());
+        }
+    }
+
+    CProfileZone(const CProfileZone&) = delete;
+    CProfileZone& operator=(const CProfileZone&) = delete;
+
+private:
+    const char* m_pName;
+    uint64 m_StartNs;
+};
+
+#define SGS_PROFILE_CONCAT_IMPL(a, b) a##b
+#define SGS_PROFILE_CONCAT(a, b) SGS_PROFILE_CONCAT_IMPL(a, b)
+
+#if SGS_PROFILER
+#define SGS_PROFILE_SCOPE(name) CProfileZone SGS_PROFILE_CONCAT(sgsProfileZone, __LINE__)(name)
+#define SGS_PROFILE_FUNCTION() SGS_PROFILE_SCOPE(__FUNCTION__)
+#else
+#define SGS_PROFILE_SCOPE(name)
+#define SGS_PROFILE_FUNCTION()
+#endif
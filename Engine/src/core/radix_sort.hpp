@@ -0,0 +1,68 @@
+#pragma once
+
+#include "defines.h"
+
+#include <cstddef>
+#include <utility>
+
+namespace radixsort
+{
+    /**
+     * @brief Stable LSD radix sort of aCount elements by the 64 bit key returned by aGetKey(const T&), one byte per pass.
+     * apScratch must hold aCount elements too. The passes ping-pong between both arrays, so the sorted elements may end
+     * up in either of them: the returned pointer is the one holding them.
+     *
+     * The histograms of every byte are built in a single read of the input, and the bytes all keys share (usually the
+     * high ones) are skipped.
+     */
+    template<class T, class F>
+    T* SortByKey64(T* apData, T* apScratch, size_t aCount, F&& aGetKey)
+    {
+        constexpr uint32 NUM_PASSES = sizeof(uint64);
+        constexpr uint32 NUM_BUCKETS = 256;
+
+        if (aCount < 2)
+        {
+            return apData;
+        }
+
+        size_t Histograms[NUM_PASSES][NUM_BUCKETS] = {};
+        for (size_t i = 0; i < aCount; ++i)
+        {
+            const uint64 Key = aGetKey(apData[i]);
+            for (uint32 Pass = 0; Pass < NUM_PASSES; ++Pass)
+            {
+                ++Histograms[Pass][(Key >> (Pass * 8)) & 0xFF];
+            }
+        }
+
+        T* pSource = apData;
+        T* pDestination = apScratch;
+        for (uint32 Pass = 0; Pass < NUM_PASSES; ++Pass)
+        {
+            const uint32 Shift = Pass * 8;
+            size_t* Histogram = Histograms[Pass];
+            if (Histogram[(aGetKey(pSource[0]) >> Shift) & 0xFF] == aCount)
+            {
+                continue;
+            }
+
+            // Turn the counts into the first position of each bucket.
+            size_t Offset = 0;
+            for (uint32 Bucket = 0; Bucket < NUM_BUCKETS; ++Bucket)
+            {
+                const size_t Count = Histogram[Bucket];
+                Histogram[Bucket] = Offset;
+                Offset += Count;
+            }
+
+            for (size_t i = 0; i < aCount; ++i)
+            {
+                pDestination[Histogram[(aGetKey(pSource[i]) >> Shift) & 0xFF]++] = pSource[i];
+            }
+            std::swap(pSource, pDestination);
+        }
+
+        return pSource;
+    }
+}
@@ -2,18 +2,23 @@
 
 #include <deque>
 #include <functional>
+#include <mutex>
 
 struct sDeletionQueue
 {
 	std::deque<std::function<void()>> Deletors;
+	// Resources can be created from worker threads (e.g. asset loading jobs).
+	std::mutex Mutex;
 
 	void PushFunction(std::function<void()>&& function)
 	{
+		std::lock_guard<std::mutex> Lock(Mutex);
 		Deletors.push_back(function);
 	}
 
 	void Flush()
 	{
+		std::lock_guard<std::mutex> Lock(Mutex);
 		for (auto it = Deletors.rbegin(); it != Deletors.rend(); it++)
 		{
 			(*it)();
@@ -1,5 +1,7 @@
 #include "engine.hpp"
 #include "core/logger.h"
+#include "core/job_system.hpp"
+#include "core/profiler.hpp"
 
 #include <GLFW/glfw3.h>
 
@@ -25,7 +27,11 @@ CEngine *CEngine::Get()
 
 void CEngine::StartUp()
 {
+    logging::Initialize();
+    profiler::SetThreadName("Main Thread");
     SGSINFO("StartUp!");
+
+    jobs::Initialize();
     
     glfwInit();
 
@@ -48,6 +54,8 @@ void CEngine::Run()
     {
         auto Start = std::chrono::system_clock::now();
 
+        // Sleeps first, so the input is as recent as possible when the frame reaches the GPU.
+        m_RenderModule.PaceFrame();
         glfwPollEvents();
         m_RenderModule.Update();
     
@@ -64,6 +72,10 @@ void CEngine::Shutdown()
 
     glfwDestroyWindow(m_pWindow);
     glfwTerminate();
+
+    jobs::Shutdown();
+
+    logging::Shutdown();
 }
 
 GLFWwindow* CEngine::GetWindow()
@@ -11,28 +11,30 @@ CVkTexture::CVkTexture(const std::string& aFilePath)
    
     CVulkanDevice* pDevice = GetVulkanDevice();
     VK_CHECK(vkCreateImageView(pDevice->m_Device, &ViewInfo, nullptr, &m_ImageView));
-
-    // TODO: To be removed. Free resources in another place.
-    pDevice->m_MainDeletionQueue.PushFunction([=]
-    {
-        vkDestroyImageView(pDevice->m_Device, m_ImageView, nullptr);
-        vmaDestroyImage(pDevice->m_Allocator, m_AllocatedImage.Image, m_AllocatedImage.Allocation);
-    });
 }
 
 CVkTexture::CVkTexture(const uint64_t aImageSize, void *aPixel_Ptr, int32_t aTexWidth, int32_t aTexHeight)
 {
-    vkutils::UploadImageToVRAM(GetVulkanDevice(), aImageSize, aPixel_Ptr, aTexWidth, aTexHeight, m_AllocatedImage);
+    vkutils::UploadImageToVRAM(GetVulkanDevice(), aImageSize, aPixel_Ptr, aTexWidth, aTexHeight, "Embedded Texture", m_AllocatedImage);
+    m_Width = static_cast<uint32_t>(aTexWidth);
+    m_Height = static_cast<uint32_t>(aTexHeight);
     
     VkImageViewCreateInfo ViewInfo = vkinit::ImageViewCreateInfo(VK_FORMAT_R8G8B8A8_SRGB, m_AllocatedImage.Image, VK_IMAGE_ASPECT_COLOR_BIT);
 
     CVulkanDevice* pDevice = GetVulkanDevice();
     VK_CHECK(vkCreateImageView(pDevice->m_Device, &ViewInfo, nullptr, &m_ImageView));
-    
-    // TODO: To be removed. Free resources in another place.
-    pDevice->m_MainDeletionQueue.PushFunction([=]
+}
+
+CVkTexture::~CVkTexture()
+{
+    // Frames in flight may still sample the texture.
+    CVulkanDevice* pDevice = GetVulkanDevice();
+    if (m_ImageView != VK_NULL_HANDLE)
+    {
+        pDevice->m_FrameDeletionQueue.DestroyImageView(m_ImageView);
+    }
+    if (m_AllocatedImage.Image != VK_NULL_HANDLE)
     {
-        vkDestroyImageView(pDevice->m_Device, m_ImageView, nullptr);
-        vmaDestroyImage(pDevice->m_Allocator, m_AllocatedImage.Image, m_AllocatedImage.Allocation);
-    });
+        pDevice->m_FrameDeletionQueue.DestroyImage(m_AllocatedImage);
+    }
 }
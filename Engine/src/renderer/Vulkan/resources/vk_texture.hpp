@@ -11,6 +11,7 @@ public:
     CVkTexture() = default;
     CVkTexture(const std::string& aFilePath); 
     CVkTexture(const uint64_t aImageSize, void *aPixel_Ptr, int32_t aTexWidth, int32_t aTexHeight);
+    virtual ~CVkTexture() override;
 
     virtual uint32_t GetWidth() const override { return m_Width; }
     virtual uint32_t GetHeight() const override { return m_Height; }
@@ -19,8 +20,8 @@ public:
     VkImageView GetImageView() const { return m_ImageView; }
 
 private:
-    uint32_t m_Width;
-    uint32_t m_Height;
-    AllocatedImage m_AllocatedImage;
-    VkImageView m_ImageView;
+    uint32_t m_Width = 0;
+    uint32_t m_Height = 0;
+    AllocatedImage m_AllocatedImage = {};
+    VkImageView m_ImageView = VK_NULL_HANDLE;
 };
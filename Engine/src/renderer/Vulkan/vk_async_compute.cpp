@@ -0,0 +1,123 @@
+#include "vk_async_compute.hpp"
+#include "vulkan_device.hpp"
+#include "vk_initializers.hpp"
+#include "vk_utils.hpp"
+#include <core/logger.h>
+
+#include <cassert>
+
+CVulkanAsyncCompute::CVulkanAsyncCompute() :
+	m_pVulkanDevice(nullptr),
+	m_bEnabled(false)
+{
+}
+
+void CVulkanAsyncCompute::Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames)
+{
+	m_pVulkanDevice = apVulkanDevice;
+	m_bEnabled = apVulkanDevice->HasAsyncCompute();
+	if (!m_bEnabled)
+	{
+		SGSINFO("No separate compute queue family, the compute passes run on the graphics queue.");
+		return;
+	}
+
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+	const VkSemaphoreCreateInfo SemaphoreInfo = vkinit::SemaphoreCreateInfo();
+
+	m_Frames.resize(aNumFrames);
+	for (sFrameResources& Frame : m_Frames)
+	{
+		// A pool per frame, resetting it is cheaper than resetting its command buffer.
+		const VkCommandPoolCreateInfo CommandPoolInfo = vkinit::CommandPoolCreateInfo(m_pVulkanDevice->m_ComputeQueueFamily, VK_COMMAND_POOL_CREATE_TRANSIENT_BIT);
+		VK_CHECK(vkCreateCommandPool(Device, &CommandPoolInfo, nullptr, &Frame.CommandPool));
+
+		const VkCommandBufferAllocateInfo CmdAllocInfo = vkinit::CommandBufferAllocateInfo(Frame.CommandPool, 1);
+		VK_CHECK(vkAllocateCommandBuffers(Device, &CmdAllocInfo, &Frame.CommandBuffer));
+
+		VK_CHECK(vkCreateSemaphore(Device, &SemaphoreInfo, nullptr, &Frame.Semaphore));
+	}
+}
+
+void CVulkanAsyncCompute::Shutdown()
+{
+	if (!m_bEnabled)
+	{
+		return;
+	}
+
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+	vkQueueWaitIdle(m_pVulkanDevice->m_ComputeQueue);
+
+	for (sFrameResources& Frame : m_Frames)
+	{
+		vkDestroySemaphore(Device, Frame.Semaphore, nullptr);
+		vkDestroyCommandPool(Device, Frame.CommandPool, nullptr);
+	}
+	m_Frames.clear();
+	m_bEnabled = false;
+}
+
+VkCommandBuffer CVulkanAsyncCompute::BeginFrame(uint32_t aFrameIdx)
+{
+	assert(m_bEnabled && aFrameIdx < m_Frames.size());
+	sFrameResources& Frame = m_Frames[aFrameIdx];
+
+	// The graphics submission of the frame waited on the last one, its fence covers it.
+	VK_CHECK(vkResetCommandPool(m_pVulkanDevice->m_Device, Frame.CommandPool, 0));
+
+	const VkCommandBufferBeginInfo BeginInfo = vkinit::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
+	VK_CHECK(vkBeginCommandBuffer(Frame.CommandBuffer, &BeginInfo));
+
+	return Frame.CommandBuffer;
+}
+
+void CVulkanAsyncCompute::Submit(uint32_t aFrameIdx)
+{
+	assert(m_bEnabled && aFrameIdx < m_Frames.size());
+	sFrameResources& Frame = m_Frames[aFrameIdx];
+
+	VK_CHECK(vkEndCommandBuffer(Frame.CommandBuffer));
+
+	VkSubmitInfo SubmitInfo = vkinit::SubmitInfo(&Frame.CommandBuffer);
+	SubmitInfo.signalSemaphoreCount = 1;
+	SubmitInfo.pSignalSemaphores = &Frame.Semaphore;
+
+	VK_CHECK(vkQueueSubmit(m_pVulkanDevice->m_ComputeQueue, 1, &SubmitInfo, VK_NULL_HANDLE));
+}
+
+void CVulkanAsyncCompute::RecordRelease(VkCommandBuffer aCmdBuffer, const VkBuffer* apBuffers, uint32_t aNumBuffers, VkPipelineStageFlags aSrcStages,
+	VkAccessFlags aSrcAccess) const
+{
+	// The destination half of a release is ignored, the acquire on the other queue carries it.
+	RecordOwnershipTransfer(aCmdBuffer, apBuffers, aNumBuffers, aSrcStages, aSrcAccess, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0);
+}
+
+void CVulkanAsyncCompute::RecordAcquire(VkCommandBuffer aCmdBuffer, const VkBuffer* apBuffers, uint32_t aNumBuffers, VkPipelineStageFlags aDstStages,
+	VkAccessFlags aDstAccess) const
+{
+	// And the source half of an acquire, the semaphore orders it after the release.
+	RecordOwnershipTransfer(aCmdBuffer, apBuffers, aNumBuffers, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, 0, aDstStages, aDstAccess);
+}
+
+void CVulkanAsyncCompute::RecordOwnershipTransfer(VkCommandBuffer aCmdBuffer, const VkBuffer* apBuffers, uint32_t aNumBuffers, VkPipelineStageFlags aSrcStages,
+	VkAccessFlags aSrcAccess, VkPipelineStageFlags aDstStages, VkAccessFlags aDstAccess) const
+{
+	assert(m_bEnabled);
+
+	std::vector<VkBufferMemoryBarrier> Barriers(aNumBuffers);
+	for (uint32_t i = 0; i < aNumBuffers; ++i)
+	{
+		VkBufferMemoryBarrier& Barrier = Barriers[i];
+		Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		Barrier.srcAccessMask = aSrcAccess;
+		Barrier.dstAccessMask = aDstAccess;
+		Barrier.srcQueueFamilyIndex = m_pVulkanDevice->m_ComputeQueueFamily;
+		Barrier.dstQueueFamilyIndex = m_pVulkanDevice->m_GraphicsQueueFamily;
+		Barrier.buffer = apBuffers[i];
+		Barrier.offset = 0;
+		Barrier.size = VK_WHOLE_SIZE;
+	}
+
+	vkCmdPipelineBarrier(aCmdBuffer, aSrcStages, aDstStages, 0, 0, nullptr, aNumBuffers, Barriers.data(), 0, nullptr);
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+#include <vector>
+
+class CVulkanDevice;
+
+/**
+ * @brief Command buffers and synchronization to run the compute passes of a frame on the compute queue, next to the
+ * graphics work of the frames still in flight.
+ *
+ * Every frame the compute passes are recorded in the frame's compute command buffer and submitted before the graphics
+ * command buffer, which waits on the semaphore of the submission at the fragment shader stage. The vertex work of the
+ * frame (shadows, G-Buffer, depth prepass) is not held back.
+ *
+ * Buffers written on the compute queue and read by the graphics queue are exclusive to a queue family: the compute
+ * command buffer releases them (RecordRelease()) and the graphics one acquires them (RecordAcquire()) with the same
+ * barriers. Nothing is transferred back, the compute passes overwrite the whole buffers and their previous contents can
+ * be discarded. Buffers written by the host and read by both queues are created concurrent instead (see
+ * vkutils::CreateBuffer()).
+ *
+ * Disabled when the device has no compute family apart from the graphics one, the render paths then record the compute
+ * passes in the graphics command buffer.
+ */
+class CVulkanAsyncCompute
+{
+public:
+    CVulkanAsyncCompute();
+
+    void Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames);
+    void Shutdown();
+
+    bool IsEnabled() const { return m_bEnabled; }
+
+    /**
+     * @brief Resets and begins the compute command buffer of the frame. The frame must not be in use by the GPU.
+     */
+    VkCommandBuffer BeginFrame(uint32_t aFrameIdx);
+
+    /**
+     * @brief Ends and submits the compute command buffer of the frame, signaling GetSemaphore().
+     */
+    void Submit(uint32_t aFrameIdx);
+
+    /**
+     * @brief Signaled by the last Submit() of the frame. The graphics submission of the frame must wait on it at
+     * WAIT_STAGE, every signal needs its wait.
+     */
+    VkSemaphore GetSemaphore(uint32_t aFrameIdx) const { return m_Frames[aFrameIdx].Semaphore; }
+    static constexpr VkPipelineStageFlags WAIT_STAGE = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+
+    /**
+     * @brief Releases aBuffers from the compute queue family to the graphics one. Recorded in the compute command buffer
+     * after the commands that write them.
+     */
+    void RecordRelease(VkCommandBuffer aCmdBuffer, const VkBuffer* apBuffers, uint32_t aNumBuffers, VkPipelineStageFlags aSrcStages,
+        VkAccessFlags aSrcAccess) const;
+
+    /**
+     * @brief Acquires aBuffers on the graphics queue family, matching a RecordRelease(). aDstStages must be covered by
+     * WAIT_STAGE or come later.
+     */
+    void RecordAcquire(VkCommandBuffer aCmdBuffer, const VkBuffer* apBuffers, uint32_t aNumBuffers, VkPipelineStageFlags aDstStages,
+        VkAccessFlags aDstAccess) const;
+
+private:
+    struct sFrameResources
+    {
+        VkCommandPool CommandPool = VK_NULL_HANDLE;
+        VkCommandBuffer CommandBuffer = VK_NULL_HANDLE;
+        VkSemaphore Semaphore = VK_NULL_HANDLE;
+    };
+
+    void RecordOwnershipTransfer(VkCommandBuffer aCmdBuffer, const VkBuffer* apBuffers, uint32_t aNumBuffers, VkPipelineStageFlags aSrcStages,
+        VkAccessFlags aSrcAccess, VkPipelineStageFlags aDstStages, VkAccessFlags aDstAccess) const;
+
+    CVulkanDevice* m_pVulkanDevice;
+    bool m_bEnabled;
+    std::vector<sFrameResources> m_Frames;
+};
@@ -0,0 +1,288 @@
+#include "vk_clustered_lighting.hpp"
+#include "vk_async_compute.hpp"
+#include "vk_descriptors.hpp"
+#include "vulkan_device.hpp"
+#include "vk_initializers.hpp"
+#include "vk_utils.hpp"
+#include <core/logger.h>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t CULLING_GROUP_SIZE = 64; // Must match cluster_culling.comp.
+
+	// GPU layouts, must match clustered_lighting.glsl.
+	struct sGPUClusterInfo
+	{
+		glm::mat4 View;
+		glm::mat4 InvProj;
+		glm::uvec4 GridSize;
+		glm::vec4 ZParams;
+		glm::vec4 TileSize;
+		glm::uvec4 LightCounts;
+	};
+
+	struct sGPUPointLight
+	{
+		glm::vec4 PositionRadius;
+		glm::vec4 ColorIntensity;
+	};
+
+	struct sGPUSpotLight
+	{
+		glm::vec4 PositionRadius;
+		glm::vec4 ColorIntensity;
+		glm::vec4 Direction;
+		glm::vec4 Cone;
+	};
+
+	// Per cluster point and spot light counts.
+	constexpr VkDeviceSize CLUSTER_GRID_SIZE = sizeof(glm::uvec2) * NUM_CLUSTERS;
+	constexpr VkDeviceSize LIGHT_INDICES_SIZE = sizeof(uint32_t) * NUM_CLUSTERS * MAX_LIGHTS_PER_CLUSTER;
+}
+
+CVulkanClusteredLighting::CVulkanClusteredLighting() :
+	m_pVulkanDevice(nullptr),
+	m_SetLayout(VK_NULL_HANDLE),
+	m_CullingPipelineLayout(VK_NULL_HANDLE),
+	m_CullingPipeline(VK_NULL_HANDLE),
+	m_bWarnedTooManyLights(false)
+{
+}
+
+void CVulkanClusteredLighting::Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames, VkPipelineCache aPipelineCache, CVulkanDescriptorLayoutCache& aLayoutCache,
+	CVulkanDescriptorAllocator& aDescriptorAllocator)
+{
+	m_pVulkanDevice = apVulkanDevice;
+	m_Frames.resize(aNumFrames);
+
+	const VmaAllocator Allocator = m_pVulkanDevice->m_Allocator;
+	for (sFrameResources& Frame : m_Frames)
+	{
+		// Read by the culling, which may run on the async compute queue, and by the fragment shaders.
+		Frame.ClusterInfoBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sGPUClusterInfo), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			eMemoryCategory::UNIFORM, "Cluster Info", 0, true);
+		Frame.PointLightsBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sGPUPointLight) * MAX_POINT_LIGHTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			eMemoryCategory::STORAGE, "Point Lights", 0, true);
+		Frame.SpotLightsBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sGPUSpotLight) * MAX_SPOT_LIGHTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			eMemoryCategory::STORAGE, "Spot Lights", 0, true);
+		vmaMapMemory(Allocator, Frame.ClusterInfoBuffer.Allocation, &Frame.pMappedClusterInfo);
+		vmaMapMemory(Allocator, Frame.PointLightsBuffer.Allocation, &Frame.pMappedPointLights);
+		vmaMapMemory(Allocator, Frame.SpotLightsBuffer.Allocation, &Frame.pMappedSpotLights);
+
+		Frame.ClusterGridBuffer = vkutils::CreateBuffer(m_pVulkanDevice, CLUSTER_GRID_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+			eMemoryCategory::STORAGE, "Cluster Grid");
+		Frame.LightIndicesBuffer = vkutils::CreateBuffer(m_pVulkanDevice, LIGHT_INDICES_SIZE, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+			eMemoryCategory::STORAGE, "Cluster Light Indices");
+	}
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		for (sFrameResources& Frame : m_Frames)
+		{
+			vmaUnmapMemory(Allocator, Frame.ClusterInfoBuffer.Allocation);
+			vmaUnmapMemory(Allocator, Frame.PointLightsBuffer.Allocation);
+			vmaUnmapMemory(Allocator, Frame.SpotLightsBuffer.Allocation);
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(Frame.ClusterInfoBuffer);
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(Frame.PointLightsBuffer);
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(Frame.SpotLightsBuffer);
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(Frame.ClusterGridBuffer);
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(Frame.LightIndicesBuffer);
+		}
+		m_Frames.clear();
+	});
+
+	CreateDescriptors(aLayoutCache, aDescriptorAllocator);
+	CreateCullingPipeline(aPipelineCache);
+}
+
+void CVulkanClusteredLighting::Shutdown()
+{
+	m_DeletionQueue.Flush();
+}
+
+void CVulkanClusteredLighting::UpdateFrame(uint32_t aFrameIdx, const sFramePacket& aFramePacket, const glm::mat4& aView, const glm::mat4& aProj,
+	float aNearPlane, float aFarPlane, VkExtent2D aExtent)
+{
+	assert(aFrameIdx < m_Frames.size());
+	sFrameResources& Frame = m_Frames[aFrameIdx];
+
+	const std::vector<sPointLight>& PointLights = aFramePacket.PointLights;
+	const std::vector<sSpotLight>& SpotLights = aFramePacket.SpotLights;
+
+	const uint32_t NumPointLights = static_cast<uint32_t>(std::min<size_t>(PointLights.size(), MAX_POINT_LIGHTS));
+	const uint32_t NumSpotLights = static_cast<uint32_t>(std::min<size_t>(SpotLights.size(), MAX_SPOT_LIGHTS));
+	if ((NumPointLights < PointLights.size() || NumSpotLights < SpotLights.size()) && !m_bWarnedTooManyLights)
+	{
+		SGSWARN("The scene has more lights than supported (%u point, %u spot). The rest are ignored.", MAX_POINT_LIGHTS, MAX_SPOT_LIGHTS);
+		m_bWarnedTooManyLights = true;
+	}
+
+	sGPUPointLight* pGPUPointLights = static_cast<sGPUPointLight*>(Frame.pMappedPointLights);
+	for (uint32_t i = 0; i < NumPointLights; ++i)
+	{
+		const sPointLight& Light = PointLights[i];
+		pGPUPointLights[i].PositionRadius = glm::vec4(Light.Position, Light.Radius);
+		pGPUPointLights[i].ColorIntensity = glm::vec4(Light.Color, Light.Intensity);
+	}
+
+	sGPUSpotLight* pGPUSpotLights = static_cast<sGPUSpotLight*>(Frame.pMappedSpotLights);
+	for (uint32_t i = 0; i < NumSpotLights; ++i)
+	{
+		const sSpotLight& Light = SpotLights[i];
+		pGPUSpotLights[i].PositionRadius = glm::vec4(Light.Position, Light.Radius);
+		pGPUSpotLights[i].ColorIntensity = glm::vec4(Light.Color, Light.Intensity);
+		pGPUSpotLights[i].Direction = glm::vec4(glm::normalize(Light.Direction), 0.0f);
+		pGPUSpotLights[i].Cone = glm::vec4(std::cos(Light.InnerAngle), std::cos(Light.OuterAngle), 0.0f, 0.0f);
+	}
+
+	// Slice k starts at Near * (Far / Near)^(k / Z), so slice(z) = log(z) * Z / log(Far / Near) - Z * log(Near) / log(Far / Near).
+	const float LogDepthRange = std::log(aFarPlane / aNearPlane);
+	const float SliceScale = static_cast<float>(CLUSTER_GRID_Z) / LogDepthRange;
+	const float SliceBias = -static_cast<float>(CLUSTER_GRID_Z) * std::log(aNearPlane) / LogDepthRange;
+
+	sGPUClusterInfo ClusterInfo = {};
+	ClusterInfo.View = aView;
+	ClusterInfo.InvProj = glm::inverse(aProj);
+	ClusterInfo.GridSize = glm::uvec4(CLUSTER_GRID_X, CLUSTER_GRID_Y, CLUSTER_GRID_Z, MAX_LIGHTS_PER_CLUSTER);
+	ClusterInfo.ZParams = glm::vec4(aNearPlane, aFarPlane, SliceScale, SliceBias);
+	ClusterInfo.TileSize = glm::vec4(
+		std::ceil(aExtent.width / static_cast<float>(CLUSTER_GRID_X)),
+		std::ceil(aExtent.height / static_cast<float>(CLUSTER_GRID_Y)),
+		static_cast<float>(aExtent.width),
+		static_cast<float>(aExtent.height));
+	ClusterInfo.LightCounts = glm::uvec4(NumPointLights, NumSpotLights, 0, 0);
+
+	memcpy(Frame.pMappedClusterInfo, &ClusterInfo, sizeof(sGPUClusterInfo));
+}
+
+void CVulkanClusteredLighting::RecordCulling(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx) const
+{
+	const sFrameResources& Frame = m_Frames[aFrameIdx];
+
+	// The previous use of this frame's lists was read by fragment shaders. The fence of the frame already
+	// waited for it, so no barrier is needed before overwriting them.
+	vkCmdBindPipeline(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullingPipeline);
+	vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullingPipelineLayout, 0, 1, &Frame.DescriptorSet, 0, nullptr);
+	vkCmdDispatch(aCmdBuffer, (NUM_CLUSTERS + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+
+	std::array<VkBufferMemoryBarrier, 2> Barriers = {};
+	for (VkBufferMemoryBarrier& Barrier : Barriers)
+	{
+		Barrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+		Barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+		Barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+		Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+		Barrier.offset = 0;
+		Barrier.size = VK_WHOLE_SIZE;
+	}
+	Barriers[0].buffer = Frame.ClusterGridBuffer.Buffer;
+	Barriers[1].buffer = Frame.LightIndicesBuffer.Buffer;
+
+	vkCmdPipelineBarrier(aCmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+		0, nullptr, static_cast<uint32_t>(Barriers.size()), Barriers.data(), 0, nullptr);
+}
+
+void CVulkanClusteredLighting::RecordAsyncCulling(VkCommandBuffer aComputeCmdBuffer, uint32_t aFrameIdx, const CVulkanAsyncCompute& aAsyncCompute) const
+{
+	const sFrameResources& Frame = m_Frames[aFrameIdx];
+
+	// The lists are rewritten entirely and their previous contents are discarded, so the graphics queue does not
+	// transfer them back. The fence of the frame already waited for the fragment shaders reading them.
+	vkCmdBindPipeline(aComputeCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullingPipeline);
+	vkCmdBindDescriptorSets(aComputeCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_CullingPipelineLayout, 0, 1, &Frame.DescriptorSet, 0, nullptr);
+	vkCmdDispatch(aComputeCmdBuffer, (NUM_CLUSTERS + CULLING_GROUP_SIZE - 1) / CULLING_GROUP_SIZE, 1, 1);
+
+	const std::array<VkBuffer, 2> Buffers = { Frame.ClusterGridBuffer.Buffer, Frame.LightIndicesBuffer.Buffer };
+	aAsyncCompute.RecordRelease(aComputeCmdBuffer, Buffers.data(), static_cast<uint32_t>(Buffers.size()), VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_ACCESS_SHADER_WRITE_BIT);
+}
+
+void CVulkanClusteredLighting::RecordAcquire(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx, const CVulkanAsyncCompute& aAsyncCompute) const
+{
+	const sFrameResources& Frame = m_Frames[aFrameIdx];
+
+	const std::array<VkBuffer, 2> Buffers = { Frame.ClusterGridBuffer.Buffer, Frame.LightIndicesBuffer.Buffer };
+	aAsyncCompute.RecordAcquire(aCmdBuffer, Buffers.data(), static_cast<uint32_t>(Buffers.size()), VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+}
+
+void CVulkanClusteredLighting::CreateDescriptors(CVulkanDescriptorLayoutCache& aLayoutCache, CVulkanDescriptorAllocator& aDescriptorAllocator)
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+	const VkShaderStageFlags Stages = VK_SHADER_STAGE_COMPUTE_BIT | VK_SHADER_STAGE_FRAGMENT_BIT;
+
+	const std::array<VkDescriptorSetLayoutBinding, 5> Bindings =
+	{
+		vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, Stages, 0),
+		vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Stages, 1),
+		vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Stages, 2),
+		vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Stages, 3),
+		vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Stages, 4)
+	};
+
+	VkDescriptorSetLayoutCreateInfo LayoutInfo = {};
+	LayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	LayoutInfo.bindingCount = static_cast<uint32_t>(Bindings.size());
+	LayoutInfo.pBindings = Bindings.data();
+
+	m_SetLayout = aLayoutCache.CreateLayout(LayoutInfo);
+
+	for (sFrameResources& Frame : m_Frames)
+	{
+		Frame.DescriptorSet = aDescriptorAllocator.Allocate(m_SetLayout);
+
+		std::array<VkDescriptorBufferInfo, 5> BufferInfos =
+		{{
+			{ Frame.ClusterInfoBuffer.Buffer, 0, sizeof(sGPUClusterInfo) },
+			{ Frame.PointLightsBuffer.Buffer, 0, VK_WHOLE_SIZE },
+			{ Frame.SpotLightsBuffer.Buffer, 0, VK_WHOLE_SIZE },
+			{ Frame.ClusterGridBuffer.Buffer, 0, VK_WHOLE_SIZE },
+			{ Frame.LightIndicesBuffer.Buffer, 0, VK_WHOLE_SIZE }
+		}};
+
+		std::array<VkWriteDescriptorSet, 5> Writes;
+		for (uint32_t i = 0; i < Writes.size(); ++i)
+		{
+			const VkDescriptorType Type = i == 0 ? VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER : VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+			Writes[i] = vkinit::WriteDescriptorBuffer(Type, Frame.DescriptorSet, &BufferInfos[i], i);
+		}
+
+		vkUpdateDescriptorSets(Device, static_cast<uint32_t>(Writes.size()), Writes.data(), 0, nullptr);
+	}
+}
+
+void CVulkanClusteredLighting::CreateCullingPipeline(VkPipelineCache aPipelineCache)
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+
+	VkPipelineLayoutCreateInfo LayoutInfo = vkinit::PipelineLayoutCreateInfo();
+	LayoutInfo.setLayoutCount = 1;
+	LayoutInfo.pSetLayouts = &m_SetLayout;
+
+	VK_CHECK(vkCreatePipelineLayout(Device, &LayoutInfo, nullptr, &m_CullingPipelineLayout));
+
+	VkShaderModule ComputeShader;
+	if (!vkutils::LoadShaderModule(Device, vkutils::GetShaderPath("cluster_culling_comp.spv").c_str(), &ComputeShader))
+	{
+		SGSERROR("Error when building the cluster culling shader module");
+	}
+
+	VkComputePipelineCreateInfo PipelineInfo = {};
+	PipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	PipelineInfo.stage = vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT, ComputeShader);
+	PipelineInfo.layout = m_CullingPipelineLayout;
+
+	VK_CHECK(vkCreateComputePipelines(Device, aPipelineCache, 1, &PipelineInfo, nullptr, &m_CullingPipeline));
+
+	vkDestroyShaderModule(Device, ComputeShader, nullptr);
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		vkDestroyPipeline(Device, m_CullingPipeline, nullptr);
+		vkDestroyPipelineLayout(Device, m_CullingPipelineLayout, nullptr);
+	});
+}
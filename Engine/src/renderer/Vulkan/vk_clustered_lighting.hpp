@@ -0,0 +1,106 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include "renderer/frame_packet.hpp"
+#include <core/types.hpp>
+
+#include <glm/glm.hpp>
+
+class CVulkanDevice;
+class CVulkanDescriptorLayoutCache;
+class CVulkanDescriptorAllocator;
+class CVulkanAsyncCompute;
+
+// Size of the froxel grid: screen tiles in X and Y, exponential depth slices in Z.
+constexpr uint32_t CLUSTER_GRID_X = 16;
+constexpr uint32_t CLUSTER_GRID_Y = 9;
+constexpr uint32_t CLUSTER_GRID_Z = 24;
+constexpr uint32_t NUM_CLUSTERS = CLUSTER_GRID_X * CLUSTER_GRID_Y * CLUSTER_GRID_Z;
+
+// Bounds the cost of shading a pixel: lights past this count in a cluster are dropped.
+constexpr uint32_t MAX_LIGHTS_PER_CLUSTER = 128;
+constexpr uint32_t MAX_POINT_LIGHTS = 1024;
+constexpr uint32_t MAX_SPOT_LIGHTS = 256;
+
+/**
+ * @brief Clustered light culling. Every frame the point and spot lights of the scene are uploaded and a compute
+ * pass bins them into a 3D grid of froxels (screen tiles x depth slices). Shaders only evaluate the lights of the
+ * cluster their fragment falls in, see clustered_lighting.glsl.
+ *
+ * Owns one descriptor set per frame in flight (lights, cluster info, cluster light lists) usable from the compute
+ * and fragment stages. Render paths add GetSetLayout() to their pipeline layouts and call RecordCulling() before
+ * the passes that shade. With async compute the culling is recorded on the compute queue with RecordAsyncCulling()
+ * instead, and the graphics command buffer calls RecordAcquire().
+ */
+class CVulkanClusteredLighting
+{
+public:
+    CVulkanClusteredLighting();
+
+    /**
+     * @brief The set layout is created by aLayoutCache and the sets of the frames allocated from aDescriptorAllocator,
+     * both owned by the backend.
+     */
+    void Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames, VkPipelineCache aPipelineCache, CVulkanDescriptorLayoutCache& aLayoutCache,
+        CVulkanDescriptorAllocator& aDescriptorAllocator);
+    void Shutdown();
+
+    /**
+     * @brief Uploads the lights of the frame packet and the cluster parameters for the frame. The frame must not be in use by the GPU.
+     */
+    void UpdateFrame(uint32_t aFrameIdx, const sFramePacket& aFramePacket, const glm::mat4& aView, const glm::mat4& aProj,
+        float aNearPlane, float aFarPlane, VkExtent2D aExtent);
+
+    /**
+     * @brief Records the culling dispatch and the barrier that makes its results visible to the fragment shaders.
+     */
+    void RecordCulling(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx) const;
+
+    /**
+     * @brief Records the culling dispatch in a command buffer of the compute queue and releases the cluster lists to
+     * the graphics queue.
+     */
+    void RecordAsyncCulling(VkCommandBuffer aComputeCmdBuffer, uint32_t aFrameIdx, const CVulkanAsyncCompute& aAsyncCompute) const;
+
+    /**
+     * @brief Acquires the cluster lists written by RecordAsyncCulling() for the fragment shaders.
+     */
+    void RecordAcquire(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx, const CVulkanAsyncCompute& aAsyncCompute) const;
+
+    VkDescriptorSetLayout GetSetLayout() const { return m_SetLayout; }
+    VkDescriptorSet GetDescriptorSet(uint32_t aFrameIdx) const { return m_Frames[aFrameIdx].DescriptorSet; }
+
+private:
+    struct sFrameResources
+    {
+        AllocatedBuffer ClusterInfoBuffer;
+        AllocatedBuffer PointLightsBuffer;
+        AllocatedBuffer SpotLightsBuffer;
+        void* pMappedClusterInfo = nullptr;
+        void* pMappedPointLights = nullptr;
+        void* pMappedSpotLights = nullptr;
+
+        // Written by the culling pass.
+        AllocatedBuffer ClusterGridBuffer;
+        AllocatedBuffer LightIndicesBuffer;
+
+        VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+    };
+
+    void CreateDescriptors(CVulkanDescriptorLayoutCache& aLayoutCache, CVulkanDescriptorAllocator& aDescriptorAllocator);
+    void CreateCullingPipeline(VkPipelineCache aPipelineCache);
+
+    CVulkanDevice* m_pVulkanDevice;
+
+    std::vector<sFrameResources> m_Frames;
+
+    // Owned by the layout cache of the backend.
+    VkDescriptorSetLayout m_SetLayout;
+    VkPipelineLayout m_CullingPipelineLayout;
+    VkPipeline m_CullingPipeline;
+
+    bool m_bWarnedTooManyLights;
+
+    // Holds the deletion functions.
+    sDeletionQueue m_DeletionQueue;
+};
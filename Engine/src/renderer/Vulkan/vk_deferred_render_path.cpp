@@ -6,25 +6,41 @@
 #include "engine.hpp"
 #include <renderer/core/geometry_generator.hpp>
 #include <core/logger.h>
+#include <core/job_system.hpp>
+#include <core/profiler.hpp>
 
-#include <iostream>
 #include <array>
     
-CVulkanDeferredRenderPath::CVulkanDeferredRenderPath(CVulkanBackend* apVulkanBackend, CVulkanDevice* apVulkanDevice, CVulkanSwapchain* apVulkanSwapchain) :
-    m_pVulkanBackend(apVulkanBackend), m_pVulkanDevice(apVulkanDevice), m_pVulkanSwapchain(apVulkanSwapchain)
+CVulkanDeferredRenderPath::CVulkanDeferredRenderPath(CVulkanBackend* apVulkanBackend, CVulkanDevice* apVulkanDevice, CVulkanSwapchain* apVulkanSwapchain, bool abSingleRenderPass, bool abCompactGBuffer) :
+    m_pVulkanBackend(apVulkanBackend), m_pVulkanDevice(apVulkanDevice), m_pVulkanSwapchain(apVulkanSwapchain),
+	m_bSingleRenderPass(abSingleRenderPass),
+	m_bCompactGBuffer(abCompactGBuffer),
+	m_RenderGraph(apVulkanDevice),
+	m_BackbufferImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_SceneColorImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_PositionImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_NormalImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_AlbedoImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_DepthImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_GBufferPass(0),
+	m_LightPass(0),
+	m_UpscalePass(apVulkanDevice)
 {
 }
 
 void CVulkanDeferredRenderPath::CreateResources()
 {
 	CreateDeferredQuad();
-    CreateDeferredAttachments();
+	CreateRenderGraph();
     CreateGBufferDescriptors();
-    CreateDeferredRenderPass();
-	CreateGBufferFramebuffer();
-    CreateDeferredPipeline();
-	CreateDeferredCommandStructures();
-	CreateDeferredSyncrhonizationStructures();
+    CreateDeferredPipelineLayouts();
+}
+
+void CVulkanDeferredRenderPath::CreatePipelines(sJobCounter& aCounter)
+{
+	jobs::Execute(aCounter, [this] { BuildGBufferPipeline(); });
+	jobs::Execute(aCounter, [this] { BuildLightPipeline(); });
+	jobs::Execute(aCounter, [this] { m_UpscalePass.BuildPipeline(m_pVulkanBackend->m_PipelineCache.GetHandle()); });
 }
     
 void CVulkanDeferredRenderPath::DestroyResources()
@@ -33,133 +49,79 @@ void CVulkanDeferredRenderPath::DestroyResources()
     m_MainDeletionQueue.Flush();
 }
 
-void CVulkanDeferredRenderPath::RecordGBufferPassCommands()
+void CVulkanDeferredRenderPath::DrawGBufferPass(const sRenderGraphPassContext& aContext)
 {
-	VkCommandBufferBeginInfo deferredCmdBeginInfo = vkinit::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT);
-
-	VK_CHECK(vkBeginCommandBuffer(m_DeferredCommandBuffer, &deferredCmdBeginInfo));
-
-	VkClearValue first_clearValue;
-	first_clearValue.color = { {0.0f, 0.0f, 0.0f, 1.0f} };
-
-	VkClearValue first_depthClear;
-	first_depthClear.depthStencil.depth = 1.0f;
-
-	VkRenderPassBeginInfo rpInfo = vkinit::RenderPassBeginInfo(m_DeferredRenderPass, m_pVulkanSwapchain->m_WindowExtent, m_GBufferFramebuffer);
-
-	std::array<VkClearValue, 4> first_clearValues = { first_clearValue, first_clearValue, first_clearValue, first_depthClear };
-
-	rpInfo.clearValueCount = static_cast<uint32_t>(first_clearValues.size());
-	rpInfo.pClearValues = first_clearValues.data();
-
-	vkCmdBeginRenderPass(m_DeferredCommandBuffer, &rpInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-	vkCmdBindPipeline(m_DeferredCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DeferredPipeline);
-	
-	VkViewport Viewport{};
-	Viewport.x = 0.0f;
-	Viewport.y = 0.0f;
-	Viewport.width = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.width);
-	Viewport.height = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.height);
-	Viewport.minDepth = 0.0f;
-	Viewport.maxDepth = 1.0f;
-	vkCmdSetViewport(m_DeferredCommandBuffer, 0, 1, &Viewport);
-
-	VkRect2D Scissor{};
-	Scissor.offset = {0, 0};
-	Scissor.extent = m_pVulkanSwapchain->m_WindowExtent;
-	vkCmdSetScissor(m_DeferredCommandBuffer, 0, 1, &Scissor);
-
-	std::array<VkDescriptorSet, 2> DescriptorSets = { m_CameraDescriptorSet, m_pVulkanBackend->m_ObjectsDataDescriptorSet };
-
-	vkCmdBindDescriptorSets(m_DeferredCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_DeferredPipelineLayout, 0, static_cast<uint32_t>(DescriptorSets.size()), DescriptorSets.data(), 0, nullptr);
-
 	sRenderContext RenderContext = {};
-	RenderContext.CmdBuffer = m_DeferredCommandBuffer;
+	RenderContext.CmdBuffer = aContext.CmdBuffer;
 	RenderContext.DrawCallNum = 0;
+	RenderContext.FrameDescriptorSet = m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].DescriptorSet;
 	RenderContext.MaterialDescriptors = &m_pVulkanBackend->m_MaterialDescriptors;
-	RenderContext.ObjectsDescriptorSet = m_pVulkanBackend->m_ObjectsDataDescriptorSet;
+	RenderContext.ObjectsDescriptorSet = m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].ObjectsDescriptorSet;
 	RenderContext.PipelineLayout = m_DeferredPipelineLayout;
 
-	for (const auto& Renderable :  m_pVulkanBackend->m_Renderables)
-	{
-		Renderable->Draw(RenderContext);
-	}
+	// The material is needed to fill the metallic and roughness of the G-Buffer.
+	// There is no blending in the G-Buffer, the blended draws are drawn as solid after the rest.
+	const CVulkanDrawList& DrawList = m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].DrawList;
+	DrawList.Record(RenderContext, eDrawPass::SOLID, &m_DeferredPipeline, true);
+	DrawList.Record(RenderContext, eDrawPass::BLENDED, &m_DeferredPipeline, true);
+}
 
-	vkCmdEndRenderPass(m_DeferredCommandBuffer);
+void CVulkanDeferredRenderPath::DrawLightPass(const sRenderGraphPassContext& aContext)
+{
+	vkCmdBindPipeline(aContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_LightPipeline);
+
+	const std::array<VkDescriptorSet, 3> DescriptorSets = { m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].DescriptorSet, m_GBufferDescriptorSet,
+		m_pVulkanBackend->m_ClusteredLighting.GetDescriptorSet(m_pVulkanBackend->m_CurrentFrame) };
+	vkCmdBindDescriptorSets(aContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_LightPipelineLayout, 
+		0, static_cast<uint32_t>(DescriptorSets.size()), DescriptorSets.data(), 0, nullptr);
+
+	// Deferred Quad.
+	VkDeviceSize Offset = 0;
+	vkCmdBindVertexBuffers(aContext.CmdBuffer, 0, 1, &m_Quad->m_VertexBuffer.Buffer, &Offset);
+	vkCmdBindIndexBuffer(aContext.CmdBuffer, m_Quad->m_IndexBuffer.Buffer, 0, VK_INDEX_TYPE_UINT32);
 
-	VK_CHECK(vkEndCommandBuffer(m_DeferredCommandBuffer));
+	// TODO: Make a way to refer quicker to submeshes. Too much redirection.
+	const uint32_t NumIndices = static_cast<uint32_t>(m_Quad->m_pRoots[0]->m_pMeshData->SubMeshes[0]->m_IndexCount);
+	vkCmdDrawIndexed(aContext.CmdBuffer, NumIndices, 1, 0, 0, 0);
 }
 
-void CVulkanDeferredRenderPath::RecordLightPassCommands(VkCommandBuffer aCommandBuffer, uint32_t aImageIdx)
+void CVulkanDeferredRenderPath::RecordCommands(VkCommandBuffer aCommandBuffer, uint32_t aImageIdx)
 {
-	VK_CHECK(vkResetCommandBuffer(aCommandBuffer, 0));
+	SGS_PROFILE_FUNCTION();
 
 	VkCommandBufferBeginInfo CmdBeginInfo = vkinit::CommandBufferBeginInfo(VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT);
 
 	VK_CHECK(vkBeginCommandBuffer(aCommandBuffer, &CmdBeginInfo));
-	
-	VkRenderPassBeginInfo LightPassBeginInfo = vkinit::RenderPassBeginInfo(m_pVulkanSwapchain->m_RenderPass, m_pVulkanSwapchain->m_WindowExtent, m_pVulkanSwapchain->m_Framebuffers[aImageIdx]);
-
-	std::array<VkClearValue, 2> ClearValues = {};
-	ClearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-	ClearValues[1].depthStencil = {1.0f, 0};
-	
-	LightPassBeginInfo.clearValueCount = static_cast<uint32_t>(ClearValues.size());
-	LightPassBeginInfo.pClearValues = ClearValues.data();
-
-	vkCmdBeginRenderPass(aCommandBuffer, &LightPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-	vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_LightPipeline);
-
-	VkViewport Viewport{};
-	Viewport.x = 0.0f;
-	Viewport.y = 0.0f;
-	Viewport.width = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.width);
-	Viewport.height = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.height);
-	Viewport.minDepth = 0.0f;
-	Viewport.maxDepth = 1.0f;
-	vkCmdSetViewport(aCommandBuffer, 0, 1, &Viewport);
-
-	VkRect2D Scissor{};
-	Scissor.offset = {0, 0};
-	Scissor.extent = m_pVulkanSwapchain->m_WindowExtent;
-	vkCmdSetScissor(aCommandBuffer, 0, 1, &Scissor);
-
-	// TODO: que ous fa aquesta linia.
-	//uint32_t uniform_offset = vkutils::GetAlignedSize(sizeof(GPUSceneData) * frameIndex, VulkanEngine::cinstance->_gpuProperties.limits.minUniformBufferOffsetAlignment);
-	const std::array<VkDescriptorSet, 2> DescriptorSets = { m_pVulkanBackend->m_FramesData[aImageIdx].DescriptorSet, m_GBufferDescriptorSet };
-	vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_LightPipelineLayout, 
-		0, static_cast<uint32_t>(DescriptorSets.size()), DescriptorSets.data(), 0, nullptr);
 
-	vkCmdBindDescriptorSets(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_LightPipelineLayout, 1, 1, &m_GBufferDescriptorSet, 0, nullptr);
+	m_pVulkanBackend->m_DynamicResolution.RecordFrameBegin(aCommandBuffer, m_pVulkanBackend->m_CurrentFrame);
 
-	// Deferred Quad.
-	VkDeviceSize Offset = 0;
-	vkCmdBindVertexBuffers(aCommandBuffer, 0, 1, &m_Quad->m_VertexBuffer.Buffer, &Offset);
-	vkCmdBindIndexBuffer(aCommandBuffer, m_Quad->m_IndexBuffer.Buffer, 0, VK_INDEX_TYPE_UINT32);
+	m_pVulkanBackend->m_Skinning.RecordSkinning(aCommandBuffer, m_pVulkanBackend->m_CurrentFrame);
+	m_pVulkanBackend->m_ShadowMaps.RecordShadows(aCommandBuffer, m_pVulkanBackend->m_Renderables, m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].ObjectsDescriptorSet);
+	m_pVulkanBackend->RecordComputePasses(aCommandBuffer, m_pVulkanBackend->m_CurrentFrame);
 
-	// TODO: Make a way to refer quicker to submeshes. Too much redirection.
-	const uint32_t NumIndices = static_cast<uint32_t>(m_Quad->m_pRoots[0]->m_pMeshData->SubMeshes[0]->m_IndexCount);
-	vkCmdDrawIndexed(aCommandBuffer, NumIndices, 1, 0, 0, 0);
+	m_RenderGraph.SetImportedImage(m_BackbufferImage, m_pVulkanSwapchain->m_SwapchainImages[aImageIdx], m_pVulkanSwapchain->m_SwapchainImageViews[aImageIdx]);
+	m_RenderGraph.SetRenderExtent(m_pVulkanBackend->m_DynamicResolution.GetRenderExtent(m_RenderGraph.GetExtent()));
+	m_RenderGraph.Execute(aCommandBuffer);
 
-	vkCmdEndRenderPass(aCommandBuffer);
+	m_pVulkanBackend->m_DynamicResolution.RecordFrameEnd(aCommandBuffer, m_pVulkanBackend->m_CurrentFrame);
 
 	VK_CHECK(vkEndCommandBuffer(aCommandBuffer));
 }
 
-void CVulkanDeferredRenderPath::Render(const CCamera* const aCamera)
+void CVulkanDeferredRenderPath::Render(const sFramePacket& aFramePacket)
 {
+    SGS_PROFILE_FUNCTION();
+
     // TODO: Probably there is a chunk of this code that can go to CVulkanBackend.
 	
-    VK_CHECK(vkWaitForFences(m_pVulkanDevice->m_Device, 1, &m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].RenderFence, VK_TRUE, UINT64_MAX));
+    m_pVulkanBackend->WaitForFrame();
     
     uint32_t ImageIndex;
 	VkResult Result = vkAcquireNextImageKHR(m_pVulkanDevice->m_Device, m_pVulkanSwapchain->m_Swapchain, UINT64_MAX, m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].PresentSemaphore, VK_NULL_HANDLE, &ImageIndex);
 	if (Result == VK_ERROR_OUT_OF_DATE_KHR || Result == VK_SUBOPTIMAL_KHR || m_pVulkanBackend->m_bWasWindowResized)
 	{
 		m_pVulkanBackend->m_bWasWindowResized = false;
-		m_pVulkanSwapchain->RecreateSwapchain();
+		m_pVulkanBackend->RecreateSwapchain();
 		return;
 	}
 	else if (Result != VK_SUCCESS)
@@ -167,34 +129,28 @@ void CVulkanDeferredRenderPath::Render(const CCamera* const aCamera)
 		throw std::runtime_error("Failed to acquire swap chain image!");
 	}
 
-    m_pVulkanBackend->UpdateFrameUBO(aCamera, m_pVulkanBackend->m_CurrentFrame);
+    m_pVulkanBackend->UpdateFrameData(aFramePacket, m_pVulkanBackend->m_CurrentFrame);
+    m_pVulkanBackend->SubmitAsyncCompute(m_pVulkanBackend->m_CurrentFrame);
 
     // Delay fence reset to prevent possible deadlock when recreating the swapchain.
 	VK_CHECK(vkResetFences(m_pVulkanDevice->m_Device, 1, &m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].RenderFence));
 
 	vkResetCommandBuffer(m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].MainCommandBuffer, 0);
-	RecordLightPassCommands(m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].MainCommandBuffer, ImageIndex);
-
-	VkSubmitInfo GBuffersSubmit = vkinit::SubmitInfo(&m_DeferredCommandBuffer);
-	
-    VkSemaphore WaitSemaphores[] = {m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].PresentSemaphore};
-	VkPipelineStageFlags GBuffersWaitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	GBuffersSubmit.pWaitDstStageMask = &GBuffersWaitStage;
-	GBuffersSubmit.waitSemaphoreCount = 1;
-	GBuffersSubmit.pWaitSemaphores = WaitSemaphores;
-	GBuffersSubmit.signalSemaphoreCount = 1;
-	GBuffersSubmit.pSignalSemaphores = &m_GBufferReadySemaphore;
-
-	VK_CHECK(vkQueueSubmit(m_pVulkanDevice->m_GraphicsQueue, 1, &GBuffersSubmit, nullptr));
+	RecordCommands(m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].MainCommandBuffer, ImageIndex);
 
+	// G-Buffer and light passes go in the same command buffer, the render graph synchronizes them.
     VkSubmitInfo RenderSubmit = vkinit::SubmitInfo(&m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].MainCommandBuffer);
 
-	VkPipelineStageFlags waitStage = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+	// The light pass also waits for the compute passes when they run on the compute queue.
+	const CVulkanAsyncCompute& AsyncCompute = m_pVulkanBackend->m_AsyncCompute;
+    VkSemaphore WaitSemaphores[] = {m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].PresentSemaphore,
+		AsyncCompute.IsEnabled() ? AsyncCompute.GetSemaphore(m_pVulkanBackend->m_CurrentFrame) : VK_NULL_HANDLE};
+	VkPipelineStageFlags WaitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, CVulkanAsyncCompute::WAIT_STAGE};
 	
     VkSemaphore SignalSemaphores[] = {m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].RenderSemaphore};
-	RenderSubmit.pWaitDstStageMask = &waitStage;
-	RenderSubmit.waitSemaphoreCount = 1;
-	RenderSubmit.pWaitSemaphores = &m_GBufferReadySemaphore;
+	RenderSubmit.pWaitDstStageMask = WaitStages;
+	RenderSubmit.waitSemaphoreCount = AsyncCompute.IsEnabled() ? 2 : 1;
+	RenderSubmit.pWaitSemaphores = WaitSemaphores;
 	RenderSubmit.signalSemaphoreCount = 1;
 	RenderSubmit.pSignalSemaphores = SignalSemaphores;
 
@@ -210,105 +166,118 @@ void CVulkanDeferredRenderPath::Render(const CCamera* const aCamera)
 
 	vkQueuePresentKHR(m_pVulkanDevice->m_GraphicsQueue, &PresentInfo);
 
-	m_pVulkanBackend->m_CurrentFrame = (m_pVulkanBackend->m_CurrentFrame + 1) % FRAME_OVERLAP;
+	m_pVulkanBackend->m_CurrentFrame = (m_pVulkanBackend->m_CurrentFrame + 1) % m_pVulkanBackend->m_NumFramesInFlight;
 }
 
-void CVulkanDeferredRenderPath::UpdateBuffers()
-{	
-	const auto Camera = CEngine::Get()->GetRenderModule()->GetCamera();
-
-	glm::mat4 Projection = glm::perspective(glm::radians(70.0f), m_pVulkanSwapchain->m_WindowExtent.width / (float)m_pVulkanSwapchain->m_WindowExtent.height, 0.1f, 200.0f);
-	Projection[1][1] *= -1;
-
-	sGPUCameraData CameraData;
-	// TODO: Do not harcode this.
-	CameraData.Projection =  
-	CameraData.View = Camera->GetViewMatrix();
-	CameraData.Viewproj = Projection * CameraData.View;
-
-	void* Data;
-	vmaMapMemory(m_pVulkanDevice->m_Allocator, m_CameraBuffer.Allocation, &Data);
-	memcpy(Data, &CameraData, sizeof(sGPUCameraData));
-	vmaUnmapMemory(m_pVulkanDevice->m_Allocator, m_CameraBuffer.Allocation);
+void CVulkanDeferredRenderPath::HandleSceneChanged()
+{
 }
 
-void CVulkanDeferredRenderPath::HandleSceneChanged()
+void CVulkanDeferredRenderPath::HandleSwapchainRecreated()
 {
-	SGSINFO("Handle Scene Changed");
-	RecordGBufferPassCommands();
+	m_RenderGraph.Resize(m_pVulkanSwapchain->m_WindowExtent);
+	UpdateGBufferDescriptors();
+	m_UpscalePass.UpdateDescriptors();
 }
 
 void CVulkanDeferredRenderPath::CreateDeferredQuad()
 {
-	sMeshData* Quad = new sMeshData();
-	*Quad = CGeometryGenerator::CreateQuad(-1.0f, 1.0f, 2.0f, 2.0f, 0.0f);
-	Quad->ID = "DeferredQuad"; //TODO: Improve this.
+	sMeshData Quad = CGeometryGenerator::CreateQuad(-1.0f, 1.0f, 2.0f, 2.0f, 0.0f);
+	Quad.ID = "DeferredQuad"; //TODO: Improve this.
 
-	m_Quad = new CVulkanRenderable(Quad);
+	m_Quad = new CVulkanRenderable(&Quad);
+	m_Quad->m_Name = Quad.ID;
 	m_Quad->UploadToVRAM();
-}
 
-void CVulkanDeferredRenderPath::CreateDeferredAttachments()
-{
-    VkExtent3D AttachmentExtent
+	m_MainDeletionQueue.PushFunction([=]()
 	{
-		m_pVulkanSwapchain->m_WindowExtent.width,
-		m_pVulkanSwapchain->m_WindowExtent.height,
-		1
-	};
-
-	m_PositionFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
-	m_NormalFormat = VK_FORMAT_R16G16B16A16_SFLOAT;
-	m_AlbedoFormat = VK_FORMAT_R8G8B8A8_UNORM;
+		delete m_Quad;
+	});
+}
 
-	VkImageCreateInfo PositionImgInfo = vkinit::ImageCreateInfo(m_PositionFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, AttachmentExtent);
-	VkImageCreateInfo NormalImgInfo = vkinit::ImageCreateInfo(m_NormalFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, AttachmentExtent);
-	VkImageCreateInfo AlbedoImgInfo = vkinit::ImageCreateInfo(m_AlbedoFormat, VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT, AttachmentExtent);
+void CVulkanDeferredRenderPath::CreateRenderGraph()
+{
+	m_BackbufferImage = m_RenderGraph.ImportImage("Backbuffer", m_pVulkanSwapchain->m_SwapchainImageFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
-	VmaAllocationCreateInfo ImgAllocInfo = {};
-	ImgAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
-	ImgAllocInfo.requiredFlags = VkMemoryPropertyFlagBits(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+	// Same format as the backbuffer, the upscale does not change the encoding of the colors.
+	sRenderGraphImageDesc SceneColorDesc;
+	SceneColorDesc.Format = m_pVulkanSwapchain->m_SwapchainImageFormat;
+	m_SceneColorImage = m_RenderGraph.CreateImage("SceneColor", SceneColorDesc);
 
-	vmaCreateImage(m_pVulkanDevice->m_Allocator, &PositionImgInfo, &ImgAllocInfo, &m_PositionImage.Image, &m_PositionImage.Allocation, nullptr);
-	vmaCreateImage(m_pVulkanDevice->m_Allocator, &NormalImgInfo, &ImgAllocInfo, &m_NormalImage.Image, &m_NormalImage.Allocation, nullptr);
-	vmaCreateImage(m_pVulkanDevice->m_Allocator, &AlbedoImgInfo, &ImgAllocInfo, &m_AlbedoImage.Image, &m_AlbedoImage.Allocation, nullptr);
+	// See gbuffer.glsl for the contents of every target.
+	sRenderGraphImageDesc GBufferDesc;
+	if (m_bCompactGBuffer)
+	{
+		GBufferDesc.Format = VK_FORMAT_A2B10G10R10_UNORM_PACK32;
+		m_NormalImage = m_RenderGraph.CreateImage("GBuffer.Normal", GBufferDesc);
+	}
+	else
+	{
+		GBufferDesc.Format = VK_FORMAT_R16G16B16A16_SFLOAT;
+		m_PositionImage = m_RenderGraph.CreateImage("GBuffer.Position", GBufferDesc);
+		m_NormalImage = m_RenderGraph.CreateImage("GBuffer.Normal", GBufferDesc);
+	}
+	GBufferDesc.Format = VK_FORMAT_R8G8B8A8_UNORM;
+	m_AlbedoImage = m_RenderGraph.CreateImage("GBuffer.Albedo", GBufferDesc);
 
-	VkImageViewCreateInfo PositionViewInfo = vkinit::ImageViewCreateInfo(VK_FORMAT_R16G16B16A16_SFLOAT, m_PositionImage.Image, VK_IMAGE_ASPECT_COLOR_BIT);
-	VkImageViewCreateInfo NormalViewInfo = vkinit::ImageViewCreateInfo(VK_FORMAT_R16G16B16A16_SFLOAT, m_NormalImage.Image, VK_IMAGE_ASPECT_COLOR_BIT);
-	VkImageViewCreateInfo AlbedoViewInfo = vkinit::ImageViewCreateInfo(VK_FORMAT_R8G8B8A8_UNORM, m_AlbedoImage.Image, VK_IMAGE_ASPECT_COLOR_BIT);
+	sRenderGraphImageDesc DepthDesc;
+	DepthDesc.Format = m_pVulkanDevice->FindDepthFormat();
+	DepthDesc.Aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	m_DepthImage = m_RenderGraph.CreateImage("Depth", DepthDesc);
 
-	VK_CHECK(vkCreateImageView(m_pVulkanDevice->m_Device, &PositionViewInfo, nullptr, &m_PositionImageView));
-	VK_CHECK(vkCreateImageView(m_pVulkanDevice->m_Device, &NormalViewInfo, nullptr, &m_NormalImageView));
-	VK_CHECK(vkCreateImageView(m_pVulkanDevice->m_Device, &AlbedoViewInfo, nullptr, &m_AlbedoImageView));
+	m_GBufferPass = m_RenderGraph.AddPass("GBuffer", [&](CRenderGraphPassBuilder& aBuilder)
+	{
+		if (!m_bCompactGBuffer)
+		{
+			aBuilder.WriteColor(m_PositionImage);
+		}
+		aBuilder.WriteColor(m_NormalImage);
+		aBuilder.WriteColor(m_AlbedoImage);
+		aBuilder.WriteDepth(m_DepthImage);
+		aBuilder.UseRenderExtent();
+	},
+	[this](const sRenderGraphPassContext& aContext) { DrawGBufferPass(aContext); });
+
+	// Reading the G-Buffer as input attachments makes the graph merge both passes in one render pass.
+	m_LightPass = m_RenderGraph.AddPass("Light", [&](CRenderGraphPassBuilder& aBuilder)
+	{
+		// The compact layout reconstructs the position from depth.
+		for (RenderGraphResource GBufferImage : { m_bCompactGBuffer ? m_DepthImage : m_PositionImage, m_NormalImage, m_AlbedoImage })
+		{
+			if (m_bSingleRenderPass)
+			{
+				aBuilder.ReadInputAttachment(GBufferImage);
+			}
+			else
+			{
+				aBuilder.ReadTexture(GBufferImage);
+			}
+		}
+		aBuilder.WriteColor(m_SceneColorImage);
+		aBuilder.UseRenderExtent();
+	},
+	[this](const sRenderGraphPassContext& aContext) { DrawLightPass(aContext); });
+
+	m_UpscalePass.AddToGraph(&m_RenderGraph, m_SceneColorImage, m_BackbufferImage);
+
+	m_RenderGraph.Compile(m_pVulkanSwapchain->m_WindowExtent);
+	m_UpscalePass.CreateResources(m_pVulkanBackend->m_DefaultSampler, m_pVulkanBackend->m_DescriptorLayoutCache, m_pVulkanBackend->m_DescriptorAllocator);
 
 	m_MainDeletionQueue.PushFunction([=]()
 	{
-		vkDestroyImageView(m_pVulkanDevice->m_Device, m_PositionImageView, nullptr);
-		vmaDestroyImage(m_pVulkanDevice->m_Allocator, m_PositionImage.Image, m_PositionImage.Allocation);
-		vkDestroyImageView(m_pVulkanDevice->m_Device, m_NormalImageView, nullptr);
-		vmaDestroyImage(m_pVulkanDevice->m_Allocator, m_NormalImage.Image, m_NormalImage.Allocation);
-		vkDestroyImageView(m_pVulkanDevice->m_Device, m_AlbedoImageView, nullptr);
-		vmaDestroyImage(m_pVulkanDevice->m_Allocator, m_AlbedoImage.Image, m_AlbedoImage.Allocation);
+		m_UpscalePass.Destroy();
+		m_RenderGraph.Destroy();
 	});
 }
 
 void CVulkanDeferredRenderPath::CreateGBufferDescriptors()
 {
-    VkDescriptorPoolSize PoolSize = { VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 10 };
-
-	VkDescriptorPoolCreateInfo PoolInfo = {};
-	PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	PoolInfo.flags = 0;
-	PoolInfo.maxSets = 10;
-	PoolInfo.poolSizeCount = 1;
-	PoolInfo.pPoolSizes = &PoolSize;
-
-	vkCreateDescriptorPool(m_pVulkanDevice->m_Device, &PoolInfo, nullptr, &m_DeferredDescriptorPool);
-
 	//gbuffers
-	VkDescriptorSetLayoutBinding PositionBind = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0);
-	VkDescriptorSetLayoutBinding NormalBind = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
-	VkDescriptorSetLayoutBinding AlbedoBind = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 2);
+	const VkDescriptorType GBufferDescriptorType = GetGBufferDescriptorType();
+	// Binding 0 is the position target, or the depth buffer with the compact layout.
+	VkDescriptorSetLayoutBinding PositionBind = vkinit::DescriptorLayoutBinding(GBufferDescriptorType, VK_SHADER_STAGE_FRAGMENT_BIT, 0);
+	VkDescriptorSetLayoutBinding NormalBind = vkinit::DescriptorLayoutBinding(GBufferDescriptorType, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
+	VkDescriptorSetLayoutBinding AlbedoBind = vkinit::DescriptorLayoutBinding(GBufferDescriptorType, VK_SHADER_STAGE_FRAGMENT_BIT, 2);
 
 	std::array<VkDescriptorSetLayoutBinding, 3> DeferredSetLayouts = { PositionBind, NormalBind, AlbedoBind };
 
@@ -319,276 +288,169 @@ void CVulkanDeferredRenderPath::CreateGBufferDescriptors()
 	DeferredLayoutInfo.bindingCount = static_cast<uint32_t>(DeferredSetLayouts.size());
 	DeferredLayoutInfo.pBindings = DeferredSetLayouts.data();
 
-	VK_CHECK(vkCreateDescriptorSetLayout(m_pVulkanDevice->m_Device, &DeferredLayoutInfo, nullptr, &m_GBufferSetLayout));
+	m_GBufferSetLayout = m_pVulkanBackend->m_DescriptorLayoutCache.CreateLayout(DeferredLayoutInfo);
+	m_GBufferDescriptorSet = m_pVulkanBackend->m_DescriptorAllocator.Allocate(m_GBufferSetLayout);
+
+	UpdateGBufferDescriptors();
+}
 
-	VkDescriptorSetAllocateInfo DeferredSetAlloc = {};
-	DeferredSetAlloc.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	DeferredSetAlloc.pNext = nullptr;
-	DeferredSetAlloc.descriptorPool = m_DeferredDescriptorPool;
-	DeferredSetAlloc.descriptorSetCount = 1;
-	DeferredSetAlloc.pSetLayouts = &m_GBufferSetLayout;
+VkDescriptorType CVulkanDeferredRenderPath::GetGBufferDescriptorType() const
+{
+	return m_bSingleRenderPass ? VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT : VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+}
 
-	vkAllocateDescriptorSets(m_pVulkanDevice->m_Device, &DeferredSetAlloc, &m_GBufferDescriptorSet);
+void CVulkanDeferredRenderPath::UpdateGBufferDescriptors()
+{
+	// Input attachments are read with subpassLoad(), they take no sampler.
+	const VkSampler Sampler = m_bSingleRenderPass ? VK_NULL_HANDLE : m_pVulkanBackend->m_DefaultSampler;
+	const VkDescriptorType GBufferDescriptorType = GetGBufferDescriptorType();
 
 	VkDescriptorImageInfo PositionDescriptorImage;
-	PositionDescriptorImage.sampler = m_pVulkanBackend->m_DefaultSampler;
-	PositionDescriptorImage.imageView = m_PositionImageView;
+	PositionDescriptorImage.sampler = Sampler;
+	PositionDescriptorImage.imageView = m_RenderGraph.GetImageView(m_bCompactGBuffer ? m_DepthImage : m_PositionImage);
 	PositionDescriptorImage.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 	VkDescriptorImageInfo NormalDescriptorImage;
-	NormalDescriptorImage.sampler = m_pVulkanBackend->m_DefaultSampler;
-	NormalDescriptorImage.imageView = m_NormalImageView;
+	NormalDescriptorImage.sampler = Sampler;
+	NormalDescriptorImage.imageView = m_RenderGraph.GetImageView(m_NormalImage);
 	NormalDescriptorImage.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
 	VkDescriptorImageInfo AlbedoDescriptorImage;
-	AlbedoDescriptorImage.sampler = m_pVulkanBackend->m_DefaultSampler;
-	AlbedoDescriptorImage.imageView = m_AlbedoImageView;
+	AlbedoDescriptorImage.sampler = Sampler;
+	AlbedoDescriptorImage.imageView = m_RenderGraph.GetImageView(m_AlbedoImage);
 	AlbedoDescriptorImage.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
 
-	VkWriteDescriptorSet PositionTextureWrite = vkinit::WriteDescriptorImage(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_GBufferDescriptorSet, &PositionDescriptorImage, 0);
-	VkWriteDescriptorSet NormalTextureWrite = vkinit::WriteDescriptorImage(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_GBufferDescriptorSet, &NormalDescriptorImage, 1);
-	VkWriteDescriptorSet AlbedoTextureWrite = vkinit::WriteDescriptorImage(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_GBufferDescriptorSet, &AlbedoDescriptorImage, 2);
+	VkWriteDescriptorSet PositionTextureWrite = vkinit::WriteDescriptorImage(GBufferDescriptorType, m_GBufferDescriptorSet, &PositionDescriptorImage, 0);
+	VkWriteDescriptorSet NormalTextureWrite = vkinit::WriteDescriptorImage(GBufferDescriptorType, m_GBufferDescriptorSet, &NormalDescriptorImage, 1);
+	VkWriteDescriptorSet AlbedoTextureWrite = vkinit::WriteDescriptorImage(GBufferDescriptorType, m_GBufferDescriptorSet, &AlbedoDescriptorImage, 2);
 
 	std::array<VkWriteDescriptorSet, 3> SetWrites = { PositionTextureWrite, NormalTextureWrite, AlbedoTextureWrite };
 
 	vkUpdateDescriptorSets(m_pVulkanDevice->m_Device, static_cast<uint32_t>(SetWrites.size()), SetWrites.data(), 0, nullptr);
+}
 
-	VkDescriptorSetLayoutBinding cameraBind = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT, 0);
-
-	VkDescriptorSetLayoutCreateInfo CamSetInfo = {};
-	CamSetInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	CamSetInfo.pNext = nullptr;
-
-	CamSetInfo.bindingCount = 1;
-	CamSetInfo.flags = 0;
-	CamSetInfo.pBindings = &cameraBind;
-
-	vkCreateDescriptorSetLayout(m_pVulkanDevice->m_Device, &CamSetInfo, nullptr, &m_CameraSetLayout);
-
-	VkDescriptorSetAllocateInfo CameraSetAllocInfo = {};
-	CameraSetAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	CameraSetAllocInfo.pNext = nullptr;
-	CameraSetAllocInfo.descriptorPool = m_DeferredDescriptorPool;
-	CameraSetAllocInfo.descriptorSetCount = 1;
-	CameraSetAllocInfo.pSetLayouts = &m_CameraSetLayout;
-	
-	vkAllocateDescriptorSets(m_pVulkanDevice->m_Device, &CameraSetAllocInfo, &m_CameraDescriptorSet);
+void CVulkanDeferredRenderPath::CreateDeferredPipelineLayouts()
+{
+	VkPipelineLayoutCreateInfo LayoutInfo = vkinit::PipelineLayoutCreateInfo();
 
-	m_CameraBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sGPUCameraData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	std::array<VkDescriptorSetLayout, 3> DeferredSetLayouts = { m_pVulkanBackend->m_DescriptorSetLayout, m_pVulkanBackend->m_RenderObjectsSetLayout, m_pVulkanBackend->m_MaterialsSetLayout };
 
-	VkDescriptorBufferInfo CamBufferInfo = {};
-	CamBufferInfo.buffer = m_CameraBuffer.Buffer;
-	CamBufferInfo.offset = 0;
-	CamBufferInfo.range = sizeof(sGPUCameraData);
+	LayoutInfo.pushConstantRangeCount = 0;
+	LayoutInfo.pPushConstantRanges = nullptr;
+	LayoutInfo.setLayoutCount = static_cast<uint32_t>(DeferredSetLayouts.size());
+	LayoutInfo.pSetLayouts = DeferredSetLayouts.data();
 
-	VkWriteDescriptorSet CamWrite = vkinit::WriteDescriptorBuffer(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_CameraDescriptorSet, &CamBufferInfo, 0);
+	VK_CHECK(vkCreatePipelineLayout(m_pVulkanDevice->m_Device, &LayoutInfo, nullptr, &m_DeferredPipelineLayout));
 
-	vkUpdateDescriptorSets(m_pVulkanDevice->m_Device, 1, &CamWrite, 0, nullptr);
+	std::array<VkDescriptorSetLayout, 3> LightSetLayouts = { m_pVulkanBackend->m_DescriptorSetLayout, m_GBufferSetLayout, m_pVulkanBackend->m_ClusteredLighting.GetSetLayout() };
 
-	m_MainDeletionQueue.PushFunction([=]
-	{
-		vmaDestroyBuffer(m_pVulkanDevice->m_Allocator, m_CameraBuffer.Buffer, m_CameraBuffer.Allocation);
-		vkDestroyDescriptorSetLayout(m_pVulkanDevice->m_Device, m_CameraSetLayout, nullptr);
-		vkDestroyDescriptorSetLayout(m_pVulkanDevice->m_Device, m_GBufferSetLayout, nullptr);
-		vkDestroyDescriptorPool(m_pVulkanDevice->m_Device, m_DeferredDescriptorPool, nullptr);
-	});
-}
+	LayoutInfo.setLayoutCount = static_cast<uint32_t>(LightSetLayouts.size());
+	LayoutInfo.pSetLayouts = LightSetLayouts.data();
 
-void CVulkanDeferredRenderPath::CreateDeferredRenderPass()
-{
-	// G-Buffers Pass.
-	VkAttachmentDescription PositionAttachment = {};
-	PositionAttachment.format = m_PositionFormat;
-	PositionAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	PositionAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	PositionAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	PositionAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	PositionAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	PositionAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	PositionAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-	VkAttachmentDescription NormalAttachment = {};
-	NormalAttachment.format = m_NormalFormat;
-	NormalAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	NormalAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	NormalAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	NormalAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	NormalAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	NormalAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	NormalAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-	VkAttachmentDescription AlbedoAttachment = {};
-	AlbedoAttachment.format = m_AlbedoFormat;
-	AlbedoAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	AlbedoAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	AlbedoAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	AlbedoAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	AlbedoAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	AlbedoAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	AlbedoAttachment.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-
-	VkAttachmentDescription DepthAttachment = {};
-	DepthAttachment.format = m_pVulkanDevice->FindDepthFormat();
-	DepthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
-	DepthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-	DepthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-	DepthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-	DepthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-	DepthAttachment.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-	DepthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-	std::array<VkAttachmentDescription, 4> AttachmentDescriptions = { PositionAttachment, NormalAttachment, AlbedoAttachment, DepthAttachment };
-
-	VkAttachmentReference PositionRef;
-	PositionRef.attachment = 0;
-	PositionRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentReference NormalRef;
-	NormalRef.attachment = 1;
-	NormalRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	VkAttachmentReference AlbedoRef;
-	AlbedoRef.attachment = 2;
-	AlbedoRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
-
-	std::array<VkAttachmentReference, 3> ColorReferences = { PositionRef, NormalRef, AlbedoRef };
-
-	VkAttachmentReference DepthRef;
-	DepthRef.attachment = 3;
-	DepthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
-
-	VkSubpassDescription Subpass = {};
-	Subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-	Subpass.colorAttachmentCount = static_cast<uint32_t>(ColorReferences.size());
-	Subpass.pColorAttachments = ColorReferences.data();
-	Subpass.pDepthStencilAttachment = &DepthRef;
-
-	std::array<VkSubpassDependency, 2> Dependencies;
-
-	Dependencies[0].srcSubpass = VK_SUBPASS_EXTERNAL;
-	Dependencies[0].dstSubpass = 0;
-	Dependencies[0].srcStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	Dependencies[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	Dependencies[0].srcAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	Dependencies[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	Dependencies[0].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-	Dependencies[1].srcSubpass = 0;
-	Dependencies[1].dstSubpass = VK_SUBPASS_EXTERNAL;
-	Dependencies[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-	Dependencies[1].dstStageMask = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
-	Dependencies[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
-	Dependencies[1].dstAccessMask = VK_ACCESS_MEMORY_READ_BIT;
-	Dependencies[1].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
-
-	VkRenderPassCreateInfo DeferredPass = {};
-	DeferredPass.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
-	DeferredPass.pNext = nullptr;
-	DeferredPass.attachmentCount = static_cast<uint32_t>(AttachmentDescriptions.size());
-	DeferredPass.pAttachments = AttachmentDescriptions.data();
-	DeferredPass.subpassCount = 1;
-	DeferredPass.pSubpasses = &Subpass;
-	DeferredPass.dependencyCount = static_cast<uint32_t>(Dependencies.size());
-	DeferredPass.pDependencies = Dependencies.data();
-
-	VK_CHECK(vkCreateRenderPass(m_pVulkanDevice->m_Device, &DeferredPass, nullptr, &m_DeferredRenderPass));
+	VK_CHECK(vkCreatePipelineLayout(m_pVulkanDevice->m_Device, &LayoutInfo, nullptr, &m_LightPipelineLayout));
 
 	m_MainDeletionQueue.PushFunction([=]() {
-		vkDestroyRenderPass(m_pVulkanDevice->m_Device, m_DeferredRenderPass, nullptr);
+		vkDestroyPipelineLayout(m_pVulkanDevice->m_Device, m_DeferredPipelineLayout, nullptr);
+		vkDestroyPipelineLayout(m_pVulkanDevice->m_Device, m_LightPipelineLayout, nullptr);
 		});
 }
 
-void CVulkanDeferredRenderPath::CreateGBufferFramebuffer()
+static void SetupDeferredPipelineBuilderState(PipelineBuilder& aBuilder, const sVertexInputDescription& aVertexDescription, const std::vector<VkDynamicState>& aDynamicStates, VkExtent2D aExtent)
 {
-	std::array<VkImageView, 4> Attachments;
-	Attachments[0] = m_PositionImageView;
-	Attachments[1] = m_NormalImageView;
-	Attachments[2] = m_AlbedoImageView;
-	Attachments[3] = m_pVulkanSwapchain->m_DepthImageView;
-
-	VkFramebufferCreateInfo FramebufferInfo = {};
-	FramebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-	FramebufferInfo.pNext = nullptr;
-	FramebufferInfo.renderPass = m_DeferredRenderPass;
-	FramebufferInfo.attachmentCount = static_cast<uint32_t>(Attachments.size());
-	FramebufferInfo.pAttachments = Attachments.data();
-	FramebufferInfo.width = m_pVulkanSwapchain->m_WindowExtent.width;
-	FramebufferInfo.height = m_pVulkanSwapchain->m_WindowExtent.height;
-	FramebufferInfo.layers = 1;
-
-	VK_CHECK(vkCreateFramebuffer(m_pVulkanDevice->m_Device, &FramebufferInfo, nullptr, &m_GBufferFramebuffer));
-
-	m_MainDeletionQueue.PushFunction([=]
-	{
-		vkDestroyFramebuffer(m_pVulkanDevice->m_Device, m_GBufferFramebuffer, nullptr);
-	});
+	aBuilder.m_DynamicState = vkinit::DynamicStateCreateInfo(aDynamicStates);
+
+	aBuilder.m_VertexInputInfo = vkinit::VertexInputStateCreateInfo();
+	aBuilder.m_VertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(aVertexDescription.Bindings.size());
+	aBuilder.m_VertexInputInfo.pVertexBindingDescriptions = aVertexDescription.Bindings.data();
+	aBuilder.m_VertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(aVertexDescription.Attributes.size());
+	aBuilder.m_VertexInputInfo.pVertexAttributeDescriptions = aVertexDescription.Attributes.data();
+
+	aBuilder.m_InputAssembly = vkinit::InputAssemblyCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+	aBuilder.m_Viewport.x = 0.0f;
+	aBuilder.m_Viewport.y = 0.0f;
+	aBuilder.m_Viewport.width = static_cast<float>(aExtent.width);
+	aBuilder.m_Viewport.height = static_cast<float>(aExtent.height);
+	aBuilder.m_Viewport.minDepth = 0.0f;
+	aBuilder.m_Viewport.maxDepth = 1.0f;
+
+	aBuilder.m_Scissor.offset = {0, 0};
+	aBuilder.m_Scissor.extent = aExtent;
+
+	aBuilder.m_Rasterizer = vkinit::RasterizationStateCreateInfo(VK_POLYGON_MODE_FILL);
+	aBuilder.m_Multisampling = vkinit::MultisamplingStateCreateInfo();
 }
 
-void CVulkanDeferredRenderPath::CreateDeferredPipeline()
+void CVulkanDeferredRenderPath::BuildGBufferPipeline()
 {
 	VkShaderModule DeferredVertShader;
-	// TODO: Do not hardcode this.
-	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, "../Engine/shaders/deferred_vert.spv", &DeferredVertShader))
+	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, vkutils::GetShaderPath("deferred_vert.spv").c_str(), &DeferredVertShader))
 	{
-		std::cout << "Error when building the deferred vertex shader module" << std::endl;
-	}
-	else
-	{
-		std::cout << "Deferred Vertex Shader loaded SUCCESSFULLY!" << std::endl;
+		SGSERROR("Error when building the deferred vertex shader module");
 	}
 
 	VkShaderModule DeferredFragShader;
-	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, "../Engine/shaders/deferred_frag.spv", &DeferredFragShader))
-	{
-		std::cout << "Error when building the deferred fragment shader module" << std::endl;
-	}
-	else
+	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, vkutils::GetShaderPath(m_bCompactGBuffer ? "deferred_compact_frag.spv" : "deferred_frag.spv").c_str(), &DeferredFragShader))
 	{
-		std::cout << "Deferred Fragment Shader loaded SUCCESSFULLY!" << std::endl;
+		SGSERROR("Error when building the deferred fragment shader module");
 	}
 
-	VkShaderModule LightVertexShader;
-	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, "../Engine/shaders/light_vert.spv", &LightVertexShader))
-	{
-		std::cout << "Error when building the light vertex shader module" << std::endl;
-	}
-	else
+	std::vector<VkDynamicState> DynamicStates = 
 	{
-		std::cout << "Light Vertex Shader loaded SUCCESSFULLY!" << std::endl;
-	}
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
 
-	VkShaderModule LightFragShader;
-	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, "../Engine/shaders/light_frag.spv", &LightFragShader))
-	{
-		std::cout << "Error when building the light fragment shader module" << std::endl;
-	}
-	else
-	{
-		std::cout << "Light Fragment Shader loaded SUCCESSFULLY!" << std::endl;
-	}
+	const sVertexInputDescription VertexDescription = GetVertexDescription();
 
-	// Layouts
-	VkPipelineLayoutCreateInfo LayoutInfo = vkinit::PipelineLayoutCreateInfo();
+	PipelineBuilder PipelineBuilder;
+	SetupDeferredPipelineBuilderState(PipelineBuilder, VertexDescription, DynamicStates, m_pVulkanSwapchain->m_WindowExtent);
 
-	std::array<VkDescriptorSetLayout, 2> DeferredSetLayouts = { m_CameraSetLayout, m_pVulkanBackend->m_RenderObjectsSetLayout };
+	// The depth is reversed, nearer is greater.
+	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(true, true, VK_COMPARE_OP_GREATER);
 
-	LayoutInfo.pushConstantRangeCount = 0;
-	LayoutInfo.pPushConstantRanges = nullptr;
-	LayoutInfo.setLayoutCount = static_cast<uint32_t>(DeferredSetLayouts.size());
-	LayoutInfo.pSetLayouts = DeferredSetLayouts.data();
+	const uint32_t NumGBufferTargets = m_bCompactGBuffer ? 2 : 3;
+	for (uint32_t i = 0; i < NumGBufferTargets; ++i)
+	{
+		PipelineBuilder.m_ColorBlendAttachment.push_back(vkinit::ColorBlendAttachmentState());
+	}
 
-	VK_CHECK(vkCreatePipelineLayout(m_pVulkanDevice->m_Device, &LayoutInfo, nullptr, &m_DeferredPipelineLayout));
+	PipelineBuilder.m_ShaderStages.push_back(
+		vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, DeferredVertShader));
+	PipelineBuilder.m_ShaderStages.push_back(
+		vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT, DeferredFragShader));
 
-	std::array<VkDescriptorSetLayout, 2> LightSetLayouts = { m_pVulkanBackend->m_DescriptorSetLayout, m_GBufferSetLayout };
+	PipelineBuilder.m_PipelineLayout = m_DeferredPipelineLayout;
 
-	LayoutInfo.setLayoutCount = static_cast<uint32_t>(LightSetLayouts.size());
-	LayoutInfo.pSetLayouts = LightSetLayouts.data();
+	m_DeferredPipeline = PipelineBuilder.BuildPipeline(m_pVulkanDevice->m_Device, m_RenderGraph.GetRenderPass(m_GBufferPass), m_pVulkanBackend->m_PipelineCache.GetHandle());
 
-	VK_CHECK(vkCreatePipelineLayout(m_pVulkanDevice->m_Device, &LayoutInfo, nullptr, &m_LightPipelineLayout));
+	vkDestroyShaderModule(m_pVulkanDevice->m_Device, DeferredFragShader, nullptr);
+	vkDestroyShaderModule(m_pVulkanDevice->m_Device, DeferredVertShader, nullptr);
 
+	m_MainDeletionQueue.PushFunction([=]() {
+		vkDestroyPipeline(m_pVulkanDevice->m_Device, m_DeferredPipeline, nullptr);
+		});
+}
 
-	// G-Buffers Pipeline Creation.
-	PipelineBuilder PipelineBuilder;
+void CVulkanDeferredRenderPath::BuildLightPipeline()
+{
+	VkShaderModule LightVertexShader;
+	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, vkutils::GetShaderPath("light_vert.spv").c_str(), &LightVertexShader))
+	{
+		SGSERROR("Error when building the light vertex shader module");
+	}
+
+	VkShaderModule LightFragShader;
+	static const char* LightFragShaderFiles[2][2] =
+	{
+		{ "light_frag.spv", "light_compact_frag.spv" },
+		{ "light_subpass_frag.spv", "light_subpass_compact_frag.spv" }
+	};
+	const char* LightFragShaderFile = LightFragShaderFiles[m_bSingleRenderPass][m_bCompactGBuffer];
+	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, vkutils::GetShaderPath(LightFragShaderFile).c_str(), &LightFragShader))
+	{
+		SGSERROR("Error when building the light fragment shader module");
+	}
 
 	std::vector<VkDynamicState> DynamicStates = 
 	{
@@ -596,107 +458,29 @@ void CVulkanDeferredRenderPath::CreateDeferredPipeline()
 		VK_DYNAMIC_STATE_SCISSOR
 	};
 
-	PipelineBuilder.m_DynamicState = vkinit::DynamicStateCreateInfo(DynamicStates);
-
-	sVertexInputDescription VertexDescription = GetVertexDescription();
-
-	PipelineBuilder.m_VertexInputInfo = vkinit::VertexInputStateCreateInfo();
-	PipelineBuilder.m_VertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(VertexDescription.Bindings.size());
-	PipelineBuilder.m_VertexInputInfo.pVertexBindingDescriptions = VertexDescription.Bindings.data();
-	PipelineBuilder.m_VertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(VertexDescription.Attributes.size());
-	PipelineBuilder.m_VertexInputInfo.pVertexAttributeDescriptions = VertexDescription.Attributes.data();
-
-	PipelineBuilder.m_InputAssembly = vkinit::InputAssemblyCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
-
-	PipelineBuilder.m_Viewport.x = 0.0f;
-	PipelineBuilder.m_Viewport.y = 0.0f;
-	PipelineBuilder.m_Viewport.width = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.width);
-	PipelineBuilder.m_Viewport.height = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.height);
-	PipelineBuilder.m_Viewport.minDepth = 0.0f;
-	PipelineBuilder.m_Viewport.maxDepth = 1.0f;
-
-	PipelineBuilder.m_Scissor.offset = {0, 0};
-	PipelineBuilder.m_Scissor.extent = m_pVulkanSwapchain->m_WindowExtent;
-
-	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(true, true, VK_COMPARE_OP_LESS);
-	PipelineBuilder.m_Rasterizer = vkinit::RasterizationStateCreateInfo(VK_POLYGON_MODE_FILL);
-	PipelineBuilder.m_Multisampling = vkinit::MultisamplingStateCreateInfo();
-
-	PipelineBuilder.m_ColorBlendAttachment.push_back(vkinit::ColorBlendAttachmentState());
-	PipelineBuilder.m_ColorBlendAttachment.push_back(vkinit::ColorBlendAttachmentState());
-	PipelineBuilder.m_ColorBlendAttachment.push_back(vkinit::ColorBlendAttachmentState());
-
-	//Deferred Shaders
-	PipelineBuilder.m_ShaderStages.push_back(
-		vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, DeferredVertShader));
-	PipelineBuilder.m_ShaderStages.push_back(
-		vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT, DeferredFragShader));
-
-	PipelineBuilder.m_PipelineLayout = m_DeferredPipelineLayout;
-
-	m_DeferredPipeline = PipelineBuilder.BuildPipeline(m_pVulkanDevice->m_Device, m_DeferredRenderPass);
+	const sVertexInputDescription VertexDescription = GetVertexDescription();
 
-	// Light Pipeline Creation.
+	PipelineBuilder PipelineBuilder;
+	SetupDeferredPipelineBuilderState(PipelineBuilder, VertexDescription, DynamicStates, m_pVulkanSwapchain->m_WindowExtent);
 
-	//Light Depth Stencil
 	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(false, false, VK_COMPARE_OP_ALWAYS);
 
-	//Deferred Color Blend Attachment
-	PipelineBuilder.m_ColorBlendAttachment.clear();
 	PipelineBuilder.m_ColorBlendAttachment.push_back(vkinit::ColorBlendAttachmentState());
 
-	//Light Shaders
-	PipelineBuilder.m_ShaderStages.clear();
 	PipelineBuilder.m_ShaderStages.push_back(
 		vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, LightVertexShader));
 	PipelineBuilder.m_ShaderStages.push_back(
 		vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT, LightFragShader));
 
-	//Light Layout
 	PipelineBuilder.m_PipelineLayout = m_LightPipelineLayout;
+	PipelineBuilder.m_Subpass = m_RenderGraph.GetSubpassIndex(m_LightPass);
 
-	m_LightPipeline = PipelineBuilder.BuildPipeline(m_pVulkanDevice->m_Device, m_pVulkanSwapchain->m_RenderPass);
-
-	//DELETIONS
+	m_LightPipeline = PipelineBuilder.BuildPipeline(m_pVulkanDevice->m_Device, m_RenderGraph.GetRenderPass(m_LightPass), m_pVulkanBackend->m_PipelineCache.GetHandle());
 
 	vkDestroyShaderModule(m_pVulkanDevice->m_Device, LightFragShader, nullptr);
 	vkDestroyShaderModule(m_pVulkanDevice->m_Device, LightVertexShader, nullptr);
-	vkDestroyShaderModule(m_pVulkanDevice->m_Device, DeferredFragShader, nullptr);
-	vkDestroyShaderModule(m_pVulkanDevice->m_Device, DeferredVertShader, nullptr);
 
 	m_MainDeletionQueue.PushFunction([=]() {
-		vkDestroyPipeline(m_pVulkanDevice->m_Device, m_DeferredPipeline, nullptr);
 		vkDestroyPipeline(m_pVulkanDevice->m_Device, m_LightPipeline, nullptr);
-
-		vkDestroyPipelineLayout(m_pVulkanDevice->m_Device, m_DeferredPipelineLayout, nullptr);
-		vkDestroyPipelineLayout(m_pVulkanDevice->m_Device, m_LightPipelineLayout, nullptr);
 		});
 }
-
-void CVulkanDeferredRenderPath::CreateDeferredCommandStructures()
-{
-    VkCommandPoolCreateInfo CommandPoolInfo = vkinit::CommandPoolCreateInfo(m_pVulkanDevice->m_GraphicsQueueFamily, VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT);
-	
-	VK_CHECK(vkCreateCommandPool(m_pVulkanDevice->m_Device, &CommandPoolInfo, nullptr, &m_DeferredCommandPool));
-
-	VkCommandBufferAllocateInfo CmdAllocInfo = vkinit::CommandBufferAllocateInfo(m_DeferredCommandPool, 1);
-	VK_CHECK(vkAllocateCommandBuffers(m_pVulkanDevice->m_Device, &CmdAllocInfo, &m_DeferredCommandBuffer));
-
-	m_MainDeletionQueue.PushFunction([=]() {
-		vkDestroyCommandPool(m_pVulkanDevice->m_Device, m_DeferredCommandPool, nullptr);
-	});
-}
-
-void CVulkanDeferredRenderPath::CreateDeferredSyncrhonizationStructures()
-{
-	VkSemaphoreCreateInfo GBufferReadySempahoreInfo = {};
-	GBufferReadySempahoreInfo.sType = VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO;
-	GBufferReadySempahoreInfo.pNext = nullptr;
-	GBufferReadySempahoreInfo.flags = 0;
-
-	VK_CHECK(vkCreateSemaphore(m_pVulkanDevice->m_Device, &GBufferReadySempahoreInfo, nullptr, &m_GBufferReadySemaphore));
-
-	m_MainDeletionQueue.PushFunction([=]() {
-		vkDestroySemaphore(m_pVulkanDevice->m_Device, m_GBufferReadySemaphore, nullptr);
-	});
-}
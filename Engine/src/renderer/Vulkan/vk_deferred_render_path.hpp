@@ -1,6 +1,8 @@
 #pragma once
 
 #include "vk_types.hpp"
+#include "vk_render_graph.hpp"
+#include "vk_upscale_pass.hpp"
 #include <renderer/render_pipeline/IRenderPath.hpp>
 #include <core/types.hpp>
 #include "vulkan_backend.hpp"
@@ -8,70 +10,74 @@
 class CVulkanDevice;
 class CVulkanSwapchain;
 
-struct sGPUCameraData {
-	glm::mat4 View;
-	glm::mat4 Projection;
-	glm::mat4 Viewproj;
-};
+// G-Buffer layout used by the deferred render paths, see gbuffer.glsl. The compact layout drops the position target
+// (it is reconstructed from depth) and packs normals and material, 8 bytes per pixel instead of 20.
+// Can be overridden at build time (/DSGS_COMPACT_GBUFFER=0).
+#ifndef SGS_COMPACT_GBUFFER
+#define SGS_COMPACT_GBUFFER 1
+#endif
 
 class CVulkanDeferredRenderPath : public IRenderPath
 {
 public:
-    CVulkanDeferredRenderPath(CVulkanBackend* apVulkanBackend, CVulkanDevice* apVulkanDevice, CVulkanSwapchain* apVulkanSwapchain);
+    /**
+     * @param abSingleRenderPass Records the G-Buffer and light passes as two subpasses of one render pass. The light pass
+     * reads the G-Buffer as input attachments, so on tiled GPUs it never leaves tile memory.
+     * @param abCompactGBuffer Uses the compact G-Buffer layout.
+     */
+    CVulkanDeferredRenderPath(CVulkanBackend* apVulkanBackend, CVulkanDevice* apVulkanDevice, CVulkanSwapchain* apVulkanSwapchain, bool abSingleRenderPass, bool abCompactGBuffer);
     virtual void CreateResources() override;
+    virtual void CreatePipelines(sJobCounter& aCounter) override;
     virtual void DestroyResources() override;
-    virtual void Render(const CCamera* const aCamera) override;
-    virtual void UpdateBuffers() override;
+    virtual void Render(const sFramePacket& aFramePacket) override;
+    // The G-Buffer pass uses the frame UBO of the backend.
+    virtual void UpdateBuffers() override {};
     virtual void HandleSceneChanged() override;
+    virtual void HandleSwapchainRecreated() override;
 
 private:
     void CreateDeferredQuad();
-    void CreateDeferredAttachments();
+    void CreateRenderGraph();
     void CreateGBufferDescriptors();
-    void CreateDeferredRenderPass();
-    void CreateGBufferFramebuffer();
-    void CreateDeferredPipeline();
-    void CreateDeferredCommandStructures();
-    void CreateDeferredSyncrhonizationStructures();
+    void UpdateGBufferDescriptors();
+    void CreateDeferredPipelineLayouts();
+    void BuildGBufferPipeline();
+    void BuildLightPipeline();
+    VkDescriptorType GetGBufferDescriptorType() const;
 
-    void RecordLightPassCommands(VkCommandBuffer aCommandBuffer, uint32_t aImageIdx);
-    void RecordGBufferPassCommands();
+    void RecordCommands(VkCommandBuffer aCommandBuffer, uint32_t aImageIdx);
+    void DrawGBufferPass(const sRenderGraphPassContext& aContext);
+    void DrawLightPass(const sRenderGraphPassContext& aContext);
 
     CVulkanBackend* m_pVulkanBackend;
     CVulkanDevice* m_pVulkanDevice;
     CVulkanSwapchain* m_pVulkanSwapchain;
-
-    VkFormat m_PositionFormat;
-    VkFormat m_NormalFormat;
-    VkFormat m_AlbedoFormat;
-
-    AllocatedImage m_PositionImage;
-    AllocatedImage m_NormalImage;
-    AllocatedImage m_AlbedoImage;
-
-    VkImageView m_PositionImageView;
-    VkImageView m_NormalImageView;
-    VkImageView m_AlbedoImageView;
-
-    VkFramebuffer m_GBufferFramebuffer;
-    VkRenderPass m_DeferredRenderPass;
-
+    const bool m_bSingleRenderPass;
+    const bool m_bCompactGBuffer;
+
+    // G-Buffer targets and depth are transient images owned by the render graph.
+    // The position target is only used by the standard layout.
+    // The scene is rendered at the dynamic resolution into the scene color and upscaled into the backbuffer.
+    CVulkanRenderGraph m_RenderGraph;
+    RenderGraphResource m_BackbufferImage;
+    RenderGraphResource m_SceneColorImage;
+    RenderGraphResource m_PositionImage;
+    RenderGraphResource m_NormalImage;
+    RenderGraphResource m_AlbedoImage;
+    RenderGraphResource m_DepthImage;
+    uint32_t m_GBufferPass;
+    uint32_t m_LightPass;
+    CVulkanUpscalePass m_UpscalePass;
+
+    // Owned by the layout cache of the backend, the set is allocated from its descriptor allocator.
     VkDescriptorSetLayout m_GBufferSetLayout;
-    VkDescriptorSetLayout m_CameraSetLayout;
-    VkDescriptorPool m_DeferredDescriptorPool;
     VkDescriptorSet m_GBufferDescriptorSet;
-    VkDescriptorSet m_CameraDescriptorSet;
-    AllocatedBuffer m_CameraBuffer;
 
     VkPipelineLayout m_DeferredPipelineLayout;
     VkPipelineLayout m_LightPipelineLayout;
     VkPipeline m_DeferredPipeline;
     VkPipeline m_LightPipeline;
 
-    VkCommandPool m_DeferredCommandPool;
-    VkCommandBuffer m_DeferredCommandBuffer;
-    VkSemaphore m_GBufferReadySemaphore;
-
     CVulkanRenderable* m_Quad;
 
     // Holds the deletion functions.
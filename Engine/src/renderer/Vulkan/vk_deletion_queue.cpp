@@ -0,0 +1,183 @@
+#include "vk_deletion_queue.hpp"
+#include "vulkan_device.hpp"
+
+#include <cstring>
+
+namespace
+{
+	// Handles are pointers or 64 bit integers depending on the platform.
+	template <typename T>
+	uint64_t HandleToUInt64(T aHandle)
+	{
+		uint64_t Value = 0;
+		memcpy(&Value, &aHandle, sizeof(T));
+		return Value;
+	}
+}
+
+CVulkanDeletionQueue::CVulkanDeletionQueue() :
+	m_pVulkanDevice(nullptr),
+	m_CurrentFrame(0)
+{
+}
+
+void CVulkanDeletionQueue::Initialize(CVulkanDevice* apVulkanDevice)
+{
+	m_pVulkanDevice = apVulkanDevice;
+}
+
+void CVulkanDeletionQueue::DestroyBuffer(const AllocatedBuffer& aBuffer)
+{
+	sRecord Record = {};
+	Record.Type = eObjectType::BUFFER;
+	Record.Buffer = aBuffer.Buffer;
+	Record.Allocation = aBuffer.Allocation;
+	Push(Record);
+}
+
+void CVulkanDeletionQueue::DestroyImage(const AllocatedImage& aImage)
+{
+	sRecord Record = {};
+	Record.Type = eObjectType::IMAGE;
+	Record.Image = aImage.Image;
+	Record.Allocation = aImage.Allocation;
+	Push(Record);
+}
+
+void CVulkanDeletionQueue::DestroyImageView(VkImageView aImageView)
+{
+	sRecord Record = {};
+	Record.Type = eObjectType::IMAGE_VIEW;
+	Record.ImageView = aImageView;
+	Push(Record);
+}
+
+void CVulkanDeletionQueue::DestroySampler(VkSampler aSampler)
+{
+	sRecord Record = {};
+	Record.Type = eObjectType::SAMPLER;
+	Record.Sampler = aSampler;
+	Push(Record);
+}
+
+void CVulkanDeletionQueue::DestroyFramebuffer(VkFramebuffer aFramebuffer)
+{
+	sRecord Record = {};
+	Record.Type = eObjectType::FRAMEBUFFER;
+	Record.Framebuffer = aFramebuffer;
+	Push(Record);
+}
+
+void CVulkanDeletionQueue::DestroyRenderPass(VkRenderPass aRenderPass)
+{
+	sRecord Record = {};
+	Record.Type = eObjectType::RENDER_PASS;
+	Record.RenderPass = aRenderPass;
+	Push(Record);
+}
+
+void CVulkanDeletionQueue::DestroyPipeline(VkPipeline aPipeline)
+{
+	sRecord Record = {};
+	Record.Type = eObjectType::PIPELINE;
+	Record.Pipeline = aPipeline;
+	Push(Record);
+}
+
+void CVulkanDeletionQueue::DestroyDescriptorPool(VkDescriptorPool aDescriptorPool)
+{
+	sRecord Record = {};
+	Record.Type = eObjectType::DESCRIPTOR_POOL;
+	Record.DescriptorPool = aDescriptorPool;
+	Push(Record);
+}
+
+void CVulkanDeletionQueue::SetReleaseListener(std::function<void(uint64_t)> aListener)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	m_ReleaseListener = std::move(aListener);
+}
+
+uint64_t CVulkanDeletionQueue::BeginFrame()
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	return ++m_CurrentFrame;
+}
+
+void CVulkanDeletionQueue::CollectGarbage(uint64_t aCompletedFrame)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	while (!m_Records.empty() && m_Records.front().Frame <= aCompletedFrame)
+	{
+		Destroy(m_Records.front());
+		m_Records.pop_front();
+	}
+}
+
+void CVulkanDeletionQueue::Flush()
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	for (const sRecord& Record : m_Records)
+	{
+		Destroy(Record);
+	}
+	m_Records.clear();
+}
+
+void CVulkanDeletionQueue::Push(sRecord& aRecord)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	// A frame recorded before this one may still use the object, and so may the one being recorded.
+	aRecord.Frame = m_CurrentFrame;
+	m_Records.push_back(aRecord);
+}
+
+void CVulkanDeletionQueue::Destroy(const sRecord& aRecord) const
+{
+	if (m_ReleaseListener)
+	{
+		switch (aRecord.Type)
+		{
+			case eObjectType::BUFFER:
+				m_ReleaseListener(HandleToUInt64(aRecord.Buffer));
+				break;
+			case eObjectType::IMAGE_VIEW:
+				m_ReleaseListener(HandleToUInt64(aRecord.ImageView));
+				break;
+			case eObjectType::SAMPLER:
+				m_ReleaseListener(HandleToUInt64(aRecord.Sampler));
+				break;
+			default:
+				break;
+		}
+	}
+
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+	switch (aRecord.Type)
+	{
+		case eObjectType::BUFFER:
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer({ aRecord.Buffer, aRecord.Allocation });
+			break;
+		case eObjectType::IMAGE:
+			m_pVulkanDevice->m_MemoryAllocator.DestroyImage({ aRecord.Image, aRecord.Allocation });
+			break;
+		case eObjectType::IMAGE_VIEW:
+			vkDestroyImageView(Device, aRecord.ImageView, nullptr);
+			break;
+		case eObjectType::SAMPLER:
+			vkDestroySampler(Device, aRecord.Sampler, nullptr);
+			break;
+		case eObjectType::FRAMEBUFFER:
+			vkDestroyFramebuffer(Device, aRecord.Framebuffer, nullptr);
+			break;
+		case eObjectType::RENDER_PASS:
+			vkDestroyRenderPass(Device, aRecord.RenderPass, nullptr);
+			break;
+		case eObjectType::PIPELINE:
+			vkDestroyPipeline(Device, aRecord.Pipeline, nullptr);
+			break;
+		case eObjectType::DESCRIPTOR_POOL:
+			vkDestroyDescriptorPool(Device, aRecord.DescriptorPool, nullptr);
+			break;
+	}
+}
@@ -0,0 +1,101 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+#include <deque>
+#include <functional>
+#include <mutex>
+
+class CVulkanDevice;
+
+/**
+ * @brief Destroys Vulkan objects once the GPU is done with them, so they can be released at runtime (unloading a level,
+ * streaming assets) without waiting for the queue to go idle.
+ *
+ * Every released object is stored as a typed record tagged with the number of the frame being recorded at that moment.
+ * When the fence of a frame is waited, CollectGarbage() destroys the records tagged up to that frame: every submission
+ * that could use them has finished. sDeletionQueue is still used for the objects that live until shutdown.
+ *
+ * The Destroy functions can be called from any thread.
+ */
+class CVulkanDeletionQueue
+{
+public:
+    CVulkanDeletionQueue();
+
+    void Initialize(CVulkanDevice* apVulkanDevice);
+
+    void DestroyBuffer(const AllocatedBuffer& aBuffer);
+    void DestroyImage(const AllocatedImage& aImage);
+    void DestroyImageView(VkImageView aImageView);
+    void DestroySampler(VkSampler aSampler);
+    void DestroyFramebuffer(VkFramebuffer aFramebuffer);
+    void DestroyRenderPass(VkRenderPass aRenderPass);
+    void DestroyPipeline(VkPipeline aPipeline);
+    void DestroyDescriptorPool(VkDescriptorPool aDescriptorPool);
+
+    /**
+     * @brief aListener(uint64_t aHandle) is called with the handle value of every buffer, image view and sampler right
+     * before it is destroyed, so the caches keyed by handles forget it before the driver reuses the value. Called with
+     * the queue locked, it must not release objects.
+     */
+    void SetReleaseListener(std::function<void(uint64_t)> aListener);
+
+    /**
+     * @brief Starts recording a new frame.
+     * @return Number of the frame, to be passed to CollectGarbage() once its fence is signaled.
+     */
+    uint64_t BeginFrame();
+
+    /**
+     * @brief Destroys the objects released up to frame aCompletedFrame, whose fence must be signaled.
+     */
+    void CollectGarbage(uint64_t aCompletedFrame);
+
+    /**
+     * @brief Destroys every pending object. The GPU must be idle.
+     */
+    void Flush();
+
+private:
+    enum class eObjectType : uint8_t
+    {
+        BUFFER = 0,
+        IMAGE,
+        IMAGE_VIEW,
+        SAMPLER,
+        FRAMEBUFFER,
+        RENDER_PASS,
+        PIPELINE,
+        DESCRIPTOR_POOL
+    };
+
+    struct sRecord
+    {
+        eObjectType Type;
+        union
+        {
+            VkBuffer Buffer;
+            VkImage Image;
+            VkImageView ImageView;
+            VkSampler Sampler;
+            VkFramebuffer Framebuffer;
+            VkRenderPass RenderPass;
+            VkPipeline Pipeline;
+            VkDescriptorPool DescriptorPool;
+        };
+        VmaAllocation Allocation;
+        uint64_t Frame;
+    };
+
+    void Push(sRecord& aRecord);
+    void Destroy(const sRecord& aRecord) const;
+
+    CVulkanDevice* m_pVulkanDevice;
+    std::function<void(uint64_t)> m_ReleaseListener;
+
+    // Sorted by frame, the frame number only grows and is read under the mutex.
+    std::deque<sRecord> m_Records;
+    uint64_t m_CurrentFrame;
+    std::mutex m_Mutex;
+};
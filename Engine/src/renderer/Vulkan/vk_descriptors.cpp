@@ -0,0 +1,338 @@
+#include "vk_descriptors.hpp"
+#include "vk_initializers.hpp"
+#include <core/logger.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	// Pools stop growing past this size, a new pool is created instead.
+	constexpr uint32_t MAX_SETS_PER_POOL = 4096;
+
+	// Handles are pointers or 64 bit integers depending on the platform.
+	template <typename T>
+	uint64_t HandleToUInt64(T aHandle)
+	{
+		uint64_t Value = 0;
+		memcpy(&Value, &aHandle, sizeof(T));
+		return Value;
+	}
+
+	inline void HashCombine(size_t& aSeed, uint64_t aValue)
+	{
+		aSeed ^= std::hash<uint64_t>()(aValue) + 0x9e3779b97f4a7c15ull + (aSeed << 6) + (aSeed >> 2);
+	}
+
+	bool IsImageDescriptor(VkDescriptorType aType)
+	{
+		return aType == VK_DESCRIPTOR_TYPE_SAMPLER || aType == VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER || aType == VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE ||
+			aType == VK_DESCRIPTOR_TYPE_STORAGE_IMAGE || aType == VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+	}
+}
+
+CVulkanDescriptorAllocator::CVulkanDescriptorAllocator() :
+	m_Device(VK_NULL_HANDLE),
+	m_SetsPerPool(0)
+{
+}
+
+void CVulkanDescriptorAllocator::Initialize(VkDevice aDevice, uint32_t aInitialSets, const std::vector<sDescriptorPoolRatio>& aRatios)
+{
+	assert(aInitialSets > 0 && !aRatios.empty());
+
+	m_Device = aDevice;
+	m_Ratios = aRatios;
+	m_SetsPerPool = std::min(aInitialSets, MAX_SETS_PER_POOL);
+}
+
+void CVulkanDescriptorAllocator::Shutdown()
+{
+	for (VkDescriptorPool Pool : m_ReadyPools)
+	{
+		vkDestroyDescriptorPool(m_Device, Pool, nullptr);
+	}
+	for (VkDescriptorPool Pool : m_FullPools)
+	{
+		vkDestroyDescriptorPool(m_Device, Pool, nullptr);
+	}
+	m_ReadyPools.clear();
+	m_FullPools.clear();
+}
+
+VkDescriptorSet CVulkanDescriptorAllocator::Allocate(VkDescriptorSetLayout aLayout)
+{
+	VkDescriptorPool Pool = GetPool();
+
+	VkDescriptorSetAllocateInfo AllocInfo = {};
+	AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
+	AllocInfo.descriptorPool = Pool;
+	AllocInfo.descriptorSetCount = 1;
+	AllocInfo.pSetLayouts = &aLayout;
+
+	VkDescriptorSet Set = VK_NULL_HANDLE;
+	VkResult Result = vkAllocateDescriptorSets(m_Device, &AllocInfo, &Set);
+	if (Result == VK_ERROR_OUT_OF_POOL_MEMORY || Result == VK_ERROR_FRAGMENTED_POOL)
+	{
+		// The pool is done, the next one is empty and the allocation has to fit.
+		m_FullPools.push_back(Pool);
+		Pool = GetPool();
+		AllocInfo.descriptorPool = Pool;
+		Result = vkAllocateDescriptorSets(m_Device, &AllocInfo, &Set);
+	}
+	VK_CHECK(Result);
+
+	m_ReadyPools.push_back(Pool);
+	return Set;
+}
+
+VkDescriptorPool CVulkanDescriptorAllocator::GetPool()
+{
+	if (!m_ReadyPools.empty())
+	{
+		const VkDescriptorPool Pool = m_ReadyPools.back();
+		m_ReadyPools.pop_back();
+		return Pool;
+	}
+
+	std::vector<VkDescriptorPoolSize> PoolSizes;
+	PoolSizes.reserve(m_Ratios.size());
+	for (const sDescriptorPoolRatio& Ratio : m_Ratios)
+	{
+		const uint32_t Count = static_cast<uint32_t>(std::ceil(Ratio.Ratio * m_SetsPerPool));
+		PoolSizes.push_back({ Ratio.Type, std::max(Count, 1u) });
+	}
+
+	VkDescriptorPoolCreateInfo PoolInfo = {};
+	PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
+	PoolInfo.poolSizeCount = static_cast<uint32_t>(PoolSizes.size());
+	PoolInfo.pPoolSizes = PoolSizes.data();
+	PoolInfo.maxSets = m_SetsPerPool;
+
+	VkDescriptorPool Pool;
+	VK_CHECK(vkCreateDescriptorPool(m_Device, &PoolInfo, nullptr, &Pool));
+
+	// Allocators that keep running out need fewer, larger pools.
+	m_SetsPerPool = std::min(m_SetsPerPool + m_SetsPerPool / 2, MAX_SETS_PER_POOL);
+
+	return Pool;
+}
+
+CVulkanDescriptorLayoutCache::CVulkanDescriptorLayoutCache() :
+	m_Device(VK_NULL_HANDLE)
+{
+}
+
+void CVulkanDescriptorLayoutCache::Initialize(VkDevice aDevice)
+{
+	m_Device = aDevice;
+}
+
+void CVulkanDescriptorLayoutCache::Shutdown()
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	for (const auto& Entry : m_Layouts)
+	{
+		vkDestroyDescriptorSetLayout(m_Device, Entry.second, nullptr);
+	}
+	m_Layouts.clear();
+}
+
+VkDescriptorSetLayout CVulkanDescriptorLayoutCache::CreateLayout(const VkDescriptorSetLayoutCreateInfo& aInfo)
+{
+	assert(aInfo.pNext == nullptr);
+
+	sLayoutKey Key;
+	Key.Flags = aInfo.flags;
+	Key.Bindings.assign(aInfo.pBindings, aInfo.pBindings + aInfo.bindingCount);
+	std::sort(Key.Bindings.begin(), Key.Bindings.end(), [](const VkDescriptorSetLayoutBinding& aA, const VkDescriptorSetLayoutBinding& aB)
+	{
+		return aA.binding < aB.binding;
+	});
+
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	const auto It = m_Layouts.find(Key);
+	if (It != m_Layouts.end())
+	{
+		return It->second;
+	}
+
+	VkDescriptorSetLayout Layout;
+	VK_CHECK(vkCreateDescriptorSetLayout(m_Device, &aInfo, nullptr, &Layout));
+	m_Layouts.emplace(std::move(Key), Layout);
+	return Layout;
+}
+
+bool CVulkanDescriptorLayoutCache::sLayoutKey::operator==(const sLayoutKey& aOther) const
+{
+	if (Flags != aOther.Flags || Bindings.size() != aOther.Bindings.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < Bindings.size(); ++i)
+	{
+		const VkDescriptorSetLayoutBinding& A = Bindings[i];
+		const VkDescriptorSetLayoutBinding& B = aOther.Bindings[i];
+		assert(A.pImmutableSamplers == nullptr && B.pImmutableSamplers == nullptr);
+		if (A.binding != B.binding || A.descriptorType != B.descriptorType || A.descriptorCount != B.descriptorCount || A.stageFlags != B.stageFlags)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+size_t CVulkanDescriptorLayoutCache::sLayoutKeyHash::operator()(const sLayoutKey& aKey) const
+{
+	size_t Hash = std::hash<uint32_t>()(aKey.Flags);
+	for (const VkDescriptorSetLayoutBinding& Binding : aKey.Bindings)
+	{
+		HashCombine(Hash, Binding.binding);
+		HashCombine(Hash, static_cast<uint64_t>(Binding.descriptorType));
+		HashCombine(Hash, Binding.descriptorCount);
+		HashCombine(Hash, Binding.stageFlags);
+	}
+	return Hash;
+}
+
+void sDescriptorSetDesc::AddBuffer(uint32_t aBinding, VkDescriptorType aType, VkBuffer aBuffer, VkDeviceSize aOffset, VkDeviceSize aRange)
+{
+	sBinding NewBinding = {};
+	NewBinding.Binding = aBinding;
+	NewBinding.Type = aType;
+	NewBinding.BufferInfo = { aBuffer, aOffset, aRange };
+	Bindings.push_back(NewBinding);
+}
+
+void sDescriptorSetDesc::AddImage(uint32_t aBinding, VkDescriptorType aType, VkImageView aImageView, VkSampler aSampler, VkImageLayout aImageLayout)
+{
+	sBinding NewBinding = {};
+	NewBinding.Binding = aBinding;
+	NewBinding.Type = aType;
+	NewBinding.ImageInfo = { aSampler, aImageView, aImageLayout };
+	Bindings.push_back(NewBinding);
+}
+
+bool sDescriptorSetDesc::operator==(const sDescriptorSetDesc& aOther) const
+{
+	if (Layout != aOther.Layout || Bindings.size() != aOther.Bindings.size())
+	{
+		return false;
+	}
+
+	for (size_t i = 0; i < Bindings.size(); ++i)
+	{
+		const sBinding& A = Bindings[i];
+		const sBinding& B = aOther.Bindings[i];
+		if (A.Binding != B.Binding || A.Type != B.Type ||
+			A.BufferInfo.buffer != B.BufferInfo.buffer || A.BufferInfo.offset != B.BufferInfo.offset || A.BufferInfo.range != B.BufferInfo.range ||
+			A.ImageInfo.sampler != B.ImageInfo.sampler || A.ImageInfo.imageView != B.ImageInfo.imageView || A.ImageInfo.imageLayout != B.ImageInfo.imageLayout)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+CVulkanDescriptorSetCache::CVulkanDescriptorSetCache() :
+	m_Device(VK_NULL_HANDLE),
+	m_pAllocator(nullptr)
+{
+}
+
+void CVulkanDescriptorSetCache::Initialize(VkDevice aDevice, CVulkanDescriptorAllocator* apAllocator)
+{
+	m_Device = aDevice;
+	m_pAllocator = apAllocator;
+}
+
+VkDescriptorSet CVulkanDescriptorSetCache::GetSet(const sDescriptorSetDesc& aDesc)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	const auto It = m_Sets.find(aDesc);
+	if (It != m_Sets.end())
+	{
+		return It->second;
+	}
+
+	VkDescriptorSet Set = VK_NULL_HANDLE;
+	std::vector<VkDescriptorSet>& FreeSets = m_FreeSets[aDesc.Layout];
+	if (!FreeSets.empty())
+	{
+		Set = FreeSets.back();
+		FreeSets.pop_back();
+	}
+	else
+	{
+		Set = m_pAllocator->Allocate(aDesc.Layout);
+	}
+
+	// Copies, the writes take non const infos.
+	std::vector<sDescriptorSetDesc::sBinding> Bindings = aDesc.Bindings;
+	std::vector<VkWriteDescriptorSet> Writes;
+	Writes.reserve(Bindings.size());
+	for (sDescriptorSetDesc::sBinding& Binding : Bindings)
+	{
+		Writes.push_back(IsImageDescriptor(Binding.Type) ?
+			vkinit::WriteDescriptorImage(Binding.Type, Set, &Binding.ImageInfo, Binding.Binding) :
+			vkinit::WriteDescriptorBuffer(Binding.Type, Set, &Binding.BufferInfo, Binding.Binding));
+	}
+
+	vkUpdateDescriptorSets(m_Device, static_cast<uint32_t>(Writes.size()), Writes.data(), 0, nullptr);
+
+	m_Sets.emplace(aDesc, Set);
+	return Set;
+}
+
+void CVulkanDescriptorSetCache::Evict(uint64_t aHandle)
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+
+	for (auto It = m_Sets.begin(); It != m_Sets.end();)
+	{
+		const std::vector<sDescriptorSetDesc::sBinding>& Bindings = It->first.Bindings;
+		const bool bReferenced = std::any_of(Bindings.begin(), Bindings.end(), [aHandle](const sDescriptorSetDesc::sBinding& aBinding)
+		{
+			return HandleToUInt64(aBinding.BufferInfo.buffer) == aHandle || HandleToUInt64(aBinding.ImageInfo.imageView) == aHandle ||
+				HandleToUInt64(aBinding.ImageInfo.sampler) == aHandle;
+		});
+
+		if (bReferenced)
+		{
+			m_FreeSets[It->first.Layout].push_back(It->second);
+			It = m_Sets.erase(It);
+		}
+		else
+		{
+			++It;
+		}
+	}
+}
+
+void CVulkanDescriptorSetCache::Clear()
+{
+	std::lock_guard<std::mutex> Lock(m_Mutex);
+	m_Sets.clear();
+	m_FreeSets.clear();
+}
+
+size_t CVulkanDescriptorSetCache::sDescHash::operator()(const sDescriptorSetDesc& aDesc) const
+{
+	size_t Hash = std::hash<uint64_t>()(HandleToUInt64(aDesc.Layout));
+	for (const sDescriptorSetDesc::sBinding& Binding : aDesc.Bindings)
+	{
+		HashCombine(Hash, Binding.Binding);
+		HashCombine(Hash, static_cast<uint64_t>(Binding.Type));
+		HashCombine(Hash, HandleToUInt64(Binding.BufferInfo.buffer));
+		HashCombine(Hash, Binding.BufferInfo.offset);
+		HashCombine(Hash, Binding.BufferInfo.range);
+		HashCombine(Hash, HandleToUInt64(Binding.ImageInfo.sampler));
+		HashCombine(Hash, HandleToUInt64(Binding.ImageInfo.imageView));
+		HashCombine(Hash, static_cast<uint64_t>(Binding.ImageInfo.imageLayout));
+	}
+	return Hash;
+}
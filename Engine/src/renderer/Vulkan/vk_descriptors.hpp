@@ -0,0 +1,159 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Descriptors of a type a pool holds per set it can allocate, e.g. { COMBINED_IMAGE_SAMPLER, 4.0f } for sets
+ * with four textures.
+ */
+struct sDescriptorPoolRatio
+{
+    VkDescriptorType Type;
+    float Ratio;
+};
+
+/**
+ * @brief Allocates descriptor sets from a chain of pools. When a pool runs out a new one is created, each larger than
+ * the previous one up to a limit, so the number of sets is only bounded by memory.
+ *
+ * Sets are never freed one by one, they live until Shutdown(). Sets written once and released with their resources are
+ * recycled by CVulkanDescriptorSetCache. Not thread safe.
+ */
+class CVulkanDescriptorAllocator
+{
+public:
+    CVulkanDescriptorAllocator();
+
+    /**
+     * @brief aInitialSets is the size of the first pool, aRatios the descriptors of every type per set.
+     */
+    void Initialize(VkDevice aDevice, uint32_t aInitialSets, const std::vector<sDescriptorPoolRatio>& aRatios);
+    void Shutdown();
+
+    VkDescriptorSet Allocate(VkDescriptorSetLayout aLayout);
+
+private:
+    VkDescriptorPool GetPool();
+
+    VkDevice m_Device;
+    std::vector<sDescriptorPoolRatio> m_Ratios;
+    // Pools with room left, the last one is allocated from.
+    std::vector<VkDescriptorPool> m_ReadyPools;
+    std::vector<VkDescriptorPool> m_FullPools;
+    // Size of the next pool created.
+    uint32_t m_SetsPerPool;
+};
+
+/**
+ * @brief Owns the descriptor set layouts of the backend. Layouts with the same bindings, in any order, are the same
+ * object, so asking for a layout twice does not create a new one. Thread safe, pipelines are built from jobs.
+ */
+class CVulkanDescriptorLayoutCache
+{
+public:
+    CVulkanDescriptorLayoutCache();
+
+    void Initialize(VkDevice aDevice);
+
+    /**
+     * @brief Destroys every layout of the cache.
+     */
+    void Shutdown();
+
+    /**
+     * @brief Returns the layout described by aInfo, created the first time. It is owned by the cache. Immutable samplers
+     * and extension structures are not supported.
+     */
+    VkDescriptorSetLayout CreateLayout(const VkDescriptorSetLayoutCreateInfo& aInfo);
+
+private:
+    struct sLayoutKey
+    {
+        VkDescriptorSetLayoutCreateFlags Flags;
+        // Sorted by binding.
+        std::vector<VkDescriptorSetLayoutBinding> Bindings;
+
+        bool operator==(const sLayoutKey& aOther) const;
+    };
+
+    struct sLayoutKeyHash
+    {
+        size_t operator()(const sLayoutKey& aKey) const;
+    };
+
+    VkDevice m_Device;
+    std::unordered_map<sLayoutKey, VkDescriptorSetLayout, sLayoutKeyHash> m_Layouts;
+    std::mutex m_Mutex;
+};
+
+/**
+ * @brief Contents of a descriptor set: its layout and the resource written to every binding.
+ */
+struct sDescriptorSetDesc
+{
+    struct sBinding
+    {
+        uint32_t Binding;
+        VkDescriptorType Type;
+        // Only the one matching Type is used, the other is kept zeroed so bindings can be hashed and compared as they are.
+        VkDescriptorBufferInfo BufferInfo;
+        VkDescriptorImageInfo ImageInfo;
+    };
+
+    explicit sDescriptorSetDesc(VkDescriptorSetLayout aLayout) : Layout(aLayout) {}
+
+    void AddBuffer(uint32_t aBinding, VkDescriptorType aType, VkBuffer aBuffer, VkDeviceSize aOffset, VkDeviceSize aRange);
+    void AddImage(uint32_t aBinding, VkDescriptorType aType, VkImageView aImageView, VkSampler aSampler, VkImageLayout aImageLayout);
+
+    bool operator==(const sDescriptorSetDesc& aOther) const;
+
+    VkDescriptorSetLayout Layout;
+    std::vector<sBinding> Bindings;
+};
+
+/**
+ * @brief Descriptor sets that are written once and never updated, keyed by their contents. Asking twice for the same
+ * layout and resources returns the same set, so reloading a scene does not allocate the sets of its materials again.
+ *
+ * The keys are handle values, which the driver reuses once an object is destroyed. Evict() must be called when a
+ * resource is destroyed (the backend listens to the frame deletion queue), it forgets the sets referencing it and keeps
+ * them to be rewritten by the next GetSet() with the same layout. The sets come from a CVulkanDescriptorAllocator that
+ * must outlive the cache. Thread safe.
+ */
+class CVulkanDescriptorSetCache
+{
+public:
+    CVulkanDescriptorSetCache();
+
+    void Initialize(VkDevice aDevice, CVulkanDescriptorAllocator* apAllocator);
+
+    /**
+     * @brief Returns the set with the contents of aDesc, allocated and written the first time.
+     */
+    VkDescriptorSet GetSet(const sDescriptorSetDesc& aDesc);
+
+    /**
+     * @brief aHandle, the value of a VkBuffer, VkImageView or VkSampler, is being destroyed. The GPU must be done with
+     * the sets referencing it.
+     */
+    void Evict(uint64_t aHandle);
+
+    void Clear();
+
+private:
+    struct sDescHash
+    {
+        size_t operator()(const sDescriptorSetDesc& aDesc) const;
+    };
+
+    VkDevice m_Device;
+    CVulkanDescriptorAllocator* m_pAllocator;
+    std::unordered_map<sDescriptorSetDesc, VkDescriptorSet, sDescHash> m_Sets;
+    // Evicted sets, reused by the next sets of their layout.
+    std::unordered_map<VkDescriptorSetLayout, std::vector<VkDescriptorSet>> m_FreeSets;
+    std::mutex m_Mutex;
+};
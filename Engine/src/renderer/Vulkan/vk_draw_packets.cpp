@@ -0,0 +1,194 @@
+#include "vk_draw_packets.hpp"
+#include <core/profiler.hpp>
+#include <core/radix_sort.hpp>
+
+#include <glm/gtc/matrix_access.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+uint32_t drawkeys::QuantizeDepth(float aViewDepth, float aFarPlane)
+{
+	constexpr uint32_t MAX_DEPTH = (1u << DEPTH_BITS) - 1;
+
+	const float Depth = std::min(std::max(aViewDepth, 0.0f), aFarPlane);
+	const float Normalized = std::log1p(Depth) / std::log1p(aFarPlane);
+	return static_cast<uint32_t>(Normalized * static_cast<float>(MAX_DEPTH));
+}
+
+uint64_t drawkeys::MakeKey(eDrawPass aPass, uint32_t aPipelineID, uint32_t aMaterialIndex, uint32_t aMeshID, uint32_t aQuantizedDepth)
+{
+	const uint64_t Pass = static_cast<uint64_t>(aPass) & ((1ull << PASS_BITS) - 1);
+	const uint64_t Pipeline = aPipelineID & ((1ull << PIPELINE_BITS) - 1);
+	const uint64_t Material = aMaterialIndex & ((1ull << MATERIAL_BITS) - 1);
+	const uint64_t Mesh = aMeshID & ((1ull << MESH_BITS) - 1);
+	const uint64_t Depth = aQuantizedDepth & ((1ull << DEPTH_BITS) - 1);
+
+	uint64_t Key = Pass;
+	if (aPass == eDrawPass::BLENDED)
+	{
+		// Farthest first.
+		const uint64_t InverseDepth = ((1ull << DEPTH_BITS) - 1) - Depth;
+		Key = (Key << DEPTH_BITS) | InverseDepth;
+		Key = (Key << PIPELINE_BITS) | Pipeline;
+		Key = (Key << MATERIAL_BITS) | Material;
+		Key = (Key << MESH_BITS) | Mesh;
+	}
+	else
+	{
+		Key = (Key << PIPELINE_BITS) | Pipeline;
+		Key = (Key << MATERIAL_BITS) | Material;
+		Key = (Key << MESH_BITS) | Mesh;
+		Key = (Key << DEPTH_BITS) | Depth;
+	}
+	return Key;
+}
+
+struct sDrawListBuildContext
+{
+	const sFramePacket* pFramePacket;
+	uint32_t NumObjects;
+	float FarPlane;
+	CVulkanRenderable* pRenderable;
+	uint32_t MeshID;
+	LinearVector<sDrawPacket>* pPackets;
+};
+
+// Same traversal as CVulkanRenderable::DrawNode(), so aDrawIndex follows the order of the transforms.
+static void EmitNodePackets(const CMeshNode* apMeshNode, sDrawListBuildContext& aContext, uint32_t& aDrawIndex)
+{
+	for (const CMeshNode* pChild = apMeshNode->m_pFirstChild; pChild; pChild = pChild->m_pNextSibling)
+	{
+		EmitNodePackets(pChild, aContext, aDrawIndex);
+	}
+
+	if (!apMeshNode->m_pMeshData)
+	{
+		return;
+	}
+
+	for (const CSubMesh* pSubMesh : apMeshNode->m_pMeshData->SubMeshes)
+	{
+		const uint32_t DrawIndex = aDrawIndex++;
+		if (!apMeshNode->m_bVisible || DrawIndex >= aContext.NumObjects || !aContext.pFramePacket->VisibleDraws[DrawIndex])
+		{
+			continue;
+		}
+
+		// The origin of the transform stands for the whole submesh.
+		const glm::vec4 Position = glm::column(aContext.pFramePacket->ObjectTransforms[DrawIndex], 3);
+		const float ViewDepth = -(aContext.pFramePacket->View * glm::vec4(glm::vec3(Position), 1.0f)).z;
+
+		sDrawPacket Packet;
+		Packet.pRenderable = aContext.pRenderable;
+		Packet.pSubMesh = pSubMesh;
+		Packet.ObjectIndex = DrawIndex;
+		Packet.MaterialIndex = pSubMesh->m_Material->GetIndex();
+		// Every pass draws its submeshes with a single pipeline for now.
+		Packet.PipelineID = 0;
+
+		const eDrawPass Pass = apMeshNode->m_bOpaque ? eDrawPass::SOLID : eDrawPass::BLENDED;
+		Packet.SortKey = drawkeys::MakeKey(Pass, Packet.PipelineID, Packet.MaterialIndex, aContext.MeshID,
+			drawkeys::QuantizeDepth(ViewDepth, aContext.FarPlane));
+
+		aContext.pPackets->push_back(Packet);
+	}
+}
+
+void CVulkanDrawList::Build(const std::vector<CVulkanRenderable*>& aRenderables, const sFramePacket& aFramePacket, uint32_t aNumObjects,
+	float aFarPlane, CLinearAllocator& aAllocator)
+{
+	SGS_PROFILE_FUNCTION();
+
+	const uint32_t NumObjects = std::min({ aNumObjects, static_cast<uint32_t>(aFramePacket.ObjectTransforms.size()),
+		static_cast<uint32_t>(aFramePacket.VisibleDraws.size()) });
+
+	LinearVector<sDrawPacket> Packets{ CLinearAllocatorAdapter<sDrawPacket>(aAllocator) };
+	Packets.reserve(NumObjects);
+
+	sDrawListBuildContext Context;
+	Context.pFramePacket = &aFramePacket;
+	Context.NumObjects = NumObjects;
+	Context.FarPlane = aFarPlane;
+	Context.pPackets = &Packets;
+
+	uint32_t DrawIndex = 0;
+	for (uint32_t i = 0; i < aRenderables.size(); ++i)
+	{
+		Context.pRenderable = aRenderables[i];
+		Context.MeshID = i;
+		for (const CMeshNode* pRoot : aRenderables[i]->m_pRoots)
+		{
+			EmitNodePackets(pRoot, Context, DrawIndex);
+		}
+	}
+
+	// The vector is never shrunk or freed before the allocator is reset, its storage can be handed out as it is.
+	sDrawPacket* pScratch = aAllocator.AllocateArray<sDrawPacket>(Packets.size());
+	m_pPackets = radixsort::SortByKey64(Packets.data(), pScratch, Packets.size(), [](const sDrawPacket& aPacket) { return aPacket.SortKey; });
+	m_NumPackets = static_cast<uint32_t>(Packets.size());
+
+	uint32_t PacketIdx = 0;
+	for (uint32_t Pass = 0; Pass < static_cast<uint32_t>(eDrawPass::NUM); ++Pass)
+	{
+		m_PassBegin[Pass] = PacketIdx;
+		while (PacketIdx < m_NumPackets && static_cast<uint32_t>(drawkeys::GetPass(m_pPackets[PacketIdx].SortKey)) == Pass)
+		{
+			++PacketIdx;
+		}
+	}
+	m_PassBegin[static_cast<size_t>(eDrawPass::NUM)] = m_NumPackets;
+}
+
+void CVulkanDrawList::Record(const sRenderContext& aRenderContext, eDrawPass aPass, const VkPipeline* apPipelines, bool abBindMaterialDescriptor) const
+{
+	SGS_PROFILE_FUNCTION();
+
+	const uint32_t Begin = m_PassBegin[static_cast<size_t>(aPass)];
+	const uint32_t End = m_PassBegin[static_cast<size_t>(aPass) + 1];
+	if (Begin == End)
+	{
+		return;
+	}
+
+	const std::array<VkDescriptorSet, 2> DescriptorSets = { aRenderContext.FrameDescriptorSet, aRenderContext.ObjectsDescriptorSet };
+	vkCmdBindDescriptorSets(aRenderContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, aRenderContext.PipelineLayout,
+		0, static_cast<uint32_t>(DescriptorSets.size()), DescriptorSets.data(), 0, nullptr);
+
+	uint32_t BoundPipelineID = UINT32_MAX;
+	uint32_t BoundMaterialIndex = UINT32_MAX;
+	const CVulkanRenderable* pBoundRenderable = nullptr;
+
+	for (uint32_t i = Begin; i < End; ++i)
+	{
+		const sDrawPacket& Packet = m_pPackets[i];
+
+		if (Packet.PipelineID != BoundPipelineID)
+		{
+			vkCmdBindPipeline(aRenderContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, apPipelines[Packet.PipelineID]);
+			BoundPipelineID = Packet.PipelineID;
+		}
+
+		if (Packet.pRenderable != pBoundRenderable)
+		{
+			const VkDeviceSize Offset = 0;
+			const VkBuffer VertexBuffer = Packet.pRenderable->GetDrawVertexBuffer();
+			vkCmdBindVertexBuffers(aRenderContext.CmdBuffer, 0, 1, &VertexBuffer, &Offset);
+			vkCmdBindIndexBuffer(aRenderContext.CmdBuffer, Packet.pRenderable->m_IndexBuffer.Buffer, 0, VK_INDEX_TYPE_UINT32);
+			pBoundRenderable = Packet.pRenderable;
+		}
+
+		if (abBindMaterialDescriptor && Packet.MaterialIndex != BoundMaterialIndex)
+		{
+			const VkDescriptorSet MaterialDescriptorSet = (*aRenderContext.MaterialDescriptors)[Packet.MaterialIndex]->DescriptorSet;
+			vkCmdBindDescriptorSets(aRenderContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, aRenderContext.PipelineLayout,
+				2, 1, &MaterialDescriptorSet, 0, nullptr);
+			BoundMaterialIndex = Packet.MaterialIndex;
+		}
+
+		const CSubMesh* pSubMesh = Packet.pSubMesh;
+		vkCmdDrawIndexed(aRenderContext.CmdBuffer, static_cast<uint32_t>(pSubMesh->m_IndexCount), 1,
+			static_cast<uint32_t>(pSubMesh->m_FirstIndex), static_cast<int32_t>(pSubMesh->m_FirstVertex), Packet.ObjectIndex);
+	}
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include "renderer/frame_packet.hpp"
+#include <core/linear_allocator.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Passes a draw can belong to, in the order they are drawn. They take the highest bits of the sort keys.
+ */
+enum class eDrawPass : uint8_t
+{
+    // Sorted by state first and then front to back, so most hidden fragments are rejected by the depth test.
+    SOLID = 0,
+    // Sorted back to front, the order matters more than the state changes.
+    BLENDED,
+    NUM
+};
+
+/**
+ * @brief Everything needed to record the draw of a submesh. The packets are sorted by SortKey and consecutive packets
+ * only bind the state that differs from the previous one.
+ */
+struct sDrawPacket
+{
+    uint64_t SortKey;
+    CVulkanRenderable* pRenderable;
+    const CSubMesh* pSubMesh;
+    // Index of the transform in the objects buffer, passed as first instance (see sFramePacket::ObjectTransforms).
+    uint32_t ObjectIndex;
+    // Indexed by CMaterial::GetIndex().
+    uint32_t MaterialIndex;
+    // Index in the pipelines given to CVulkanDrawList::Record().
+    uint32_t PipelineID;
+};
+
+namespace drawkeys
+{
+    // Solid:   Pass (4) | Pipeline (8) | Material (16) | Mesh (12) | Depth (24)
+    // Blended: Pass (4) | Inverse depth (24) | Pipeline (8) | Material (16) | Mesh (12)
+    // Fields wider than their bits are truncated, it only makes the order less ideal since the recording compares the
+    // state itself.
+    constexpr uint32_t PASS_BITS = 4;
+    constexpr uint32_t PIPELINE_BITS = 8;
+    constexpr uint32_t MATERIAL_BITS = 16;
+    constexpr uint32_t MESH_BITS = 12;
+    constexpr uint32_t DEPTH_BITS = 24;
+    static_assert(PASS_BITS + PIPELINE_BITS + MATERIAL_BITS + MESH_BITS + DEPTH_BITS == 64, "The sort key fields must fill 64 bits.");
+
+    /**
+     * @brief Maps a view depth in [0, aFarPlane] to DEPTH_BITS bits. The scale is logarithmic, so near draws, the ones
+     * occluding the most, are told apart more finely.
+     */
+    uint32_t QuantizeDepth(float aViewDepth, float aFarPlane);
+
+    uint64_t MakeKey(eDrawPass aPass, uint32_t aPipelineID, uint32_t aMaterialIndex, uint32_t aMeshID, uint32_t aQuantizedDepth);
+
+    inline eDrawPass GetPass(uint64_t aKey) { return static_cast<eDrawPass>(aKey >> (64 - PASS_BITS)); }
+}
+
+/**
+ * @brief Draws of a frame as sorted packets. Built once per frame from the renderables and recorded by the scene
+ * passes of the render paths. The packets live in the frame allocator, so they are valid until it is reset.
+ */
+class CVulkanDrawList
+{
+public:
+    /**
+     * @brief Emits a packet per visible submesh of aRenderables with a transform among the first aNumObjects of the
+     * frame packet and inside the view (see sFramePacket::VisibleDraws), and sorts them.
+     */
+    void Build(const std::vector<CVulkanRenderable*>& aRenderables, const sFramePacket& aFramePacket, uint32_t aNumObjects,
+        float aFarPlane, CLinearAllocator& aAllocator);
+
+    /**
+     * @brief Records the draws of aPass with the frame and objects descriptor sets of aRenderContext. The pipeline,
+     * vertex and index buffers and material descriptor set are only bound when they change. apPipelines is indexed by
+     * the PipelineID of the packets.
+     */
+    void Record(const sRenderContext& aRenderContext, eDrawPass aPass, const VkPipeline* apPipelines, bool abBindMaterialDescriptor) const;
+
+    uint32_t GetSize() const { return m_NumPackets; }
+    uint32_t GetPassSize(eDrawPass aPass) const { return m_PassBegin[static_cast<size_t>(aPass) + 1] - m_PassBegin[static_cast<size_t>(aPass)]; }
+    const sDrawPacket* GetPackets() const { return m_pPackets; }
+
+private:
+    const sDrawPacket* m_pPackets = nullptr;
+    uint32_t m_NumPackets = 0;
+    // The packets of every pass are contiguous once sorted, the ones of pass i are [m_PassBegin[i], m_PassBegin[i + 1]).
+    uint32_t m_PassBegin[static_cast<size_t>(eDrawPass::NUM) + 1] = {};
+};
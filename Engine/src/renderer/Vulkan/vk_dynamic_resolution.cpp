@@ -0,0 +1,198 @@
+#include "vk_dynamic_resolution.hpp"
+#include "vulkan_device.hpp"
+#include <core/logger.h>
+#include <core/profiler.hpp>
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+	// Scales are multiples of this step, so small variations of the GPU time do not change the resolution.
+	constexpr float RENDER_SCALE_STEP = 0.05f;
+	// The scale only grows when the frame takes less than this fraction of the budget.
+	constexpr float RAISE_THRESHOLD = 0.85f;
+	// Weight of the last frame in the smoothed GPU time.
+	constexpr float GPU_TIME_SMOOTHING = 0.1f;
+}
+
+CVulkanDynamicResolution::CVulkanDynamicResolution() :
+	m_pVulkanDevice(nullptr),
+	m_QueryPool(VK_NULL_HANDLE),
+	m_bTimestampsSupported(false),
+	m_TimestampPeriodNs(1.0f),
+	m_TimestampMask(0),
+	m_GPUToCPUOffsetNs(0.0),
+	m_LastFrameEndNs(0),
+	m_RenderScale(1.0f),
+	m_SmoothedGPUTimeMs(0.0f),
+	m_FramesUntilNextChange(0)
+{
+}
+
+void CVulkanDynamicResolution::Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames)
+{
+	m_pVulkanDevice = apVulkanDevice;
+	m_PendingFrames.assign(aNumFrames, false);
+
+	VkPhysicalDeviceProperties Properties = {};
+	vkGetPhysicalDeviceProperties(m_pVulkanDevice->m_PhysicalDevice, &Properties);
+
+	uint32_t NumQueueFamilies = 0;
+	vkGetPhysicalDeviceQueueFamilyProperties(m_pVulkanDevice->m_PhysicalDevice, &NumQueueFamilies, nullptr);
+	std::vector<VkQueueFamilyProperties> QueueFamilies(NumQueueFamilies);
+	vkGetPhysicalDeviceQueueFamilyProperties(m_pVulkanDevice->m_PhysicalDevice, &NumQueueFamilies, QueueFamilies.data());
+
+	const uint32_t TimestampValidBits = QueueFamilies[m_pVulkanDevice->m_GraphicsQueueFamily].timestampValidBits;
+	m_bTimestampsSupported = TimestampValidBits > 0 && Properties.limits.timestampPeriod > 0.0f;
+	if (!m_bTimestampsSupported)
+	{
+		SGSWARN("The graphics queue does not support timestamps, dynamic resolution is disabled.");
+		return;
+	}
+
+	m_TimestampPeriodNs = Properties.limits.timestampPeriod;
+	m_TimestampMask = TimestampValidBits >= 64 ? UINT64_MAX : (uint64_t(1) << TimestampValidBits) - 1;
+
+	VkQueryPoolCreateInfo QueryPoolInfo = {};
+	QueryPoolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+	QueryPoolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+	QueryPoolInfo.queryCount = 2 * aNumFrames;
+
+	VK_CHECK(vkCreateQueryPool(m_pVulkanDevice->m_Device, &QueryPoolInfo, nullptr, &m_QueryPool));
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		vkDestroyQueryPool(m_pVulkanDevice->m_Device, m_QueryPool, nullptr);
+		m_QueryPool = VK_NULL_HANDLE;
+	});
+
+	CalibrateTimestamps();
+}
+
+void CVulkanDynamicResolution::Shutdown()
+{
+	m_DeletionQueue.Flush();
+}
+
+void CVulkanDynamicResolution::Update(uint32_t aFrameIdx)
+{
+	m_LastFrameEndNs = 0;
+	if (!m_bTimestampsSupported || !m_PendingFrames[aFrameIdx])
+	{
+		return;
+	}
+
+	uint64_t Timestamps[2] = {};
+	const VkResult Result = vkGetQueryPoolResults(m_pVulkanDevice->m_Device, m_QueryPool, 2 * aFrameIdx, 2, sizeof(Timestamps), Timestamps,
+		sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+	if (Result != VK_SUCCESS)
+	{
+		return;
+	}
+	m_PendingFrames[aFrameIdx] = false;
+
+	m_LastFrameEndNs = ToProfilerTime(Timestamps[1]);
+	profiler::AddGPUZone("GPU Frame", ToProfilerTime(Timestamps[0]), m_LastFrameEndNs);
+
+	const uint64_t Ticks = (Timestamps[1] - Timestamps[0]) & m_TimestampMask;
+	const float GPUTimeMs = static_cast<float>(static_cast<double>(Ticks) * m_TimestampPeriodNs * 1e-6);
+
+	m_SmoothedGPUTimeMs = m_SmoothedGPUTimeMs > 0.0f ? m_SmoothedGPUTimeMs + (GPUTimeMs - m_SmoothedGPUTimeMs) * GPU_TIME_SMOOTHING : GPUTimeMs;
+
+#if SGS_DYNAMIC_RESOLUTION
+	PickRenderScale(m_SmoothedGPUTimeMs);
+#endif
+}
+
+void CVulkanDynamicResolution::PickRenderScale(float aGPUTimeMs)
+{
+	if (m_FramesUntilNextChange > 0)
+	{
+		--m_FramesUntilNextChange;
+		return;
+	}
+
+	const float BudgetMs = static_cast<float>(SGS_GPU_FRAME_BUDGET_MS);
+	const float MinScale = static_cast<float>(SGS_MIN_RENDER_SCALE);
+
+	// The cost of the frame grows with the number of pixels, the square of the scale.
+	const float FittingScale = m_RenderScale * std::sqrt(BudgetMs / std::max(aGPUTimeMs, 0.01f));
+	const float SnappedScale = std::floor(FittingScale / RENDER_SCALE_STEP) * RENDER_SCALE_STEP;
+
+	float NewScale = m_RenderScale;
+	if (aGPUTimeMs > BudgetMs)
+	{
+		NewScale = SnappedScale;
+	}
+	else if (aGPUTimeMs < BudgetMs * RAISE_THRESHOLD)
+	{
+		NewScale = std::max(m_RenderScale, std::min(m_RenderScale + RENDER_SCALE_STEP, SnappedScale));
+	}
+	NewScale = std::clamp(NewScale, MinScale, 1.0f);
+
+	if (std::abs(NewScale - m_RenderScale) < RENDER_SCALE_STEP * 0.5f)
+	{
+		return;
+	}
+
+	// Expected time at the new scale, until real measurements come in.
+	m_SmoothedGPUTimeMs *= (NewScale * NewScale) / (m_RenderScale * m_RenderScale);
+	m_RenderScale = NewScale;
+	m_FramesUntilNextChange = static_cast<uint32_t>(m_PendingFrames.size());
+}
+
+void CVulkanDynamicResolution::CalibrateTimestamps()
+{
+	// The timestamp is taken somewhere between the two CPU times, the middle is close enough for the captures.
+	const uint64_t CPUTimeBefore = profiler::GetTimeNs();
+	m_pVulkanDevice->ImmediateSubmit([=](VkCommandBuffer aCmdBuffer)
+	{
+		vkCmdResetQueryPool(aCmdBuffer, m_QueryPool, 0, 1);
+		vkCmdWriteTimestamp(aCmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, 0);
+	});
+	const uint64_t CPUTimeAfter = profiler::GetTimeNs();
+
+	uint64_t Timestamp = 0;
+	VK_CHECK(vkGetQueryPoolResults(m_pVulkanDevice->m_Device, m_QueryPool, 0, 1, sizeof(Timestamp), &Timestamp, sizeof(uint64_t),
+		VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WAIT_BIT));
+
+	const double CPUTime = 0.5 * (static_cast<double>(CPUTimeBefore) + static_cast<double>(CPUTimeAfter));
+	m_GPUToCPUOffsetNs = CPUTime - static_cast<double>(Timestamp & m_TimestampMask) * m_TimestampPeriodNs;
+}
+
+uint64_t CVulkanDynamicResolution::ToProfilerTime(uint64_t aTimestamp) const
+{
+	const double Time = static_cast<double>(aTimestamp & m_TimestampMask) * m_TimestampPeriodNs + m_GPUToCPUOffsetNs;
+	return Time > 0.0 ? static_cast<uint64_t>(Time) : 0;
+}
+
+void CVulkanDynamicResolution::RecordFrameBegin(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx)
+{
+	if (!m_bTimestampsSupported)
+	{
+		return;
+	}
+
+	vkCmdResetQueryPool(aCmdBuffer, m_QueryPool, 2 * aFrameIdx, 2);
+	vkCmdWriteTimestamp(aCmdBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_QueryPool, 2 * aFrameIdx);
+}
+
+void CVulkanDynamicResolution::RecordFrameEnd(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx)
+{
+	if (!m_bTimestampsSupported)
+	{
+		return;
+	}
+
+	vkCmdWriteTimestamp(aCmdBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_QueryPool, 2 * aFrameIdx + 1);
+	m_PendingFrames[aFrameIdx] = true;
+}
+
+VkExtent2D CVulkanDynamicResolution::GetRenderExtent(VkExtent2D aFullExtent) const
+{
+	VkExtent2D RenderExtent;
+	RenderExtent.width = std::max(1u, static_cast<uint32_t>(aFullExtent.width * m_RenderScale));
+	RenderExtent.height = std::max(1u, static_cast<uint32_t>(aFullExtent.height * m_RenderScale));
+	return RenderExtent;
+}
@@ -0,0 +1,93 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include <core/types.hpp>
+
+#include <vector>
+
+class CVulkanDevice;
+
+// Renders the scene at a fraction of the window size, picked every frame from the measured GPU time.
+// Can be overridden at build time (/DSGS_DYNAMIC_RESOLUTION=0 always renders at full size).
+#ifndef SGS_DYNAMIC_RESOLUTION
+#define SGS_DYNAMIC_RESOLUTION 1
+#endif
+
+// GPU time the render scale is tuned for, in milliseconds.
+#ifndef SGS_GPU_FRAME_BUDGET_MS
+#define SGS_GPU_FRAME_BUDGET_MS 16.0f
+#endif
+
+// Lowest render scale, per axis.
+#ifndef SGS_MIN_RENDER_SCALE
+#define SGS_MIN_RENDER_SCALE 0.5f
+#endif
+
+/**
+ * @brief Measures the GPU time of every frame with timestamp queries and picks the render scale (per axis) of the
+ * scene passes so it fits in SGS_GPU_FRAME_BUDGET_MS. The measured frames are also added to the profiler captures.
+ *
+ * The scale drops right away when the frame goes over budget and only grows back, one step at a time, once there
+ * is some headroom, so it does not oscillate around the budget. Render paths render the scene with
+ * GetRenderExtent() into targets of the full size and upscale it into the swapchain (see CVulkanUpscalePass).
+ */
+class CVulkanDynamicResolution
+{
+public:
+    CVulkanDynamicResolution();
+
+    void Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames);
+    void Shutdown();
+
+    /**
+     * @brief Reads the GPU time of the last frame recorded with aFrameIdx and picks the render scale of the new one.
+     * The fence of the frame must be signaled.
+     */
+    void Update(uint32_t aFrameIdx);
+
+    /**
+     * @brief The timestamps enclosing the commands of the frame. Must be recorded outside of any render pass.
+     */
+    void RecordFrameBegin(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx);
+    void RecordFrameEnd(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx);
+
+    /**
+     * @brief Extent the scene is rendered at this frame, aFullExtent scaled by the render scale.
+     */
+    VkExtent2D GetRenderExtent(VkExtent2D aFullExtent) const;
+
+    float GetRenderScale() const { return m_RenderScale; }
+    float GetGPUTimeMs() const { return m_SmoothedGPUTimeMs; }
+
+    /**
+     * @brief When the GPU finished the frame read by the last Update(), in profiler::GetTimeNs(). 0 if that call did
+     * not read any timestamp.
+     */
+    uint64_t GetLastFrameEndNs() const { return m_LastFrameEndNs; }
+
+private:
+    void PickRenderScale(float aGPUTimeMs);
+    void CalibrateTimestamps();
+    uint64_t ToProfilerTime(uint64_t aTimestamp) const;
+
+    CVulkanDevice* m_pVulkanDevice;
+
+    // Two timestamps per frame in flight.
+    VkQueryPool m_QueryPool;
+    // Frames whose timestamps were recorded and not read yet.
+    std::vector<bool> m_PendingFrames;
+    bool m_bTimestampsSupported;
+    float m_TimestampPeriodNs;
+    uint64_t m_TimestampMask;
+    // profiler::GetTimeNs() minus the GPU time, in nanoseconds. Places the GPU frames in the profiler captures.
+    double m_GPUToCPUOffsetNs;
+    uint64_t m_LastFrameEndNs;
+
+    float m_RenderScale;
+    float m_SmoothedGPUTimeMs;
+    // Frames to wait before changing the scale again, the frames in flight were recorded with the old one.
+    uint32_t m_FramesUntilNextChange;
+
+    // Holds the deletion functions.
+    sDeletionQueue m_DeletionQueue;
+};
@@ -4,18 +4,37 @@
 #include "vulkan_swapchain.hpp"
 #include "vk_initializers.hpp"
 #include "vk_utils.hpp"
+#include <core/job_system.hpp>
+#include <core/logger.h>
+#include <core/profiler.hpp>
 
-#include <iostream>
 #include <array>
 
 CVulkanForwardRenderPath::CVulkanForwardRenderPath(CVulkanBackend* apVulkanBackend, CVulkanDevice* apVulkanDevice, CVulkanSwapchain* apVulkanSwapchain) :
-    m_pVulkanBackend(apVulkanBackend), m_pVulkanDevice(apVulkanDevice), m_pVulkanSwapchain(apVulkanSwapchain)
+    m_pVulkanBackend(apVulkanBackend), m_pVulkanDevice(apVulkanDevice), m_pVulkanSwapchain(apVulkanSwapchain),
+	m_RenderGraph(apVulkanDevice),
+	m_BackbufferImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_SceneColorImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_DepthImage(INVALID_RENDER_GRAPH_RESOURCE),
+	m_DepthPrepass(0),
+	m_ForwardPass(0),
+	m_UpscalePass(apVulkanDevice)
 {
 }
 
 void CVulkanForwardRenderPath::CreateResources()
 {
-    CreateForwardPipeline();
+    CreateForwardPipelineLayout();
+	CreateRenderGraph();
+}
+
+void CVulkanForwardRenderPath::CreatePipelines(sJobCounter& aCounter)
+{
+	jobs::Execute(aCounter, [this] { BuildForwardPipelines(); });
+#if SGS_FORWARD_DEPTH_PREPASS
+	jobs::Execute(aCounter, [this] { BuildDepthPrepassPipeline(); });
+#endif
+	jobs::Execute(aCounter, [this] { m_UpscalePass.BuildPipeline(m_pVulkanBackend->m_PipelineCache.GetHandle()); });
 }
 
 void CVulkanForwardRenderPath::DestroyResources()
@@ -24,69 +43,118 @@ void CVulkanForwardRenderPath::DestroyResources()
     m_MainDeletionQueue.Flush();
 }
 
-void CVulkanForwardRenderPath::RecordCommands(VkCommandBuffer aCommandBuffer, uint32_t aImageIdx)
+void CVulkanForwardRenderPath::CreateRenderGraph()
 {
-	VkCommandBufferBeginInfo BeginInfo = vkinit::CommandBufferBeginInfo();
+	m_BackbufferImage = m_RenderGraph.ImportImage("Backbuffer", m_pVulkanSwapchain->m_SwapchainImageFormat, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR);
 
-	VK_CHECK(vkBeginCommandBuffer(aCommandBuffer, &BeginInfo));
+	// Same format as the backbuffer, the upscale does not change the encoding of the colors.
+	sRenderGraphImageDesc SceneColorDesc;
+	SceneColorDesc.Format = m_pVulkanSwapchain->m_SwapchainImageFormat;
+	m_SceneColorImage = m_RenderGraph.CreateImage("SceneColor", SceneColorDesc);
 
-	VkRenderPassBeginInfo RenderPassInfo = vkinit::RenderPassBeginInfo(m_pVulkanSwapchain->m_RenderPass, m_pVulkanSwapchain->m_WindowExtent, m_pVulkanSwapchain->m_Framebuffers[aImageIdx]);
+	sRenderGraphImageDesc DepthDesc;
+	DepthDesc.Format = m_pVulkanDevice->FindDepthFormat();
+	DepthDesc.Aspect = VK_IMAGE_ASPECT_DEPTH_BIT;
+	m_DepthImage = m_RenderGraph.CreateImage("Depth", DepthDesc);
 
-	std::array<VkClearValue, 2> ClearValues = {};
-	ClearValues[0].color = {{0.0f, 0.0f, 0.0f, 1.0f}};
-	ClearValues[1].depthStencil = {1.0f, 0};
-	
-	RenderPassInfo.clearValueCount = static_cast<uint32_t>(ClearValues.size());
-	RenderPassInfo.pClearValues = ClearValues.data();
+#if SGS_FORWARD_DEPTH_PREPASS
+	m_DepthPrepass = m_RenderGraph.AddPass("DepthPrepass", [&](CRenderGraphPassBuilder& aBuilder)
+	{
+		aBuilder.WriteDepth(m_DepthImage);
+		aBuilder.UseRenderExtent();
+	},
+	[this](const sRenderGraphPassContext& aContext) { DrawDepthPrepass(aContext); });
+#endif
 
-	vkCmdBeginRenderPass(aCommandBuffer, &RenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+	m_ForwardPass = m_RenderGraph.AddPass("Forward", [&](CRenderGraphPassBuilder& aBuilder)
+	{
+		aBuilder.WriteColor(m_SceneColorImage);
+		// Cleared here unless the prepass already filled it.
+		aBuilder.WriteDepth(m_DepthImage, !SGS_FORWARD_DEPTH_PREPASS);
+		aBuilder.UseRenderExtent();
+	},
+	[this](const sRenderGraphPassContext& aContext) { DrawScene(aContext); });
+
+	m_UpscalePass.AddToGraph(&m_RenderGraph, m_SceneColorImage, m_BackbufferImage);
+
+	m_RenderGraph.Compile(m_pVulkanSwapchain->m_WindowExtent);
+	m_UpscalePass.CreateResources(m_pVulkanBackend->m_DefaultSampler, m_pVulkanBackend->m_DescriptorLayoutCache, m_pVulkanBackend->m_DescriptorAllocator);
 
-	vkCmdBindPipeline(aCommandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ForwardPipeline);
+	m_MainDeletionQueue.PushFunction([=]()
+	{
+		m_UpscalePass.Destroy();
+		m_RenderGraph.Destroy();
+	});
+}
 
-	VkViewport Viewport{};
-	Viewport.x = 0.0f;
-	Viewport.y = 0.0f;
-	Viewport.width = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.width);
-	Viewport.height = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.height);
-	Viewport.minDepth = 0.0f;
-	Viewport.maxDepth = 1.0f;
-	vkCmdSetViewport(aCommandBuffer, 0, 1, &Viewport);
+void CVulkanForwardRenderPath::DrawDepthPrepass(const sRenderGraphPassContext& aContext)
+{
+	sRenderContext RenderContext = {};
+	RenderContext.CmdBuffer = aContext.CmdBuffer;
+	RenderContext.DrawCallNum = 0;
+	RenderContext.FrameDescriptorSet = m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].DescriptorSet;
+	RenderContext.MaterialDescriptors = &m_pVulkanBackend->m_MaterialDescriptors;
+	RenderContext.ObjectsDescriptorSet = m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].ObjectsDescriptorSet;
+	RenderContext.PipelineLayout = m_ForwardPipelineLayout;
 
-	VkRect2D Scissor{};
-	Scissor.offset = {0, 0};
-	Scissor.extent = m_pVulkanSwapchain->m_WindowExtent;
-	vkCmdSetScissor(aCommandBuffer, 0, 1, &Scissor);
+	m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].DrawList.Record(RenderContext, eDrawPass::SOLID, &m_DepthPrepassPipeline, false);
+}
 
+void CVulkanForwardRenderPath::DrawScene(const sRenderGraphPassContext& aContext)
+{
 	sRenderContext RenderContext = {};
-	RenderContext.CmdBuffer = aCommandBuffer;
+	RenderContext.CmdBuffer = aContext.CmdBuffer;
 	RenderContext.DrawCallNum = 0;
-	RenderContext.FrameDescriptorSet = m_pVulkanBackend->m_FramesData[aImageIdx].DescriptorSet;
+	RenderContext.FrameDescriptorSet = m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].DescriptorSet;
 	RenderContext.MaterialDescriptors = &m_pVulkanBackend->m_MaterialDescriptors;
-	RenderContext.ObjectsDescriptorSet = m_pVulkanBackend->m_ObjectsDataDescriptorSet;
+	RenderContext.ObjectsDescriptorSet = m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].ObjectsDescriptorSet;
 	RenderContext.PipelineLayout = m_ForwardPipelineLayout;
 
-	for (const auto& Renderable :  m_pVulkanBackend->m_Renderables)
-	{
-		Renderable->Draw(RenderContext, true);
-	}
+	const VkDescriptorSet LightsDescriptorSet = m_pVulkanBackend->m_ClusteredLighting.GetDescriptorSet(m_pVulkanBackend->m_CurrentFrame);
+	vkCmdBindDescriptorSets(aContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_ForwardPipelineLayout, 3, 1, &LightsDescriptorSet, 0, nullptr);
 
-	vkCmdEndRenderPass(aCommandBuffer);
+	const CVulkanDrawList& DrawList = m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].DrawList;
+	DrawList.Record(RenderContext, eDrawPass::SOLID, &m_ForwardPipeline, true);
+	DrawList.Record(RenderContext, eDrawPass::BLENDED, &m_ForwardBlendedPipeline, true);
+}
+
+void CVulkanForwardRenderPath::RecordCommands(VkCommandBuffer aCommandBuffer, uint32_t aImageIdx)
+{
+	SGS_PROFILE_FUNCTION();
+
+	VkCommandBufferBeginInfo BeginInfo = vkinit::CommandBufferBeginInfo();
+
+	VK_CHECK(vkBeginCommandBuffer(aCommandBuffer, &BeginInfo));
+
+	m_pVulkanBackend->m_DynamicResolution.RecordFrameBegin(aCommandBuffer, m_pVulkanBackend->m_CurrentFrame);
+
+	m_pVulkanBackend->m_Skinning.RecordSkinning(aCommandBuffer, m_pVulkanBackend->m_CurrentFrame);
+	m_pVulkanBackend->m_ShadowMaps.RecordShadows(aCommandBuffer, m_pVulkanBackend->m_Renderables, m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].ObjectsDescriptorSet);
+	m_pVulkanBackend->RecordComputePasses(aCommandBuffer, m_pVulkanBackend->m_CurrentFrame);
+
+	m_RenderGraph.SetImportedImage(m_BackbufferImage, m_pVulkanSwapchain->m_SwapchainImages[aImageIdx], m_pVulkanSwapchain->m_SwapchainImageViews[aImageIdx]);
+	m_RenderGraph.SetRenderExtent(m_pVulkanBackend->m_DynamicResolution.GetRenderExtent(m_RenderGraph.GetExtent()));
+	m_RenderGraph.Execute(aCommandBuffer);
+
+	m_pVulkanBackend->m_DynamicResolution.RecordFrameEnd(aCommandBuffer, m_pVulkanBackend->m_CurrentFrame);
 
 	VK_CHECK(vkEndCommandBuffer(aCommandBuffer));
 }
 
-void CVulkanForwardRenderPath::Render(const CCamera* const aCamera)
+void CVulkanForwardRenderPath::Render(const sFramePacket& aFramePacket)
 {
+	SGS_PROFILE_FUNCTION();
+
     // TODO: Probably there is a chunk of this code that can go to CVulkanBackend.
 
-	VK_CHECK(vkWaitForFences(m_pVulkanDevice->m_Device, 1, &m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].RenderFence, VK_TRUE, UINT64_MAX));
+	m_pVulkanBackend->WaitForFrame();
 
 	uint32_t ImageIndex;
 	VkResult Result = vkAcquireNextImageKHR(m_pVulkanDevice->m_Device, m_pVulkanSwapchain->m_Swapchain, UINT64_MAX, m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].PresentSemaphore, VK_NULL_HANDLE, &ImageIndex);
 	if (Result == VK_ERROR_OUT_OF_DATE_KHR || Result == VK_SUBOPTIMAL_KHR || m_pVulkanBackend->m_bWasWindowResized)
 	{
 		m_pVulkanBackend->m_bWasWindowResized = false;
-		m_pVulkanSwapchain->RecreateSwapchain();
+		m_pVulkanBackend->RecreateSwapchain();
 		return;
 	}
 	else if (Result != VK_SUCCESS)
@@ -94,7 +162,8 @@ void CVulkanForwardRenderPath::Render(const CCamera* const aCamera)
 		throw std::runtime_error("Failed to acquire swap chain image!");
 	}
 
-	m_pVulkanBackend->UpdateFrameUBO(aCamera, m_pVulkanBackend->m_CurrentFrame);
+	m_pVulkanBackend->UpdateFrameData(aFramePacket, m_pVulkanBackend->m_CurrentFrame);
+	m_pVulkanBackend->SubmitAsyncCompute(m_pVulkanBackend->m_CurrentFrame);
 
 	// Delay fence reset to prevent possible deadlock when recreating the swapchain.
 	VK_CHECK(vkResetFences(m_pVulkanDevice->m_Device, 1, &m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].RenderFence));
@@ -104,9 +173,11 @@ void CVulkanForwardRenderPath::Render(const CCamera* const aCamera)
 
 	VkSubmitInfo SubmitInfo = vkinit::SubmitInfo(&m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].MainCommandBuffer);
 
-	VkSemaphore WaitSemaphores[] = {m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].PresentSemaphore};
-	VkPipelineStageFlags WaitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-	SubmitInfo.waitSemaphoreCount = 1;
+	const CVulkanAsyncCompute& AsyncCompute = m_pVulkanBackend->m_AsyncCompute;
+	VkSemaphore WaitSemaphores[] = {m_pVulkanBackend->m_FramesData[m_pVulkanBackend->m_CurrentFrame].PresentSemaphore,
+		AsyncCompute.IsEnabled() ? AsyncCompute.GetSemaphore(m_pVulkanBackend->m_CurrentFrame) : VK_NULL_HANDLE};
+	VkPipelineStageFlags WaitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT, CVulkanAsyncCompute::WAIT_STAGE};
+	SubmitInfo.waitSemaphoreCount = AsyncCompute.IsEnabled() ? 2 : 1;
 	SubmitInfo.pWaitSemaphores = WaitSemaphores;
 	SubmitInfo.pWaitDstStageMask = WaitStages;
 
@@ -126,44 +197,76 @@ void CVulkanForwardRenderPath::Render(const CCamera* const aCamera)
 
 	vkQueuePresentKHR(m_pVulkanDevice->m_GraphicsQueue, &PresentInfo);
 
-	m_pVulkanBackend->m_CurrentFrame = (m_pVulkanBackend->m_CurrentFrame + 1) % FRAME_OVERLAP;
+	m_pVulkanBackend->m_CurrentFrame = (m_pVulkanBackend->m_CurrentFrame + 1) % m_pVulkanBackend->m_NumFramesInFlight;
 }
 
 void CVulkanForwardRenderPath::HandleSceneChanged()
 {
 }
 
-void CVulkanForwardRenderPath::CreateForwardPipeline()
+void CVulkanForwardRenderPath::HandleSwapchainRecreated()
 {
-	VkShaderModule VertShader;
-	// TODO: Do not hardcode this.
-	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, "../Engine/shaders/vert.spv", &VertShader))
-	{
-		std::cout << "Error when building the vertex shader module" << std::endl;
-	}
-	else
-	{
-		std::cout << "Vertex Shader loaded SUCCESSFULLY!" << std::endl;
-	}
-
-	VkShaderModule FragShader;
-	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, "../Engine/shaders/frag.spv", &FragShader))
-	{
-		std::cout << "Error when building the fragment shader module" << std::endl;
-	}
-	else
-	{
-		std::cout << "Fragment Shader loaded SUCCESSFULLY!" << std::endl;
-	}
+	m_RenderGraph.Resize(m_pVulkanSwapchain->m_WindowExtent);
+	m_UpscalePass.UpdateDescriptors();
+}
 
+void CVulkanForwardRenderPath::CreateForwardPipelineLayout()
+{
 	VkPipelineLayoutCreateInfo PipelineLayoutInfo = vkinit::PipelineLayoutCreateInfo();
-	std::array<VkDescriptorSetLayout, 3> SetLayouts = { m_pVulkanBackend->m_DescriptorSetLayout, m_pVulkanBackend->m_RenderObjectsSetLayout, m_pVulkanBackend->m_MaterialsSetLayout };
+	std::array<VkDescriptorSetLayout, 4> SetLayouts = { m_pVulkanBackend->m_DescriptorSetLayout, m_pVulkanBackend->m_RenderObjectsSetLayout, m_pVulkanBackend->m_MaterialsSetLayout,
+		m_pVulkanBackend->m_ClusteredLighting.GetSetLayout() };
 	PipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(SetLayouts.size());
 	PipelineLayoutInfo.pSetLayouts = SetLayouts.data();
 
 	VK_CHECK(vkCreatePipelineLayout(m_pVulkanDevice->m_Device, &PipelineLayoutInfo, nullptr, &m_ForwardPipelineLayout));
 
-	PipelineBuilder PipelineBuilder;
+	m_MainDeletionQueue.PushFunction([=]()
+	{
+		vkDestroyPipelineLayout(m_pVulkanDevice->m_Device, m_ForwardPipelineLayout, nullptr);
+	});
+}
+
+static void SetupForwardPipelineBuilderState(PipelineBuilder& aBuilder, const sVertexInputDescription& aVertexDescription, const std::vector<VkDynamicState>& aDynamicStates, VkExtent2D aExtent)
+{
+	aBuilder.m_DynamicState = vkinit::DynamicStateCreateInfo(aDynamicStates);
+
+	aBuilder.m_VertexInputInfo = vkinit::VertexInputStateCreateInfo();
+	aBuilder.m_VertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(aVertexDescription.Bindings.size());
+	aBuilder.m_VertexInputInfo.pVertexBindingDescriptions = aVertexDescription.Bindings.data();
+	aBuilder.m_VertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(aVertexDescription.Attributes.size());
+	aBuilder.m_VertexInputInfo.pVertexAttributeDescriptions = aVertexDescription.Attributes.data();
+
+	aBuilder.m_InputAssembly = vkinit::InputAssemblyCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+	aBuilder.m_Viewport.x = 0.0f;
+	aBuilder.m_Viewport.y = 0.0f;
+	aBuilder.m_Viewport.width = static_cast<float>(aExtent.width);
+	aBuilder.m_Viewport.height = static_cast<float>(aExtent.height);
+	aBuilder.m_Viewport.minDepth = 0.0f;
+	aBuilder.m_Viewport.maxDepth = 1.0f;
+
+	aBuilder.m_Scissor.offset = {0, 0};
+	aBuilder.m_Scissor.extent = aExtent;
+
+	aBuilder.m_Rasterizer = vkinit::RasterizationStateCreateInfo(VK_POLYGON_MODE_FILL);
+	aBuilder.m_Rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
+	aBuilder.m_Rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+	aBuilder.m_Multisampling = vkinit::MultisamplingStateCreateInfo();
+}
+
+void CVulkanForwardRenderPath::BuildForwardPipelines()
+{
+	VkShaderModule VertShader;
+	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, vkutils::GetShaderPath("vert.spv").c_str(), &VertShader))
+	{
+		SGSERROR("Error when building the vertex shader module");
+	}
+
+	VkShaderModule FragShader;
+	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, vkutils::GetShaderPath("frag.spv").c_str(), &FragShader))
+	{
+		SGSERROR("Error when building the fragment shader module");
+	}
 
 	std::vector<VkDynamicState> DynamicStates = 
 	{
@@ -171,33 +274,17 @@ void CVulkanForwardRenderPath::CreateForwardPipeline()
 		VK_DYNAMIC_STATE_SCISSOR
 	};
 
-	PipelineBuilder.m_DynamicState = vkinit::DynamicStateCreateInfo(DynamicStates);
-
-	sVertexInputDescription VertexDescription = GetVertexDescription();
-
-	PipelineBuilder.m_VertexInputInfo = vkinit::VertexInputStateCreateInfo();
-	PipelineBuilder.m_VertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(VertexDescription.Bindings.size());
-	PipelineBuilder.m_VertexInputInfo.pVertexBindingDescriptions = VertexDescription.Bindings.data();
-	PipelineBuilder.m_VertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(VertexDescription.Attributes.size());
-	PipelineBuilder.m_VertexInputInfo.pVertexAttributeDescriptions = VertexDescription.Attributes.data();
-
-	PipelineBuilder.m_InputAssembly = vkinit::InputAssemblyCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+	const sVertexInputDescription VertexDescription = GetVertexDescription();
 
-	PipelineBuilder.m_Viewport.x = 0.0f;
-	PipelineBuilder.m_Viewport.y = 0.0f;
-	PipelineBuilder.m_Viewport.width = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.width);
-	PipelineBuilder.m_Viewport.height = static_cast<float>(m_pVulkanSwapchain->m_WindowExtent.height);
-	PipelineBuilder.m_Viewport.minDepth = 0.0f;
-	PipelineBuilder.m_Viewport.maxDepth = 1.0f;
-
-	PipelineBuilder.m_Scissor.offset = {0, 0};
-	PipelineBuilder.m_Scissor.extent = m_pVulkanSwapchain->m_WindowExtent;
-
-	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(true, true, VK_COMPARE_OP_LESS);
-	PipelineBuilder.m_Rasterizer = vkinit::RasterizationStateCreateInfo(VK_POLYGON_MODE_FILL);
-	PipelineBuilder.m_Rasterizer.cullMode = VK_CULL_MODE_BACK_BIT;
-	PipelineBuilder.m_Rasterizer.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-	PipelineBuilder.m_Multisampling = vkinit::MultisamplingStateCreateInfo();
+	PipelineBuilder PipelineBuilder;
+	SetupForwardPipelineBuilderState(PipelineBuilder, VertexDescription, DynamicStates, m_pVulkanSwapchain->m_WindowExtent);
+
+	// The depth is reversed, nearer is greater. After the prepass only the nearest fragment of every pixel is left.
+#if SGS_FORWARD_DEPTH_PREPASS
+	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(true, false, VK_COMPARE_OP_EQUAL);
+#else
+	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(true, true, VK_COMPARE_OP_GREATER);
+#endif
 	PipelineBuilder.m_ColorBlendAttachment.push_back(vkinit::ColorBlendAttachmentState());
 
 	PipelineBuilder.m_ShaderStages.push_back(vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, VertShader));
@@ -205,7 +292,20 @@ void CVulkanForwardRenderPath::CreateForwardPipeline()
 
 	PipelineBuilder.m_PipelineLayout = m_ForwardPipelineLayout;
 
-	m_ForwardPipeline = PipelineBuilder.BuildPipeline(m_pVulkanDevice->m_Device, m_pVulkanSwapchain->m_RenderPass);
+	m_ForwardPipeline = PipelineBuilder.BuildPipeline(m_pVulkanDevice->m_Device, m_RenderGraph.GetRenderPass(m_ForwardPass), m_pVulkanBackend->m_PipelineCache.GetHandle());
+
+	// Blended draws are not in the prepass. They are tested against the solid geometry but do not hide each other.
+	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(true, false, VK_COMPARE_OP_GREATER);
+	VkPipelineColorBlendAttachmentState& BlendAttachment = PipelineBuilder.m_ColorBlendAttachment[0];
+	BlendAttachment.blendEnable = VK_TRUE;
+	BlendAttachment.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+	BlendAttachment.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	BlendAttachment.colorBlendOp = VK_BLEND_OP_ADD;
+	BlendAttachment.srcAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+	BlendAttachment.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	BlendAttachment.alphaBlendOp = VK_BLEND_OP_ADD;
+
+	m_ForwardBlendedPipeline = PipelineBuilder.BuildPipeline(m_pVulkanDevice->m_Device, m_RenderGraph.GetRenderPass(m_ForwardPass), m_pVulkanBackend->m_PipelineCache.GetHandle());
 
 	vkDestroyShaderModule(m_pVulkanDevice->m_Device, VertShader, nullptr);
 	vkDestroyShaderModule(m_pVulkanDevice->m_Device, FragShader, nullptr);
@@ -213,6 +313,41 @@ void CVulkanForwardRenderPath::CreateForwardPipeline()
 	m_MainDeletionQueue.PushFunction([=]()
 	{
 		vkDestroyPipeline(m_pVulkanDevice->m_Device, m_ForwardPipeline, nullptr);
-		vkDestroyPipelineLayout(m_pVulkanDevice->m_Device, m_ForwardPipelineLayout, nullptr);
+		vkDestroyPipeline(m_pVulkanDevice->m_Device, m_ForwardBlendedPipeline, nullptr);
+	});
+}
+
+void CVulkanForwardRenderPath::BuildDepthPrepassPipeline()
+{
+	// Same vertex shader as the forward pipeline, gl_Position is invariant so both passes get the same depth.
+	VkShaderModule VertShader;
+	if (!vkutils::LoadShaderModule(m_pVulkanDevice->m_Device, vkutils::GetShaderPath("vert.spv").c_str(), &VertShader))
+	{
+		SGSERROR("Error when building the vertex shader module");
+	}
+
+	std::vector<VkDynamicState> DynamicStates = 
+	{
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+
+	const sVertexInputDescription VertexDescription = GetVertexDescription();
+
+	PipelineBuilder PipelineBuilder;
+	SetupForwardPipelineBuilderState(PipelineBuilder, VertexDescription, DynamicStates, m_pVulkanSwapchain->m_WindowExtent);
+
+	// No fragment shader and no color attachment, only the depth is written.
+	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(true, true, VK_COMPARE_OP_GREATER);
+	PipelineBuilder.m_ShaderStages.push_back(vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, VertShader));
+	PipelineBuilder.m_PipelineLayout = m_ForwardPipelineLayout;
+
+	m_DepthPrepassPipeline = PipelineBuilder.BuildPipeline(m_pVulkanDevice->m_Device, m_RenderGraph.GetRenderPass(m_DepthPrepass), m_pVulkanBackend->m_PipelineCache.GetHandle());
+
+	vkDestroyShaderModule(m_pVulkanDevice->m_Device, VertShader, nullptr);
+
+	m_MainDeletionQueue.PushFunction([=]()
+	{
+		vkDestroyPipeline(m_pVulkanDevice->m_Device, m_DepthPrepassPipeline, nullptr);
 	});
 }
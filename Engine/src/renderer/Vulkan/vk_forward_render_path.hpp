@@ -1,6 +1,8 @@
 #pragma once
 
 #include "vk_types.hpp"
+#include "vk_render_graph.hpp"
+#include "vk_upscale_pass.hpp"
 #include <renderer/render_pipeline/IRenderPath.hpp>
 #include <core/types.hpp>
 
@@ -8,27 +10,51 @@ class CVulkanBackend;
 class CVulkanDevice;
 class CVulkanSwapchain;
 
+// Draws the depth of the solid geometry before the forward pass, which then only shades the visible fragment of every
+// pixel. Can be overridden at build time (/DSGS_FORWARD_DEPTH_PREPASS=0).
+#ifndef SGS_FORWARD_DEPTH_PREPASS
+#define SGS_FORWARD_DEPTH_PREPASS 1
+#endif
+
 class CVulkanForwardRenderPath : public IRenderPath
 {
 public:
     CVulkanForwardRenderPath(CVulkanBackend* apVulkanBackend, CVulkanDevice* apVulkanDevice, CVulkanSwapchain* apVulkanSwapchain);
     virtual void CreateResources() override;
+    virtual void CreatePipelines(sJobCounter& aCounter) override;
     virtual void DestroyResources() override;
-    virtual void Render(const CCamera* const aCamera) override;
+    virtual void Render(const sFramePacket& aFramePacket) override;
     virtual void UpdateBuffers() override {};
     virtual void HandleSceneChanged() override;
+    virtual void HandleSwapchainRecreated() override;
 
     VkPipeline m_ForwardPipeline;
+    VkPipeline m_ForwardBlendedPipeline;
+    VkPipeline m_DepthPrepassPipeline;
     VkPipelineLayout m_ForwardPipelineLayout;
     
 private:
-    void CreateForwardPipeline();
+    void CreateForwardPipelineLayout();
+    void CreateRenderGraph();
+    void BuildForwardPipelines();
+    void BuildDepthPrepassPipeline();
     void RecordCommands(VkCommandBuffer aCommandBuffer, uint32_t aImageIdx);
+    void DrawDepthPrepass(const sRenderGraphPassContext& aContext);
+    void DrawScene(const sRenderGraphPassContext& aContext);
 
     CVulkanBackend* m_pVulkanBackend;
     CVulkanDevice* m_pVulkanDevice;
     CVulkanSwapchain* m_pVulkanSwapchain;
 
+    // The scene is rendered at the dynamic resolution into the scene color and upscaled into the backbuffer.
+    CVulkanRenderGraph m_RenderGraph;
+    RenderGraphResource m_BackbufferImage;
+    RenderGraphResource m_SceneColorImage;
+    RenderGraphResource m_DepthImage;
+    uint32_t m_DepthPrepass;
+    uint32_t m_ForwardPass;
+    CVulkanUpscalePass m_UpscalePass;
+
     // Holds the deletion functions.
     sDeletionQueue m_MainDeletionQueue;
 };
\ No newline at end of file
@@ -312,7 +312,7 @@ VkImageViewCreateInfo vkinit::ImageViewCreateInfo(VkFormat aFormat, VkImage aIma
 	return Info;
 }
 
-VkPipeline PipelineBuilder::BuildPipeline(VkDevice aDevice, VkRenderPass aRenderPass)
+VkPipeline PipelineBuilder::BuildPipeline(VkDevice aDevice, VkRenderPass aRenderPass, VkPipelineCache aPipelineCache)
 {
     VkPipelineViewportStateCreateInfo ViewportState = {};
 	ViewportState.sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO;
@@ -349,12 +349,12 @@ VkPipeline PipelineBuilder::BuildPipeline(VkDevice aDevice, VkRenderPass aRender
     PipelineInfo.pDynamicState = &m_DynamicState;
 	PipelineInfo.layout = m_PipelineLayout;
 	PipelineInfo.renderPass = aRenderPass;
-	PipelineInfo.subpass = 0;
+	PipelineInfo.subpass = m_Subpass;
 	PipelineInfo.basePipelineHandle = VK_NULL_HANDLE;
 
 	VkPipeline NewPipeline;
 	if (vkCreateGraphicsPipelines(
-		aDevice, VK_NULL_HANDLE, 1, &PipelineInfo, nullptr, &NewPipeline) != VK_SUCCESS)
+		aDevice, aPipelineCache, 1, &PipelineInfo, nullptr, &NewPipeline) != VK_SUCCESS)
 	{
 		std::cout << "failed to create pipeline\n";
 		return VK_NULL_HANDLE;
@@ -64,6 +64,8 @@ public:
 	VkPipelineMultisampleStateCreateInfo m_Multisampling;
 	VkPipelineLayout m_PipelineLayout;
     VkPipelineDynamicStateCreateInfo m_DynamicState;
+	// Subpass of the render pass the pipeline is used in.
+	uint32_t m_Subpass = 0;
 
-	VkPipeline BuildPipeline(VkDevice aDevice, VkRenderPass aRenderPass);
+	VkPipeline BuildPipeline(VkDevice aDevice, VkRenderPass aRenderPass, VkPipelineCache aPipelineCache = VK_NULL_HANDLE);
 };
\ No newline at end of file
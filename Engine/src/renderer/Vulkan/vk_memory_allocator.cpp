@@ -0,0 +1,226 @@
+#include "vk_memory_allocator.hpp"
+#include "vulkan_device.hpp"
+#include <core/logger.h>
+
+#include <algorithm>
+#include <fstream>
+
+namespace
+{
+    void WriteEscaped(std::ofstream& aFile, const std::string& aString)
+    {
+        for (const char Character : aString)
+        {
+            if (Character == '"' || Character == '\\')
+            {
+                aFile << '\\';
+            }
+            aFile << Character;
+        }
+    }
+}
+
+const char* GetMemoryCategoryName(eMemoryCategory aCategory)
+{
+    static const char* CategoryNames[] = { "Texture", "Mesh", "RenderTarget", "ShadowMap", "Uniform", "Storage", "Staging", "Other" };
+    static_assert(sizeof(CategoryNames) / sizeof(CategoryNames[0]) == static_cast<size_t>(eMemoryCategory::NUM), "Missing memory category names.");
+    return CategoryNames[static_cast<size_t>(aCategory)];
+}
+
+CVulkanMemoryAllocator::CVulkanMemoryAllocator() :
+    m_pVulkanDevice(nullptr)
+{
+}
+
+void CVulkanMemoryAllocator::Initialize(CVulkanDevice* apVulkanDevice)
+{
+    m_pVulkanDevice = apVulkanDevice;
+    UpdateBudgets(0);
+}
+
+VkResult CVulkanMemoryAllocator::CreateBuffer(const VkBufferCreateInfo& aBufferInfo, const VmaAllocationCreateInfo& aAllocInfo, eMemoryCategory aCategory,
+    const char* apName, AllocatedBuffer& aOutBuffer)
+{
+    const VkResult Result = vmaCreateBuffer(m_pVulkanDevice->m_Allocator, &aBufferInfo, &aAllocInfo, &aOutBuffer.Buffer, &aOutBuffer.Allocation, nullptr);
+    if (Result == VK_SUCCESS)
+    {
+        Track(aOutBuffer.Allocation, aCategory, apName);
+    }
+    return Result;
+}
+
+VkResult CVulkanMemoryAllocator::CreateImage(const VkImageCreateInfo& aImageInfo, const VmaAllocationCreateInfo& aAllocInfo, eMemoryCategory aCategory,
+    const char* apName, AllocatedImage& aOutImage)
+{
+    const VkResult Result = vmaCreateImage(m_pVulkanDevice->m_Allocator, &aImageInfo, &aAllocInfo, &aOutImage.Image, &aOutImage.Allocation, nullptr);
+    if (Result == VK_SUCCESS)
+    {
+        Track(aOutImage.Allocation, aCategory, apName);
+    }
+    return Result;
+}
+
+VkResult CVulkanMemoryAllocator::AllocateMemory(const VkMemoryRequirements& aRequirements, const VmaAllocationCreateInfo& aAllocInfo, eMemoryCategory aCategory,
+    const char* apName, VmaAllocation& aOutAllocation)
+{
+    const VkResult Result = vmaAllocateMemory(m_pVulkanDevice->m_Allocator, &aRequirements, &aAllocInfo, &aOutAllocation, nullptr);
+    if (Result == VK_SUCCESS)
+    {
+        Track(aOutAllocation, aCategory, apName);
+    }
+    return Result;
+}
+
+void CVulkanMemoryAllocator::DestroyBuffer(const AllocatedBuffer& aBuffer)
+{
+    Untrack(aBuffer.Allocation);
+    vmaDestroyBuffer(m_pVulkanDevice->m_Allocator, aBuffer.Buffer, aBuffer.Allocation);
+}
+
+void CVulkanMemoryAllocator::DestroyImage(const AllocatedImage& aImage)
+{
+    Untrack(aImage.Allocation);
+    vmaDestroyImage(m_pVulkanDevice->m_Allocator, aImage.Image, aImage.Allocation);
+}
+
+void CVulkanMemoryAllocator::FreeMemory(VmaAllocation aAllocation)
+{
+    Untrack(aAllocation);
+    vmaFreeMemory(m_pVulkanDevice->m_Allocator, aAllocation);
+}
+
+void CVulkanMemoryAllocator::UpdateBudgets(uint32_t aFrameIndex)
+{
+    const VkPhysicalDeviceMemoryProperties* pMemoryProperties = nullptr;
+    vmaGetMemoryProperties(m_pVulkanDevice->m_Allocator, &pMemoryProperties);
+
+    vmaSetCurrentFrameIndex(m_pVulkanDevice->m_Allocator, aFrameIndex);
+    VmaBudget Budgets[VK_MAX_MEMORY_HEAPS];
+    vmaGetHeapBudgets(m_pVulkanDevice->m_Allocator, Budgets);
+
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    m_HeapBudgets.resize(pMemoryProperties->memoryHeapCount);
+    for (uint32_t i = 0; i < pMemoryProperties->memoryHeapCount; ++i)
+    {
+        m_HeapBudgets[i].Usage = Budgets[i].usage;
+        m_HeapBudgets[i].Budget = Budgets[i].budget;
+        m_HeapBudgets[i].bDeviceLocal = (pMemoryProperties->memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0;
+    }
+}
+
+sMemoryCategoryStats CVulkanMemoryAllocator::GetCategoryStats(eMemoryCategory aCategory) const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_CategoryStats[static_cast<size_t>(aCategory)];
+}
+
+std::vector<sMemoryHeapBudget> CVulkanMemoryAllocator::GetHeapBudgets() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_HeapBudgets;
+}
+
+uint64_t CVulkanMemoryAllocator::GetTotalBytes() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    uint64_t TotalBytes = 0;
+    for (const sMemoryCategoryStats& Stats : m_CategoryStats)
+    {
+        TotalBytes += Stats.Bytes;
+    }
+    return TotalBytes;
+}
+
+bool CVulkanMemoryAllocator::WriteReport(const char* aFilePath) const
+{
+    std::ofstream File(aFilePath, std::ios::trunc);
+    if (!File.is_open())
+    {
+        SGSERROR("Could not write the GPU memory report to %s.", aFilePath);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+
+    File << "{\n\"heaps\": [";
+    for (size_t i = 0; i < m_HeapBudgets.size(); ++i)
+    {
+        const sMemoryHeapBudget& Heap = m_HeapBudgets[i];
+        File << (i == 0 ? "\n" : ",\n") << "  {\"index\": " << i << ", \"deviceLocal\": " << (Heap.bDeviceLocal ? "true" : "false")
+            << ", \"usage\": " << Heap.Usage << ", \"budget\": " << Heap.Budget << "}";
+    }
+
+    File << "\n],\n\"categories\": {";
+    for (size_t i = 0; i < static_cast<size_t>(eMemoryCategory::NUM); ++i)
+    {
+        File << (i == 0 ? "\n" : ",\n") << "  \"" << GetMemoryCategoryName(static_cast<eMemoryCategory>(i)) << "\": {\"bytes\": "
+            << m_CategoryStats[i].Bytes << ", \"allocations\": " << m_CategoryStats[i].NumAllocations << "}";
+    }
+
+    // Biggest allocations first.
+    std::vector<const sAllocationRecord*> Records;
+    Records.reserve(m_Allocations.size());
+    for (const auto& Allocation : m_Allocations)
+    {
+        Records.push_back(&Allocation.second);
+    }
+    std::sort(Records.begin(), Records.end(), [](const sAllocationRecord* apA, const sAllocationRecord* apB) { return apA->Size > apB->Size; });
+
+    File << "\n},\n\"allocations\": [";
+    for (size_t i = 0; i < Records.size(); ++i)
+    {
+        File << (i == 0 ? "\n" : ",\n") << "  {\"name\": \"";
+        WriteEscaped(File, Records[i]->Name);
+        File << "\", \"category\": \"" << GetMemoryCategoryName(Records[i]->Category) << "\", \"bytes\": " << Records[i]->Size << "}";
+    }
+    File << "\n]\n}\n";
+
+    SGSINFO("GPU memory report written to %s.", aFilePath);
+    return true;
+}
+
+uint32_t CVulkanMemoryAllocator::ReportLeaks() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    for (const auto& Allocation : m_Allocations)
+    {
+        const sAllocationRecord& Record = Allocation.second;
+        SGSERROR("Leaked GPU allocation: %s (%s, %llu bytes).", Record.Name.c_str(), GetMemoryCategoryName(Record.Category),
+            static_cast<unsigned long long>(Record.Size));
+    }
+    return static_cast<uint32_t>(m_Allocations.size());
+}
+
+void CVulkanMemoryAllocator::Track(VmaAllocation aAllocation, eMemoryCategory aCategory, const char* apName)
+{
+    VmaAllocationInfo AllocationInfo = {};
+    vmaGetAllocationInfo(m_pVulkanDevice->m_Allocator, aAllocation, &AllocationInfo);
+
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    m_Allocations[aAllocation] = { aCategory, (apName && *apName) ? apName : "Unnamed", AllocationInfo.size };
+
+    sMemoryCategoryStats& Stats = m_CategoryStats[static_cast<size_t>(aCategory)];
+    Stats.Bytes += AllocationInfo.size;
+    ++Stats.NumAllocations;
+}
+
+void CVulkanMemoryAllocator::Untrack(VmaAllocation aAllocation)
+{
+    if (aAllocation == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    const auto& Found = m_Allocations.find(aAllocation);
+    if (Found == m_Allocations.cend())
+    {
+        SGSWARN("Freeing a GPU allocation that was not made through CVulkanMemoryAllocator.");
+        return;
+    }
+
+    sMemoryCategoryStats& Stats = m_CategoryStats[static_cast<size_t>(Found->second.Category)];
+    Stats.Bytes -= Found->second.Size;
+    --Stats.NumAllocations;
+    m_Allocations.erase(Found);
+}
@@ -0,0 +1,108 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class CVulkanDevice;
+
+/**
+ * @brief What an allocation is used for, to know where the GPU memory goes.
+ */
+enum class eMemoryCategory : uint8_t
+{
+    TEXTURE = 0,
+    MESH,
+    RENDER_TARGET,
+    SHADOW_MAP,
+    UNIFORM,
+    STORAGE,
+    STAGING,
+    OTHER,
+    NUM
+};
+
+const char* GetMemoryCategoryName(eMemoryCategory aCategory);
+
+struct sMemoryCategoryStats
+{
+    uint64_t Bytes = 0;
+    uint32_t NumAllocations = 0;
+};
+
+/**
+ * @brief Usage and budget of a memory heap, as reported by the driver (VK_EXT_memory_budget when available).
+ */
+struct sMemoryHeapBudget
+{
+    uint64_t Usage = 0;
+    uint64_t Budget = 0;
+    bool bDeviceLocal = false;
+};
+
+/**
+ * @brief Layer on top of VMA every GPU allocation of the engine goes through. Allocations are tagged with a category
+ * and a name, so the memory used by textures, meshes, render targets... can be queried, dumped to a JSON report and
+ * the allocations still alive at shutdown reported as leaks.
+ *
+ * Thread safe, assets are uploaded from loading jobs.
+ */
+class CVulkanMemoryAllocator
+{
+public:
+    CVulkanMemoryAllocator();
+
+    void Initialize(CVulkanDevice* apVulkanDevice);
+
+    VkResult CreateBuffer(const VkBufferCreateInfo& aBufferInfo, const VmaAllocationCreateInfo& aAllocInfo, eMemoryCategory aCategory,
+        const char* apName, AllocatedBuffer& aOutBuffer);
+    VkResult CreateImage(const VkImageCreateInfo& aImageInfo, const VmaAllocationCreateInfo& aAllocInfo, eMemoryCategory aCategory,
+        const char* apName, AllocatedImage& aOutImage);
+    VkResult AllocateMemory(const VkMemoryRequirements& aRequirements, const VmaAllocationCreateInfo& aAllocInfo, eMemoryCategory aCategory,
+        const char* apName, VmaAllocation& aOutAllocation);
+
+    void DestroyBuffer(const AllocatedBuffer& aBuffer);
+    void DestroyImage(const AllocatedImage& aImage);
+    void FreeMemory(VmaAllocation aAllocation);
+
+    /**
+     * @brief Reads the heap budgets from VMA. Called once per frame.
+     */
+    void UpdateBudgets(uint32_t aFrameIndex);
+
+    sMemoryCategoryStats GetCategoryStats(eMemoryCategory aCategory) const;
+    std::vector<sMemoryHeapBudget> GetHeapBudgets() const;
+    uint64_t GetTotalBytes() const;
+
+    /**
+     * @brief Writes the budgets, the totals per category and every live allocation to aFilePath as JSON.
+     */
+    bool WriteReport(const char* aFilePath) const;
+
+    /**
+     * @brief Logs every allocation still alive. Meant to be called at shutdown, once everything was destroyed.
+     * @return Number of leaked allocations.
+     */
+    uint32_t ReportLeaks() const;
+
+private:
+    struct sAllocationRecord
+    {
+        eMemoryCategory Category;
+        std::string Name;
+        VkDeviceSize Size;
+    };
+
+    void Track(VmaAllocation aAllocation, eMemoryCategory aCategory, const char* apName);
+    void Untrack(VmaAllocation aAllocation);
+
+    CVulkanDevice* m_pVulkanDevice;
+
+    std::unordered_map<VmaAllocation, sAllocationRecord> m_Allocations;
+    sMemoryCategoryStats m_CategoryStats[static_cast<size_t>(eMemoryCategory::NUM)];
+    std::vector<sMemoryHeapBudget> m_HeapBudgets;
+    mutable std::mutex m_Mutex;
+};
@@ -0,0 +1,210 @@
+#include "vk_pipeline_cache.hpp"
+#include "vulkan_device.hpp"
+#include <core/logger.h>
+
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace
+{
+    constexpr uint32_t PIPELINE_CACHE_FILE_MAGIC = 0x43505353; // "SSPC"
+    constexpr uint32_t PIPELINE_CACHE_FILE_VERSION = 1;
+
+    /**
+     * @brief Header written in front of the driver's cache blob. It identifies the device and driver
+     * that produced the data, plus a checksum to detect truncated or corrupted files.
+     */
+    struct sPipelineCacheFileHeader
+    {
+        uint32_t Magic;
+        uint32_t Version;
+        uint32_t VendorID;
+        uint32_t DeviceID;
+        uint32_t DriverVersion;
+        uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+        uint64_t DataSize;
+        uint64_t DataHash;
+    };
+
+    // FNV-1a.
+    uint64_t HashData(const uint8_t* apData, size_t aSize)
+    {
+        uint64_t Hash = 14695981039346656037ull;
+        for (size_t i = 0; i < aSize; ++i)
+        {
+            Hash ^= apData[i];
+            Hash *= 1099511628211ull;
+        }
+        return Hash;
+    }
+}
+
+CVulkanPipelineCache::CVulkanPipelineCache() :
+    m_pVulkanDevice(nullptr),
+    m_PipelineCache(VK_NULL_HANDLE),
+    m_DeviceProperties{}
+{
+}
+
+void CVulkanPipelineCache::Initialize(const CVulkanDevice* const apVulkanDevice, const std::string& aFilePath)
+{
+    m_pVulkanDevice = apVulkanDevice;
+    m_FilePath = aFilePath;
+
+    vkGetPhysicalDeviceProperties(m_pVulkanDevice->m_PhysicalDevice, &m_DeviceProperties);
+
+    std::vector<uint8_t> InitialData;
+    if (LoadFromFile(InitialData))
+    {
+        SGSINFO("Pipeline cache loaded from %s (%zu bytes).", m_FilePath.c_str(), InitialData.size());
+    }
+
+    VkPipelineCacheCreateInfo CacheInfo = {};
+    CacheInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+    CacheInfo.pNext = nullptr;
+    CacheInfo.flags = 0;
+    CacheInfo.initialDataSize = InitialData.size();
+    CacheInfo.pInitialData = InitialData.empty() ? nullptr : InitialData.data();
+
+    if (vkCreatePipelineCache(m_pVulkanDevice->m_Device, &CacheInfo, nullptr, &m_PipelineCache) != VK_SUCCESS)
+    {
+        // The driver may still reject data that passed our checks, start from an empty cache then.
+        SGSWARN("Pipeline cache data rejected by the driver, creating an empty cache.");
+        CacheInfo.initialDataSize = 0;
+        CacheInfo.pInitialData = nullptr;
+        VK_CHECK(vkCreatePipelineCache(m_pVulkanDevice->m_Device, &CacheInfo, nullptr, &m_PipelineCache));
+    }
+}
+
+bool CVulkanPipelineCache::LoadFromFile(std::vector<uint8_t>& aOutData) const
+{
+    std::ifstream File(m_FilePath, std::ios::binary);
+    if (!File.is_open())
+    {
+        return false;
+    }
+
+    sPipelineCacheFileHeader Header;
+    if (!File.read(reinterpret_cast<char*>(&Header), sizeof(Header)))
+    {
+        SGSWARN("Pipeline cache file %s is too small, ignoring it.", m_FilePath.c_str());
+        return false;
+    }
+
+    if (Header.Magic != PIPELINE_CACHE_FILE_MAGIC || Header.Version != PIPELINE_CACHE_FILE_VERSION)
+    {
+        SGSWARN("Pipeline cache file %s has an unknown format, ignoring it.", m_FilePath.c_str());
+        return false;
+    }
+
+    if (Header.VendorID != m_DeviceProperties.vendorID || Header.DeviceID != m_DeviceProperties.deviceID ||
+        Header.DriverVersion != m_DeviceProperties.driverVersion ||
+        std::memcmp(Header.PipelineCacheUUID, m_DeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        SGSINFO("Pipeline cache file %s was created by another device or driver, ignoring it.", m_FilePath.c_str());
+        return false;
+    }
+
+    aOutData.resize(static_cast<size_t>(Header.DataSize));
+    if (!File.read(reinterpret_cast<char*>(aOutData.data()), aOutData.size()) ||
+        HashData(aOutData.data(), aOutData.size()) != Header.DataHash)
+    {
+        SGSWARN("Pipeline cache file %s is corrupted, ignoring it.", m_FilePath.c_str());
+        aOutData.clear();
+        return false;
+    }
+
+    // The blob starts with the header defined by Vulkan, check it as well before handing it to the driver.
+    VkPipelineCacheHeaderVersionOne DriverHeader;
+    if (aOutData.size() < sizeof(DriverHeader))
+    {
+        aOutData.clear();
+        return false;
+    }
+
+    std::memcpy(&DriverHeader, aOutData.data(), sizeof(DriverHeader));
+    if (DriverHeader.headerVersion != VK_PIPELINE_CACHE_HEADER_VERSION_ONE ||
+        DriverHeader.vendorID != m_DeviceProperties.vendorID || DriverHeader.deviceID != m_DeviceProperties.deviceID ||
+        std::memcmp(DriverHeader.pipelineCacheUUID, m_DeviceProperties.pipelineCacheUUID, VK_UUID_SIZE) != 0)
+    {
+        SGSWARN("Pipeline cache file %s does not match the driver header, ignoring it.", m_FilePath.c_str());
+        aOutData.clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool CVulkanPipelineCache::Save() const
+{
+    if (m_PipelineCache == VK_NULL_HANDLE)
+    {
+        return false;
+    }
+
+    size_t DataSize = 0;
+    VK_CHECK(vkGetPipelineCacheData(m_pVulkanDevice->m_Device, m_PipelineCache, &DataSize, nullptr));
+
+    std::vector<uint8_t> Data(DataSize);
+    VK_CHECK(vkGetPipelineCacheData(m_pVulkanDevice->m_Device, m_PipelineCache, &DataSize, Data.data()));
+    Data.resize(DataSize);
+
+    sPipelineCacheFileHeader Header = {};
+    Header.Magic = PIPELINE_CACHE_FILE_MAGIC;
+    Header.Version = PIPELINE_CACHE_FILE_VERSION;
+    Header.VendorID = m_DeviceProperties.vendorID;
+    Header.DeviceID = m_DeviceProperties.deviceID;
+    Header.DriverVersion = m_DeviceProperties.driverVersion;
+    std::memcpy(Header.PipelineCacheUUID, m_DeviceProperties.pipelineCacheUUID, VK_UUID_SIZE);
+    Header.DataSize = Data.size();
+    Header.DataHash = HashData(Data.data(), Data.size());
+
+    std::error_code Error;
+    const std::filesystem::path FilePath(m_FilePath);
+    if (FilePath.has_parent_path())
+    {
+        std::filesystem::create_directories(FilePath.parent_path(), Error);
+    }
+
+    // Write to a temporary file first so a crash while saving never leaves a half written cache behind.
+    const std::string TempPath = m_FilePath + ".tmp";
+    {
+        std::ofstream File(TempPath, std::ios::binary | std::ios::trunc);
+        if (!File.is_open())
+        {
+            SGSWARN("Could not open %s to save the pipeline cache.", TempPath.c_str());
+            return false;
+        }
+
+        File.write(reinterpret_cast<const char*>(&Header), sizeof(Header));
+        File.write(reinterpret_cast<const char*>(Data.data()), Data.size());
+        if (!File)
+        {
+            SGSWARN("Failed to write the pipeline cache to %s.", TempPath.c_str());
+            return false;
+        }
+    }
+
+    std::filesystem::rename(TempPath, FilePath, Error);
+    if (Error)
+    {
+        SGSWARN("Failed to move the pipeline cache to %s: %s", m_FilePath.c_str(), Error.message().c_str());
+        return false;
+    }
+
+    SGSINFO("Pipeline cache saved to %s (%zu bytes).", m_FilePath.c_str(), Data.size());
+    return true;
+}
+
+void CVulkanPipelineCache::Shutdown()
+{
+    if (m_PipelineCache == VK_NULL_HANDLE)
+    {
+        return;
+    }
+
+    Save();
+    vkDestroyPipelineCache(m_pVulkanDevice->m_Device, m_PipelineCache, nullptr);
+    m_PipelineCache = VK_NULL_HANDLE;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+#include <string>
+
+class CVulkanDevice;
+
+// File the pipeline cache is persisted to between runs. Can be overridden at build time (/DSGS_PIPELINE_CACHE_FILE=...).
+#ifndef SGS_PIPELINE_CACHE_FILE
+#define SGS_PIPELINE_CACHE_FILE "../Engine/cache/pipeline_cache.bin"
+#endif
+
+/**
+ * @brief Owns the VkPipelineCache shared by every pipeline of the backend and persists it on disk,
+ * so pipelines compiled in a previous run do not need to be compiled again by the driver.
+ * The file starts with a header identifying the device and driver that produced it. If it does not
+ * match the current device (GPU or driver update) the data is discarded and the cache starts empty.
+ */
+class CVulkanPipelineCache
+{
+public:
+    CVulkanPipelineCache();
+
+    /**
+     * @brief Creates the pipeline cache, seeding it with the contents of aFilePath when they are valid for this device.
+     */
+    void Initialize(const CVulkanDevice* const apVulkanDevice, const std::string& aFilePath);
+
+    /**
+     * @brief Writes the current contents of the cache to disk.
+     */
+    bool Save() const;
+
+    /**
+     * @brief Saves the cache and destroys it.
+     */
+    void Shutdown();
+
+    VkPipelineCache GetHandle() const { return m_PipelineCache; }
+
+private:
+    bool LoadFromFile(std::vector<uint8_t>& aOutData) const;
+
+    const CVulkanDevice* m_pVulkanDevice;
+    VkPipelineCache m_PipelineCache;
+    VkPhysicalDeviceProperties m_DeviceProperties;
+    std::string m_FilePath;
+};
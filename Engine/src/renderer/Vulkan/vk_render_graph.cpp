@@ -0,0 +1,991 @@
+#include "vk_render_graph.hpp"
+#include "vulkan_device.hpp"
+#include "vk_initializers.hpp"
+#include <core/logger.h>
+#include <core/assertions.h>
+
+#include <algorithm>
+#include <functional>
+#include <queue>
+
+namespace
+{
+    constexpr VkAccessFlags WRITE_ACCESS_MASK = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT |
+        VK_ACCESS_SHADER_WRITE_BIT | VK_ACCESS_TRANSFER_WRITE_BIT;
+
+    // Imported images are expected to be acquired with a semaphore waited at this stage (swapchain images).
+    constexpr VkPipelineStageFlags IMPORTED_IMAGE_STAGE = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+
+    // Usages allowed on an image created with VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT.
+    constexpr VkImageUsageFlags ATTACHMENT_USAGE_MASK = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT |
+        VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
+}
+
+CRenderGraphPassBuilder::CRenderGraphPassBuilder(CVulkanRenderGraph* apRenderGraph, uint32_t aPassIdx) :
+    m_pRenderGraph(apRenderGraph), m_PassIdx(aPassIdx)
+{
+}
+
+void CRenderGraphPassBuilder::WriteColor(RenderGraphResource aResource, bool abClear, VkClearColorValue aClearColor)
+{
+    VkClearValue ClearValue = {};
+    ClearValue.color = aClearColor;
+    m_pRenderGraph->m_Passes[m_PassIdx].Uses.push_back({aResource, CVulkanRenderGraph::eAccess::COLOR_ATTACHMENT, abClear, ClearValue});
+}
+
+void CRenderGraphPassBuilder::WriteDepth(RenderGraphResource aResource, bool abClear, float aClearDepth)
+{
+    VkClearValue ClearValue = {};
+    ClearValue.depthStencil = {aClearDepth, 0};
+    m_pRenderGraph->m_Passes[m_PassIdx].Uses.push_back({aResource, CVulkanRenderGraph::eAccess::DEPTH_ATTACHMENT, abClear, ClearValue});
+}
+
+void CRenderGraphPassBuilder::ReadTexture(RenderGraphResource aResource)
+{
+    m_pRenderGraph->m_Passes[m_PassIdx].Uses.push_back({aResource, CVulkanRenderGraph::eAccess::SAMPLED, false, {}});
+}
+
+void CRenderGraphPassBuilder::ReadInputAttachment(RenderGraphResource aResource)
+{
+    m_pRenderGraph->m_Passes[m_PassIdx].Uses.push_back({aResource, CVulkanRenderGraph::eAccess::INPUT_ATTACHMENT, false, {}});
+}
+
+void CRenderGraphPassBuilder::UseRenderExtent()
+{
+    m_pRenderGraph->m_Passes[m_PassIdx].bUsesRenderExtent = true;
+}
+
+CVulkanRenderGraph::CVulkanRenderGraph(CVulkanDevice* apVulkanDevice) :
+    m_pVulkanDevice(apVulkanDevice),
+    m_Extent{0, 0},
+    m_RenderExtent{0, 0},
+    m_bCompiled(false)
+{
+}
+
+RenderGraphResource CVulkanRenderGraph::CreateImage(const std::string& aName, const sRenderGraphImageDesc& aDesc)
+{
+    SGSASSERT(!m_bCompiled);
+
+    sImage Image;
+    Image.Name = aName;
+    Image.Desc = aDesc;
+    m_Images.push_back(Image);
+    return static_cast<RenderGraphResource>(m_Images.size() - 1);
+}
+
+RenderGraphResource CVulkanRenderGraph::ImportImage(const std::string& aName, VkFormat aFormat, VkImageLayout aFinalLayout)
+{
+    SGSASSERT(!m_bCompiled);
+
+    sImage Image;
+    Image.Name = aName;
+    Image.Desc.Format = aFormat;
+    Image.bImported = true;
+    Image.FinalLayout = aFinalLayout;
+    m_Images.push_back(Image);
+    return static_cast<RenderGraphResource>(m_Images.size() - 1);
+}
+
+uint32_t CVulkanRenderGraph::AddPass(const std::string& aName, const std::function<void(CRenderGraphPassBuilder& aBuilder)>& aSetup, RenderGraphExecuteFunction&& aExecute)
+{
+    SGSASSERT(!m_bCompiled);
+
+    const uint32_t PassIdx = static_cast<uint32_t>(m_Passes.size());
+    m_Passes.emplace_back();
+    m_Passes.back().Name = aName;
+    m_Passes.back().Execute = std::move(aExecute);
+
+    CRenderGraphPassBuilder Builder(this, PassIdx);
+    aSetup(Builder);
+
+    return PassIdx;
+}
+
+void CVulkanRenderGraph::Compile(VkExtent2D aExtent)
+{
+    SGSASSERT(!m_bCompiled);
+
+    m_Extent = aExtent;
+    m_RenderExtent = aExtent;
+
+    SortPasses();
+    ComputeLifetimes();
+    BuildPassGroups();
+    CreateRenderPasses();
+    CreateTransientImages();
+
+    m_ImageStates.resize(m_Images.size());
+    m_LastBarrierGroup.resize(m_Images.size());
+    m_bCompiled = true;
+}
+
+void CVulkanRenderGraph::Resize(VkExtent2D aExtent)
+{
+    SGSASSERT(m_bCompiled);
+
+    DestroyFramebuffers();
+    DestroyTransientImages();
+
+    m_Extent = aExtent;
+    m_RenderExtent = aExtent;
+    CreateTransientImages();
+}
+
+void CVulkanRenderGraph::SetImportedImage(RenderGraphResource aResource, VkImage aImage, VkImageView aImageView)
+{
+    sImage& Image = m_Images[aResource];
+    SGSASSERT(Image.bImported);
+
+    Image.Image = aImage;
+    Image.View = aImageView;
+}
+
+void CVulkanRenderGraph::SetRenderExtent(VkExtent2D aRenderExtent)
+{
+    m_RenderExtent.width = std::clamp(aRenderExtent.width, 1u, m_Extent.width);
+    m_RenderExtent.height = std::clamp(aRenderExtent.height, 1u, m_Extent.height);
+}
+
+CVulkanRenderGraph::sImageState CVulkanRenderGraph::GetRequiredState(eAccess aAccess)
+{
+    switch (aAccess)
+    {
+        case eAccess::COLOR_ATTACHMENT:
+            return { VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+                VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT };
+
+        case eAccess::DEPTH_ATTACHMENT:
+            return { VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+                VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT };
+
+        case eAccess::INPUT_ATTACHMENT:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_INPUT_ATTACHMENT_READ_BIT };
+
+        case eAccess::SAMPLED:
+        default:
+            return { VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT };
+    }
+}
+
+void CVulkanRenderGraph::SortPasses()
+{
+    const size_t NumPasses = m_Passes.size();
+
+    // Writers of every image, in declaration order. Writers of an image run in the order they were added,
+    // and the readers of an image run after all of its writers.
+    std::vector<std::vector<uint32_t>> Writers(m_Images.size());
+    for (uint32_t PassIdx = 0; PassIdx < NumPasses; ++PassIdx)
+    {
+        for (const sResourceUse& Use : m_Passes[PassIdx].Uses)
+        {
+            auto& ImageWriters = Writers[Use.Resource];
+            if (IsWriteAccess(Use.Access) && (ImageWriters.empty() || ImageWriters.back() != PassIdx))
+            {
+                ImageWriters.push_back(PassIdx);
+            }
+        }
+    }
+
+    std::vector<std::vector<uint32_t>> Successors(NumPasses);
+    std::vector<std::vector<uint32_t>> Predecessors(NumPasses);
+    auto AddEdge = [&](uint32_t aFrom, uint32_t aTo)
+    {
+        Successors[aFrom].push_back(aTo);
+        Predecessors[aTo].push_back(aFrom);
+    };
+
+    for (const auto& ImageWriters : Writers)
+    {
+        for (size_t i = 1; i < ImageWriters.size(); ++i)
+        {
+            AddEdge(ImageWriters[i - 1], ImageWriters[i]);
+        }
+    }
+
+    for (uint32_t PassIdx = 0; PassIdx < NumPasses; ++PassIdx)
+    {
+        for (const sResourceUse& Use : m_Passes[PassIdx].Uses)
+        {
+            if (IsWriteAccess(Use.Access))
+            {
+                continue;
+            }
+
+            if (Writers[Use.Resource].empty() && !m_Images[Use.Resource].bImported)
+            {
+                SGSWARN("Render graph pass %s reads %s, which is never written.", m_Passes[PassIdx].Name.c_str(), m_Images[Use.Resource].Name.c_str());
+            }
+
+            for (uint32_t Writer : Writers[Use.Resource])
+            {
+                if (Writer != PassIdx)
+                {
+                    AddEdge(Writer, PassIdx);
+                }
+            }
+        }
+    }
+
+    // Cull the passes that do not contribute to an imported image.
+    std::vector<bool> Needed(NumPasses, false);
+    std::vector<uint32_t> Stack;
+    for (uint32_t PassIdx = 0; PassIdx < NumPasses; ++PassIdx)
+    {
+        for (const sResourceUse& Use : m_Passes[PassIdx].Uses)
+        {
+            if (IsWriteAccess(Use.Access) && m_Images[Use.Resource].bImported && !Needed[PassIdx])
+            {
+                Needed[PassIdx] = true;
+                Stack.push_back(PassIdx);
+            }
+        }
+    }
+
+    while (!Stack.empty())
+    {
+        const uint32_t PassIdx = Stack.back();
+        Stack.pop_back();
+        for (uint32_t Predecessor : Predecessors[PassIdx])
+        {
+            if (!Needed[Predecessor])
+            {
+                Needed[Predecessor] = true;
+                Stack.push_back(Predecessor);
+            }
+        }
+    }
+
+    // Topological sort. Among the passes that are ready, the one declared first goes first.
+    std::vector<uint32_t> InDegree(NumPasses, 0);
+    for (uint32_t PassIdx = 0; PassIdx < NumPasses; ++PassIdx)
+    {
+        for (uint32_t Successor : Successors[PassIdx])
+        {
+            ++InDegree[Successor];
+        }
+    }
+
+    std::priority_queue<uint32_t, std::vector<uint32_t>, std::greater<uint32_t>> Ready;
+    for (uint32_t PassIdx = 0; PassIdx < NumPasses; ++PassIdx)
+    {
+        if (InDegree[PassIdx] == 0)
+        {
+            Ready.push(PassIdx);
+        }
+    }
+
+    m_ExecutionOrder.clear();
+    size_t NumSorted = 0;
+    while (!Ready.empty())
+    {
+        const uint32_t PassIdx = Ready.top();
+        Ready.pop();
+        ++NumSorted;
+
+        if (Needed[PassIdx])
+        {
+            m_ExecutionOrder.push_back(PassIdx);
+        }
+        else
+        {
+            SGSDEBUG("Render graph pass %s culled.", m_Passes[PassIdx].Name.c_str());
+        }
+
+        for (uint32_t Successor : Successors[PassIdx])
+        {
+            if (--InDegree[Successor] == 0)
+            {
+                Ready.push(Successor);
+            }
+        }
+    }
+
+    if (NumSorted != NumPasses)
+    {
+        SGSERROR("Render graph has a dependency cycle, executing the passes in declaration order.");
+        m_ExecutionOrder.clear();
+        for (uint32_t PassIdx = 0; PassIdx < NumPasses; ++PassIdx)
+        {
+            m_ExecutionOrder.push_back(PassIdx);
+        }
+    }
+}
+
+void CVulkanRenderGraph::ComputeLifetimes()
+{
+    for (uint32_t Position = 0; Position < m_ExecutionOrder.size(); ++Position)
+    {
+        for (const sResourceUse& Use : m_Passes[m_ExecutionOrder[Position]].Uses)
+        {
+            sImage& Image = m_Images[Use.Resource];
+            Image.FirstUse = std::min(Image.FirstUse, Position);
+            Image.LastUse = std::max(Image.LastUse, Position);
+
+            switch (Use.Access)
+            {
+                case eAccess::COLOR_ATTACHMENT: Image.Usage |= VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT; break;
+                case eAccess::DEPTH_ATTACHMENT: Image.Usage |= VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT; break;
+                case eAccess::INPUT_ATTACHMENT: Image.Usage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT; break;
+                case eAccess::SAMPLED: Image.Usage |= VK_IMAGE_USAGE_SAMPLED_BIT; break;
+            }
+        }
+    }
+}
+
+bool CVulkanRenderGraph::CanMergeIntoGroup(const sPassGroup& aGroup, const sPass& aPass) const
+{
+    auto IsUsedInGroup = [&](RenderGraphResource aResource, bool abWrites, bool abSampled)
+    {
+        for (uint32_t PassIdx : aGroup.Passes)
+        {
+            for (const sResourceUse& Use : m_Passes[PassIdx].Uses)
+            {
+                if (Use.Resource == aResource && (!abWrites || IsWriteAccess(Use.Access)) && (!abSampled || Use.Access == eAccess::SAMPLED))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    };
+
+    // Every subpass of a render pass shares its render area.
+    if (m_Passes[aGroup.Passes.front()].bUsesRenderExtent != aPass.bUsesRenderExtent)
+    {
+        return false;
+    }
+
+    // A pass joins the group when it reads some of its outputs as input attachments and none of them as textures.
+    // Sampling an image written in the same render pass would need the whole image, not only the current pixel.
+    bool bReadsInputAttachment = false;
+    for (const sResourceUse& Use : aPass.Uses)
+    {
+        switch (Use.Access)
+        {
+            case eAccess::INPUT_ATTACHMENT:
+                if (!IsUsedInGroup(Use.Resource, true, false))
+                {
+                    return false;
+                }
+                bReadsInputAttachment = true;
+                break;
+
+            case eAccess::SAMPLED:
+                if (IsUsedInGroup(Use.Resource, false, false))
+                {
+                    return false;
+                }
+                break;
+
+            default:
+                if (IsUsedInGroup(Use.Resource, false, true))
+                {
+                    return false;
+                }
+                break;
+        }
+    }
+
+    return bReadsInputAttachment;
+}
+
+void CVulkanRenderGraph::BuildPassGroups()
+{
+    for (uint32_t Position = 0; Position < m_ExecutionOrder.size(); ++Position)
+    {
+        const uint32_t PassIdx = m_ExecutionOrder[Position];
+        sPass& Pass = m_Passes[PassIdx];
+
+        if (m_Groups.empty() || !CanMergeIntoGroup(m_Groups.back(), Pass))
+        {
+            sPassGroup Group;
+            Group.FirstPosition = Position;
+            m_Groups.push_back(Group);
+        }
+
+        sPassGroup& Group = m_Groups.back();
+        Pass.Group = static_cast<uint32_t>(m_Groups.size() - 1);
+        Pass.Subpass = static_cast<uint32_t>(Group.Passes.size());
+        Group.Passes.push_back(PassIdx);
+        Group.LastPosition = Position;
+    }
+
+    // Images that are only attachments of a single render pass never need to be backed by real memory.
+    for (sImage& Image : m_Images)
+    {
+        if (Image.bImported || Image.FirstUse == UINT32_MAX)
+        {
+            continue;
+        }
+
+        const bool bSingleGroup = m_Passes[m_ExecutionOrder[Image.FirstUse]].Group == m_Passes[m_ExecutionOrder[Image.LastUse]].Group;
+        if (bSingleGroup && ((Image.Usage | Image.Desc.AdditionalUsage) & ~ATTACHMENT_USAGE_MASK) == 0)
+        {
+            Image.Usage |= VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+            Image.bLazilyAllocated = true;
+        }
+    }
+}
+
+void CVulkanRenderGraph::CreateRenderPasses()
+{
+    for (sPassGroup& Group : m_Groups)
+    {
+        CreateRenderPass(Group);
+    }
+}
+
+void CVulkanRenderGraph::CreateRenderPass(sPassGroup& aGroup)
+{
+    struct sAttachmentUse
+    {
+        uint32_t Subpass;
+        const sResourceUse* pUse;
+    };
+
+    // Every attachment of the group with its uses, in subpass order.
+    std::vector<std::vector<sAttachmentUse>> AttachmentUses;
+    for (uint32_t SubpassIdx = 0; SubpassIdx < aGroup.Passes.size(); ++SubpassIdx)
+    {
+        for (const sResourceUse& Use : m_Passes[aGroup.Passes[SubpassIdx]].Uses)
+        {
+            if (!IsAttachmentAccess(Use.Access))
+            {
+                continue;
+            }
+
+            const auto Found = std::find(aGroup.Attachments.begin(), aGroup.Attachments.end(), Use.Resource);
+            if (Found == aGroup.Attachments.end())
+            {
+                aGroup.Attachments.push_back(Use.Resource);
+                AttachmentUses.emplace_back();
+                AttachmentUses.back().push_back({SubpassIdx, &Use});
+            }
+            else
+            {
+                AttachmentUses[Found - aGroup.Attachments.begin()].push_back({SubpassIdx, &Use});
+            }
+        }
+    }
+
+    if (aGroup.Attachments.empty())
+    {
+        return;
+    }
+
+    const uint32_t NumSubpasses = static_cast<uint32_t>(aGroup.Passes.size());
+    std::vector<VkAttachmentDescription> AttachmentDescriptions;
+    std::vector<std::vector<VkAttachmentReference>> ColorReferences(NumSubpasses);
+    std::vector<std::vector<VkAttachmentReference>> InputReferences(NumSubpasses);
+    std::vector<VkAttachmentReference> DepthReferences(NumSubpasses, {VK_ATTACHMENT_UNUSED, VK_IMAGE_LAYOUT_UNDEFINED});
+    std::vector<std::vector<uint32_t>> PreserveAttachments(NumSubpasses);
+    std::vector<VkSubpassDependency> Dependencies;
+
+    for (uint32_t AttachmentIdx = 0; AttachmentIdx < aGroup.Attachments.size(); ++AttachmentIdx)
+    {
+        const sImage& Image = m_Images[aGroup.Attachments[AttachmentIdx]];
+        const std::vector<sAttachmentUse>& Uses = AttachmentUses[AttachmentIdx];
+        const sAttachmentUse& FirstUse = Uses.front();
+        const sAttachmentUse& LastUse = Uses.back();
+
+        // Layout transitions before the group are done by the graph barriers, the ones between subpasses by the render pass.
+        VkAttachmentDescription Attachment = {};
+        Attachment.format = Image.Desc.Format;
+        Attachment.samples = VK_SAMPLE_COUNT_1_BIT;
+        if (FirstUse.pUse->bClear)
+        {
+            Attachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+        }
+        else
+        {
+            Attachment.loadOp = Image.FirstUse == aGroup.FirstPosition + FirstUse.Subpass ? VK_ATTACHMENT_LOAD_OP_DONT_CARE : VK_ATTACHMENT_LOAD_OP_LOAD;
+        }
+        // Transient images that nobody reads after the group never need to leave the tile memory.
+        const bool bStore = Image.bImported || Image.LastUse > aGroup.LastPosition;
+        Attachment.storeOp = bStore ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        Attachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+        Attachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        Attachment.initialLayout = GetRequiredState(FirstUse.pUse->Access).Layout;
+        Attachment.finalLayout = GetRequiredState(LastUse.pUse->Access).Layout;
+
+        AttachmentDescriptions.push_back(Attachment);
+        aGroup.ClearValues.push_back(FirstUse.pUse->ClearValue);
+
+        for (size_t UseIdx = 0; UseIdx < Uses.size(); ++UseIdx)
+        {
+            const sAttachmentUse& Use = Uses[UseIdx];
+            const VkAttachmentReference Reference = { AttachmentIdx, GetRequiredState(Use.pUse->Access).Layout };
+            switch (Use.pUse->Access)
+            {
+                case eAccess::COLOR_ATTACHMENT: ColorReferences[Use.Subpass].push_back(Reference); break;
+                case eAccess::DEPTH_ATTACHMENT: DepthReferences[Use.Subpass] = Reference; break;
+                default: InputReferences[Use.Subpass].push_back(Reference); break;
+            }
+
+            if (UseIdx == 0)
+            {
+                continue;
+            }
+
+            // Subpasses in between that do not touch the attachment must keep its contents.
+            const sAttachmentUse& PreviousUse = Uses[UseIdx - 1];
+            for (uint32_t SubpassIdx = PreviousUse.Subpass + 1; SubpassIdx < Use.Subpass; ++SubpassIdx)
+            {
+                PreserveAttachments[SubpassIdx].push_back(AttachmentIdx);
+            }
+
+            if (PreviousUse.Subpass == Use.Subpass || (!IsWriteAccess(PreviousUse.pUse->Access) && !IsWriteAccess(Use.pUse->Access)))
+            {
+                continue;
+            }
+
+            const sImageState Src = GetRequiredState(PreviousUse.pUse->Access);
+            const sImageState Dst = GetRequiredState(Use.pUse->Access);
+            auto Dependency = std::find_if(Dependencies.begin(), Dependencies.end(), [&](const VkSubpassDependency& aDependency)
+            {
+                return aDependency.srcSubpass == PreviousUse.Subpass && aDependency.dstSubpass == Use.Subpass;
+            });
+            if (Dependency == Dependencies.end())
+            {
+                VkSubpassDependency NewDependency = {};
+                NewDependency.srcSubpass = PreviousUse.Subpass;
+                NewDependency.dstSubpass = Use.Subpass;
+                // Subpasses only read the texel of the pixel they shade, so the dependency is tile local.
+                NewDependency.dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+                Dependencies.push_back(NewDependency);
+                Dependency = Dependencies.end() - 1;
+            }
+            Dependency->srcStageMask |= Src.Stages;
+            Dependency->dstStageMask |= Dst.Stages;
+            Dependency->srcAccessMask |= Src.Access & WRITE_ACCESS_MASK;
+            Dependency->dstAccessMask |= Dst.Access;
+        }
+
+        if (bStore)
+        {
+            for (uint32_t SubpassIdx = LastUse.Subpass + 1; SubpassIdx < NumSubpasses; ++SubpassIdx)
+            {
+                PreserveAttachments[SubpassIdx].push_back(AttachmentIdx);
+            }
+        }
+    }
+
+    std::vector<VkSubpassDescription> Subpasses(NumSubpasses);
+    for (uint32_t SubpassIdx = 0; SubpassIdx < NumSubpasses; ++SubpassIdx)
+    {
+        VkSubpassDescription& Subpass = Subpasses[SubpassIdx];
+        Subpass = {};
+        Subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+        Subpass.inputAttachmentCount = static_cast<uint32_t>(InputReferences[SubpassIdx].size());
+        Subpass.pInputAttachments = InputReferences[SubpassIdx].data();
+        Subpass.colorAttachmentCount = static_cast<uint32_t>(ColorReferences[SubpassIdx].size());
+        Subpass.pColorAttachments = ColorReferences[SubpassIdx].data();
+        Subpass.pDepthStencilAttachment = DepthReferences[SubpassIdx].attachment != VK_ATTACHMENT_UNUSED ? &DepthReferences[SubpassIdx] : nullptr;
+        Subpass.preserveAttachmentCount = static_cast<uint32_t>(PreserveAttachments[SubpassIdx].size());
+        Subpass.pPreserveAttachments = PreserveAttachments[SubpassIdx].data();
+    }
+
+    VkRenderPassCreateInfo RenderPassInfo = {};
+    RenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+    RenderPassInfo.pNext = nullptr;
+    RenderPassInfo.attachmentCount = static_cast<uint32_t>(AttachmentDescriptions.size());
+    RenderPassInfo.pAttachments = AttachmentDescriptions.data();
+    RenderPassInfo.subpassCount = NumSubpasses;
+    RenderPassInfo.pSubpasses = Subpasses.data();
+    RenderPassInfo.dependencyCount = static_cast<uint32_t>(Dependencies.size());
+    RenderPassInfo.pDependencies = Dependencies.data();
+
+    VK_CHECK(vkCreateRenderPass(m_pVulkanDevice->m_Device, &RenderPassInfo, nullptr, &aGroup.RenderPass));
+
+    if (NumSubpasses > 1)
+    {
+        SGSDEBUG("Render graph: pass %s merged with %u more passes as subpasses.", m_Passes[aGroup.Passes.front()].Name.c_str(), NumSubpasses - 1);
+    }
+}
+
+void CVulkanRenderGraph::CreateTransientImages()
+{
+    std::vector<RenderGraphResource> TransientImages;
+    std::vector<VkMemoryRequirements> Requirements(m_Images.size());
+
+    for (RenderGraphResource Resource = 0; Resource < m_Images.size(); ++Resource)
+    {
+        sImage& Image = m_Images[Resource];
+        if (Image.bImported || Image.FirstUse == UINT32_MAX)
+        {
+            continue;
+        }
+
+        VkImageCreateInfo ImageInfo = vkinit::ImageCreateInfo(Image.Desc.Format, Image.Usage | Image.Desc.AdditionalUsage, {m_Extent.width, m_Extent.height, 1});
+        VK_CHECK(vkCreateImage(m_pVulkanDevice->m_Device, &ImageInfo, nullptr, &Image.Image));
+        vkGetImageMemoryRequirements(m_pVulkanDevice->m_Device, Image.Image, &Requirements[Resource]);
+
+        TransientImages.push_back(Resource);
+    }
+
+    // Biggest images first, each one goes to the first block it fits in without overlapping lifetimes.
+    std::sort(TransientImages.begin(), TransientImages.end(), [&](RenderGraphResource aLeft, RenderGraphResource aRight)
+    {
+        return Requirements[aLeft].size > Requirements[aRight].size;
+    });
+
+    VkDeviceSize TotalSize = 0;
+    for (RenderGraphResource Resource : TransientImages)
+    {
+        sImage& Image = m_Images[Resource];
+        const VkMemoryRequirements& ImageRequirements = Requirements[Resource];
+        TotalSize += ImageRequirements.size;
+
+        // Lazily allocated images get their own block, there is nothing to alias when the memory is never committed.
+        for (uint32_t BlockIdx = 0; BlockIdx < m_MemoryBlocks.size() && Image.MemoryBlock == UINT32_MAX && !Image.bLazilyAllocated; ++BlockIdx)
+        {
+            sMemoryBlock& Block = m_MemoryBlocks[BlockIdx];
+            if (Block.bLazilyAllocated || (Block.Requirements.memoryTypeBits & ImageRequirements.memoryTypeBits) == 0)
+            {
+                continue;
+            }
+
+            const bool bOverlaps = std::any_of(Block.Images.begin(), Block.Images.end(), [&](RenderGraphResource aOther)
+            {
+                const sImage& Other = m_Images[aOther];
+                return Image.FirstUse <= Other.LastUse && Other.FirstUse <= Image.LastUse;
+            });
+
+            if (!bOverlaps)
+            {
+                Block.Requirements.size = std::max(Block.Requirements.size, ImageRequirements.size);
+                Block.Requirements.alignment = std::max(Block.Requirements.alignment, ImageRequirements.alignment);
+                Block.Requirements.memoryTypeBits &= ImageRequirements.memoryTypeBits;
+                Block.Images.push_back(Resource);
+                Image.MemoryBlock = BlockIdx;
+            }
+        }
+
+        if (Image.MemoryBlock == UINT32_MAX)
+        {
+            sMemoryBlock Block;
+            Block.Requirements = ImageRequirements;
+            Block.Images.push_back(Resource);
+            Block.bLazilyAllocated = Image.bLazilyAllocated;
+            Image.MemoryBlock = static_cast<uint32_t>(m_MemoryBlocks.size());
+            m_MemoryBlocks.push_back(Block);
+        }
+    }
+
+    VkDeviceSize AliasedSize = 0;
+    size_t NumLazilyAllocated = 0;
+    for (sMemoryBlock& Block : m_MemoryBlocks)
+    {
+        // Aliased blocks are reported under the name of their first image.
+        const char* pBlockName = m_Images[Block.Images[0]].Name.c_str();
+        CVulkanMemoryAllocator& MemoryAllocator = m_pVulkanDevice->m_MemoryAllocator;
+
+        VmaAllocationCreateInfo AllocInfo = {};
+        AllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+        AllocInfo.requiredFlags = VkMemoryPropertyFlagBits(VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+        if (Block.bLazilyAllocated)
+        {
+            VmaAllocationCreateInfo LazyAllocInfo = {};
+            LazyAllocInfo.usage = VMA_MEMORY_USAGE_GPU_LAZILY_ALLOCATED;
+            LazyAllocInfo.requiredFlags = VkMemoryPropertyFlagBits(VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+
+            // Most desktop GPUs have no lazily allocated memory type, regular device memory is used then.
+            if (MemoryAllocator.AllocateMemory(Block.Requirements, LazyAllocInfo, eMemoryCategory::RENDER_TARGET, pBlockName, Block.Allocation) == VK_SUCCESS)
+            {
+                ++NumLazilyAllocated;
+            }
+            else
+            {
+                Block.bLazilyAllocated = false;
+            }
+        }
+
+        if (!Block.bLazilyAllocated)
+        {
+            VK_CHECK(MemoryAllocator.AllocateMemory(Block.Requirements, AllocInfo, eMemoryCategory::RENDER_TARGET, pBlockName, Block.Allocation));
+            AliasedSize += Block.Requirements.size;
+        }
+
+        for (RenderGraphResource Resource : Block.Images)
+        {
+            sImage& Image = m_Images[Resource];
+            VK_CHECK(vmaBindImageMemory(m_pVulkanDevice->m_Allocator, Block.Allocation, Image.Image));
+
+            VkImageViewCreateInfo ViewInfo = vkinit::ImageViewCreateInfo(Image.Desc.Format, Image.Image, Image.Desc.Aspect);
+            VK_CHECK(vkCreateImageView(m_pVulkanDevice->m_Device, &ViewInfo, nullptr, &Image.View));
+
+            for (uint32_t PassIdx : m_ExecutionOrder)
+            {
+                for (const sResourceUse& Use : m_Passes[PassIdx].Uses)
+                {
+                    if (Use.Resource == Resource)
+                    {
+                        const sImageState State = GetRequiredState(Use.Access);
+                        Block.Stages |= State.Stages;
+                        Block.WriteAccess |= State.Access & WRITE_ACCESS_MASK;
+                    }
+                }
+            }
+        }
+    }
+
+    SGSINFO("Render graph: %zu transient images in %zu memory blocks (%zu lazily allocated), %.2f MB (%.2f MB without aliasing).",
+        TransientImages.size(), m_MemoryBlocks.size(), NumLazilyAllocated, AliasedSize / (1024.0 * 1024.0), TotalSize / (1024.0 * 1024.0));
+}
+
+void CVulkanRenderGraph::DestroyTransientImages()
+{
+    for (sImage& Image : m_Images)
+    {
+        if (Image.bImported || Image.Image == VK_NULL_HANDLE)
+        {
+            continue;
+        }
+
+        vkDestroyImageView(m_pVulkanDevice->m_Device, Image.View, nullptr);
+        vkDestroyImage(m_pVulkanDevice->m_Device, Image.Image, nullptr);
+        Image.View = VK_NULL_HANDLE;
+        Image.Image = VK_NULL_HANDLE;
+        Image.MemoryBlock = UINT32_MAX;
+    }
+
+    for (sMemoryBlock& Block : m_MemoryBlocks)
+    {
+        m_pVulkanDevice->m_MemoryAllocator.FreeMemory(Block.Allocation);
+    }
+    m_MemoryBlocks.clear();
+}
+
+void CVulkanRenderGraph::DestroyFramebuffers()
+{
+    for (sPassGroup& Group : m_Groups)
+    {
+        for (sFramebufferEntry& Entry : Group.Framebuffers)
+        {
+            vkDestroyFramebuffer(m_pVulkanDevice->m_Device, Entry.Framebuffer, nullptr);
+        }
+        Group.Framebuffers.clear();
+    }
+}
+
+VkRenderPass CVulkanRenderGraph::GetRenderPass(uint32_t aPassIdx) const
+{
+    const uint32_t GroupIdx = m_Passes[aPassIdx].Group;
+    return GroupIdx != UINT32_MAX ? m_Groups[GroupIdx].RenderPass : VK_NULL_HANDLE;
+}
+
+VkFramebuffer CVulkanRenderGraph::GetFramebuffer(sPassGroup& aGroup)
+{
+    // Imported images change from frame to frame (one per swapchain image), so there is one framebuffer per combination of views.
+    std::vector<VkImageView> Views;
+    Views.reserve(aGroup.Attachments.size());
+    for (RenderGraphResource Resource : aGroup.Attachments)
+    {
+        Views.push_back(m_Images[Resource].View);
+    }
+
+    for (const sFramebufferEntry& Entry : aGroup.Framebuffers)
+    {
+        if (Entry.Views == Views)
+        {
+            return Entry.Framebuffer;
+        }
+    }
+
+    VkFramebufferCreateInfo FramebufferInfo = {};
+    FramebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+    FramebufferInfo.pNext = nullptr;
+    FramebufferInfo.renderPass = aGroup.RenderPass;
+    FramebufferInfo.attachmentCount = static_cast<uint32_t>(Views.size());
+    FramebufferInfo.pAttachments = Views.data();
+    FramebufferInfo.width = m_Extent.width;
+    FramebufferInfo.height = m_Extent.height;
+    FramebufferInfo.layers = 1;
+
+    sFramebufferEntry Entry;
+    VK_CHECK(vkCreateFramebuffer(m_pVulkanDevice->m_Device, &FramebufferInfo, nullptr, &Entry.Framebuffer));
+    Entry.Views = std::move(Views);
+    aGroup.Framebuffers.push_back(std::move(Entry));
+
+    return aGroup.Framebuffers.back().Framebuffer;
+}
+
+void CVulkanRenderGraph::Execute(VkCommandBuffer aCmdBuffer)
+{
+    SGSASSERT(m_bCompiled);
+
+    for (RenderGraphResource Resource = 0; Resource < m_Images.size(); ++Resource)
+    {
+        const sImage& Image = m_Images[Resource];
+        if (Image.bImported)
+        {
+            m_ImageStates[Resource] = { VK_IMAGE_LAYOUT_UNDEFINED, IMPORTED_IMAGE_STAGE, 0 };
+        }
+        else if (Image.MemoryBlock != UINT32_MAX)
+        {
+            const sMemoryBlock& Block = m_MemoryBlocks[Image.MemoryBlock];
+            m_ImageStates[Resource] = { VK_IMAGE_LAYOUT_UNDEFINED, Block.Stages, Block.WriteAccess };
+        }
+    }
+
+    auto AddBarrier = [this](const sImage& aImage, const sImageState& aFrom, const sImageState& aTo)
+    {
+        VkImageMemoryBarrier Barrier = {};
+        Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        Barrier.pNext = nullptr;
+        Barrier.srcAccessMask = aFrom.Access & WRITE_ACCESS_MASK;
+        Barrier.dstAccessMask = aTo.Access;
+        Barrier.oldLayout = aFrom.Layout;
+        Barrier.newLayout = aTo.Layout;
+        Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        Barrier.image = aImage.Image;
+        Barrier.subresourceRange.aspectMask = aImage.Desc.Aspect;
+        Barrier.subresourceRange.baseMipLevel = 0;
+        Barrier.subresourceRange.levelCount = 1;
+        Barrier.subresourceRange.baseArrayLayer = 0;
+        Barrier.subresourceRange.layerCount = 1;
+        m_Barriers.push_back(Barrier);
+    };
+
+    std::fill(m_LastBarrierGroup.begin(), m_LastBarrierGroup.end(), UINT32_MAX);
+
+    for (uint32_t GroupIdx = 0; GroupIdx < m_Groups.size(); ++GroupIdx)
+    {
+        sPassGroup& Group = m_Groups[GroupIdx];
+
+        m_Barriers.clear();
+        VkPipelineStageFlags SrcStages = 0;
+        VkPipelineStageFlags DstStages = 0;
+
+        for (uint32_t PassIdx : Group.Passes)
+        {
+            for (const sResourceUse& Use : m_Passes[PassIdx].Uses)
+            {
+                sImageState& State = m_ImageStates[Use.Resource];
+                const sImageState Required = GetRequiredState(Use.Access);
+
+                // Only the first use in the group needs a barrier, the subpass dependencies handle the rest.
+                if (m_LastBarrierGroup[Use.Resource] == GroupIdx)
+                {
+                    State = Required;
+                    continue;
+                }
+                m_LastBarrierGroup[Use.Resource] = GroupIdx;
+
+                // Reads after reads in the same layout need no barrier, they only extend the set of stages to wait on later.
+                const bool bNeedsBarrier = State.Layout != Required.Layout || IsWriteAccess(Use.Access) || (State.Access & WRITE_ACCESS_MASK) != 0;
+                if (bNeedsBarrier)
+                {
+                    AddBarrier(m_Images[Use.Resource], State, Required);
+                    SrcStages |= State.Stages;
+                    DstStages |= Required.Stages;
+                    State = Required;
+                }
+                else
+                {
+                    State.Stages |= Required.Stages;
+                    State.Access |= Required.Access;
+                }
+            }
+        }
+
+        if (!m_Barriers.empty())
+        {
+            vkCmdPipelineBarrier(aCmdBuffer, SrcStages ? SrcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, DstStages, 0,
+                0, nullptr, 0, nullptr, static_cast<uint32_t>(m_Barriers.size()), m_Barriers.data());
+        }
+
+        const VkExtent2D RenderArea = m_Passes[Group.Passes.front()].bUsesRenderExtent ? m_RenderExtent : m_Extent;
+
+        sRenderGraphPassContext Context = {};
+        Context.CmdBuffer = aCmdBuffer;
+        Context.RenderPass = Group.RenderPass;
+        Context.Subpass = 0;
+        Context.Extent = RenderArea;
+
+        if (Group.RenderPass == VK_NULL_HANDLE)
+        {
+            for (uint32_t PassIdx : Group.Passes)
+            {
+                m_Passes[PassIdx].Execute(Context);
+            }
+            continue;
+        }
+
+        VkRenderPassBeginInfo RenderPassInfo = vkinit::RenderPassBeginInfo(Group.RenderPass, RenderArea, GetFramebuffer(Group));
+        RenderPassInfo.clearValueCount = static_cast<uint32_t>(Group.ClearValues.size());
+        RenderPassInfo.pClearValues = Group.ClearValues.data();
+
+        vkCmdBeginRenderPass(aCmdBuffer, &RenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        VkViewport Viewport{};
+        Viewport.x = 0.0f;
+        Viewport.y = 0.0f;
+        Viewport.width = static_cast<float>(RenderArea.width);
+        Viewport.height = static_cast<float>(RenderArea.height);
+        Viewport.minDepth = 0.0f;
+        Viewport.maxDepth = 1.0f;
+        vkCmdSetViewport(aCmdBuffer, 0, 1, &Viewport);
+
+        VkRect2D Scissor{};
+        Scissor.offset = {0, 0};
+        Scissor.extent = RenderArea;
+        vkCmdSetScissor(aCmdBuffer, 0, 1, &Scissor);
+
+        for (uint32_t SubpassIdx = 0; SubpassIdx < Group.Passes.size(); ++SubpassIdx)
+        {
+            if (SubpassIdx > 0)
+            {
+                vkCmdNextSubpass(aCmdBuffer, VK_SUBPASS_CONTENTS_INLINE);
+            }
+
+            Context.Subpass = SubpassIdx;
+            m_Passes[Group.Passes[SubpassIdx]].Execute(Context);
+        }
+
+        vkCmdEndRenderPass(aCmdBuffer);
+    }
+
+    // Leave the imported images the way their owner expects them (e.g. ready to present).
+    m_Barriers.clear();
+    VkPipelineStageFlags SrcStages = 0;
+    for (RenderGraphResource Resource = 0; Resource < m_Images.size(); ++Resource)
+    {
+        const sImage& Image = m_Images[Resource];
+        sImageState& State = m_ImageStates[Resource];
+        if (Image.bImported && Image.FirstUse != UINT32_MAX && Image.FinalLayout != VK_IMAGE_LAYOUT_UNDEFINED && State.Layout != Image.FinalLayout)
+        {
+            AddBarrier(Image, State, { Image.FinalLayout, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0 });
+            SrcStages |= State.Stages;
+        }
+    }
+
+    if (!m_Barriers.empty())
+    {
+        vkCmdPipelineBarrier(aCmdBuffer, SrcStages, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+            0, nullptr, 0, nullptr, static_cast<uint32_t>(m_Barriers.size()), m_Barriers.data());
+    }
+}
+
+void CVulkanRenderGraph::Destroy()
+{
+    DestroyFramebuffers();
+    DestroyTransientImages();
+
+    for (sPassGroup& Group : m_Groups)
+    {
+        if (Group.RenderPass != VK_NULL_HANDLE)
+        {
+            vkDestroyRenderPass(m_pVulkanDevice->m_Device, Group.RenderPass, nullptr);
+        }
+    }
+
+    m_Groups.clear();
+    m_Passes.clear();
+    m_Images.clear();
+    m_ExecutionOrder.clear();
+    m_bCompiled = false;
+}
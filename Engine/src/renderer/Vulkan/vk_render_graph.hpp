@@ -0,0 +1,263 @@
+#pragma once
+
+#include "vk_types.hpp"
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class CVulkanDevice;
+class CVulkanRenderGraph;
+
+using RenderGraphResource = uint32_t;
+constexpr RenderGraphResource INVALID_RENDER_GRAPH_RESOURCE = UINT32_MAX;
+
+/**
+ * @brief Description of an image owned by the render graph. Its size always matches the graph extent.
+ */
+struct sRenderGraphImageDesc
+{
+    VkFormat Format = VK_FORMAT_UNDEFINED;
+    VkImageAspectFlags Aspect = VK_IMAGE_ASPECT_COLOR_BIT;
+    // Usage on top of the one deduced from the passes that access the image.
+    VkImageUsageFlags AdditionalUsage = 0;
+};
+
+/**
+ * @brief Data handed to a pass when it is executed. The render pass is already begun (and in the
+ * subpass of the pass) and the viewport and scissor cover Extent: the render extent for the passes
+ * that called UseRenderExtent(), the whole graph extent otherwise.
+ */
+struct sRenderGraphPassContext
+{
+    VkCommandBuffer CmdBuffer;
+    VkRenderPass RenderPass;
+    uint32_t Subpass;
+    VkExtent2D Extent;
+};
+
+using RenderGraphExecuteFunction = std::function<void(const sRenderGraphPassContext& aContext)>;
+
+/**
+ * @brief Used by the passes to declare which resources they read and write.
+ */
+class CRenderGraphPassBuilder
+{
+public:
+    void WriteColor(RenderGraphResource aResource, bool abClear = true, VkClearColorValue aClearColor = {{0.0f, 0.0f, 0.0f, 1.0f}});
+    /**
+     * @brief The scene depth is reversed (see CCamera::GetProjection()), so it is cleared to the far plane at 0 by default.
+     */
+    void WriteDepth(RenderGraphResource aResource, bool abClear = true, float aClearDepth = 0.0f);
+    void ReadTexture(RenderGraphResource aResource);
+    /**
+     * @brief Reads the texel of the current pixel with subpassLoad(). When the image is written by the passes
+     * right before, this pass becomes a subpass of their render pass and the image may never leave tile memory.
+     */
+    void ReadInputAttachment(RenderGraphResource aResource);
+    /**
+     * @brief The pass only renders to the top left corner of its attachments, sized by the render extent of the graph
+     * (see CVulkanRenderGraph::SetRenderExtent()). Passes that read its output must account for it.
+     */
+    void UseRenderExtent();
+
+private:
+    friend class CVulkanRenderGraph;
+    CRenderGraphPassBuilder(CVulkanRenderGraph* apRenderGraph, uint32_t aPassIdx);
+
+    CVulkanRenderGraph* m_pRenderGraph;
+    uint32_t m_PassIdx;
+};
+
+/**
+ * @brief Frame graph for the render paths. Passes declare the images they read and write and the graph:
+ * - Orders the passes from their dependencies and culls the ones whose output is never used.
+ * - Creates a VkRenderPass and the framebuffers for every pass from its attachments. Passes that only read
+ *   the previous passes as input attachments are merged with them as subpasses of a single render pass.
+ * - Records the minimal image barriers between passes, so the whole frame goes in a single command buffer.
+ * - Owns the transient images and aliases the memory of the ones whose lifetimes do not overlap. Images that
+ *   live inside a single render pass use lazily allocated memory when the device has it.
+ *
+ * Usage: declare images and passes, Compile() once, then Execute() every frame. Imported images (e.g. the
+ * swapchain image) must be bound with SetImportedImage() before executing.
+ */
+class CVulkanRenderGraph
+{
+public:
+    CVulkanRenderGraph(CVulkanDevice* apVulkanDevice);
+
+    /**
+     * @brief Declares an image owned by the graph. Its contents do not survive between frames.
+     */
+    RenderGraphResource CreateImage(const std::string& aName, const sRenderGraphImageDesc& aDesc);
+
+    /**
+     * @brief Declares an image owned outside of the graph, like the swapchain image.
+     * @param aFinalLayout Layout the image is left in at the end of the frame.
+     */
+    RenderGraphResource ImportImage(const std::string& aName, VkFormat aFormat, VkImageLayout aFinalLayout);
+
+    /**
+     * @brief Adds a pass. aSetup is called right away to declare the resources of the pass.
+     * @return Index of the pass, used to query its VkRenderPass.
+     */
+    uint32_t AddPass(const std::string& aName, const std::function<void(CRenderGraphPassBuilder& aBuilder)>& aSetup, RenderGraphExecuteFunction&& aExecute);
+
+    /**
+     * @brief Orders the passes, creates the render passes and allocates the transient images.
+     */
+    void Compile(VkExtent2D aExtent);
+
+    /**
+     * @brief Recreates the transient images and framebuffers with a new extent. The GPU must be idle.
+     */
+    void Resize(VkExtent2D aExtent);
+
+    void SetImportedImage(RenderGraphResource aResource, VkImage aImage, VkImageView aImageView);
+
+    /**
+     * @brief Sets the area rendered by the passes that UseRenderExtent(), clamped to the graph extent. Can change every
+     * frame, the images are not recreated. Compile() and Resize() reset it to the graph extent.
+     */
+    void SetRenderExtent(VkExtent2D aRenderExtent);
+
+    /**
+     * @brief Records every pass with its barriers in aCmdBuffer.
+     */
+    void Execute(VkCommandBuffer aCmdBuffer);
+
+    /**
+     * @brief Destroys every Vulkan object owned by the graph. The GPU must be idle.
+     */
+    void Destroy();
+
+    VkRenderPass GetRenderPass(uint32_t aPassIdx) const;
+    uint32_t GetSubpassIndex(uint32_t aPassIdx) const { return m_Passes[aPassIdx].Subpass; }
+    VkImageView GetImageView(RenderGraphResource aResource) const { return m_Images[aResource].View; }
+    VkExtent2D GetExtent() const { return m_Extent; }
+    VkExtent2D GetRenderExtent() const { return m_RenderExtent; }
+
+private:
+    friend class CRenderGraphPassBuilder;
+
+    enum class eAccess : uint8_t
+    {
+        COLOR_ATTACHMENT = 0,
+        DEPTH_ATTACHMENT,
+        INPUT_ATTACHMENT,
+        SAMPLED
+    };
+
+    struct sResourceUse
+    {
+        RenderGraphResource Resource;
+        eAccess Access;
+        bool bClear;
+        VkClearValue ClearValue;
+    };
+
+    // Layout, stages and accesses an image is in (or needs to be in).
+    struct sImageState
+    {
+        VkImageLayout Layout;
+        VkPipelineStageFlags Stages;
+        VkAccessFlags Access;
+    };
+
+    struct sFramebufferEntry
+    {
+        std::vector<VkImageView> Views;
+        VkFramebuffer Framebuffer;
+    };
+
+    struct sPass
+    {
+        std::string Name;
+        std::vector<sResourceUse> Uses;
+        RenderGraphExecuteFunction Execute;
+        bool bUsesRenderExtent = false;
+
+        uint32_t Group = UINT32_MAX;
+        uint32_t Subpass = 0;
+    };
+
+    // Consecutive passes recorded in the same VkRenderPass, one subpass each.
+    struct sPassGroup
+    {
+        std::vector<uint32_t> Passes;
+        // Positions in m_ExecutionOrder of the first and last passes.
+        uint32_t FirstPosition;
+        uint32_t LastPosition;
+
+        VkRenderPass RenderPass = VK_NULL_HANDLE;
+        std::vector<RenderGraphResource> Attachments;
+        std::vector<VkClearValue> ClearValues;
+        std::vector<sFramebufferEntry> Framebuffers;
+    };
+
+    struct sImage
+    {
+        std::string Name;
+        sRenderGraphImageDesc Desc;
+        bool bImported = false;
+        VkImageLayout FinalLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+
+        VkImageUsageFlags Usage = 0;
+        VkImage Image = VK_NULL_HANDLE;
+        VkImageView View = VK_NULL_HANDLE;
+
+        // Lifetime, as positions in m_ExecutionOrder.
+        uint32_t FirstUse = UINT32_MAX;
+        uint32_t LastUse = 0;
+        uint32_t MemoryBlock = UINT32_MAX;
+        // Only used as an attachment inside a single render pass, its contents never reach memory.
+        bool bLazilyAllocated = false;
+    };
+
+    // Memory shared by transient images whose lifetimes do not overlap.
+    struct sMemoryBlock
+    {
+        VmaAllocation Allocation = VK_NULL_HANDLE;
+        VkMemoryRequirements Requirements = {};
+        std::vector<RenderGraphResource> Images;
+        // Every stage and write access done on the block during a frame. The first use of an image
+        // in the block waits on them, which covers the previous occupant and the previous frame.
+        VkPipelineStageFlags Stages = 0;
+        VkAccessFlags WriteAccess = 0;
+        bool bLazilyAllocated = false;
+    };
+
+    static sImageState GetRequiredState(eAccess aAccess);
+    static bool IsWriteAccess(eAccess aAccess) { return aAccess == eAccess::COLOR_ATTACHMENT || aAccess == eAccess::DEPTH_ATTACHMENT; }
+    static bool IsAttachmentAccess(eAccess aAccess) { return aAccess != eAccess::SAMPLED; }
+
+    void SortPasses();
+    void ComputeLifetimes();
+    void BuildPassGroups();
+    bool CanMergeIntoGroup(const sPassGroup& aGroup, const sPass& aPass) const;
+    void CreateRenderPasses();
+    void CreateRenderPass(sPassGroup& aGroup);
+    void CreateTransientImages();
+    void DestroyTransientImages();
+    void DestroyFramebuffers();
+    VkFramebuffer GetFramebuffer(sPassGroup& aGroup);
+
+    CVulkanDevice* m_pVulkanDevice;
+    VkExtent2D m_Extent;
+    VkExtent2D m_RenderExtent;
+
+    std::vector<sPass> m_Passes;
+    std::vector<sPassGroup> m_Groups;
+    std::vector<sImage> m_Images;
+    std::vector<sMemoryBlock> m_MemoryBlocks;
+
+    // Indices of the passes that survived culling, in execution order.
+    std::vector<uint32_t> m_ExecutionOrder;
+
+    // Scratch data reused every frame.
+    std::vector<sImageState> m_ImageStates;
+    std::vector<VkImageMemoryBarrier> m_Barriers;
+    std::vector<uint32_t> m_LastBarrierGroup;
+
+    bool m_bCompiled;
+};
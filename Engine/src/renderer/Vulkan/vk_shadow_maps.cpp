@@ -0,0 +1,577 @@
+#include "vk_shadow_maps.hpp"
+#include "vulkan_device.hpp"
+#include "vk_initializers.hpp"
+#include "vk_utils.hpp"
+#include <core/logger.h>
+
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace
+{
+	constexpr VkFormat SHADOW_MAP_FORMAT = VK_FORMAT_D32_SFLOAT;
+
+	// How far the cascades reach from the camera, nothing is shadowed past it.
+	constexpr float SHADOW_DISTANCE = 100.0f;
+	// Blend between logarithmic (1) and uniform (0) cascade splits.
+	constexpr float SPLIT_LAMBDA = 0.8f;
+	// Cascades cover this much more than their frustum slice, so they can be reused while the camera moves.
+	constexpr float CASCADE_MARGIN = 1.25f;
+	// Casters outside of the cascade but between it and the light still cast shadows into it.
+	constexpr float CASTER_DISTANCE = 100.0f;
+
+	// The first cascade is updated every frame, the next one every other frame and the last two every four frames,
+	// interleaved so at most two cascades are drawn per frame.
+	constexpr uint32_t CASCADE_UPDATE_INTERVAL[NUM_SHADOW_CASCADES] = { 1, 2, 4, 4 };
+	constexpr uint32_t CASCADE_UPDATE_PHASE[NUM_SHADOW_CASCADES] = { 0, 1, 0, 2 };
+
+	// GPU layout, must match shadows.glsl.
+	struct sGPUShadowData
+	{
+		glm::mat4 CascadeViewProj[NUM_SHADOW_CASCADES];
+		glm::vec4 CascadeSplits;
+		// World size of a texel of every cascade.
+		glm::vec4 CascadeTexelSizes;
+		glm::vec4 LightDirection;
+		glm::vec4 LightColor;
+		glm::vec4 ShadowParams;
+	};
+}
+
+CVulkanShadowMaps::CVulkanShadowMaps() :
+	m_pVulkanDevice(nullptr),
+	m_Cascades(),
+	m_LightView(1.0f),
+	m_LightDirection(0.0f),
+	m_FrameCounter(0),
+	m_ScheduledCascades(0),
+	m_ShadowMap(),
+	m_StaticCache(),
+	m_ShadowMapArrayView(VK_NULL_HANDLE),
+	m_ShadowSampler(VK_NULL_HANDLE),
+	m_StaticRenderPass(VK_NULL_HANDLE),
+	m_DynamicRenderPass(VK_NULL_HANDLE),
+	m_PipelineLayout(VK_NULL_HANDLE),
+	m_Pipeline(VK_NULL_HANDLE)
+{
+}
+
+void CVulkanShadowMaps::Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames, VkPipelineCache aPipelineCache,
+	VkDescriptorSetLayout aFrameSetLayout, VkDescriptorSetLayout aRenderObjectsSetLayout)
+{
+	m_pVulkanDevice = apVulkanDevice;
+
+	m_Frames.resize(aNumFrames);
+	const VmaAllocator Allocator = m_pVulkanDevice->m_Allocator;
+	for (sFrameResources& Frame : m_Frames)
+	{
+		Frame.ShadowBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sGPUShadowData), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			eMemoryCategory::UNIFORM, "Shadow Data");
+		vmaMapMemory(Allocator, Frame.ShadowBuffer.Allocation, &Frame.pMappedShadowBuffer);
+	}
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		for (sFrameResources& Frame : m_Frames)
+		{
+			vmaUnmapMemory(Allocator, Frame.ShadowBuffer.Allocation);
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(Frame.ShadowBuffer);
+		}
+		m_Frames.clear();
+	});
+
+	CreateImages();
+	CreateRenderPasses();
+	CreateFramebuffers();
+	CreatePipeline(aPipelineCache, aFrameSetLayout, aRenderObjectsSetLayout);
+}
+
+void CVulkanShadowMaps::Shutdown()
+{
+	m_DeletionQueue.Flush();
+}
+
+void CVulkanShadowMaps::UpdateFrame(uint32_t aFrameIdx, const sFramePacket& aFramePacket, const glm::mat4& aView, float aFovY, float aAspect, float aNearPlane)
+{
+	assert(aFrameIdx < m_Frames.size());
+
+	const sDirectionalLight& Light = aFramePacket.DirectionalLight;
+	const glm::vec3 LightDirection = glm::normalize(Light.Direction);
+	if (LightDirection != m_LightDirection)
+	{
+		// Every cascade is seen from a new angle, nothing can be reused.
+		const glm::vec3 Up = std::abs(LightDirection.y) > 0.99f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+		m_LightView = glm::lookAt(glm::vec3(0.0f), LightDirection, Up);
+		m_LightDirection = LightDirection;
+		for (sCascade& Cascade : m_Cascades)
+		{
+			Cascade.bFitted = false;
+		}
+	}
+
+	const glm::mat4 InvView = glm::inverse(aView);
+	const float TanHalfFovY = std::tan(aFovY * 0.5f);
+	const float TanHalfFovX = TanHalfFovY * aAspect;
+
+	m_ScheduledCascades = 0;
+	float SplitNear = aNearPlane;
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; ++i)
+	{
+		const float t = static_cast<float>(i + 1) / NUM_SHADOW_CASCADES;
+		const float LogSplit = aNearPlane * std::pow(SHADOW_DISTANCE / aNearPlane, t);
+		const float UniformSplit = aNearPlane + (SHADOW_DISTANCE - aNearPlane) * t;
+		const float SplitFar = SPLIT_LAMBDA * LogSplit + (1.0f - SPLIT_LAMBDA) * UniformSplit;
+
+		// Bounding sphere of the slice. Its radius only depends on the projection, so it does not change when the camera moves.
+		glm::vec3 Corners[8];
+		glm::vec3 Center(0.0f);
+		for (uint32_t c = 0; c < 8; ++c)
+		{
+			const float Depth = (c & 4) ? SplitFar : SplitNear;
+			const glm::vec3 ViewCorner((c & 1 ? 1.0f : -1.0f) * Depth * TanHalfFovX, (c & 2 ? 1.0f : -1.0f) * Depth * TanHalfFovY, -Depth);
+			Corners[c] = glm::vec3(InvView * glm::vec4(ViewCorner, 1.0f));
+			Center += Corners[c] / 8.0f;
+		}
+
+		float Radius = 0.0f;
+		for (const glm::vec3& Corner : Corners)
+		{
+			Radius = std::max(Radius, glm::length(Corner - Center));
+		}
+		Radius = std::ceil(Radius * 16.0f) / 16.0f;
+
+		sCascade& Cascade = m_Cascades[i];
+		Cascade.SplitFar = SplitFar;
+
+		const glm::vec3 LightSpaceCenter = glm::vec3(m_LightView * glm::vec4(Center, 1.0f));
+		const bool bFits = Cascade.bFitted && glm::length(LightSpaceCenter - Cascade.Center) + Radius <= Cascade.Radius;
+		if (!bFits)
+		{
+			FitCascade(Cascade, LightSpaceCenter, Radius);
+		}
+
+		if ((m_FrameCounter % CASCADE_UPDATE_INTERVAL[i]) == CASCADE_UPDATE_PHASE[i])
+		{
+			m_ScheduledCascades |= 1u << i;
+		}
+
+		SplitNear = SplitFar;
+	}
+	++m_FrameCounter;
+
+	sGPUShadowData ShadowData = {};
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; ++i)
+	{
+		ShadowData.CascadeViewProj[i] = m_Cascades[i].ViewProj;
+		ShadowData.CascadeSplits[i] = m_Cascades[i].SplitFar;
+		ShadowData.CascadeTexelSizes[i] = 2.0f * m_Cascades[i].Radius / SGS_SHADOW_MAP_SIZE;
+	}
+	ShadowData.LightDirection = glm::vec4(LightDirection, 0.0f);
+	ShadowData.LightColor = glm::vec4(Light.Color, Light.Intensity);
+	ShadowData.ShadowParams = glm::vec4(1.0f / SGS_SHADOW_MAP_SIZE, 0.0f, 0.0f, 0.0f);
+
+	memcpy(m_Frames[aFrameIdx].pMappedShadowBuffer, &ShadowData, sizeof(sGPUShadowData));
+}
+
+void CVulkanShadowMaps::FitCascade(sCascade& aCascade, const glm::vec3& aLightSpaceCenter, float aRadius)
+{
+	aCascade.Radius = aRadius * CASCADE_MARGIN;
+
+	// Moving the cascade by whole texels keeps the edges of the shadows from shimmering.
+	const float TexelSize = 2.0f * aCascade.Radius / SGS_SHADOW_MAP_SIZE;
+	aCascade.Center = glm::floor(aLightSpaceCenter / TexelSize) * TexelSize;
+
+	const glm::vec3& C = aCascade.Center;
+	const float R = aCascade.Radius;
+	const glm::mat4 Proj = glm::orthoRH_ZO(C.x - R, C.x + R, C.y - R, C.y + R, -C.z - R - CASTER_DISTANCE, -C.z + R);
+	aCascade.ViewProj = Proj * m_LightView;
+
+	aCascade.bFitted = true;
+	aCascade.bStaticDirty = true;
+}
+
+void CVulkanShadowMaps::RecordShadows(VkCommandBuffer aCmdBuffer, const std::vector<CVulkanRenderable*>& aRenderables, VkDescriptorSet aObjectsDescriptorSet)
+{
+	bool bHasDynamicCasters = false;
+	for (const CVulkanRenderable* pRenderable : aRenderables)
+	{
+		bHasDynamicCasters |= !pRenderable->m_bIsStatic;
+	}
+
+	// Without dynamic casters a scheduled update would produce the same depth again.
+	uint32_t CascadesToUpdate = bHasDynamicCasters ? m_ScheduledCascades : 0;
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; ++i)
+	{
+		if (m_Cascades[i].bStaticDirty)
+		{
+			CascadesToUpdate |= 1u << i;
+		}
+	}
+
+	if (CascadesToUpdate == 0)
+	{
+		return;
+	}
+
+	vkCmdBindPipeline(aCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+	vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 1, 1, &aObjectsDescriptorSet, 0, nullptr);
+
+	const VkExtent2D Extent = { SGS_SHADOW_MAP_SIZE, SGS_SHADOW_MAP_SIZE };
+	const VkViewport Viewport = { 0.0f, 0.0f, static_cast<float>(Extent.width), static_cast<float>(Extent.height), 0.0f, 1.0f };
+	const VkRect2D Scissor = { {0, 0}, Extent };
+	vkCmdSetViewport(aCmdBuffer, 0, 1, &Viewport);
+	vkCmdSetScissor(aCmdBuffer, 0, 1, &Scissor);
+
+	VkImageMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+	Barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+	Barrier.subresourceRange = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1 };
+
+	const auto RecordBarrier = [&](VkImage aImage, uint32_t aLayer, VkImageLayout aOldLayout, VkImageLayout aNewLayout,
+		VkPipelineStageFlags aSrcStages, VkAccessFlags aSrcAccess, VkPipelineStageFlags aDstStages, VkAccessFlags aDstAccess)
+	{
+		Barrier.image = aImage;
+		Barrier.subresourceRange.baseArrayLayer = aLayer;
+		Barrier.oldLayout = aOldLayout;
+		Barrier.newLayout = aNewLayout;
+		Barrier.srcAccessMask = aSrcAccess;
+		Barrier.dstAccessMask = aDstAccess;
+		vkCmdPipelineBarrier(aCmdBuffer, aSrcStages, aDstStages, 0, 0, nullptr, 0, nullptr, 1, &Barrier);
+	};
+
+	constexpr VkPipelineStageFlags DepthStages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT;
+	constexpr VkAccessFlags DepthAccess = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT;
+
+	VkClearValue ClearValue = {};
+	ClearValue.depthStencil.depth = 1.0f;
+
+	VkRenderPassBeginInfo RenderPassInfo = {};
+	RenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+	RenderPassInfo.renderArea = Scissor;
+
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; ++i)
+	{
+		if ((CascadesToUpdate & (1u << i)) == 0)
+		{
+			continue;
+		}
+
+		sCascade& Cascade = m_Cascades[i];
+
+		if (Cascade.bStaticDirty)
+		{
+			// The previous contents are thrown away, only the copies reading them need to be done.
+			RecordBarrier(m_StaticCache.Image, i, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, 0, DepthStages, DepthAccess);
+
+			RenderPassInfo.renderPass = m_StaticRenderPass;
+			RenderPassInfo.framebuffer = Cascade.StaticCacheFramebuffer;
+			RenderPassInfo.clearValueCount = 1;
+			RenderPassInfo.pClearValues = &ClearValue;
+			vkCmdBeginRenderPass(aCmdBuffer, &RenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+			DrawCasters(aCmdBuffer, Cascade, aRenderables, aObjectsDescriptorSet, true);
+			vkCmdEndRenderPass(aCmdBuffer);
+
+			RecordBarrier(m_StaticCache.Image, i, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+				VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_READ_BIT);
+
+			Cascade.bStaticDirty = false;
+		}
+
+		// Start from the cached static depth. Previous frames sampling the shadow map must be done with it.
+		const VkImageLayout OldLayout = Cascade.bShadowMapInitialized ? VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL : VK_IMAGE_LAYOUT_UNDEFINED;
+		RecordBarrier(m_ShadowMap.Image, i, OldLayout, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT);
+		Cascade.bShadowMapInitialized = true;
+
+		VkImageCopy Copy = {};
+		Copy.srcSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, i, 1 };
+		Copy.dstSubresource = { VK_IMAGE_ASPECT_DEPTH_BIT, 0, i, 1 };
+		Copy.extent = { Extent.width, Extent.height, 1 };
+		vkCmdCopyImage(aCmdBuffer, m_StaticCache.Image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, m_ShadowMap.Image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &Copy);
+
+		if (!bHasDynamicCasters)
+		{
+			RecordBarrier(m_ShadowMap.Image, i, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+				VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+			continue;
+		}
+
+		RecordBarrier(m_ShadowMap.Image, i, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+			VK_PIPELINE_STAGE_TRANSFER_BIT, VK_ACCESS_TRANSFER_WRITE_BIT, DepthStages, DepthAccess);
+
+		RenderPassInfo.renderPass = m_DynamicRenderPass;
+		RenderPassInfo.framebuffer = Cascade.ShadowMapFramebuffer;
+		RenderPassInfo.clearValueCount = 0;
+		RenderPassInfo.pClearValues = nullptr;
+		vkCmdBeginRenderPass(aCmdBuffer, &RenderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
+		DrawCasters(aCmdBuffer, Cascade, aRenderables, aObjectsDescriptorSet, false);
+		vkCmdEndRenderPass(aCmdBuffer);
+
+		RecordBarrier(m_ShadowMap.Image, i, VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+			VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT, VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_ACCESS_SHADER_READ_BIT);
+	}
+}
+
+void CVulkanShadowMaps::DrawCasters(VkCommandBuffer aCmdBuffer, const sCascade& aCascade, const std::vector<CVulkanRenderable*>& aRenderables,
+	VkDescriptorSet aObjectsDescriptorSet, bool abStatic) const
+{
+	vkCmdPushConstants(aCmdBuffer, m_PipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(glm::mat4), &aCascade.ViewProj);
+
+	sRenderContext RenderContext = {};
+	RenderContext.CmdBuffer = aCmdBuffer;
+	RenderContext.DrawCallNum = 0;
+	RenderContext.ObjectsDescriptorSet = aObjectsDescriptorSet;
+	RenderContext.PipelineLayout = m_PipelineLayout;
+
+	for (CVulkanRenderable* pRenderable : aRenderables)
+	{
+		if (pRenderable->m_bIsStatic == abStatic)
+		{
+			pRenderable->Draw(RenderContext);
+		}
+		else
+		{
+			RenderContext.DrawCallNum += pRenderable->GetNumDrawCalls();
+		}
+	}
+}
+
+void CVulkanShadowMaps::InvalidateStaticCache()
+{
+	for (sCascade& Cascade : m_Cascades)
+	{
+		Cascade.bStaticDirty = true;
+	}
+}
+
+VkDescriptorBufferInfo CVulkanShadowMaps::GetShadowBufferInfo(uint32_t aFrameIdx) const
+{
+	VkDescriptorBufferInfo BufferInfo = {};
+	BufferInfo.buffer = m_Frames[aFrameIdx].ShadowBuffer.Buffer;
+	BufferInfo.offset = 0;
+	BufferInfo.range = sizeof(sGPUShadowData);
+	return BufferInfo;
+}
+
+VkDescriptorImageInfo CVulkanShadowMaps::GetShadowMapImageInfo() const
+{
+	VkDescriptorImageInfo ImageInfo = {};
+	ImageInfo.sampler = m_ShadowSampler;
+	ImageInfo.imageView = m_ShadowMapArrayView;
+	ImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+	return ImageInfo;
+}
+
+void CVulkanShadowMaps::CreateImages()
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+	const VkExtent3D Extent = { SGS_SHADOW_MAP_SIZE, SGS_SHADOW_MAP_SIZE, 1 };
+
+	VmaAllocationCreateInfo AllocInfo = {};
+	AllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+
+	VkImageCreateInfo ImageInfo = vkinit::ImageCreateInfo(SHADOW_MAP_FORMAT,
+		VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT, Extent);
+	ImageInfo.arrayLayers = NUM_SHADOW_CASCADES;
+	VK_CHECK(m_pVulkanDevice->m_MemoryAllocator.CreateImage(ImageInfo, AllocInfo, eMemoryCategory::SHADOW_MAP, "Shadow Map", m_ShadowMap));
+
+	ImageInfo.usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+	VK_CHECK(m_pVulkanDevice->m_MemoryAllocator.CreateImage(ImageInfo, AllocInfo, eMemoryCategory::SHADOW_MAP, "Shadow Map Static Cache", m_StaticCache));
+
+	VkImageViewCreateInfo ViewInfo = vkinit::ImageViewCreateInfo(SHADOW_MAP_FORMAT, m_ShadowMap.Image, VK_IMAGE_ASPECT_DEPTH_BIT);
+	ViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D_ARRAY;
+	ViewInfo.subresourceRange.layerCount = NUM_SHADOW_CASCADES;
+	VK_CHECK(vkCreateImageView(Device, &ViewInfo, nullptr, &m_ShadowMapArrayView));
+
+	// One view per layer to render into.
+	ViewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
+	ViewInfo.subresourceRange.layerCount = 1;
+	for (uint32_t i = 0; i < NUM_SHADOW_CASCADES; ++i)
+	{
+		ViewInfo.subresourceRange.baseArrayLayer = i;
+		ViewInfo.image = m_ShadowMap.Image;
+		VK_CHECK(vkCreateImageView(Device, &ViewInfo, nullptr, &m_Cascades[i].ShadowMapView));
+		ViewInfo.image = m_StaticCache.Image;
+		VK_CHECK(vkCreateImageView(Device, &ViewInfo, nullptr, &m_Cascades[i].StaticCacheView));
+	}
+
+	// Hardware PCF: the sampler compares against the reference depth and filters the results.
+	VkSamplerCreateInfo SamplerInfo = {};
+	SamplerInfo.sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO;
+	SamplerInfo.magFilter = VK_FILTER_LINEAR;
+	SamplerInfo.minFilter = VK_FILTER_LINEAR;
+	SamplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+	SamplerInfo.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	SamplerInfo.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	SamplerInfo.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_BORDER;
+	SamplerInfo.borderColor = VK_BORDER_COLOR_FLOAT_OPAQUE_WHITE;
+	SamplerInfo.compareEnable = VK_TRUE;
+	SamplerInfo.compareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+	SamplerInfo.maxAnisotropy = 1.0f;
+	SamplerInfo.maxLod = 1.0f;
+	VK_CHECK(vkCreateSampler(Device, &SamplerInfo, nullptr, &m_ShadowSampler));
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		vkDestroySampler(Device, m_ShadowSampler, nullptr);
+		for (sCascade& Cascade : m_Cascades)
+		{
+			vkDestroyImageView(Device, Cascade.ShadowMapView, nullptr);
+			vkDestroyImageView(Device, Cascade.StaticCacheView, nullptr);
+		}
+		vkDestroyImageView(Device, m_ShadowMapArrayView, nullptr);
+		m_pVulkanDevice->m_MemoryAllocator.DestroyImage(m_ShadowMap);
+		m_pVulkanDevice->m_MemoryAllocator.DestroyImage(m_StaticCache);
+	});
+}
+
+void CVulkanShadowMaps::CreateRenderPasses()
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+
+	// Layout transitions and synchronization are recorded by RecordShadows().
+	VkAttachmentDescription DepthAttachment = {};
+	DepthAttachment.format = SHADOW_MAP_FORMAT;
+	DepthAttachment.samples = VK_SAMPLE_COUNT_1_BIT;
+	DepthAttachment.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+	DepthAttachment.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+	DepthAttachment.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+	DepthAttachment.initialLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+	DepthAttachment.finalLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkAttachmentReference DepthRef = {};
+	DepthRef.attachment = 0;
+	DepthRef.layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL;
+
+	VkSubpassDescription Subpass = {};
+	Subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+	Subpass.colorAttachmentCount = 0;
+	Subpass.pDepthStencilAttachment = &DepthRef;
+
+	VkRenderPassCreateInfo RenderPassInfo = {};
+	RenderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO;
+	RenderPassInfo.attachmentCount = 1;
+	RenderPassInfo.pAttachments = &DepthAttachment;
+	RenderPassInfo.subpassCount = 1;
+	RenderPassInfo.pSubpasses = &Subpass;
+
+	DepthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+	VK_CHECK(vkCreateRenderPass(Device, &RenderPassInfo, nullptr, &m_StaticRenderPass));
+
+	DepthAttachment.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+	VK_CHECK(vkCreateRenderPass(Device, &RenderPassInfo, nullptr, &m_DynamicRenderPass));
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		vkDestroyRenderPass(Device, m_StaticRenderPass, nullptr);
+		vkDestroyRenderPass(Device, m_DynamicRenderPass, nullptr);
+	});
+}
+
+void CVulkanShadowMaps::CreateFramebuffers()
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+
+	VkFramebufferCreateInfo FramebufferInfo = {};
+	FramebufferInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
+	FramebufferInfo.attachmentCount = 1;
+	FramebufferInfo.width = SGS_SHADOW_MAP_SIZE;
+	FramebufferInfo.height = SGS_SHADOW_MAP_SIZE;
+	FramebufferInfo.layers = 1;
+
+	for (sCascade& Cascade : m_Cascades)
+	{
+		FramebufferInfo.renderPass = m_StaticRenderPass;
+		FramebufferInfo.pAttachments = &Cascade.StaticCacheView;
+		VK_CHECK(vkCreateFramebuffer(Device, &FramebufferInfo, nullptr, &Cascade.StaticCacheFramebuffer));
+
+		FramebufferInfo.renderPass = m_DynamicRenderPass;
+		FramebufferInfo.pAttachments = &Cascade.ShadowMapView;
+		VK_CHECK(vkCreateFramebuffer(Device, &FramebufferInfo, nullptr, &Cascade.ShadowMapFramebuffer));
+	}
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		for (sCascade& Cascade : m_Cascades)
+		{
+			vkDestroyFramebuffer(Device, Cascade.StaticCacheFramebuffer, nullptr);
+			vkDestroyFramebuffer(Device, Cascade.ShadowMapFramebuffer, nullptr);
+		}
+	});
+}
+
+void CVulkanShadowMaps::CreatePipeline(VkPipelineCache aPipelineCache, VkDescriptorSetLayout aFrameSetLayout, VkDescriptorSetLayout aRenderObjectsSetLayout)
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+
+	// Set 0 is not used, it is only there so the objects keep their usual set.
+	const std::array<VkDescriptorSetLayout, 2> SetLayouts = { aFrameSetLayout, aRenderObjectsSetLayout };
+
+	VkPushConstantRange PushConstantRange = {};
+	PushConstantRange.stageFlags = VK_SHADER_STAGE_VERTEX_BIT;
+	PushConstantRange.offset = 0;
+	PushConstantRange.size = sizeof(glm::mat4);
+
+	VkPipelineLayoutCreateInfo LayoutInfo = vkinit::PipelineLayoutCreateInfo();
+	LayoutInfo.setLayoutCount = static_cast<uint32_t>(SetLayouts.size());
+	LayoutInfo.pSetLayouts = SetLayouts.data();
+	LayoutInfo.pushConstantRangeCount = 1;
+	LayoutInfo.pPushConstantRanges = &PushConstantRange;
+
+	VK_CHECK(vkCreatePipelineLayout(Device, &LayoutInfo, nullptr, &m_PipelineLayout));
+
+	VkShaderModule VertShader;
+	if (!vkutils::LoadShaderModule(Device, vkutils::GetShaderPath("shadow_vert.spv").c_str(), &VertShader))
+	{
+		SGSERROR("Error when building the shadow vertex shader module");
+	}
+
+	PipelineBuilder PipelineBuilder;
+
+	std::vector<VkDynamicState> DynamicStates =
+	{
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+	PipelineBuilder.m_DynamicState = vkinit::DynamicStateCreateInfo(DynamicStates);
+
+	sVertexInputDescription VertexDescription = GetVertexDescription();
+	PipelineBuilder.m_VertexInputInfo = vkinit::VertexInputStateCreateInfo();
+	PipelineBuilder.m_VertexInputInfo.vertexBindingDescriptionCount = static_cast<uint32_t>(VertexDescription.Bindings.size());
+	PipelineBuilder.m_VertexInputInfo.pVertexBindingDescriptions = VertexDescription.Bindings.data();
+	PipelineBuilder.m_VertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(VertexDescription.Attributes.size());
+	PipelineBuilder.m_VertexInputInfo.pVertexAttributeDescriptions = VertexDescription.Attributes.data();
+
+	PipelineBuilder.m_InputAssembly = vkinit::InputAssemblyCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+	PipelineBuilder.m_Viewport = { 0.0f, 0.0f, static_cast<float>(SGS_SHADOW_MAP_SIZE), static_cast<float>(SGS_SHADOW_MAP_SIZE), 0.0f, 1.0f };
+	PipelineBuilder.m_Scissor = { {0, 0}, {SGS_SHADOW_MAP_SIZE, SGS_SHADOW_MAP_SIZE} };
+
+	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(true, true, VK_COMPARE_OP_LESS_OR_EQUAL);
+
+	// No culling, thin and open meshes still cast shadows. The bias keeps surfaces from shadowing themselves.
+	PipelineBuilder.m_Rasterizer = vkinit::RasterizationStateCreateInfo(VK_POLYGON_MODE_FILL);
+	PipelineBuilder.m_Rasterizer.depthBiasEnable = VK_TRUE;
+	PipelineBuilder.m_Rasterizer.depthBiasConstantFactor = 1.25f;
+	PipelineBuilder.m_Rasterizer.depthBiasSlopeFactor = 1.75f;
+
+	PipelineBuilder.m_Multisampling = vkinit::MultisamplingStateCreateInfo();
+	PipelineBuilder.m_ShaderStages.push_back(vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, VertShader));
+	PipelineBuilder.m_PipelineLayout = m_PipelineLayout;
+
+	// Both render passes are compatible, the pipeline is used with each of them.
+	m_Pipeline = PipelineBuilder.BuildPipeline(Device, m_StaticRenderPass, aPipelineCache);
+
+	vkDestroyShaderModule(Device, VertShader, nullptr);
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		vkDestroyPipeline(Device, m_Pipeline, nullptr);
+		vkDestroyPipelineLayout(Device, m_PipelineLayout, nullptr);
+	});
+}
@@ -0,0 +1,118 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include "renderer/frame_packet.hpp"
+#include <core/types.hpp>
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <vector>
+
+class CVulkanDevice;
+
+// Resolution of every cascade. Can be overridden at build time (/DSGS_SHADOW_MAP_SIZE=...).
+#ifndef SGS_SHADOW_MAP_SIZE
+#define SGS_SHADOW_MAP_SIZE 2048
+#endif
+
+constexpr uint32_t NUM_SHADOW_CASCADES = 4;
+
+/**
+ * @brief Cascaded shadow maps for the directional light of the scene, sampled through the frame descriptor set
+ * (see shadows.glsl).
+ *
+ * Every cascade is fitted to a bounding sphere of its slice of the view frustum, plus a margin, and snapped to its
+ * texels, so its matrix only changes when the camera leaves the margin. While the matrix holds, the depth of the
+ * static renderables is kept in a cache and an update only copies it back and draws the dynamic renderables on top.
+ * Cascades are updated on a staggered schedule (the first one every frame, the far ones every few frames), a cascade
+ * whose matrix changed is always updated right away.
+ */
+class CVulkanShadowMaps
+{
+public:
+    CVulkanShadowMaps();
+
+    void Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames, VkPipelineCache aPipelineCache,
+        VkDescriptorSetLayout aFrameSetLayout, VkDescriptorSetLayout aRenderObjectsSetLayout);
+    void Shutdown();
+
+    /**
+     * @brief Fits the cascades to the camera, picks the ones updated this frame and uploads the shadow data of the frame.
+     */
+    void UpdateFrame(uint32_t aFrameIdx, const sFramePacket& aFramePacket, const glm::mat4& aView, float aFovY, float aAspect, float aNearPlane);
+
+    /**
+     * @brief Records the depth passes of the cascades picked by the last UpdateFrame(). Must be recorded before the passes that sample the shadows.
+     */
+    void RecordShadows(VkCommandBuffer aCmdBuffer, const std::vector<CVulkanRenderable*>& aRenderables, VkDescriptorSet aObjectsDescriptorSet);
+
+    /**
+     * @brief The static renderables changed, the cached depth of every cascade is drawn again.
+     */
+    void InvalidateStaticCache();
+
+    VkDescriptorBufferInfo GetShadowBufferInfo(uint32_t aFrameIdx) const;
+    VkDescriptorImageInfo GetShadowMapImageInfo() const;
+
+private:
+    struct sCascade
+    {
+        glm::mat4 ViewProj = glm::mat4(1.0f);
+        // Center and half size of the area covered, in light space.
+        glm::vec3 Center = glm::vec3(0.0f);
+        float Radius = 0.0f;
+        // View depth where the cascade ends.
+        float SplitFar = 0.0f;
+
+        bool bFitted = false;
+        bool bStaticDirty = true;
+        bool bShadowMapInitialized = false;
+
+        VkImageView ShadowMapView = VK_NULL_HANDLE;
+        VkImageView StaticCacheView = VK_NULL_HANDLE;
+        VkFramebuffer ShadowMapFramebuffer = VK_NULL_HANDLE;
+        VkFramebuffer StaticCacheFramebuffer = VK_NULL_HANDLE;
+    };
+
+    struct sFrameResources
+    {
+        AllocatedBuffer ShadowBuffer;
+        void* pMappedShadowBuffer = nullptr;
+    };
+
+    void CreateImages();
+    void CreateRenderPasses();
+    void CreateFramebuffers();
+    void CreatePipeline(VkPipelineCache aPipelineCache, VkDescriptorSetLayout aFrameSetLayout, VkDescriptorSetLayout aRenderObjectsSetLayout);
+
+    void FitCascade(sCascade& aCascade, const glm::vec3& aLightSpaceCenter, float aRadius);
+    void DrawCasters(VkCommandBuffer aCmdBuffer, const sCascade& aCascade, const std::vector<CVulkanRenderable*>& aRenderables,
+        VkDescriptorSet aObjectsDescriptorSet, bool abStatic) const;
+
+    CVulkanDevice* m_pVulkanDevice;
+
+    std::array<sCascade, NUM_SHADOW_CASCADES> m_Cascades;
+    std::vector<sFrameResources> m_Frames;
+
+    glm::mat4 m_LightView;
+    glm::vec3 m_LightDirection;
+    uint64_t m_FrameCounter;
+    // Bit per cascade, cascades whose turn it is this frame.
+    uint32_t m_ScheduledCascades;
+
+    // Sampled shadow maps and cached static depth, one layer per cascade.
+    AllocatedImage m_ShadowMap;
+    AllocatedImage m_StaticCache;
+    VkImageView m_ShadowMapArrayView;
+    VkSampler m_ShadowSampler;
+
+    // Same attachment, the static cache is cleared and the shadow map keeps the copied static depth.
+    VkRenderPass m_StaticRenderPass;
+    VkRenderPass m_DynamicRenderPass;
+    VkPipelineLayout m_PipelineLayout;
+    VkPipeline m_Pipeline;
+
+    // Holds the deletion functions.
+    sDeletionQueue m_DeletionQueue;
+};
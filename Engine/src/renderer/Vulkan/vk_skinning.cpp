@@ -0,0 +1,234 @@
+#include "vk_skinning.hpp"
+#include "vulkan_device.hpp"
+#include "vk_initializers.hpp"
+#include "vk_utils.hpp"
+#include <core/logger.h>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+
+namespace
+{
+	constexpr uint32_t SKINNING_GROUP_SIZE = 64; // Must match skinning.comp.
+
+	// The shader reads the vertices as an array of floats, see skinning.comp.
+	static_assert(sizeof(sVertex) == 11 * sizeof(float), "skinning.comp expects 11 floats per vertex.");
+	static_assert(sizeof(sSkinVertex) == 8 * sizeof(uint32_t), "skinning.comp expects a uvec4 and a vec4 per vertex.");
+
+	struct sSkinningConstants
+	{
+		uint32_t FirstJoint;
+		uint32_t NumVertices;
+	};
+}
+
+CVulkanSkinning::CVulkanSkinning() :
+	m_pVulkanDevice(nullptr),
+	m_FrameSetLayout(VK_NULL_HANDLE),
+	m_RenderableSetLayout(VK_NULL_HANDLE),
+	m_PipelineLayout(VK_NULL_HANDLE),
+	m_Pipeline(VK_NULL_HANDLE),
+	m_bWarnedTooManyJoints(false)
+{
+}
+
+void CVulkanSkinning::Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames, VkPipelineCache aPipelineCache, CVulkanDescriptorLayoutCache& aLayoutCache)
+{
+	m_pVulkanDevice = apVulkanDevice;
+	m_Frames.resize(aNumFrames);
+
+	const VmaAllocator Allocator = m_pVulkanDevice->m_Allocator;
+	for (sFrameResources& Frame : m_Frames)
+	{
+		Frame.JointsBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(glm::mat4) * MAX_SKINNING_JOINTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			eMemoryCategory::STORAGE, "Skinning Joints");
+		vmaMapMemory(Allocator, Frame.JointsBuffer.Allocation, &Frame.pMappedJoints);
+	}
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		for (sFrameResources& Frame : m_Frames)
+		{
+			vmaUnmapMemory(Allocator, Frame.JointsBuffer.Allocation);
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(Frame.JointsBuffer);
+		}
+		m_Frames.clear();
+	});
+
+	CreateDescriptors(aLayoutCache);
+	CreatePipeline(aPipelineCache);
+}
+
+void CVulkanSkinning::Shutdown()
+{
+	m_DeletionQueue.Flush();
+}
+
+void CVulkanSkinning::CreateRenderableDescriptors(CVulkanRenderable* apRenderable)
+{
+	assert(apRenderable->m_SkinnedVertexBuffer.Buffer != VK_NULL_HANDLE);
+
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+	apRenderable->m_SkinningDescriptorSet = m_DescriptorAllocator.Allocate(m_RenderableSetLayout);
+
+	std::array<VkDescriptorBufferInfo, 3> BufferInfos =
+	{{
+		{ apRenderable->m_VertexBuffer.Buffer, 0, VK_WHOLE_SIZE },
+		{ apRenderable->m_SkinBuffer.Buffer, 0, VK_WHOLE_SIZE },
+		{ apRenderable->m_SkinnedVertexBuffer.Buffer, 0, VK_WHOLE_SIZE }
+	}};
+
+	std::array<VkWriteDescriptorSet, 3> Writes;
+	for (uint32_t i = 0; i < Writes.size(); ++i)
+	{
+		Writes[i] = vkinit::WriteDescriptorBuffer(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, apRenderable->m_SkinningDescriptorSet, &BufferInfos[i], i);
+	}
+
+	vkUpdateDescriptorSets(Device, static_cast<uint32_t>(Writes.size()), Writes.data(), 0, nullptr);
+}
+
+void CVulkanSkinning::UpdateFrame(uint32_t aFrameIdx, const sFramePacket& aFramePacket)
+{
+	assert(aFrameIdx < m_Frames.size());
+	sFrameResources& Frame = m_Frames[aFrameIdx];
+
+	const std::vector<glm::mat4>& JointMatrices = aFramePacket.JointMatrices;
+	const uint32_t NumJoints = static_cast<uint32_t>(std::min<size_t>(JointMatrices.size(), MAX_SKINNING_JOINTS));
+	if (NumJoints < JointMatrices.size() && !m_bWarnedTooManyJoints)
+	{
+		SGSWARN("The scene has more skinning joints than supported (%u). The renderables past them are not animated.", MAX_SKINNING_JOINTS);
+		m_bWarnedTooManyJoints = true;
+	}
+	memcpy(Frame.pMappedJoints, JointMatrices.data(), NumJoints * sizeof(glm::mat4));
+
+	Frame.Dispatches.clear();
+	for (const sSkinningInstance& Instance : aFramePacket.SkinningInstances)
+	{
+		const CVulkanRenderable* pRenderable = static_cast<const CVulkanRenderable*>(Instance.pRenderable);
+		const bool bFitsJoints = Instance.FirstJoint + pRenderable->m_pSkeleton->GetNumJoints() <= NumJoints;
+		if (pRenderable->m_SkinningDescriptorSet != VK_NULL_HANDLE && bFitsJoints)
+		{
+			Frame.Dispatches.push_back({ pRenderable, Instance.FirstJoint });
+		}
+	}
+}
+
+void CVulkanSkinning::RecordSkinning(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx) const
+{
+	const sFrameResources& Frame = m_Frames[aFrameIdx];
+	if (Frame.Dispatches.empty())
+	{
+		return;
+	}
+
+	// The draws of the previous frames read the skinned vertices that are about to be overwritten. Nothing they wrote
+	// is read, an execution dependency is enough.
+	vkCmdPipelineBarrier(aCmdBuffer, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 0, nullptr);
+
+	vkCmdBindPipeline(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_Pipeline);
+	vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 0, 1, &Frame.DescriptorSet, 0, nullptr);
+
+	for (const sDispatch& Dispatch : Frame.Dispatches)
+	{
+		const sSkinningConstants Constants = { Dispatch.FirstJoint, Dispatch.pRenderable->m_VerticesCount };
+
+		vkCmdBindDescriptorSets(aCmdBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, m_PipelineLayout, 1, 1, &Dispatch.pRenderable->m_SkinningDescriptorSet, 0, nullptr);
+		vkCmdPushConstants(aCmdBuffer, m_PipelineLayout, VK_SHADER_STAGE_COMPUTE_BIT, 0, sizeof(sSkinningConstants), &Constants);
+		vkCmdDispatch(aCmdBuffer, (Constants.NumVertices + SKINNING_GROUP_SIZE - 1) / SKINNING_GROUP_SIZE, 1, 1);
+	}
+
+	VkMemoryBarrier Barrier = {};
+	Barrier.sType = VK_STRUCTURE_TYPE_MEMORY_BARRIER;
+	Barrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+	Barrier.dstAccessMask = VK_ACCESS_VERTEX_ATTRIBUTE_READ_BIT;
+
+	vkCmdPipelineBarrier(aCmdBuffer, VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT, VK_PIPELINE_STAGE_VERTEX_INPUT_BIT, 0, 1, &Barrier, 0, nullptr, 0, nullptr);
+}
+
+void CVulkanSkinning::CreateDescriptors(CVulkanDescriptorLayoutCache& aLayoutCache)
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+
+	const VkDescriptorSetLayoutBinding JointsBinding = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 0);
+
+	VkDescriptorSetLayoutCreateInfo LayoutInfo = {};
+	LayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	LayoutInfo.bindingCount = 1;
+	LayoutInfo.pBindings = &JointsBinding;
+
+	m_FrameSetLayout = aLayoutCache.CreateLayout(LayoutInfo);
+
+	// Bind pose vertices, joints and weights, skinned vertices.
+	const std::array<VkDescriptorSetLayoutBinding, 3> RenderableBindings =
+	{
+		vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 0),
+		vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 1),
+		vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_COMPUTE_BIT, 2)
+	};
+
+	LayoutInfo.bindingCount = static_cast<uint32_t>(RenderableBindings.size());
+	LayoutInfo.pBindings = RenderableBindings.data();
+
+	m_RenderableSetLayout = aLayoutCache.CreateLayout(LayoutInfo);
+
+	// Sized for the frames and a few characters, more pools are created as renderables are added.
+	const uint32_t NumFrames = static_cast<uint32_t>(m_Frames.size());
+	m_DescriptorAllocator.Initialize(Device, NumFrames + 64, { { VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 3.0f } });
+
+	for (sFrameResources& Frame : m_Frames)
+	{
+		Frame.DescriptorSet = m_DescriptorAllocator.Allocate(m_FrameSetLayout);
+
+		VkDescriptorBufferInfo BufferInfo = { Frame.JointsBuffer.Buffer, 0, VK_WHOLE_SIZE };
+		const VkWriteDescriptorSet Write = vkinit::WriteDescriptorBuffer(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, Frame.DescriptorSet, &BufferInfo, 0);
+
+		vkUpdateDescriptorSets(Device, 1, &Write, 0, nullptr);
+	}
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		m_DescriptorAllocator.Shutdown();
+	});
+}
+
+void CVulkanSkinning::CreatePipeline(VkPipelineCache aPipelineCache)
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+
+	const std::array<VkDescriptorSetLayout, 2> SetLayouts = { m_FrameSetLayout, m_RenderableSetLayout };
+
+	VkPushConstantRange PushConstantRange = {};
+	PushConstantRange.stageFlags = VK_SHADER_STAGE_COMPUTE_BIT;
+	PushConstantRange.offset = 0;
+	PushConstantRange.size = sizeof(sSkinningConstants);
+
+	VkPipelineLayoutCreateInfo LayoutInfo = vkinit::PipelineLayoutCreateInfo();
+	LayoutInfo.setLayoutCount = static_cast<uint32_t>(SetLayouts.size());
+	LayoutInfo.pSetLayouts = SetLayouts.data();
+	LayoutInfo.pushConstantRangeCount = 1;
+	LayoutInfo.pPushConstantRanges = &PushConstantRange;
+
+	VK_CHECK(vkCreatePipelineLayout(Device, &LayoutInfo, nullptr, &m_PipelineLayout));
+
+	VkShaderModule ComputeShader;
+	if (!vkutils::LoadShaderModule(Device, vkutils::GetShaderPath("skinning_comp.spv").c_str(), &ComputeShader))
+	{
+		SGSERROR("Error when building the skinning shader module");
+	}
+
+	VkComputePipelineCreateInfo PipelineInfo = {};
+	PipelineInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
+	PipelineInfo.stage = vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_COMPUTE_BIT, ComputeShader);
+	PipelineInfo.layout = m_PipelineLayout;
+
+	VK_CHECK(vkCreateComputePipelines(Device, aPipelineCache, 1, &PipelineInfo, nullptr, &m_Pipeline));
+
+	vkDestroyShaderModule(Device, ComputeShader, nullptr);
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		vkDestroyPipeline(Device, m_Pipeline, nullptr);
+		vkDestroyPipelineLayout(Device, m_PipelineLayout, nullptr);
+	});
+}
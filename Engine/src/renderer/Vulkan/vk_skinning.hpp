@@ -0,0 +1,86 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include "vk_descriptors.hpp"
+#include "renderer/frame_packet.hpp"
+#include <core/types.hpp>
+
+#include <vector>
+
+class CVulkanDevice;
+
+// Skinning matrices uploaded per frame, shared by all the skinned renderables.
+constexpr uint32_t MAX_SKINNING_JOINTS = 16384;
+
+/**
+ * @brief Compute skinning. Every frame the skinning matrices of the frame packet are uploaded and a dispatch per
+ * skinned renderable deforms the positions and normals of its bind pose into its skinned vertex buffer (see
+ * CVulkanRenderable::GetDrawVertexBuffer()), which every pass then draws as any other vertex buffer. See skinning.comp.
+ *
+ * Recorded on the graphics queue before the shadows. There is a single skinned vertex buffer per renderable, not one
+ * per frame in flight, and the graphics queue orders the dispatches after the previous draws reading it.
+ */
+class CVulkanSkinning
+{
+public:
+    CVulkanSkinning();
+
+    /**
+     * @brief The set layouts are created by aLayoutCache, owned by the backend.
+     */
+    void Initialize(CVulkanDevice* apVulkanDevice, uint32_t aNumFrames, VkPipelineCache aPipelineCache, CVulkanDescriptorLayoutCache& aLayoutCache);
+    void Shutdown();
+
+    /**
+     * @brief Allocates the descriptor set the skinning of apRenderable uses. Called once it is uploaded to VRAM.
+     */
+    void CreateRenderableDescriptors(CVulkanRenderable* apRenderable);
+
+    /**
+     * @brief Uploads the skinning matrices of the frame packet and keeps its instances for RecordSkinning(). The frame
+     * must not be in use by the GPU.
+     */
+    void UpdateFrame(uint32_t aFrameIdx, const sFramePacket& aFramePacket);
+
+    /**
+     * @brief Records the skinning dispatches of the frame and the barrier that makes the skinned vertices visible to the vertex input.
+     */
+    void RecordSkinning(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx) const;
+
+private:
+    struct sDispatch
+    {
+        const CVulkanRenderable* pRenderable = nullptr;
+        uint32_t FirstJoint = 0;
+    };
+
+    struct sFrameResources
+    {
+        AllocatedBuffer JointsBuffer;
+        void* pMappedJoints = nullptr;
+        VkDescriptorSet DescriptorSet = VK_NULL_HANDLE;
+
+        // Keeps its capacity from frame to frame.
+        std::vector<sDispatch> Dispatches;
+    };
+
+    void CreateDescriptors(CVulkanDescriptorLayoutCache& aLayoutCache);
+    void CreatePipeline(VkPipelineCache aPipelineCache);
+
+    CVulkanDevice* m_pVulkanDevice;
+
+    std::vector<sFrameResources> m_Frames;
+
+    // Set 0 holds the joints of the frame, set 1 the buffers of a renderable. Owned by the layout cache of the backend.
+    VkDescriptorSetLayout m_FrameSetLayout;
+    VkDescriptorSetLayout m_RenderableSetLayout;
+    // Grows with the skinned renderables, there is no limit on how many of them are animated.
+    CVulkanDescriptorAllocator m_DescriptorAllocator;
+    VkPipelineLayout m_PipelineLayout;
+    VkPipeline m_Pipeline;
+
+    bool m_bWarnedTooManyJoints;
+
+    // Holds the deletion functions.
+    sDeletionQueue m_DeletionQueue;
+};
@@ -50,19 +50,41 @@ sVertexInputDescription GetVertexDescription()
 
 CVulkanRenderable::CVulkanRenderable(sMeshData* apMeshData)
 {
-	m_pRoots.push_back(new CMeshNode());
-	m_pRoots[0]->m_pMeshData = apMeshData;
+	m_pRoots.push_back(m_Storage.MeshNodes.Create());
+	m_pRoots[0]->m_pMeshData = m_Storage.MeshDatas.Create(*apMeshData);
 	m_Vertices = apMeshData->Vertices;
 	m_Indices = apMeshData->Indices32;
-	CSubMesh* pSubMesh = new CSubMesh(0, 0, m_Indices.size(), m_Vertices.size(), nullptr);
+	CSubMesh* pSubMesh = m_Storage.SubMeshes.Create(0, 0, m_Indices.size(), m_Vertices.size(), nullptr);
 	m_pRoots[0]->m_pMeshData->SubMeshes.push_back(pSubMesh);
 }
+
+CVulkanRenderable::~CVulkanRenderable()
+{
+	// The buffers may still be read by the frames in flight.
+	if (m_VertexBuffer.Buffer != VK_NULL_HANDLE)
+	{
+		GetVulkanDevice()->m_FrameDeletionQueue.DestroyBuffer(m_VertexBuffer);
+	}
+	if (m_IndexBuffer.Buffer != VK_NULL_HANDLE)
+	{
+		GetVulkanDevice()->m_FrameDeletionQueue.DestroyBuffer(m_IndexBuffer);
+	}
+	if (m_SkinBuffer.Buffer != VK_NULL_HANDLE)
+	{
+		GetVulkanDevice()->m_FrameDeletionQueue.DestroyBuffer(m_SkinBuffer);
+	}
+	if (m_SkinnedVertexBuffer.Buffer != VK_NULL_HANDLE)
+	{
+		GetVulkanDevice()->m_FrameDeletionQueue.DestroyBuffer(m_SkinnedVertexBuffer);
+	}
+}
     
 void CVulkanRenderable::Draw(sRenderContext& aRenderContext, bool bBindMaterialDescriptor)
 {
 	// Bind resources once for each renderables. Use offsets to determine which parts are drawn.
 	VkDeviceSize Offset = 0;
-	vkCmdBindVertexBuffers(aRenderContext.CmdBuffer, 0, 1, &m_VertexBuffer.Buffer, &Offset);
+	const VkBuffer VertexBuffer = GetDrawVertexBuffer();
+	vkCmdBindVertexBuffers(aRenderContext.CmdBuffer, 0, 1, &VertexBuffer, &Offset);
 	vkCmdBindIndexBuffer(aRenderContext.CmdBuffer, m_IndexBuffer.Buffer, 0, VK_INDEX_TYPE_UINT32);
 
 	for (const auto& Root : m_pRoots)
@@ -74,9 +96,9 @@ void CVulkanRenderable::Draw(sRenderContext& aRenderContext, bool bBindMaterialD
 void CVulkanRenderable::DrawNode(CMeshNode* apMeshNode, sRenderContext& aRenderContext, bool bBindMaterialDescriptor)
 {
 	// Draw children.
-	for (auto* pMeshNode : apMeshNode->m_Children)
+	for (CMeshNode* pChild = apMeshNode->m_pFirstChild; pChild; pChild = pChild->m_pNextSibling)
 	{
-		DrawNode(pMeshNode, aRenderContext, bBindMaterialDescriptor);
+		DrawNode(pChild, aRenderContext, bBindMaterialDescriptor);
 	}
 
 	// Draw current node.
@@ -94,7 +116,7 @@ void CVulkanRenderable::DrawSubMesh(CSubMesh* apSubMesh, sRenderContext& aRender
 	if (bBindMaterialDescriptor)
 	{
 		const std::array<VkDescriptorSet, 3> DescriptorSets = 
-			{ aRenderContext.FrameDescriptorSet, aRenderContext.ObjectsDescriptorSet, aRenderContext.MaterialDescriptors->at(apSubMesh->m_Material->GetID())->DescriptorSet };
+			{ aRenderContext.FrameDescriptorSet, aRenderContext.ObjectsDescriptorSet, (*aRenderContext.MaterialDescriptors)[apSubMesh->m_Material->GetIndex()]->DescriptorSet };
 
 		vkCmdBindDescriptorSets(aRenderContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, aRenderContext.PipelineLayout, 
 			0, static_cast<uint32_t>(DescriptorSets.size()), DescriptorSets.data(), 0, nullptr);
@@ -105,13 +127,63 @@ void CVulkanRenderable::DrawSubMesh(CSubMesh* apSubMesh, sRenderContext& aRender
 	++aRenderContext.DrawCallNum;
 }
 
+uint32_t CVulkanRenderable::GetNumDrawCalls() const
+{
+	uint32_t NumDrawCalls = 0;
+	for (const auto& Root : m_pRoots)
+	{
+		NumDrawCalls += GetNumDrawCalls(Root);
+	}
+	return NumDrawCalls;
+}
+
+uint32_t CVulkanRenderable::GetNumDrawCalls(const CMeshNode* apMeshNode)
+{
+	uint32_t NumDrawCalls = apMeshNode->m_pMeshData ? static_cast<uint32_t>(apMeshNode->m_pMeshData->SubMeshes.size()) : 0;
+	for (const CMeshNode* pChild = apMeshNode->m_pFirstChild; pChild; pChild = pChild->m_pNextSibling)
+	{
+		NumDrawCalls += GetNumDrawCalls(pChild);
+	}
+	return NumDrawCalls;
+}
+
 void CVulkanRenderable::UploadToVRAM()
 {
-	vkutils::CreateVertexBuffer(GetVulkanDevice(), m_Vertices, m_VertexBuffer);
-	vkutils::CreateIndexBuffer(GetVulkanDevice(), m_Indices, m_IndexBuffer);
+	const CVulkanDevice* pVulkanDevice = GetVulkanDevice();
+	if (IsSkinned())
+	{
+		// The bind pose is only read by the skinning, the passes draw the skinned vertices.
+		const size_t VerticesSize = m_Vertices.size() * sizeof(sVertex);
+		m_VertexBuffer = vkutils::CreateDeviceBuffer(pVulkanDevice, m_Vertices.data(), VerticesSize,
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_SRC_BIT, eMemoryCategory::MESH, m_Name.c_str());
+		m_SkinBuffer = vkutils::CreateDeviceBuffer(pVulkanDevice, m_SkinVertices.data(), m_SkinVertices.size() * sizeof(sSkinVertex),
+			VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, eMemoryCategory::MESH, m_Name.c_str());
+		m_SkinnedVertexBuffer = vkutils::CreateBuffer(pVulkanDevice, VerticesSize,
+			VK_BUFFER_USAGE_VERTEX_BUFFER_BIT | VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY,
+			eMemoryCategory::MESH, m_Name.c_str());
+
+		// Starts as the bind pose. The skinning only rewrites positions and normals, the rest is never touched again.
+		const VkBuffer Source = m_VertexBuffer.Buffer;
+		const VkBuffer Destination = m_SkinnedVertexBuffer.Buffer;
+		pVulkanDevice->ImmediateSubmit([=](VkCommandBuffer Cmd)
+		{
+			VkBufferCopy Copy;
+			Copy.dstOffset = 0;
+			Copy.srcOffset = 0;
+			Copy.size = VerticesSize;
+
+			vkCmdCopyBuffer(Cmd, Source, Destination, 1, &Copy);
+		});
+	}
+	else
+	{
+		vkutils::CreateVertexBuffer(pVulkanDevice, m_Vertices, m_Name.c_str(), m_VertexBuffer);
+	}
+	vkutils::CreateIndexBuffer(pVulkanDevice, m_Indices, m_Name.c_str(), m_IndexBuffer);
 
 	// TODO: Should this be done in all functions that upload things to GPU?
 	// IDEA: Do it like this and just get again from file the vertices/indices in case we detect the buffers are no logner filled and uploaded.
 	m_Vertices.clear();
 	m_Indices.clear();
+	m_SkinVertices.clear();
 }
@@ -68,7 +68,8 @@ struct sRenderContext
     VkCommandBuffer CmdBuffer;
     VkDescriptorSet FrameDescriptorSet;
     VkDescriptorSet ObjectsDescriptorSet;
-    std::unordered_map<std::string, sMaterialDescriptor*>* MaterialDescriptors; // TODO: This should be get directly from CVulkanBackend.
+    // Indexed by CMaterial::GetIndex().
+    const std::vector<sMaterialDescriptor*>* MaterialDescriptors; // TODO: This should be get directly from CVulkanBackend.
     uint32_t DrawCallNum;
 };
 
@@ -77,14 +78,33 @@ class CVulkanRenderable : public CRenderable
 public:
     CVulkanRenderable() = default;
     CVulkanRenderable(sMeshData* apMeshData);
+    virtual ~CVulkanRenderable() override;
 
     void Draw(sRenderContext& aRenderContext, bool bBindMaterialDescriptor = false);
     virtual void UploadToVRAM() override;
 
-    AllocatedBuffer m_VertexBuffer;
-    AllocatedBuffer m_IndexBuffer;
+    /**
+     * @brief Number of draw calls recorded by Draw(). Passes that skip a renderable must advance sRenderContext::DrawCallNum
+     * by it, so the following renderables still index their own transforms.
+     */
+    uint32_t GetNumDrawCalls() const;
+
+    /**
+     * @brief Vertex buffer the passes draw: the skinned vertices of a skinned renderable, the bind pose otherwise.
+     */
+    VkBuffer GetDrawVertexBuffer() const { return m_SkinnedVertexBuffer.Buffer != VK_NULL_HANDLE ? m_SkinnedVertexBuffer.Buffer : m_VertexBuffer.Buffer; }
+
+    AllocatedBuffer m_VertexBuffer = {};
+    AllocatedBuffer m_IndexBuffer = {};
+
+    // Only for skinned renderables. The skinning (see CVulkanSkinning) reads the bind pose in m_VertexBuffer and the
+    // joints and weights in m_SkinBuffer, and writes m_SkinnedVertexBuffer.
+    AllocatedBuffer m_SkinBuffer = {};
+    AllocatedBuffer m_SkinnedVertexBuffer = {};
+    VkDescriptorSet m_SkinningDescriptorSet = VK_NULL_HANDLE;
 
 private:
     void DrawNode(CMeshNode* apMeshNode, sRenderContext& aRenderContext, bool bBindMaterialDescriptor = false);
     void DrawSubMesh(CSubMesh* apSubMesh, sRenderContext& aRenderContext, bool bBindMaterialDescriptor = false);
+    static uint32_t GetNumDrawCalls(const CMeshNode* apMeshNode);
 };
@@ -0,0 +1,172 @@
+#include "vk_upscale_pass.hpp"
+#include "vulkan_device.hpp"
+#include "vk_initializers.hpp"
+#include "vk_utils.hpp"
+#include "vk_descriptors.hpp"
+#include <core/logger.h>
+
+#include <glm/glm.hpp>
+
+namespace
+{
+	// Must match upscale.frag.
+	struct sUpscaleConstants
+	{
+		// Maps the UV of the target to the rendered area of the source.
+		glm::vec2 UVScale;
+		// Center of the last rendered texel, the filter must not reach past it.
+		glm::vec2 MaxUV;
+	};
+}
+
+CVulkanUpscalePass::CVulkanUpscalePass(CVulkanDevice* apVulkanDevice) :
+	m_pVulkanDevice(apVulkanDevice),
+	m_pRenderGraph(nullptr),
+	m_Source(INVALID_RENDER_GRAPH_RESOURCE),
+	m_Pass(0),
+	m_Sampler(VK_NULL_HANDLE),
+	m_SetLayout(VK_NULL_HANDLE),
+	m_DescriptorSet(VK_NULL_HANDLE),
+	m_PipelineLayout(VK_NULL_HANDLE),
+	m_Pipeline(VK_NULL_HANDLE)
+{
+}
+
+uint32_t CVulkanUpscalePass::AddToGraph(CVulkanRenderGraph* apRenderGraph, RenderGraphResource aSource, RenderGraphResource aTarget)
+{
+	m_pRenderGraph = apRenderGraph;
+	m_Source = aSource;
+
+	// Every pixel of the target is written, it does not need a clear.
+	m_Pass = m_pRenderGraph->AddPass("Upscale", [&](CRenderGraphPassBuilder& aBuilder)
+	{
+		aBuilder.ReadTexture(aSource);
+		aBuilder.WriteColor(aTarget, false);
+	},
+	[this](const sRenderGraphPassContext& aContext) { Draw(aContext); });
+
+	return m_Pass;
+}
+
+void CVulkanUpscalePass::CreateResources(VkSampler aSampler, CVulkanDescriptorLayoutCache& aLayoutCache, CVulkanDescriptorAllocator& aDescriptorAllocator)
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+	m_Sampler = aSampler;
+
+	VkDescriptorSetLayoutBinding SourceBinding = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 0);
+
+	VkDescriptorSetLayoutCreateInfo SetLayoutInfo = {};
+	SetLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+	SetLayoutInfo.bindingCount = 1;
+	SetLayoutInfo.pBindings = &SourceBinding;
+
+	m_SetLayout = aLayoutCache.CreateLayout(SetLayoutInfo);
+	m_DescriptorSet = aDescriptorAllocator.Allocate(m_SetLayout);
+
+	VkPushConstantRange PushConstantRange = {};
+	PushConstantRange.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+	PushConstantRange.offset = 0;
+	PushConstantRange.size = sizeof(sUpscaleConstants);
+
+	VkPipelineLayoutCreateInfo LayoutInfo = vkinit::PipelineLayoutCreateInfo();
+	LayoutInfo.setLayoutCount = 1;
+	LayoutInfo.pSetLayouts = &m_SetLayout;
+	LayoutInfo.pushConstantRangeCount = 1;
+	LayoutInfo.pPushConstantRanges = &PushConstantRange;
+
+	VK_CHECK(vkCreatePipelineLayout(Device, &LayoutInfo, nullptr, &m_PipelineLayout));
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		vkDestroyPipelineLayout(Device, m_PipelineLayout, nullptr);
+	});
+
+	UpdateDescriptors();
+}
+
+void CVulkanUpscalePass::BuildPipeline(VkPipelineCache aPipelineCache)
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
+
+	VkShaderModule VertShader;
+	if (!vkutils::LoadShaderModule(Device, vkutils::GetShaderPath("upscale_vert.spv").c_str(), &VertShader))
+	{
+		SGSERROR("Error when building the upscale vertex shader module");
+	}
+
+	VkShaderModule FragShader;
+	if (!vkutils::LoadShaderModule(Device, vkutils::GetShaderPath("upscale_frag.spv").c_str(), &FragShader))
+	{
+		SGSERROR("Error when building the upscale fragment shader module");
+	}
+
+	PipelineBuilder PipelineBuilder;
+
+	std::vector<VkDynamicState> DynamicStates =
+	{
+		VK_DYNAMIC_STATE_VIEWPORT,
+		VK_DYNAMIC_STATE_SCISSOR
+	};
+	PipelineBuilder.m_DynamicState = vkinit::DynamicStateCreateInfo(DynamicStates);
+
+	// Fullscreen triangle generated in the vertex shader, no vertex buffers.
+	PipelineBuilder.m_VertexInputInfo = vkinit::VertexInputStateCreateInfo();
+	PipelineBuilder.m_InputAssembly = vkinit::InputAssemblyCreateInfo(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST);
+
+	const VkExtent2D Extent = m_pRenderGraph->GetExtent();
+	PipelineBuilder.m_Viewport = { 0.0f, 0.0f, static_cast<float>(Extent.width), static_cast<float>(Extent.height), 0.0f, 1.0f };
+	PipelineBuilder.m_Scissor = { {0, 0}, Extent };
+
+	PipelineBuilder.m_DepthStencil = vkinit::DepthStencilCreateInfo(false, false, VK_COMPARE_OP_ALWAYS);
+	PipelineBuilder.m_Rasterizer = vkinit::RasterizationStateCreateInfo(VK_POLYGON_MODE_FILL);
+	PipelineBuilder.m_Multisampling = vkinit::MultisamplingStateCreateInfo();
+	PipelineBuilder.m_ColorBlendAttachment.push_back(vkinit::ColorBlendAttachmentState());
+
+	PipelineBuilder.m_ShaderStages.push_back(vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_VERTEX_BIT, VertShader));
+	PipelineBuilder.m_ShaderStages.push_back(vkinit::PipelineShaderStageCreateInfo(VK_SHADER_STAGE_FRAGMENT_BIT, FragShader));
+
+	PipelineBuilder.m_PipelineLayout = m_PipelineLayout;
+	PipelineBuilder.m_Subpass = m_pRenderGraph->GetSubpassIndex(m_Pass);
+
+	m_Pipeline = PipelineBuilder.BuildPipeline(Device, m_pRenderGraph->GetRenderPass(m_Pass), aPipelineCache);
+
+	vkDestroyShaderModule(Device, FragShader, nullptr);
+	vkDestroyShaderModule(Device, VertShader, nullptr);
+
+	m_DeletionQueue.PushFunction([=]()
+	{
+		vkDestroyPipeline(Device, m_Pipeline, nullptr);
+	});
+}
+
+void CVulkanUpscalePass::UpdateDescriptors()
+{
+	VkDescriptorImageInfo SourceImageInfo = {};
+	SourceImageInfo.sampler = m_Sampler;
+	SourceImageInfo.imageView = m_pRenderGraph->GetImageView(m_Source);
+	SourceImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+	VkWriteDescriptorSet Write = vkinit::WriteDescriptorImage(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_DescriptorSet, &SourceImageInfo, 0);
+	vkUpdateDescriptorSets(m_pVulkanDevice->m_Device, 1, &Write, 0, nullptr);
+}
+
+void CVulkanUpscalePass::Destroy()
+{
+	m_DeletionQueue.Flush();
+}
+
+void CVulkanUpscalePass::Draw(const sRenderGraphPassContext& aContext)
+{
+	// The source has the size of the graph, only its render extent was rendered.
+	const VkExtent2D Extent = m_pRenderGraph->GetExtent();
+	const VkExtent2D RenderExtent = m_pRenderGraph->GetRenderExtent();
+
+	sUpscaleConstants Constants;
+	Constants.UVScale = glm::vec2(RenderExtent.width / static_cast<float>(Extent.width), RenderExtent.height / static_cast<float>(Extent.height));
+	Constants.MaxUV = glm::vec2((RenderExtent.width - 0.5f) / Extent.width, (RenderExtent.height - 0.5f) / Extent.height);
+
+	vkCmdBindPipeline(aContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_Pipeline);
+	vkCmdBindDescriptorSets(aContext.CmdBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_PipelineLayout, 0, 1, &m_DescriptorSet, 0, nullptr);
+	vkCmdPushConstants(aContext.CmdBuffer, m_PipelineLayout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(sUpscaleConstants), &Constants);
+	vkCmdDraw(aContext.CmdBuffer, 3, 1, 0, 0);
+}
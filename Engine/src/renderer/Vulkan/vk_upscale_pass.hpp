@@ -0,0 +1,55 @@
+#pragma once
+
+#include "vk_types.hpp"
+#include "vk_render_graph.hpp"
+#include <core/types.hpp>
+
+class CVulkanDevice;
+class CVulkanDescriptorLayoutCache;
+class CVulkanDescriptorAllocator;
+
+/**
+ * @brief Render graph pass that stretches the render extent of an image over the whole target with a bilinear
+ * filter. Render paths use it to bring the scene rendered at a lower resolution (see CVulkanDynamicResolution)
+ * to the swapchain size. At full resolution it is a plain copy.
+ *
+ * Usage: AddToGraph() before compiling the graph, CreateResources() after it, and UpdateDescriptors() every time
+ * the graph is resized.
+ */
+class CVulkanUpscalePass
+{
+public:
+    CVulkanUpscalePass(CVulkanDevice* apVulkanDevice);
+
+    /**
+     * @return Index of the pass in the graph.
+     */
+    uint32_t AddToGraph(CVulkanRenderGraph* apRenderGraph, RenderGraphResource aSource, RenderGraphResource aTarget);
+
+    /**
+     * @brief The set layout is created by aLayoutCache and the set allocated from aDescriptorAllocator, both owned by
+     * the backend.
+     */
+    void CreateResources(VkSampler aSampler, CVulkanDescriptorLayoutCache& aLayoutCache, CVulkanDescriptorAllocator& aDescriptorAllocator);
+    void BuildPipeline(VkPipelineCache aPipelineCache);
+    void UpdateDescriptors();
+    void Destroy();
+
+private:
+    void Draw(const sRenderGraphPassContext& aContext);
+
+    CVulkanDevice* m_pVulkanDevice;
+    CVulkanRenderGraph* m_pRenderGraph;
+    RenderGraphResource m_Source;
+    uint32_t m_Pass;
+    VkSampler m_Sampler;
+
+    // Owned by the layout cache of the backend.
+    VkDescriptorSetLayout m_SetLayout;
+    VkDescriptorSet m_DescriptorSet;
+    VkPipelineLayout m_PipelineLayout;
+    VkPipeline m_Pipeline;
+
+    // Holds the deletion functions.
+    sDeletionQueue m_DeletionQueue;
+};
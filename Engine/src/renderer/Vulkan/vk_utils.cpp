@@ -9,9 +9,26 @@
 #include <stb_image/stb_image.h>
 
 #include <iostream>
+#include <cstdlib>
 #include <fstream>
 #include <unordered_map>
 
+std::string vkutils::GetShaderPath(const char* aShaderName)
+{
+	static const std::string ShadersDir = []
+	{
+		const char* pEnvDir = std::getenv("SGS_SHADERS_DIR");
+		std::string Dir = (pEnvDir && *pEnvDir) ? pEnvDir : SGS_SHADERS_DIR;
+		if (!Dir.empty() && Dir.back() != '/' && Dir.back() != '\\')
+		{
+			Dir += '/';
+		}
+		return Dir;
+	}();
+
+	return ShadersDir + aShaderName;
+}
+
 bool vkutils::LoadShaderModule(VkDevice aDevice, const char* aFilePath, VkShaderModule* aOutShaderModule)
 {
 	std::ifstream File(aFilePath, std::ios::ate | std::ios::binary);
@@ -47,7 +64,7 @@ bool vkutils::LoadShaderModule(VkDevice aDevice, const char* aFilePath, VkShader
 	return true;
 }
 
-void vkutils::CreateVertexBuffer(const CVulkanDevice* const aVulkanDevice, const std::vector<sVertex>& aVertices, AllocatedBuffer& aOutBuffer)
+void vkutils::CreateVertexBuffer(const CVulkanDevice* const aVulkanDevice, const std::vector<sVertex>& aVertices, const char* apName, AllocatedBuffer& aOutBuffer)
 {
 	const size_t BufferSize = aVertices.size() * sizeof(sVertex);
 
@@ -64,8 +81,7 @@ void vkutils::CreateVertexBuffer(const CVulkanDevice* const aVulkanDevice, const
 
 	VmaAllocator Allocator = aVulkanDevice->m_Allocator;
 
-	VK_CHECK(vmaCreateBuffer(Allocator, &StagingBufferInfo, &VmaAllocInfo, 
-		&StagingBuffer.Buffer, &StagingBuffer.Allocation, nullptr));
+	VK_CHECK(aVulkanDevice->m_MemoryAllocator.CreateBuffer(StagingBufferInfo, VmaAllocInfo, eMemoryCategory::STAGING, "Vertex Staging Buffer", StagingBuffer));
 
 	void* Data;
 	vmaMapMemory(Allocator, StagingBuffer.Allocation, &Data);
@@ -82,8 +98,7 @@ void vkutils::CreateVertexBuffer(const CVulkanDevice* const aVulkanDevice, const
 	VmaAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
 	// It is responsibility of the caller to delete this.
-	VK_CHECK(vmaCreateBuffer(Allocator, &VertexBufferInfo, &VmaAllocInfo,
-		&aOutBuffer.Buffer, &aOutBuffer.Allocation, nullptr));
+	VK_CHECK(aVulkanDevice->m_MemoryAllocator.CreateBuffer(VertexBufferInfo, VmaAllocInfo, eMemoryCategory::MESH, apName, aOutBuffer));
 
 	aVulkanDevice->ImmediateSubmit([=](VkCommandBuffer Cmd)
 	{
@@ -95,10 +110,10 @@ void vkutils::CreateVertexBuffer(const CVulkanDevice* const aVulkanDevice, const
 		vkCmdCopyBuffer(Cmd, StagingBuffer.Buffer, aOutBuffer.Buffer, 1, &Copy);
 	});
 
-	vmaDestroyBuffer(Allocator, StagingBuffer.Buffer, StagingBuffer.Allocation);
+	aVulkanDevice->m_MemoryAllocator.DestroyBuffer(StagingBuffer);
 }
 
-void vkutils::CreateIndexBuffer(const CVulkanDevice* const aVulkanDevice, const std::vector<uint32_t>& aIndices, AllocatedBuffer& aOutBuffer)
+void vkutils::CreateIndexBuffer(const CVulkanDevice* const aVulkanDevice, const std::vector<uint32_t>& aIndices, const char* apName, AllocatedBuffer& aOutBuffer)
 {
 	const size_t BufferSize = aIndices.size() * sizeof(uint32_t);
 
@@ -115,8 +130,7 @@ void vkutils::CreateIndexBuffer(const CVulkanDevice* const aVulkanDevice, const
 
 	VmaAllocator Allocator = aVulkanDevice->m_Allocator;
 
-	VK_CHECK(vmaCreateBuffer(Allocator, &StagingBufferInfo, &VmaAllocInfo,
-		&StagingBuffer.Buffer, &StagingBuffer.Allocation, nullptr));
+	VK_CHECK(aVulkanDevice->m_MemoryAllocator.CreateBuffer(StagingBufferInfo, VmaAllocInfo, eMemoryCategory::STAGING, "Index Staging Buffer", StagingBuffer));
 
 	void* Data;
 	vmaMapMemory(Allocator, StagingBuffer.Allocation, &Data);
@@ -133,8 +147,7 @@ void vkutils::CreateIndexBuffer(const CVulkanDevice* const aVulkanDevice, const
     VmaAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
 	// It is responsibility of the caller to delete this.
-	VK_CHECK(vmaCreateBuffer(Allocator, &IndexBufferInfo, &VmaAllocInfo,
-		&aOutBuffer.Buffer, &aOutBuffer.Allocation, nullptr));
+	VK_CHECK(aVulkanDevice->m_MemoryAllocator.CreateBuffer(IndexBufferInfo, VmaAllocInfo, eMemoryCategory::MESH, apName, aOutBuffer));
 
 	aVulkanDevice->ImmediateSubmit([=](VkCommandBuffer Cmd)
 	{
@@ -146,10 +159,11 @@ void vkutils::CreateIndexBuffer(const CVulkanDevice* const aVulkanDevice, const
 		vkCmdCopyBuffer(Cmd, StagingBuffer.Buffer, aOutBuffer.Buffer, 1, &Copy);
 	});
 
-	vmaDestroyBuffer(Allocator, StagingBuffer.Buffer, StagingBuffer.Allocation);
+	aVulkanDevice->m_MemoryAllocator.DestroyBuffer(StagingBuffer);
 }
 
-AllocatedBuffer vkutils::CreateBuffer(const CVulkanDevice* const aVulkanDevice, size_t aAllocSize, VkBufferUsageFlags aUsage, VmaMemoryUsage aMemoryUsage, VmaAllocationCreateFlags aFlags)
+AllocatedBuffer vkutils::CreateBuffer(const CVulkanDevice* const aVulkanDevice, size_t aAllocSize, VkBufferUsageFlags aUsage, VmaMemoryUsage aMemoryUsage,
+	eMemoryCategory aCategory, const char* apName, VmaAllocationCreateFlags aFlags, bool abSharedWithCompute)
 {
 	VkBufferCreateInfo BufferInfo = {};
 	BufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
@@ -158,16 +172,50 @@ AllocatedBuffer vkutils::CreateBuffer(const CVulkanDevice* const aVulkanDevice,
 	BufferInfo.size = aAllocSize;
 	BufferInfo.usage = aUsage;
 
+	const uint32_t QueueFamilies[] = { aVulkanDevice->m_GraphicsQueueFamily, aVulkanDevice->m_ComputeQueueFamily };
+	if (abSharedWithCompute && aVulkanDevice->HasAsyncCompute())
+	{
+		BufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+		BufferInfo.queueFamilyIndexCount = 2;
+		BufferInfo.pQueueFamilyIndices = QueueFamilies;
+	}
+
 	VmaAllocationCreateInfo VmaAllocInfo = {};
 	VmaAllocInfo.usage = aMemoryUsage;
 	VmaAllocInfo.flags = aFlags;
 
 	AllocatedBuffer NewBuffer;
 
-	VK_CHECK(vmaCreateBuffer(aVulkanDevice->m_Allocator, &BufferInfo, &VmaAllocInfo,
-		&NewBuffer.Buffer,
-		&NewBuffer.Allocation,
-		nullptr));
+	VK_CHECK(aVulkanDevice->m_MemoryAllocator.CreateBuffer(BufferInfo, VmaAllocInfo, aCategory, apName, NewBuffer));
+
+	return NewBuffer;
+}
+
+AllocatedBuffer vkutils::CreateDeviceBuffer(const CVulkanDevice* const aVulkanDevice, const void* apData, size_t aSize, VkBufferUsageFlags aUsage,
+	eMemoryCategory aCategory, const char* apName)
+{
+	AllocatedBuffer StagingBuffer = CreateBuffer(aVulkanDevice, aSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY,
+		eMemoryCategory::STAGING, "Device Buffer Staging Buffer");
+
+	void* Data;
+	vmaMapMemory(aVulkanDevice->m_Allocator, StagingBuffer.Allocation, &Data);
+	memcpy(Data, apData, aSize);
+	vmaUnmapMemory(aVulkanDevice->m_Allocator, StagingBuffer.Allocation);
+
+	// It is responsibility of the caller to delete this.
+	AllocatedBuffer NewBuffer = CreateBuffer(aVulkanDevice, aSize, aUsage | VK_BUFFER_USAGE_TRANSFER_DST_BIT, VMA_MEMORY_USAGE_GPU_ONLY, aCategory, apName);
+
+	aVulkanDevice->ImmediateSubmit([=](VkCommandBuffer Cmd)
+	{
+		VkBufferCopy Copy;
+		Copy.dstOffset = 0;
+		Copy.srcOffset = 0;
+		Copy.size = aSize;
+
+		vkCmdCopyBuffer(Cmd, StagingBuffer.Buffer, NewBuffer.Buffer, 1, &Copy);
+	});
+
+	aVulkanDevice->m_MemoryAllocator.DestroyBuffer(StagingBuffer);
 
 	return NewBuffer;
 }
@@ -187,21 +235,22 @@ bool vkutils::LoadImageFromFile(const CVulkanDevice* const aVulkanDevice, const
 	void* Pixel_Ptr = Pixels;
 	const uint64_t ImageSize = TexWidth * TexHeight * 4;
 
-    UploadImageToVRAM(aVulkanDevice, ImageSize, Pixel_Ptr, TexWidth, TexHeight, aOutImage);
+    UploadImageToVRAM(aVulkanDevice, ImageSize, Pixel_Ptr, TexWidth, TexHeight, File.c_str(), aOutImage);
     
 	stbi_image_free(Pixels);
 
     return true;
 }
 
-void vkutils::UploadImageToVRAM(const CVulkanDevice *const aVulkanDevice, const uint64_t aImageSize, void *aPixel_Ptr, int32_t aTexWidth, int32_t aTexHeight, AllocatedImage &aOutImage)
+void vkutils::UploadImageToVRAM(const CVulkanDevice *const aVulkanDevice, const uint64_t aImageSize, void *aPixel_Ptr, int32_t aTexWidth, int32_t aTexHeight, const char* apName, AllocatedImage &aOutImage)
 {
     // TODO: Should all images have this format?
     VkFormat ImageFormat = VK_FORMAT_R8G8B8A8_SRGB;
 
     VmaAllocator Allocator = aVulkanDevice->m_Allocator;
 
-    AllocatedBuffer StagingBuffer = vkutils::CreateBuffer(aVulkanDevice, aImageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY);
+    AllocatedBuffer StagingBuffer = vkutils::CreateBuffer(aVulkanDevice, aImageSize, VK_BUFFER_USAGE_TRANSFER_SRC_BIT, VMA_MEMORY_USAGE_CPU_ONLY,
+        eMemoryCategory::STAGING, "Texture Staging Buffer");
 
     void *Data;
     vmaMapMemory(Allocator, StagingBuffer.Allocation, &Data);
@@ -221,7 +270,7 @@ void vkutils::UploadImageToVRAM(const CVulkanDevice *const aVulkanDevice, const
     ImageAllocInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
 
     // It is responsibility of the caller to destroy the image.
-    vmaCreateImage(Allocator, &ImageInfo, &ImageAllocInfo, &NewImage.Image, &NewImage.Allocation, nullptr);
+    VK_CHECK(aVulkanDevice->m_MemoryAllocator.CreateImage(ImageInfo, ImageAllocInfo, eMemoryCategory::TEXTURE, apName, NewImage));
 
     aVulkanDevice->ImmediateSubmit([&](VkCommandBuffer aCmd)
                                    {
@@ -265,7 +314,7 @@ void vkutils::UploadImageToVRAM(const CVulkanDevice *const aVulkanDevice, const
 		vkCmdPipelineBarrier(aCmd, VK_PIPELINE_STAGE_TRANSFER_BIT,
 			VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &ImageBarrierToReadable); });
 
-    vmaDestroyBuffer(Allocator, StagingBuffer.Buffer, StagingBuffer.Allocation);
+    aVulkanDevice->m_MemoryAllocator.DestroyBuffer(StagingBuffer);
 
     aOutImage = NewImage;
 }
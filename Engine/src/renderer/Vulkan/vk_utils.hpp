@@ -1,24 +1,48 @@
 #pragma once
 
 #include "vk_types.hpp"
+#include "vk_memory_allocator.hpp"
 #include <string>
 
 class CVulkanDevice;
 
+// Directory the compiled SPIR-V shaders are loaded from. Can be overridden at build time (/DSGS_SHADERS_DIR=...)
+// or at run time through the SGS_SHADERS_DIR environment variable.
+#ifndef SGS_SHADERS_DIR
+#define SGS_SHADERS_DIR "../Engine/shaders/"
+#endif
+
 namespace vkutils
 {
+    /**
+     * @brief Returns the path of the compiled shader aShaderName (e.g. "frag.spv") inside the shaders directory.
+     */
+    std::string GetShaderPath(const char* aShaderName);
+
     bool LoadShaderModule(VkDevice aDevice, const char* aFilePath, VkShaderModule* aOutShaderModule);
 
     // TODO: Return AllocatedBuffer instead of passing it in by reference.
-    void CreateVertexBuffer(const CVulkanDevice* const aVulkanDevice, const std::vector<sVertex>& aVertices, AllocatedBuffer& aOutBuffer);
+    void CreateVertexBuffer(const CVulkanDevice* const aVulkanDevice, const std::vector<sVertex>& aVertices, const char* apName, AllocatedBuffer& aOutBuffer);
+
+    void CreateIndexBuffer(const CVulkanDevice* const aVulkanDevice, const std::vector<uint32_t>& aIndices, const char* apName, AllocatedBuffer& aOutBuffer);
 
-    void CreateIndexBuffer(const CVulkanDevice* const aVulkanDevice, const std::vector<uint32_t>& aIndices, AllocatedBuffer& aOutBuffer);
+    /**
+     * @brief Creates a buffer through the device memory allocator, tagged with aCategory and apName for the GPU memory reports.
+     * abSharedWithCompute makes it concurrent between the graphics and the async compute queue families, for the buffers
+     * both read without ownership transfers (see CVulkanAsyncCompute).
+     */
+    AllocatedBuffer CreateBuffer(const CVulkanDevice* const aVulkanDevice, size_t aAllocSize, VkBufferUsageFlags aUsage, VmaMemoryUsage aMemoryUsage,
+        eMemoryCategory aCategory, const char* apName, VmaAllocationCreateFlags aFlags = 0, bool abSharedWithCompute = false);
 
-    AllocatedBuffer CreateBuffer(const CVulkanDevice* const aVulkanDevice, size_t aAllocSize, VkBufferUsageFlags aUsage, VmaMemoryUsage aMemoryUsage, VmaAllocationCreateFlags aFlags = 0);
+    /**
+     * @brief Creates a GPU only buffer with aUsage and uploads aSize bytes of apData to it through a staging buffer.
+     */
+    AllocatedBuffer CreateDeviceBuffer(const CVulkanDevice* const aVulkanDevice, const void* apData, size_t aSize, VkBufferUsageFlags aUsage,
+        eMemoryCategory aCategory, const char* apName);
 
     bool LoadImageFromFile(const CVulkanDevice *const aVulkanDevice, const std::string &aFile, AllocatedImage &aOutImage);
 
-    void UploadImageToVRAM(const CVulkanDevice *const aVulkanDevice, const uint64_t aImageSize, void *aPixel_Ptr, int32_t aTexWidth, int32_t aTexHeight, AllocatedImage &aOutImage);
+    void UploadImageToVRAM(const CVulkanDevice *const aVulkanDevice, const uint64_t aImageSize, void *aPixel_Ptr, int32_t aTexWidth, int32_t aTexHeight, const char* apName, AllocatedImage &aOutImage);
 
     size_t GetAlignedSize(size_t aOriginalSize, size_t aAlignment);
 }
\ No newline at end of file
@@ -17,6 +17,8 @@
 #include <renderer/resources/material.hpp>
 #include <renderer/resources/texture.hpp>
 #include "resources/vk_texture.hpp"
+#include <core/job_system.hpp>
+#include <core/profiler.hpp>
 
 #include <VulkanBootstrap/VkBootstrap.h>
 #include <glm/gtc/matrix_transform.hpp>
@@ -24,14 +26,23 @@
 #include <iostream>
 #include <chrono>
 #include <array>
+#include <algorithm>
 
 CVulkanBackend::CVulkanBackend() :
 	m_bIsInitialized(false),
 	m_pVulkanDevice(nullptr),
 	m_pVulkanSwapchain(nullptr),
+	m_pFlatNormalTexture(nullptr),
+	m_RenderPaths{},
 	m_pCurrentRenderPath(nullptr),
 	m_CurrentFrame(0),
-	m_bWasWindowResized(false)
+	m_NumFramesInFlight(sFramePacingSettings().FramesInFlight),
+	m_pFramePacer(nullptr),
+	m_RenderStartNs(0),
+	m_FrameWaitStartNs(0),
+	m_FrameFenceSignaledNs(0),
+	m_bWasWindowResized(false),
+	m_FramebufferExtent{}
 {
 }
 
@@ -47,16 +58,20 @@ bool CVulkanBackend::Initialize()
 
 	InitDescriptorSetLayouts();
 
-	InitDescriptorSetPool();
+	InitDescriptorAllocators();
 
 	InitSyncStructures();
 
+	InitFrameAllocators();
+
 	InitTextureSamplers();
 
+	InitDefaultTextures();
+
 	vkutils::LoadImageFromFile(m_pVulkanDevice, "../Resources/Images/viking_room.png", m_Image);
 	m_MainDeletionQueue.PushFunction([=]
 	{
-		vmaDestroyImage(m_pVulkanDevice->m_Allocator, m_Image.Image, m_Image.Allocation);
+		m_pVulkanDevice->m_MemoryAllocator.DestroyImage(m_Image);
 	});
 
 	// TODO: Placeholder for testing purposes. TO BE REMOVED.
@@ -70,21 +85,53 @@ bool CVulkanBackend::Initialize()
 
 	InitDescriptorSets();
 
-	m_pCurrentRenderPath = CreateRenderPath();
+	InitPipelineCache();
+
+	InitAsyncCompute();
+
+	InitClusteredLighting();
+
+	InitSkinning();
+
+	InitShadowMaps();
+
+	InitDynamicResolution();
+
+	InitRenderPaths();
+	ChangeRenderPath(CEngine::Get()->GetRenderModule()->GetRenderPath());
 
     m_bIsInitialized = true;
 
     return true;
 }
 
-void CVulkanBackend::Render(const CCamera* const aCamera)
+void CVulkanBackend::Render(const sFramePacket& aFramePacket)
 {
+	SGS_PROFILE_FUNCTION();
+
 	assert(m_bIsInitialized);
 
+	m_RenderStartNs = profiler::GetTimeNs();
+
+	if (aFramePacket.RenderPath < eRenderPath::NUM && m_RenderPaths[static_cast<size_t>(aFramePacket.RenderPath)] != m_pCurrentRenderPath)
+	{
+		ChangeRenderPath(aFramePacket.RenderPath);
+	}
+
+	// The window size comes with the packet, the render thread never asks the window for it.
+	const VkExtent2D& SwapchainExtent = m_pVulkanSwapchain->m_WindowExtent;
+	if (aFramePacket.FramebufferWidth != SwapchainExtent.width || aFramePacket.FramebufferHeight != SwapchainExtent.height)
+	{
+		m_bWasWindowResized = true;
+	}
+	m_FramebufferExtent = { aFramePacket.FramebufferWidth, aFramePacket.FramebufferHeight };
+
+	ApplyFramePacingSettings(aFramePacket);
+
 	if (m_pCurrentRenderPath)
 	{
 		m_pCurrentRenderPath->UpdateBuffers();
-		m_pCurrentRenderPath->Render(aCamera);
+		m_pCurrentRenderPath->Render(aFramePacket);
 	}
 }
 
@@ -93,17 +140,27 @@ bool CVulkanBackend::Shutdown()
 	SGSINFO("Shutting down Vulkan");
 	vkQueueWaitIdle(m_pVulkanDevice->m_GraphicsQueue);
 
-	if (m_pCurrentRenderPath)
+	DestroyRenderPaths();
+
+	for (sMaterialDescriptor* pMaterialDescriptor : m_MaterialDescriptors)
 	{
-		m_pCurrentRenderPath->DestroyResources();
-		delete m_pCurrentRenderPath;
+		if (pMaterialDescriptor)
+		{
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(pMaterialDescriptor->ConstantsBuffer);
+		}
+		delete pMaterialDescriptor;
 	}
+	m_MaterialDescriptors.clear();
+	// Their sets referenced the constants buffers.
+	m_DescriptorSetCache.Clear();
 
-	for (auto& MaterialDescriptor : m_MaterialDescriptors)
+	// Textures are owned by the asset registry. Their images are queued in the frame deletion queue.
+	CAssetTable<CTexture>& Textures = CAssetRegistry::GetTextures();
+	for (uint32_t i = 0; i < Textures.GetSize(); ++i)
 	{
-		delete MaterialDescriptor.second;
+		delete Textures.Get(i);
 	}
-	m_MaterialDescriptors.clear();
+	Textures.Clear();
 
 	// Destroy CVulkanBackend's vulkan resources.
 	m_MainDeletionQueue.Flush();
@@ -114,6 +171,10 @@ bool CVulkanBackend::Shutdown()
 		delete m_pVulkanSwapchain;
 	}
 
+	// Everything is destroyed by now, whatever the allocator still tracks was leaked.
+	m_pVulkanDevice->m_FrameDeletionQueue.Flush();
+	m_pVulkanDevice->m_MemoryAllocator.ReportLeaks();
+
 	// Destructor automatically cleans resources.
 	delete m_pVulkanDevice;
 
@@ -134,6 +195,10 @@ void CVulkanBackend::CreateRenderablesData(const std::vector<CRenderable*>& aRen
 		if (pVulkanRenderable)
 		{
 			m_Renderables.emplace_back(pVulkanRenderable);
+			if (pVulkanRenderable->IsSkinned())
+			{
+				m_Skinning.CreateRenderableDescriptors(pVulkanRenderable);
+			}
 		}
 		else
 		{
@@ -156,34 +221,23 @@ void CVulkanBackend::CreateRenderablesData(const std::vector<CRenderable*>& aRen
 
 	CreateSceneDescriptorSets();
 
-	void* Data;
-	vmaMapMemory(m_pVulkanDevice->m_Allocator, m_ObjectsDataBuffer.Allocation, &Data);
-
-	// There will be a draw call per CMeshNode, hence, we need a transform for each CMeshNode.
-	sGPURenderObjectData* GPURenderObjectData = static_cast<sGPURenderObjectData*>(Data);
-	size_t Index = 0;
+	// The transforms of the objects come with every frame packet.
+	m_ShadowMaps.InvalidateStaticCache();
 
-	for (const auto& Renderable : aRenderables)
+	for (IRenderPath* pRenderPath : m_RenderPaths)
 	{
-		for (const auto& Root : Renderable->m_pRoots)
+		if (pRenderPath)
 		{
-			AddTransformsToBuffer(GPURenderObjectData, Index, Root);
+			pRenderPath->HandleSceneChanged();
 		}
 	}
-
-	vmaUnmapMemory(m_pVulkanDevice->m_Allocator, m_ObjectsDataBuffer.Allocation);
-
-	if (m_pCurrentRenderPath)
-	{
-		m_pCurrentRenderPath->HandleSceneChanged();
-	}
 }
 
 void CVulkanBackend::CreateMaterialDescriptorsFromMeshNodeRecursive(CMeshNode *const &aMeshNode)
 {
-	for (const auto& Child : aMeshNode->m_Children)
+	for (CMeshNode* pChild = aMeshNode->m_pFirstChild; pChild; pChild = pChild->m_pNextSibling)
 	{
-		CreateMaterialDescriptorsFromMeshNodeRecursive(Child);
+		CreateMaterialDescriptorsFromMeshNodeRecursive(pChild);
 	}
 
 	CreateMaterialDescriptorsFromMeshNode(aMeshNode);
@@ -195,19 +249,27 @@ void CVulkanBackend::CreateMaterialDescriptorsFromMeshNode(CMeshNode *const &aMe
     {
         for (const auto &SubMesh : aMeshNode->m_pMeshData->SubMeshes)
         {
-            CMaterial *pMaterial = SubMesh->m_Material;
             if (SubMesh->m_Material == nullptr)
             {
                 SGSWARN("The SubMesh from the MeshNode %s does not have a material. Using default material.", aMeshNode->m_Name.c_str());
-                pMaterial = CMaterial::Get("default_material");
+                // Assigned to the submesh so drawing it does not have to check for it.
+                SubMesh->m_Material = CMaterial::Get("default_material");
             }
+            CMaterial *pMaterial = SubMesh->m_Material;
 			
             assert(pMaterial);
+            assert(pMaterial->GetIndex() != INVALID_ASSET_INDEX);
 
-			if (m_MaterialDescriptors.find(pMaterial->GetID()) != m_MaterialDescriptors.cend())
+            const uint32_t MaterialIndex = pMaterial->GetIndex();
+            if (MaterialIndex >= m_MaterialDescriptors.size())
+            {
+                m_MaterialDescriptors.resize(MaterialIndex + 1, nullptr);
+            }
+
+			// Shared with a previous submesh. The following ones may still need theirs.
+			if (m_MaterialDescriptors[MaterialIndex] != nullptr)
 			{
-				SGSWARN("Already have the descriptor for material %s.", pMaterial->GetID().c_str());
-				return;
+				continue;
 			}
 
             sMaterialDescriptor *MaterialDescriptor = new sMaterialDescriptor();
@@ -215,7 +277,8 @@ void CVulkanBackend::CreateMaterialDescriptorsFromMeshNode(CMeshNode *const &aMe
 
             const sMaterialProperties Props = MaterialDescriptor->pMaterial->GetMaterialProperties();
 
-            MaterialDescriptor->ConstantsBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sMaterialConstants), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+            MaterialDescriptor->ConstantsBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sMaterialConstants), VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+                eMemoryCategory::UNIFORM, pMaterial->GetID().c_str());
 
             void *Data;
             vmaMapMemory(m_pVulkanDevice->m_Allocator, MaterialDescriptor->ConstantsBuffer.Allocation, &Data);
@@ -228,25 +291,33 @@ void CVulkanBackend::CreateMaterialDescriptorsFromMeshNode(CMeshNode *const &aMe
             CVkTexture *pNormalTexture = nullptr;
 
             // TODO: Refactor this into a function where, in case of nullptr, it places a default texture.
-			pAlbedoTexture = Props.pAlbedoTexture ? CTexture::Get<CVkTexture>(Props.pAlbedoTexture->GetID()) : CTexture::Get<CVkTexture>("../Resources/Images/default_texture.png");
-			pMetalRoughnessTexture = Props.pMetallicRoughnessTexture ? CTexture::Get<CVkTexture>(Props.pMetallicRoughnessTexture->GetID()) : CTexture::Get<CVkTexture>("../Resources/Images/default_texture.png");
-			pEmissiveTexture = Props.pEmissiveTexture ?  CTexture::Get<CVkTexture>(Props.pEmissiveTexture->GetID()) : CTexture::Get<CVkTexture>("../Resources/Images/default_texture.png");
-			pNormalTexture = Props.pNormalTexture ? CTexture::Get<CVkTexture>(Props.pNormalTexture->GetID()) : CTexture::Get<CVkTexture>("../Resources/Images/default_texture.png");
+			pAlbedoTexture = Props.pAlbedoTexture ? dynamic_cast<CVkTexture*>(Props.pAlbedoTexture) : CTexture::Get<CVkTexture>("../Resources/Images/default_texture.png");
+			pMetalRoughnessTexture = Props.pMetallicRoughnessTexture ? dynamic_cast<CVkTexture*>(Props.pMetallicRoughnessTexture) : CTexture::Get<CVkTexture>("../Resources/Images/default_texture.png");
+			pEmissiveTexture = Props.pEmissiveTexture ? dynamic_cast<CVkTexture*>(Props.pEmissiveTexture) : CTexture::Get<CVkTexture>("../Resources/Images/default_texture.png");
+			pNormalTexture = Props.pNormalTexture ? dynamic_cast<CVkTexture*>(Props.pNormalTexture) : m_pFlatNormalTexture;
 
             MaterialDescriptor->Resources.pAlbedoTexture = pAlbedoTexture;
             MaterialDescriptor->Resources.pMetalRoughnessTexture = pMetalRoughnessTexture;
             MaterialDescriptor->Resources.pEmissiveTexture = pEmissiveTexture;
             MaterialDescriptor->Resources.pNormalTexture = pNormalTexture;
 
-            m_MaterialDescriptors.insert({pMaterial->GetID(), MaterialDescriptor});
+            m_MaterialDescriptors[MaterialIndex] = MaterialDescriptor;
             // Descriptors will be created in the specific function to create descriptors.
         }
     }
 }
 
-void CVulkanBackend::ChangeRenderPath()
+void CVulkanBackend::ChangeRenderPath(eRenderPath aRenderPath)
 {
-	m_pCurrentRenderPath = CreateRenderPath();
+	IRenderPath* pNewRenderPath = aRenderPath < eRenderPath::NUM ? m_RenderPaths[static_cast<size_t>(aRenderPath)] : nullptr;
+	if (pNewRenderPath == nullptr)
+	{
+		SGSERROR("No IRenderPath available!");
+		return;
+	}
+
+	// All the paths share the per frame data and its fences, so the new path can start rendering right away.
+	m_pCurrentRenderPath = pNewRenderPath;
 }
 
 void CVulkanBackend::InitCommandPools()
@@ -295,6 +366,22 @@ void CVulkanBackend::InitSyncStructures()
 	});
 }
 
+void CVulkanBackend::InitFrameAllocators()
+{
+	for (int32_t i = 0; i < FRAME_OVERLAP; ++i)
+	{
+		m_FramesData[i].FrameAllocator.Initialize(SGS_FRAME_ALLOCATOR_SIZE);
+	}
+
+	m_MainDeletionQueue.PushFunction([=]
+	{
+		for (int32_t i = 0; i < FRAME_OVERLAP; ++i)
+		{
+			m_FramesData[i].FrameAllocator.Shutdown();
+		}
+	});
+}
+
 void CVulkanBackend::InitTextureSamplers()
 {
 	VkPhysicalDeviceProperties Properties = {};
@@ -323,68 +410,56 @@ void CVulkanBackend::InitTextureSamplers()
 	});
 }
 
-void CVulkanBackend::InitDescriptorSetPool()
+void CVulkanBackend::InitDefaultTextures()
 {
-	VkDescriptorPoolSize UBOPoolSize = {};
-	UBOPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	UBOPoolSize.descriptorCount = static_cast<uint32_t>(FRAME_OVERLAP);
-
-	VkDescriptorPoolSize SamplerPoolSize = {};
-	SamplerPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	SamplerPoolSize.descriptorCount = static_cast<uint32_t>(FRAME_OVERLAP);
-
-	VkDescriptorPoolSize ObjectsDataPoolSize = {};
-	ObjectsDataPoolSize.type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	ObjectsDataPoolSize.descriptorCount = 1;
-
-	std::array<VkDescriptorPoolSize, 3> PoolSizes = { UBOPoolSize, SamplerPoolSize, ObjectsDataPoolSize };
-
-	VkDescriptorPoolCreateInfo PoolInfo = {};
-	PoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	PoolInfo.poolSizeCount = static_cast<uint32_t>(PoolSizes.size());
-	PoolInfo.pPoolSizes = PoolSizes.data();
-	// TODO: This does not make sense. The COMBINE_IMAGE_SAMPLER type is not accounted for.
-	PoolInfo.maxSets = static_cast<uint32_t>(FRAME_OVERLAP) + 1; // +1 set for the objects descriptor set.
-	
-	VK_CHECK(vkCreateDescriptorPool(m_pVulkanDevice->m_Device, &PoolInfo, nullptr, &m_DescriptorPool));
-
-
-	VkDescriptorPoolSize MaterialTexturesPoolSize = {};
-	MaterialTexturesPoolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-	MaterialTexturesPoolSize.descriptorCount = 4 * MAX_RENDER_OBJECTS; // Albedo, MetalRoughness, Emissive and Normal for a total of 4 textures.
+	// Tangent space (0, 0, 1). The image is sRGB like every texture, the shaders undo the decoding of the normal maps.
+	uint8_t FlatNormal[4] = { 128, 128, 255, 255 };
+	m_pFlatNormalTexture = new CVkTexture(sizeof(FlatNormal), FlatNormal, 1, 1);
 
-	VkDescriptorPoolSize MaterialConstantsPoolSize = {};
-	MaterialConstantsPoolSize.type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-	MaterialTexturesPoolSize.descriptorCount = MAX_RENDER_OBJECTS;
-
-	std::array<VkDescriptorPoolSize, 2> MaterialPoolSizes = { MaterialTexturesPoolSize, MaterialConstantsPoolSize };
+	m_MainDeletionQueue.PushFunction([=]
+	{
+		delete m_pFlatNormalTexture;
+		m_pFlatNormalTexture = nullptr;
+	});
+}
 
-	VkDescriptorPoolCreateInfo MaterialPoolInfo = {};
-	MaterialPoolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
-	MaterialPoolInfo.poolSizeCount = static_cast<uint32_t>(MaterialPoolSizes.size());
-	MaterialPoolInfo.pPoolSizes = MaterialPoolSizes.data();
-	MaterialPoolInfo.maxSets = MAX_RENDER_OBJECTS;
+void CVulkanBackend::InitDescriptorAllocators()
+{
+	const VkDevice Device = m_pVulkanDevice->m_Device;
 
-	VK_CHECK(vkCreateDescriptorPool(m_pVulkanDevice->m_Device, &MaterialPoolInfo, nullptr, &m_MaterialsPool));
+	// Sets that live as long as the backend: the frame and object sets, the sets of the passes (light clusters,
+	// G-Buffer, upscale) and the materials, which are most of them with their constants and four textures. None of
+	// them is rewritten per frame, so there are no per frame descriptor pools.
+	const std::vector<sDescriptorPoolRatio> Ratios =
+	{
+		{ VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.0f },
+		{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 4.0f },
+		{ VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 0.5f },
+		{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, 0.1f }
+	};
+	m_DescriptorAllocator.Initialize(Device, 128, Ratios);
+	m_DescriptorSetCache.Initialize(Device, &m_DescriptorAllocator);
+
+	// Textures and buffers released at runtime leave the cache before their handles can be reused.
+	m_pVulkanDevice->m_FrameDeletionQueue.SetReleaseListener([this](uint64_t aHandle)
+	{
+		m_DescriptorSetCache.Evict(aHandle);
+	});
 
 	m_MainDeletionQueue.PushFunction([=]
 	{
-		vkDestroyDescriptorPool(m_pVulkanDevice->m_Device, m_DescriptorPool, nullptr);
-		vkDestroyDescriptorPool(m_pVulkanDevice->m_Device, m_MaterialsPool, nullptr);
+		m_pVulkanDevice->m_FrameDeletionQueue.SetReleaseListener(nullptr);
+		m_DescriptorSetCache.Clear();
+		m_DescriptorAllocator.Shutdown();
 	});
 }
 
 void CVulkanBackend::InitDescriptorSets()
 {
-	VkDescriptorSetAllocateInfo AllocInfo{};
-	AllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	AllocInfo.descriptorPool = m_DescriptorPool;
-	AllocInfo.descriptorSetCount = 1;
-	AllocInfo.pSetLayouts = &m_DescriptorSetLayout;
-
+	// The shadow bindings of the frame sets are written later by InitShadowMaps(), they are not cached.
 	for (size_t i = 0; i < FRAME_OVERLAP; ++i)
 	{
-		VK_CHECK(vkAllocateDescriptorSets(m_pVulkanDevice->m_Device, &AllocInfo, &m_FramesData[i].DescriptorSet));
+		m_FramesData[i].DescriptorSet = m_DescriptorAllocator.Allocate(m_DescriptorSetLayout);
 	}
 
 	for (size_t i = 0; i < FRAME_OVERLAP; ++i)
@@ -408,49 +483,54 @@ void CVulkanBackend::InitDescriptorSets()
 		vkUpdateDescriptorSets(m_pVulkanDevice->m_Device, 1,&Write, 0, nullptr);
 	}
 
-	VkDescriptorSetAllocateInfo RenderObjectsAllocInfo{};
-	RenderObjectsAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	RenderObjectsAllocInfo.descriptorPool = m_DescriptorPool;
-	RenderObjectsAllocInfo.descriptorSetCount = 1;
-	RenderObjectsAllocInfo.pSetLayouts = &m_RenderObjectsSetLayout;
-
-	VK_CHECK(vkAllocateDescriptorSets(m_pVulkanDevice->m_Device, &RenderObjectsAllocInfo, &m_ObjectsDataDescriptorSet));
-
-	VkDescriptorBufferInfo RenderObjectsBufferInfo = {};
-	RenderObjectsBufferInfo.buffer = m_ObjectsDataBuffer.Buffer;
-	RenderObjectsBufferInfo.offset = 0;
-	RenderObjectsBufferInfo.range = sizeof(sGPURenderObjectData) * MAX_RENDER_OBJECTS;
-
-	VkWriteDescriptorSet RenderObjectsDescriptorWrite{};
-	RenderObjectsDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-	RenderObjectsDescriptorWrite.dstSet = m_ObjectsDataDescriptorSet;
-	RenderObjectsDescriptorWrite.dstBinding = 0;
-	RenderObjectsDescriptorWrite.dstArrayElement = 0;
-	RenderObjectsDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
-	RenderObjectsDescriptorWrite.descriptorCount = 1;
-	RenderObjectsDescriptorWrite.pBufferInfo = &RenderObjectsBufferInfo;
-	RenderObjectsDescriptorWrite.pImageInfo = nullptr;
-	RenderObjectsDescriptorWrite.pTexelBufferView = nullptr;
-
-	vkUpdateDescriptorSets(m_pVulkanDevice->m_Device, 1, &RenderObjectsDescriptorWrite, 0, nullptr);
+	for (size_t i = 0; i < FRAME_OVERLAP; ++i)
+	{
+		m_FramesData[i].ObjectsDescriptorSet = m_DescriptorAllocator.Allocate(m_RenderObjectsSetLayout);
+
+		VkDescriptorBufferInfo RenderObjectsBufferInfo = {};
+		RenderObjectsBufferInfo.buffer = m_FramesData[i].ObjectsBuffer.Buffer;
+		RenderObjectsBufferInfo.offset = 0;
+		RenderObjectsBufferInfo.range = sizeof(sGPURenderObjectData) * MAX_RENDER_OBJECTS;
+
+		VkWriteDescriptorSet RenderObjectsDescriptorWrite{};
+		RenderObjectsDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+		RenderObjectsDescriptorWrite.dstSet = m_FramesData[i].ObjectsDescriptorSet;
+		RenderObjectsDescriptorWrite.dstBinding = 0;
+		RenderObjectsDescriptorWrite.dstArrayElement = 0;
+		RenderObjectsDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+		RenderObjectsDescriptorWrite.descriptorCount = 1;
+		RenderObjectsDescriptorWrite.pBufferInfo = &RenderObjectsBufferInfo;
+		RenderObjectsDescriptorWrite.pImageInfo = nullptr;
+		RenderObjectsDescriptorWrite.pTexelBufferView = nullptr;
+
+		vkUpdateDescriptorSets(m_pVulkanDevice->m_Device, 1, &RenderObjectsDescriptorWrite, 0, nullptr);
+	}
 }
 
 void CVulkanBackend::InitDescriptorSetLayouts()
 {
+	m_DescriptorLayoutCache.Initialize(m_pVulkanDevice->m_Device);
+
 	// FRAME DESCRIPTOR LAYOUT CREATION.
 	VkDescriptorSetLayoutBinding FrameUBOVertLayoutBinding = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0);
+	// Directional light and cascaded shadow maps, written by InitShadowMaps().
+	VkDescriptorSetLayoutBinding ShadowDataLayoutBinding = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 1);
+	VkDescriptorSetLayoutBinding ShadowMapLayoutBinding = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 2);
+
+	const std::array<VkDescriptorSetLayoutBinding, 3> FrameLayoutBindings = { FrameUBOVertLayoutBinding, ShadowDataLayoutBinding, ShadowMapLayoutBinding };
 
 	VkDescriptorSetLayoutCreateInfo LayoutInfo = {};
 	LayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-	LayoutInfo.bindingCount = 1;
-	LayoutInfo.pBindings = &FrameUBOVertLayoutBinding;
+	LayoutInfo.bindingCount = static_cast<uint32_t>(FrameLayoutBindings.size());
+	LayoutInfo.pBindings = FrameLayoutBindings.data();
 
-	VK_CHECK(vkCreateDescriptorSetLayout(m_pVulkanDevice->m_Device, &LayoutInfo, nullptr, &m_DescriptorSetLayout));
+	m_DescriptorSetLayout = m_DescriptorLayoutCache.CreateLayout(LayoutInfo);
 
 	VkDeviceSize BufferSize = sizeof(sCameraFrameUBO);
 	for (int i = 0; i < FRAME_OVERLAP; ++i)
 	{
-		m_FramesData[i].UBOBuffer = vkutils::CreateBuffer(m_pVulkanDevice, BufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+		m_FramesData[i].UBOBuffer = vkutils::CreateBuffer(m_pVulkanDevice, BufferSize, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU,
+			eMemoryCategory::UNIFORM, "Camera Frame UBO");
 		vmaMapMemory(m_pVulkanDevice->m_Allocator, m_FramesData[i].UBOBuffer.Allocation, &m_FramesData[i].MappedUBOBuffer);
 	}
 
@@ -463,10 +543,16 @@ void CVulkanBackend::InitDescriptorSetLayouts()
 	RenderObjectsLayoutInfo.bindingCount = 1;
 	RenderObjectsLayoutInfo.pBindings = &TransformLayoutBinding;
 
-	VK_CHECK(vkCreateDescriptorSetLayout(m_pVulkanDevice->m_Device, &RenderObjectsLayoutInfo, nullptr, &m_RenderObjectsSetLayout));
+	m_RenderObjectsSetLayout = m_DescriptorLayoutCache.CreateLayout(RenderObjectsLayoutInfo);
 
 	// TODO: Buffer creation should not be here.
-	m_ObjectsDataBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sGPURenderObjectData) * MAX_RENDER_OBJECTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VMA_MEMORY_USAGE_CPU_TO_GPU);
+	// One buffer per frame in flight, the render thread writes a frame while the GPU reads the previous ones.
+	for (int i = 0; i < FRAME_OVERLAP; ++i)
+	{
+		m_FramesData[i].ObjectsBuffer = vkutils::CreateBuffer(m_pVulkanDevice, sizeof(sGPURenderObjectData) * MAX_RENDER_OBJECTS, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT,
+			VMA_MEMORY_USAGE_CPU_TO_GPU, eMemoryCategory::STORAGE, "Render Objects");
+		vmaMapMemory(m_pVulkanDevice->m_Allocator, m_FramesData[i].ObjectsBuffer.Allocation, &m_FramesData[i].MappedObjectsBuffer);
+	}
 
 	// Material Layout Binding.
 	VkDescriptorSetLayoutBinding MaterialConstants = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT, 0);
@@ -475,176 +561,321 @@ void CVulkanBackend::InitDescriptorSetLayouts()
 	VkDescriptorSetLayoutBinding EmissiveLayoutBinding = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 3);
 	VkDescriptorSetLayoutBinding NormalLayoutBinding = vkinit::DescriptorLayoutBinding(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_FRAGMENT_BIT, 4);
 	
-	const std::array<VkDescriptorSetLayoutBinding, 4> MaterialLayoutBindings = { MaterialConstants, AlbedoLayoutBinding, MetalRoughnessLayoutBinding, NormalLayoutBinding };
+	const std::array<VkDescriptorSetLayoutBinding, 5> MaterialLayoutBindings = { MaterialConstants, AlbedoLayoutBinding, MetalRoughnessLayoutBinding, EmissiveLayoutBinding, NormalLayoutBinding };
 
 	VkDescriptorSetLayoutCreateInfo MaterialLayoutInfo = {};
 	MaterialLayoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
 	MaterialLayoutInfo.bindingCount = static_cast<uint32_t>(MaterialLayoutBindings.size());
 	MaterialLayoutInfo.pBindings = MaterialLayoutBindings.data();
 
-	VK_CHECK(vkCreateDescriptorSetLayout(m_pVulkanDevice->m_Device, &MaterialLayoutInfo, nullptr, &m_MaterialsSetLayout));
+	m_MaterialsSetLayout = m_DescriptorLayoutCache.CreateLayout(MaterialLayoutInfo);
 
 	m_MainDeletionQueue.PushFunction([=]
 	{
 		for (size_t i = 0; i < FRAME_OVERLAP; ++i)
 		{
 			vmaUnmapMemory(m_pVulkanDevice->m_Allocator, m_FramesData[i].UBOBuffer.Allocation);
-			vmaDestroyBuffer(m_pVulkanDevice->m_Allocator, m_FramesData[i].UBOBuffer.Buffer, m_FramesData[i].UBOBuffer.Allocation);
-		}
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(m_FramesData[i].UBOBuffer);
 
-		vmaDestroyBuffer(m_pVulkanDevice->m_Allocator, m_ObjectsDataBuffer.Buffer, m_ObjectsDataBuffer.Allocation);
+			vmaUnmapMemory(m_pVulkanDevice->m_Allocator, m_FramesData[i].ObjectsBuffer.Allocation);
+			m_pVulkanDevice->m_MemoryAllocator.DestroyBuffer(m_FramesData[i].ObjectsBuffer);
+		}
 
-		vkDestroyDescriptorSetLayout(m_pVulkanDevice->m_Device, m_DescriptorSetLayout, nullptr);
-		vkDestroyDescriptorSetLayout(m_pVulkanDevice->m_Device, m_RenderObjectsSetLayout, nullptr);
-		vkDestroyDescriptorSetLayout(m_pVulkanDevice->m_Device, m_MaterialsSetLayout, nullptr);
+		m_DescriptorLayoutCache.Shutdown();
 	});
 }
 
-IRenderPath* CVulkanBackend::CreateRenderPath()
+void CVulkanBackend::ApplyFramePacingSettings(const sFramePacket& aFramePacket)
 {
-	// TODO: I need a module getter.
-	const eRenderPath RenderPath = CEngine::Get()->GetRenderModule()->GetRenderPath();
-	IRenderPath* NewRenderPath = nullptr;
-	switch (RenderPath)
+	const uint32_t NumFramesInFlight = std::clamp<uint32_t>(aFramePacket.FramesInFlight, 1, FRAME_OVERLAP);
+	if (NumFramesInFlight != m_NumFramesInFlight)
 	{
-		case eRenderPath::FORWARD:
+		// Once the GPU is idle every frame is free, so they can start over from the first one.
+		VK_CHECK(vkDeviceWaitIdle(m_pVulkanDevice->m_Device));
+		m_NumFramesInFlight = NumFramesInFlight;
+		m_CurrentFrame = 0;
+		for (sFrameData& FrameData : m_FramesData)
 		{
-			NewRenderPath = new CVulkanForwardRenderPath(this, m_pVulkanDevice, m_pVulkanSwapchain);
+			FrameData.InputTimeNs = 0;
 		}
-		break;
-		
-		case eRenderPath::DEFERRED:
+		SGSINFO("Frames in flight: %u.", m_NumFramesInFlight);
+	}
+
+	if (aFramePacket.PresentMode != m_pVulkanSwapchain->GetRequestedPresentMode())
+	{
+		m_pVulkanSwapchain->SetPresentMode(aFramePacket.PresentMode);
+		RecreateSwapchain();
+	}
+}
+
+void CVulkanBackend::WaitForFrame()
+{
+	SGS_PROFILE_SCOPE("Wait For Frame Fence");
+
+	m_FrameWaitStartNs = profiler::GetTimeNs();
+	VK_CHECK(vkWaitForFences(m_pVulkanDevice->m_Device, 1, &m_FramesData[m_CurrentFrame].RenderFence, VK_TRUE, UINT64_MAX));
+	m_FrameFenceSignaledNs = profiler::GetTimeNs();
+}
+
+void CVulkanBackend::RecreateSwapchain()
+{
+	m_pVulkanSwapchain->RecreateSwapchain(m_FramebufferExtent);
+
+	// Every path is alive, not only the current one, so all of them must follow the new swapchain.
+	for (IRenderPath* pRenderPath : m_RenderPaths)
+	{
+		if (pRenderPath)
 		{
-			NewRenderPath = new CVulkanDeferredRenderPath(this, m_pVulkanDevice, m_pVulkanSwapchain);
+			pRenderPath->HandleSwapchainRecreated();
 		}
-		break;
+	}
+}
+
+void CVulkanBackend::InitPipelineCache()
+{
+	m_PipelineCache.Initialize(m_pVulkanDevice, SGS_PIPELINE_CACHE_FILE);
+
+	m_MainDeletionQueue.PushFunction([=]
+	{
+		m_PipelineCache.Shutdown();
+	});
+}
+
+void CVulkanBackend::InitAsyncCompute()
+{
+	m_AsyncCompute.Initialize(m_pVulkanDevice, FRAME_OVERLAP);
+
+	m_MainDeletionQueue.PushFunction([=]
+	{
+		m_AsyncCompute.Shutdown();
+	});
+}
+
+void CVulkanBackend::InitClusteredLighting()
+{
+	m_ClusteredLighting.Initialize(m_pVulkanDevice, FRAME_OVERLAP, m_PipelineCache.GetHandle(), m_DescriptorLayoutCache, m_DescriptorAllocator);
+
+	m_MainDeletionQueue.PushFunction([=]
+	{
+		m_ClusteredLighting.Shutdown();
+	});
+}
+
+void CVulkanBackend::InitSkinning()
+{
+	m_Skinning.Initialize(m_pVulkanDevice, FRAME_OVERLAP, m_PipelineCache.GetHandle(), m_DescriptorLayoutCache);
 
-		default:
-			SGSERROR("No IRenderPath created!");
-			break;
+	m_MainDeletionQueue.PushFunction([=]
+	{
+		m_Skinning.Shutdown();
+	});
+}
+
+void CVulkanBackend::InitShadowMaps()
+{
+	m_ShadowMaps.Initialize(m_pVulkanDevice, FRAME_OVERLAP, m_PipelineCache.GetHandle(), m_DescriptorSetLayout, m_RenderObjectsSetLayout);
+
+	m_MainDeletionQueue.PushFunction([=]
+	{
+		m_ShadowMaps.Shutdown();
+	});
+
+	// The shadow data and the shadow maps are part of the frame descriptor set.
+	const VkDescriptorImageInfo ShadowMapInfo = m_ShadowMaps.GetShadowMapImageInfo();
+	for (size_t i = 0; i < FRAME_OVERLAP; ++i)
+	{
+		const VkDescriptorBufferInfo ShadowBufferInfo = m_ShadowMaps.GetShadowBufferInfo(static_cast<uint32_t>(i));
+
+		const std::array<VkWriteDescriptorSet, 2> Writes =
+		{
+			vkinit::WriteDescriptorBuffer(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_FramesData[i].DescriptorSet, const_cast<VkDescriptorBufferInfo*>(&ShadowBufferInfo), 1),
+			vkinit::WriteDescriptorImage(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, m_FramesData[i].DescriptorSet, const_cast<VkDescriptorImageInfo*>(&ShadowMapInfo), 2)
+		};
+
+		vkUpdateDescriptorSets(m_pVulkanDevice->m_Device, static_cast<uint32_t>(Writes.size()), Writes.data(), 0, nullptr);
 	}
+}
 
-	InitRenderPath(NewRenderPath);
+void CVulkanBackend::InitDynamicResolution()
+{
+	m_DynamicResolution.Initialize(m_pVulkanDevice, FRAME_OVERLAP);
 
-	return NewRenderPath;
+	m_MainDeletionQueue.PushFunction([=]
+	{
+		m_DynamicResolution.Shutdown();
+	});
 }
 
-void CVulkanBackend::InitRenderPath(IRenderPath* aRenderPath)
+void CVulkanBackend::InitRenderPaths()
 {
-	if (aRenderPath == nullptr)
-		return;
+	m_RenderPaths[static_cast<size_t>(eRenderPath::FORWARD)] = new CVulkanForwardRenderPath(this, m_pVulkanDevice, m_pVulkanSwapchain);
+	m_RenderPaths[static_cast<size_t>(eRenderPath::DEFERRED)] = new CVulkanDeferredRenderPath(this, m_pVulkanDevice, m_pVulkanSwapchain, false, SGS_COMPACT_GBUFFER != 0);
+	m_RenderPaths[static_cast<size_t>(eRenderPath::DEFERRED_SINGLE_PASS)] = new CVulkanDeferredRenderPath(this, m_pVulkanDevice, m_pVulkanSwapchain, true, SGS_COMPACT_GBUFFER != 0);
 
-	if (m_pCurrentRenderPath)
+	for (IRenderPath* pRenderPath : m_RenderPaths)
 	{
-		m_pCurrentRenderPath->DestroyResources();
-		delete m_pCurrentRenderPath;
-		m_pCurrentRenderPath = nullptr;
+		pRenderPath->CreateResources();
 	}
 
-	m_pCurrentRenderPath = aRenderPath;
-	m_pCurrentRenderPath->CreateResources();
-	m_pCurrentRenderPath->HandleSceneChanged();
+	// Pipeline compilation is the expensive part, build every pipeline of every path at the same time.
+	const auto StartTime = std::chrono::high_resolution_clock::now();
+
+	sJobCounter PipelinesCounter;
+	for (IRenderPath* pRenderPath : m_RenderPaths)
+	{
+		pRenderPath->CreatePipelines(PipelinesCounter);
+	}
+	jobs::Wait(PipelinesCounter);
+
+	const auto ElapsedMs = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - StartTime).count();
+	SGSINFO("Pipelines built in %.2f ms.", ElapsedMs);
+
+	// Persist right away, a crash later on should not throw the compiled pipelines away.
+	m_PipelineCache.Save();
+}
+
+void CVulkanBackend::DestroyRenderPaths()
+{
+	for (IRenderPath*& pRenderPath : m_RenderPaths)
+	{
+		if (pRenderPath)
+		{
+			pRenderPath->DestroyResources();
+			delete pRenderPath;
+			pRenderPath = nullptr;
+		}
+	}
+	m_pCurrentRenderPath = nullptr;
 }
 
 void CVulkanBackend::CreateSceneDescriptorSets()
 {
-	VkDescriptorSetAllocateInfo MaterialsAllocInfo = {};
-	MaterialsAllocInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO;
-	MaterialsAllocInfo.descriptorPool = m_MaterialsPool;
-	MaterialsAllocInfo.descriptorSetCount = 1;
-	MaterialsAllocInfo.pSetLayouts = &m_MaterialsSetLayout;
-	
 	// TODO: Maybe a unique descriptor with ALL the materials and each mesh reference them by an index?
-	for (auto& MaterialDescriptorTuple : m_MaterialDescriptors)
+	for (sMaterialDescriptor* MaterialDescriptor : m_MaterialDescriptors)
 	{
-		auto& MaterialDescriptor = MaterialDescriptorTuple.second;
+		if (MaterialDescriptor == nullptr)
+		{
+			continue;
+		}
 
-		VK_CHECK(vkAllocateDescriptorSets(m_pVulkanDevice->m_Device, &MaterialsAllocInfo, &MaterialDescriptor->DescriptorSet));
-	
 		const sMaterialResources& Resources = MaterialDescriptor->Resources;
 
-		VkDescriptorBufferInfo ConstantsBufferInfo = {};
-		ConstantsBufferInfo.buffer = MaterialDescriptor->ConstantsBuffer.Buffer;
-		ConstantsBufferInfo.offset = 0;
-		ConstantsBufferInfo.range = sizeof(sMaterialConstants);
-
-		VkDescriptorImageInfo AlbedoImageInfo = {};
-		AlbedoImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		AlbedoImageInfo.imageView = Resources.pAlbedoTexture->GetImageView();
-		AlbedoImageInfo.sampler = m_DefaultSampler;
-
-		VkDescriptorImageInfo MetalRoughnessImageInfo = {};
-		MetalRoughnessImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		MetalRoughnessImageInfo.imageView = Resources.pMetalRoughnessTexture->GetImageView();
-		MetalRoughnessImageInfo.sampler = m_DefaultSampler;
-
-		VkDescriptorImageInfo EmissiveImageInfo = {};
-		EmissiveImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		EmissiveImageInfo.imageView = Resources.pEmissiveTexture->GetImageView();
-		EmissiveImageInfo.sampler = m_DefaultSampler;
-
-		VkDescriptorImageInfo NormalImageInfo = {};
-		NormalImageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-		NormalImageInfo.imageView = Resources.pNormalTexture->GetImageView();
-		NormalImageInfo.sampler = m_DefaultSampler;
-
-		std::array<VkDescriptorImageInfo, 3> DescriptorImageInfos = { AlbedoImageInfo, MetalRoughnessImageInfo, NormalImageInfo };
-
-		VkWriteDescriptorSet MaterialImagesDescriptorWrite = {};
-		MaterialImagesDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		MaterialImagesDescriptorWrite.dstSet = MaterialDescriptor->DescriptorSet;
-		MaterialImagesDescriptorWrite.dstBinding = 1;
-		MaterialImagesDescriptorWrite.dstArrayElement = 0;
-		MaterialImagesDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-		MaterialImagesDescriptorWrite.descriptorCount = static_cast<uint32_t>(DescriptorImageInfos.size()); // Add one for the buffer descriptor.
-		MaterialImagesDescriptorWrite.pBufferInfo = nullptr;
-		MaterialImagesDescriptorWrite.pImageInfo = DescriptorImageInfos.data();
-		MaterialImagesDescriptorWrite.pTexelBufferView = nullptr;
-
-		VkWriteDescriptorSet MaterialConstantsDescriptorWrite = {};
-		MaterialConstantsDescriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
-		MaterialConstantsDescriptorWrite.dstSet = MaterialDescriptor->DescriptorSet;
-		MaterialConstantsDescriptorWrite.dstBinding = 0;
-		MaterialConstantsDescriptorWrite.dstArrayElement = 0;
-		MaterialConstantsDescriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
-		MaterialConstantsDescriptorWrite.descriptorCount = 1; // Add one for the buffer descriptor.
-		MaterialConstantsDescriptorWrite.pBufferInfo = &ConstantsBufferInfo;
-		MaterialConstantsDescriptorWrite.pImageInfo = nullptr;
-		MaterialConstantsDescriptorWrite.pTexelBufferView = nullptr;
-
-		std::array<VkWriteDescriptorSet, 2> Writes = { MaterialImagesDescriptorWrite, MaterialConstantsDescriptorWrite };
+		sDescriptorSetDesc Desc(m_MaterialsSetLayout);
+		Desc.AddBuffer(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, MaterialDescriptor->ConstantsBuffer.Buffer, 0, sizeof(sMaterialConstants));
+		Desc.AddImage(1, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Resources.pAlbedoTexture->GetImageView(), m_DefaultSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		Desc.AddImage(2, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Resources.pMetalRoughnessTexture->GetImageView(), m_DefaultSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		Desc.AddImage(3, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Resources.pEmissiveTexture->GetImageView(), m_DefaultSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+		Desc.AddImage(4, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, Resources.pNormalTexture->GetImageView(), m_DefaultSampler, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
 
-		vkUpdateDescriptorSets(m_pVulkanDevice->m_Device, static_cast<uint32_t>(Writes.size()), Writes.data(), 0, nullptr);
+		// The materials of the previous scenes keep their set, only the new ones allocate.
+		MaterialDescriptor->DescriptorSet = m_DescriptorSetCache.GetSet(Desc);
 	}
 }
 
-void CVulkanBackend::UpdateFrameUBO(const CCamera* const aCamera, uint32_t ImageIdx)
+void CVulkanBackend::UpdateFrameData(const sFramePacket& aFramePacket, uint32_t aFrameIdx)
 {
-	assert(ImageIdx >= 0 && ImageIdx < FRAME_OVERLAP);
+	assert(aFrameIdx < m_NumFramesInFlight);
+
+	// The fence was waited and a swapchain image acquired, the frame can be recorded from now on. Everything before
+	// the waits is CPU work on the frame, on the main thread and on this one.
+	if (m_pFramePacer)
+	{
+		const uint64_t ReadyNs = profiler::GetTimeNs();
+		const uint64_t MainThreadNs = aFramePacket.SubmitTimeNs - aFramePacket.InputTimeNs;
+		const uint64_t MainThreadWorkNs = MainThreadNs > aFramePacket.PacketWaitNs ? MainThreadNs - aFramePacket.PacketWaitNs : 0;
+		m_pFramePacer->ReportFrameReady(aFramePacket, MainThreadWorkNs + (m_FrameWaitStartNs - m_RenderStartNs), ReadyNs);
+	}
+
+	// The frame that used this slot before is done on the GPU, nothing allocated for it is needed anymore.
+	m_FramesData[aFrameIdx].FrameAllocator.Reset();
+
+	// Neither are the objects released up to that frame.
+	CVulkanDeletionQueue& FrameDeletionQueue = m_pVulkanDevice->m_FrameDeletionQueue;
+	FrameDeletionQueue.CollectGarbage(m_FramesData[aFrameIdx].FrameNumber);
+	m_FramesData[aFrameIdx].FrameNumber = FrameDeletionQueue.BeginFrame();
+	m_pVulkanDevice->m_MemoryAllocator.UpdateBudgets(static_cast<uint32_t>(m_FramesData[aFrameIdx].FrameNumber));
+
+	// The fence of the frame was waited, its GPU time is known. The clusters are laid out over the new render extent.
+	m_DynamicResolution.Update(aFrameIdx);
+
+	// Latency of the last frame of this slot, from its input to the end of its GPU work. The GPU clock is calibrated
+	// against the CPU one only once and may drift, the fence being seen signaled bounds the end. Without timestamps
+	// that is the end, an upper bound.
+	if (m_pFramePacer && m_FramesData[aFrameIdx].InputTimeNs != 0)
+	{
+		uint64_t FrameEndNs = m_DynamicResolution.GetLastFrameEndNs();
+		if (FrameEndNs == 0 || FrameEndNs > m_FrameFenceSignaledNs)
+		{
+			FrameEndNs = m_FrameFenceSignaledNs;
+		}
+
+		if (FrameEndNs > m_FramesData[aFrameIdx].InputTimeNs)
+		{
+			m_pFramePacer->ReportLatency(FrameEndNs - m_FramesData[aFrameIdx].InputTimeNs);
+		}
+	}
+	m_FramesData[aFrameIdx].InputTimeNs = aFramePacket.InputTimeNs;
+	const VkExtent2D RenderExtent = m_DynamicResolution.GetRenderExtent(m_pVulkanSwapchain->m_WindowExtent);
+
+	// The projection has no far plane, but the light clusters and the draw sort keys still need a depth range. Whatever
+	// is further shares their last slice.
+	const float MaxViewDepth = 1000.0f;
+	const float AspectRatio = m_pVulkanSwapchain->m_WindowExtent.width / (float)m_pVulkanSwapchain->m_WindowExtent.height;
 
 	sCameraFrameUBO FrameUBO = {};
-	FrameUBO.View = aCamera->GetViewMatrix();
-	// TODO: Do not hardcode this.
-	FrameUBO.Proj = glm::perspective(glm::radians(90.0f), m_pVulkanSwapchain->m_WindowExtent.width / (float)m_pVulkanSwapchain->m_WindowExtent.height, 0.1f, 1000.0f);
+	FrameUBO.View = aFramePacket.View;
+	FrameUBO.Proj = aFramePacket.Proj;
+	// Y points down in the Vulkan clip space.
 	FrameUBO.Proj[1][1] *= -1;
 	FrameUBO.ViewProj = FrameUBO.Proj * FrameUBO.View;
-	FrameUBO.Pos = aCamera->GetPosition();
+	FrameUBO.InvViewProj = glm::inverse(FrameUBO.ViewProj);
+	FrameUBO.Pos = aFramePacket.CameraPosition;
 
-	memcpy(m_FramesData[ImageIdx].MappedUBOBuffer, &FrameUBO, sizeof(sCameraFrameUBO));
+	memcpy(m_FramesData[aFrameIdx].MappedUBOBuffer, &FrameUBO, sizeof(sCameraFrameUBO));
+
+	// There is a draw call per CMeshNode, the packet holds a transform for each of them in draw order.
+	static_assert(sizeof(sGPURenderObjectData) == sizeof(glm::mat4), "The object transforms are copied as they are.");
+	const size_t NumObjects = std::min(aFramePacket.ObjectTransforms.size(), static_cast<size_t>(MAX_RENDER_OBJECTS));
+	if (NumObjects < aFramePacket.ObjectTransforms.size())
+	{
+		SGSWARN_THROTTLED(1000, "The frame has %zu objects, only the first %u are drawn.", aFramePacket.ObjectTransforms.size(), MAX_RENDER_OBJECTS);
+	}
+	memcpy(m_FramesData[aFrameIdx].MappedObjectsBuffer, aFramePacket.ObjectTransforms.data(), NumObjects * sizeof(sGPURenderObjectData));
+
+	m_FramesData[aFrameIdx].DrawList.Build(m_Renderables, aFramePacket, static_cast<uint32_t>(NumObjects), MaxViewDepth, m_FramesData[aFrameIdx].FrameAllocator);
+
+	m_ClusteredLighting.UpdateFrame(aFrameIdx, aFramePacket, FrameUBO.View, FrameUBO.Proj, aFramePacket.NearPlane, MaxViewDepth, RenderExtent);
+	m_Skinning.UpdateFrame(aFrameIdx, aFramePacket);
+	m_ShadowMaps.UpdateFrame(aFrameIdx, aFramePacket, FrameUBO.View, aFramePacket.FovY, AspectRatio, aFramePacket.NearPlane);
 }
 
-bool CVulkanBackend::HasStencilComponent(VkFormat aFormat)
+void CVulkanBackend::SubmitAsyncCompute(uint32_t aFrameIdx)
 {
-	return aFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || aFormat == VK_FORMAT_D24_UNORM_S8_UINT;
+	SGS_PROFILE_FUNCTION();
+
+	if (!m_AsyncCompute.IsEnabled())
+	{
+		return;
+	}
+
+	const VkCommandBuffer ComputeCmdBuffer = m_AsyncCompute.BeginFrame(aFrameIdx);
+	m_ClusteredLighting.RecordAsyncCulling(ComputeCmdBuffer, aFrameIdx, m_AsyncCompute);
+	m_AsyncCompute.Submit(aFrameIdx);
 }
 
-void CVulkanBackend::AddTransformsToBuffer(sGPURenderObjectData* apBuffer, size_t& aIndex, CMeshNode* apMeshNode)
+void CVulkanBackend::RecordComputePasses(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx)
 {
-	for (const auto& MeshNode : apMeshNode->m_Children)
+	if (m_AsyncCompute.IsEnabled())
 	{
-		AddTransformsToBuffer(apBuffer, aIndex, MeshNode);
+		m_ClusteredLighting.RecordAcquire(aCmdBuffer, aFrameIdx, m_AsyncCompute);
 	}
+	else
+	{
+		m_ClusteredLighting.RecordCulling(aCmdBuffer, aFrameIdx);
+	}
+}
 
-	apBuffer[aIndex].ModelMatrix = apMeshNode->GetWorldTransform();
-	++aIndex;
+bool CVulkanBackend::HasStencilComponent(VkFormat aFormat)
+{
+	return aFormat == VK_FORMAT_D32_SFLOAT_S8_UINT || aFormat == VK_FORMAT_D24_UNORM_S8_UINT;
 }
@@ -1,16 +1,32 @@
 #pragma once
 
 #include "vk_types.hpp"
+#include "vk_pipeline_cache.hpp"
+#include "vk_descriptors.hpp"
+#include "vk_async_compute.hpp"
+#include "vk_clustered_lighting.hpp"
+#include "vk_skinning.hpp"
+#include "vk_shadow_maps.hpp"
+#include "vk_dynamic_resolution.hpp"
+#include "vk_draw_packets.hpp"
 #include "renderer/scene.hpp"
+#include "renderer/frame_packet.hpp"
+#include "renderer/frame_pacer.hpp"
 #include <core/types.hpp>
+#include <core/linear_allocator.hpp>
+
+#include <atomic>
 
 class CVulkanDevice;
 class CVulkanSwapchain;
 class CCamera;
 class IRenderPath;
 class CRenderable;
+class CVkTexture;
 
 constexpr uint32_t MAX_RENDER_OBJECTS = 1024;
+// Maximum frames in flight, the data of every frame is created for it. How many are used is picked at runtime (see
+// sFramePacingSettings::FramesInFlight).
 constexpr uint32_t FRAME_OVERLAP = 3;
 
 struct sFrameData
@@ -23,6 +39,18 @@ struct sFrameData
     AllocatedBuffer UBOBuffer;
     void* MappedUBOBuffer;
     VkDescriptorSet DescriptorSet;
+    // Transforms of the objects, rewritten every frame from the frame packet.
+    AllocatedBuffer ObjectsBuffer;
+    void* MappedObjectsBuffer;
+    VkDescriptorSet ObjectsDescriptorSet;
+    // Transient CPU allocations of the frame (culling lists, sort keys...), reset once its fence is signaled.
+    CLinearAllocator FrameAllocator;
+    // Sorted draws of the scene passes, allocated from FrameAllocator.
+    CVulkanDrawList DrawList;
+    // Number of the last frame recorded with this data (see CVulkanDeletionQueue::BeginFrame()).
+    uint64_t FrameNumber = 0;
+    // When the input of that frame was sampled, its latency is measured once its fence is signaled.
+    uint64_t InputTimeNs = 0;
 };
 
 struct sGPURenderObjectData
@@ -35,6 +63,8 @@ struct sCameraFrameUBO
     glm::mat4 View;
     glm::mat4 Proj;
     glm::mat4 ViewProj;
+    // Used to reconstruct world positions from depth.
+    glm::mat4 InvViewProj;
     glm::vec3 Pos;
 };
 
@@ -49,7 +79,11 @@ public:
     
     bool Initialize();
 
-    void Render(const CCamera* const aCamera);
+    /**
+     * @brief Records and submits the frame described by aFramePacket. Called from the render thread, it only reads
+     * the packet and the renderer state, never the scene.
+     */
+    void Render(const sFramePacket& aFramePacket);
 
     bool Shutdown();
 
@@ -57,28 +91,70 @@ public:
 
     void CreateRenderablesData(const std::vector<CRenderable *> &aRenderables);
 
-    void ChangeRenderPath();
+    void ChangeRenderPath(eRenderPath aRenderPath);
 
     CVulkanDevice *GetDevice() const { return m_pVulkanDevice; }
 
+    /**
+     * @brief Pacer the render thread reports the frames to, can be null. Must outlive the backend.
+     */
+    void SetFramePacer(CFramePacer* apFramePacer) { m_pFramePacer = apFramePacer; }
+
+    /**
+     * @brief Allocator for the data that only lives while the current frame is recorded and in flight.
+     * Only usable from the render thread.
+     */
+    CLinearAllocator& GetFrameAllocator() { return m_FramesData[m_CurrentFrame].FrameAllocator; }
+
 private:
     void InitCommandPools();
     void InitSyncStructures();
+    void InitFrameAllocators();
     void InitTextureSamplers();
+    void InitDefaultTextures();
     void InitDescriptorSetLayouts();
-    void InitDescriptorSetPool();
+    void InitDescriptorAllocators();
     void InitDescriptorSets();
 
-    IRenderPath* CreateRenderPath();
-    void InitRenderPath(IRenderPath* aRenderPath);
+    void InitPipelineCache();
+    void InitAsyncCompute();
+    void InitClusteredLighting();
+    void InitSkinning();
+    void InitShadowMaps();
+    void InitDynamicResolution();
+    void InitRenderPaths();
+    void DestroyRenderPaths();
 
     void CreateSceneDescriptorSets();
-    void UpdateFrameUBO(const CCamera* const aCamera, uint32_t ImageIdx);
+
+    /**
+     * @brief Applies the present mode and frames in flight of the packet. Both wait for the GPU, only when they change.
+     */
+    void ApplyFramePacingSettings(const sFramePacket& aFramePacket);
+
+    /**
+     * @brief Waits for the fence of the current frame, so its data can be reused. Called by the render paths before
+     * acquiring the swapchain image, the waits up to UpdateFrameData() are not counted as CPU work of the frame.
+     */
+    void WaitForFrame();
+    void UpdateFrameData(const sFramePacket& aFramePacket, uint32_t aFrameIdx);
+
+    /**
+     * @brief Records and submits the compute passes of the frame on the compute queue. Does nothing without async
+     * compute. Called after UpdateFrameData(), the graphics submission of the frame must then wait on the semaphore of
+     * m_AsyncCompute.
+     */
+    void SubmitAsyncCompute(uint32_t aFrameIdx);
+
+    /**
+     * @brief Records the compute passes of the frame in the graphics command buffer, or the acquires of their results
+     * when they were submitted to the compute queue.
+     */
+    void RecordComputePasses(VkCommandBuffer aCmdBuffer, uint32_t aFrameIdx);
+    void RecreateSwapchain();
     
     bool HasStencilComponent(VkFormat aFormat);
 
-    void AddTransformsToBuffer(sGPURenderObjectData* apBuffer, size_t& aIndex, CMeshNode* apMeshNode);
-   
     void CreateMaterialDescriptorsFromMeshNodeRecursive(CMeshNode *const &aMeshNode);
     void CreateMaterialDescriptorsFromMeshNode(CMeshNode *const &aMeshNode);
 
@@ -90,29 +166,54 @@ private:
     CVulkanDevice* m_pVulkanDevice;
     CVulkanSwapchain* m_pVulkanSwapchain;
 
+    // Every render path is created at start up and kept alive, so switching between them is instant.
+    IRenderPath* m_RenderPaths[static_cast<size_t>(eRenderPath::NUM)];
     IRenderPath* m_pCurrentRenderPath;
 
+    CVulkanPipelineCache m_PipelineCache;
+    CVulkanAsyncCompute m_AsyncCompute;
+    CVulkanClusteredLighting m_ClusteredLighting;
+    CVulkanSkinning m_Skinning;
+    CVulkanShadowMaps m_ShadowMaps;
+    CVulkanDynamicResolution m_DynamicResolution;
+
     VkDescriptorSetLayout m_DescriptorSetLayout;
     VkDescriptorSetLayout m_RenderObjectsSetLayout;
     VkDescriptorSetLayout m_MaterialsSetLayout;
     VkSampler m_DefaultSampler;
+    // Normal map of the materials without one, every texel points along the vertex normal.
+    CVkTexture* m_pFlatNormalTexture;
 
     VkCommandPool m_CommandPool;
 
-    VkDescriptorPool m_DescriptorPool;
-    VkDescriptorPool m_MaterialsPool;
+    // Layouts of the backend and pass sets, destroyed with the cache.
+    CVulkanDescriptorLayoutCache m_DescriptorLayoutCache;
+    // Sets that live as long as the backend, its passes or the scene. Grows as materials are loaded.
+    CVulkanDescriptorAllocator m_DescriptorAllocator;
+    // Material sets, allocated from m_DescriptorAllocator and reused when a scene asks for the same contents again.
+    CVulkanDescriptorSetCache m_DescriptorSetCache;
 
     sFrameData m_FramesData[FRAME_OVERLAP];
     uint32_t m_CurrentFrame;
+    // Frames used, 1 to FRAME_OVERLAP.
+    uint32_t m_NumFramesInFlight;
+
+    CFramePacer* m_pFramePacer;
+    // Pacing times of the frame being recorded, in profiler::GetTimeNs().
+    uint64_t m_RenderStartNs;
+    uint64_t m_FrameWaitStartNs;
+    uint64_t m_FrameFenceSignaledNs;
 
-    bool m_bWasWindowResized;
+    // Set from the window callback on the main thread, read by the render thread.
+    std::atomic<bool> m_bWasWindowResized;
+    // Framebuffer size of the last frame packet, the swapchain is recreated with it.
+    VkExtent2D m_FramebufferExtent;
 
     // TODO: Some way to represent a Scene.
     std::vector<CVulkanRenderable*> m_Renderables;
-    AllocatedBuffer m_ObjectsDataBuffer;
-    VkDescriptorSet m_ObjectsDataDescriptorSet;
 
-    std::unordered_map<std::string, sMaterialDescriptor*> m_MaterialDescriptors;
+    // Indexed by CMaterial::GetIndex(), null for the materials no renderable uses.
+    std::vector<sMaterialDescriptor*> m_MaterialDescriptors;
     // ------------------------------------
 
     // TODO: To be removed.
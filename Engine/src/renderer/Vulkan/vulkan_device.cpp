@@ -6,6 +6,7 @@
 #include <GLFW/glfw3.h>
 
 #include "core/logger.h"
+#include "core/profiler.hpp"
 #include <iostream>
 
 CVulkanDevice::CVulkanDevice()
@@ -15,6 +16,7 @@ CVulkanDevice::CVulkanDevice()
 
 CVulkanDevice::~CVulkanDevice()
 {
+	m_FrameDeletionQueue.Flush();
 	vkDestroyFence(m_Device, m_UploadContext.m_UploadFence, nullptr);
 	vkDestroyCommandPool(m_Device, m_UploadContext.m_CommandPool, nullptr);
 	vmaDestroyAllocator(m_Allocator);
@@ -72,23 +74,43 @@ void CVulkanDevice::InitVulkanDevice()
 	m_GraphicsQueue = vkbDevice.get_queue(vkb::QueueType::graphics).value();
 	m_GraphicsQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::graphics).value();
 
+	// A family with compute but no graphics, its queues run next to the graphics one. Without one the compute work
+	// goes to the graphics queue.
+	m_ComputeQueue = m_GraphicsQueue;
+	m_ComputeQueueFamily = m_GraphicsQueueFamily;
+#if SGS_ASYNC_COMPUTE
+	auto ComputeQueue = vkbDevice.get_queue(vkb::QueueType::compute);
+	if (ComputeQueue.has_value())
+	{
+		m_ComputeQueue = ComputeQueue.value();
+		m_ComputeQueueFamily = vkbDevice.get_queue_index(vkb::QueueType::compute).value();
+	}
+#endif
+	SGSINFO("Compute queue family %u, graphics queue family %u.", m_ComputeQueueFamily, m_GraphicsQueueFamily);
+
 	VmaAllocatorCreateInfo AllocatorInfo = {};
 	AllocatorInfo.physicalDevice = m_PhysicalDevice;
 	AllocatorInfo.device = m_Device;
 	AllocatorInfo.instance = m_VulkanInstance;
 	AllocatorInfo.flags = VMA_ALLOCATOR_CREATE_BUFFER_DEVICE_ADDRESS_BIT;
 	vmaCreateAllocator(&AllocatorInfo, &m_Allocator);
+	m_MemoryAllocator.Initialize(this);
 
 	VkCommandPoolCreateInfo UploadCommandPoolInfo = vkinit::CommandPoolCreateInfo(m_GraphicsQueueFamily);
 	VK_CHECK(vkCreateCommandPool(m_Device, &UploadCommandPoolInfo, nullptr, &m_UploadContext.m_CommandPool));
 
 	VkFenceCreateInfo UploadFenceInfo = vkinit::FenceCreateInfo();
 	VK_CHECK(vkCreateFence(m_Device, &UploadFenceInfo, nullptr, &m_UploadContext.m_UploadFence));
+
+	m_FrameDeletionQueue.Initialize(this);
 }
 
 void CVulkanDevice::ImmediateSubmit(std::function<void(VkCommandBuffer cmd)>&& aFunction) const
 {
-	SGSDEBUG("Immediate Submit");
+	SGS_PROFILE_FUNCTION();
+	SGSDEBUG_THROTTLED(1000, "Immediate Submit");
+
+	std::lock_guard<std::mutex> Lock(m_UploadContext.m_Mutex);
 
 	VkCommandBufferAllocateInfo CmdAllocInfo = vkinit::CommandBufferAllocateInfo(m_UploadContext.m_CommandPool, 1);
 
@@ -115,8 +137,13 @@ void CVulkanDevice::ImmediateSubmit(std::function<void(VkCommandBuffer cmd)>&& a
 
 VkFormat CVulkanDevice::FindDepthFormat()
 {
-    return FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
+    const VkFormat Format = FindSupportedFormat({VK_FORMAT_D32_SFLOAT, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_FORMAT_D24_UNORM_S8_UINT},
     VK_IMAGE_TILING_OPTIMAL, VK_FORMAT_FEATURE_DEPTH_STENCIL_ATTACHMENT_BIT);
+    if (Format == VK_FORMAT_D24_UNORM_S8_UINT)
+    {
+        SGSWARN("No float depth format available, reversed depth loses most of its precision with D24.");
+    }
+    return Format;
 }
 
 VkFormat CVulkanDevice::FindSupportedFormat(const std::vector<VkFormat>& aCandidates, VkImageTiling aTiling, VkFormatFeatureFlags aFeatures)
@@ -1,12 +1,24 @@
 #pragma once
 
 #include "vk_types.hpp"
+#include "vk_deletion_queue.hpp"
+#include "vk_memory_allocator.hpp"
 #include <core/types.hpp>
 
+#include <mutex>
+
+// Runs the compute passes on a queue family without graphics when the device has one, see CVulkanAsyncCompute.
+// Can be overridden at build time (/DSGS_ASYNC_COMPUTE=0).
+#ifndef SGS_ASYNC_COMPUTE
+#define SGS_ASYNC_COMPUTE 1
+#endif
+
 struct sUploadContext
 {
     VkFence m_UploadFence;
     VkCommandPool m_CommandPool;
+    // Serializes immediate submits coming from different threads (the pool and the fence are shared).
+    mutable std::mutex m_Mutex;
 };
 
 class CVulkanDevice
@@ -19,8 +31,16 @@ public:
 
     void ImmediateSubmit(std::function<void(VkCommandBuffer cmd)>&& aFunction) const;
     
+    /**
+     * @brief Depth format of the scene. Float formats come first, the reversed depth relies on their precision near 0.
+     */
     VkFormat FindDepthFormat();
     VkFormat FindSupportedFormat(const std::vector<VkFormat>& aCandidates, VkImageTiling aTiling, VkFormatFeatureFlags aFeatures);
+
+    /**
+     * @brief Whether m_ComputeQueue belongs to another family than m_GraphicsQueue. Otherwise both are the same queue.
+     */
+    bool HasAsyncCompute() const { return m_ComputeQueueFamily != m_GraphicsQueueFamily; }
     
     // Vulkan Core.
     VkInstance m_VulkanInstance;
@@ -28,10 +48,17 @@ public:
     VkDevice m_Device;
     VkSurfaceKHR m_Surface;
     VmaAllocator m_Allocator;
+    // Every allocation goes through it instead of m_Allocator, to keep track of the GPU memory. Mutable as the
+    // helpers creating resources take a const device.
+    mutable CVulkanMemoryAllocator m_MemoryAllocator;
     VkDebugUtilsMessengerEXT m_DebugMessenger;
     sDeletionQueue m_MainDeletionQueue;
+    // Objects released at runtime, destroyed once the frames that may use them are done.
+    CVulkanDeletionQueue m_FrameDeletionQueue;
     VkQueue m_GraphicsQueue;
     uint32_t m_GraphicsQueueFamily;
+    VkQueue m_ComputeQueue;
+    uint32_t m_ComputeQueueFamily;
     sUploadContext m_UploadContext;
 
 private:
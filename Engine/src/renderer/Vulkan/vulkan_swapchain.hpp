@@ -11,19 +11,27 @@ public:
     ~CVulkanSwapchain();
 
     void InitVulkanSwapchain();
-    void RecreateSwapchain();
+    /**
+     * @brief Recreates the swapchain with aExtent, the framebuffer size of the window. Can be called from the render
+     * thread, it does not touch the window. aExtent must not be empty.
+     */
+    void RecreateSwapchain(VkExtent2D aExtent);
+
+    /**
+     * @brief Present mode of the swapchains created from now on, the current one must be recreated to use it.
+     */
+    void SetPresentMode(ePresentMode aPresentMode) { m_RequestedPresentMode = aPresentMode; }
+    ePresentMode GetRequestedPresentMode() const { return m_RequestedPresentMode; }
 
 private:
-    void InitSwapchain();
-    // TODO: Can we move it to vulkan backend? Swapchain probably should not have info about the render passes and its attachments.
-    void InitRenderPass();
-    void InitDepthBuffer();
-    void InitFramebuffers();
+    void InitSwapchain(VkExtent2D aExtent);
 
     void CleanupSwapchain();
 
     CVulkanDevice* m_VulkanDevice;
 
+    ePresentMode m_RequestedPresentMode = ePresentMode::FIFO;
+
 public:
     // Swapchain.
     VkSwapchainKHR m_Swapchain;
@@ -31,15 +39,10 @@ public:
     std::vector<VkImage> m_SwapchainImages;
     std::vector<VkImageView> m_SwapchainImageViews;
     uint32_t m_ImageIdx;
+    // The one requested if supported, FIFO otherwise.
+    VkPresentModeKHR m_PresentMode = VK_PRESENT_MODE_FIFO_KHR;
     // ------------
 
-    // Render passes.
-    VkRenderPass m_RenderPass;
-    std::vector<VkFramebuffer> m_Framebuffers;
-    // ------------
-
-    AllocatedImage m_DepthImage;
-    VkImageView m_DepthImageView;
-
+    // Render passes, framebuffers and depth buffers are owned by the render graph of each render path.
     VkExtent2D m_WindowExtent = { 800, 600 };
 };
\ No newline at end of file
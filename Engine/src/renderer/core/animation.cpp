@@ -0,0 +1,208 @@
+#include "animation.hpp"
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if SGS_ANIMATION_SIMD
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+#if SGS_ANIMATION_SIMD
+    inline __m128 Load(const glm::vec4& aVector) { return _mm_loadu_ps(&aVector.x); }
+
+    // Dot product broadcast to the four lanes.
+    inline __m128 Dot4(__m128 aA, __m128 aB)
+    {
+        __m128 Product = _mm_mul_ps(aA, aB);
+        Product = _mm_add_ps(Product, _mm_shuffle_ps(Product, Product, _MM_SHUFFLE(2, 3, 0, 1)));
+        return _mm_add_ps(Product, _mm_shuffle_ps(Product, Product, _MM_SHUFFLE(1, 0, 3, 2)));
+    }
+
+    inline __m128 Lerp(__m128 aA, __m128 aB, __m128 aT)
+    {
+        return _mm_add_ps(aA, _mm_mul_ps(_mm_sub_ps(aB, aA), aT));
+    }
+
+    inline __m128 NlerpQuat(__m128 aA, __m128 aB, __m128 aT)
+    {
+        // q and -q are the same rotation, B is moved to the hemisphere of A so the blend takes the shortest arc.
+        const __m128 SignMask = _mm_and_ps(Dot4(aA, aB), _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32>(0x80000000))));
+        const __m128 Blended = Lerp(aA, _mm_xor_ps(aB, SignMask), aT);
+        return _mm_div_ps(Blended, _mm_sqrt_ps(Dot4(Blended, Blended)));
+    }
+#endif
+
+    inline glm::vec4 LerpVector(const glm::vec4& aA, const glm::vec4& aB, float aT)
+    {
+#if SGS_ANIMATION_SIMD
+        glm::vec4 Result;
+        _mm_storeu_ps(&Result.x, Lerp(Load(aA), Load(aB), _mm_set1_ps(aT)));
+        return Result;
+#else
+        return glm::mix(aA, aB, aT);
+#endif
+    }
+
+    inline glm::vec4 NlerpQuatVector(const glm::vec4& aA, const glm::vec4& aB, float aT)
+    {
+#if SGS_ANIMATION_SIMD
+        glm::vec4 Result;
+        _mm_storeu_ps(&Result.x, NlerpQuat(Load(aA), Load(aB), _mm_set1_ps(aT)));
+        return Result;
+#else
+        const glm::vec4 B = glm::dot(aA, aB) < 0.0f ? -aB : aB;
+        return glm::normalize(glm::mix(aA, B, aT));
+#endif
+    }
+
+    /**
+     * @brief aOut = aA * aB. aOut may be either of the inputs.
+     */
+    inline void Multiply(const glm::mat4& aA, const glm::mat4& aB, glm::mat4& aOut)
+    {
+#if SGS_ANIMATION_SIMD
+        // Every column of the result is a combination of the columns of aA weighted by a column of aB.
+        const __m128 A0 = _mm_loadu_ps(&aA[0][0]);
+        const __m128 A1 = _mm_loadu_ps(&aA[1][0]);
+        const __m128 A2 = _mm_loadu_ps(&aA[2][0]);
+        const __m128 A3 = _mm_loadu_ps(&aA[3][0]);
+        for (int32 Column = 0; Column < 4; ++Column)
+        {
+            const __m128 B = _mm_loadu_ps(&aB[Column][0]);
+            __m128 Result = _mm_mul_ps(A0, _mm_shuffle_ps(B, B, _MM_SHUFFLE(0, 0, 0, 0)));
+            Result = _mm_add_ps(Result, _mm_mul_ps(A1, _mm_shuffle_ps(B, B, _MM_SHUFFLE(1, 1, 1, 1))));
+            Result = _mm_add_ps(Result, _mm_mul_ps(A2, _mm_shuffle_ps(B, B, _MM_SHUFFLE(2, 2, 2, 2))));
+            Result = _mm_add_ps(Result, _mm_mul_ps(A3, _mm_shuffle_ps(B, B, _MM_SHUFFLE(3, 3, 3, 3))));
+            _mm_storeu_ps(&aOut[Column][0], Result);
+        }
+#else
+        aOut = aA * aB;
+#endif
+    }
+
+    /**
+     * @brief Translation * Rotation * Scale of a pose.
+     */
+    glm::mat4 ComposeMatrix(const sJointPose& aPose)
+    {
+        const float x = aPose.Rotation.x;
+        const float y = aPose.Rotation.y;
+        const float z = aPose.Rotation.z;
+        const float w = aPose.Rotation.w;
+
+        glm::mat4 Matrix;
+        Matrix[0] = glm::vec4(1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y), 0.0f) * aPose.Scale.x;
+        Matrix[1] = glm::vec4(2.0f * (x * y - w * z), 1.0f - 2.0f * (x * x + z * z), 2.0f * (y * z + w * x), 0.0f) * aPose.Scale.y;
+        Matrix[2] = glm::vec4(2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y), 0.0f) * aPose.Scale.z;
+        Matrix[3] = glm::vec4(glm::vec3(aPose.Translation), 1.0f);
+        return Matrix;
+    }
+
+    glm::vec4 SampleTrack(const sAnimationTrack& aTrack, float aTime)
+    {
+        const std::vector<float>& Times = aTrack.Times;
+        if (Times.size() == 1 || aTime <= Times.front())
+        {
+            return aTrack.Values.front();
+        }
+        if (aTime >= Times.back())
+        {
+            return aTrack.Values.back();
+        }
+
+        // Times[Previous] <= aTime < Times[Next].
+        const size_t Next = static_cast<size_t>(std::upper_bound(Times.begin(), Times.end(), aTime) - Times.begin());
+        const size_t Previous = Next - 1;
+        if (aTrack.Interpolation == eAnimationInterpolation::STEP)
+        {
+            return aTrack.Values[Previous];
+        }
+
+        const float T = (aTime - Times[Previous]) / (Times[Next] - Times[Previous]);
+        return aTrack.Path == eAnimationPath::ROTATION ? NlerpQuatVector(aTrack.Values[Previous], aTrack.Values[Next], T) :
+            LerpVector(aTrack.Values[Previous], aTrack.Values[Next], T);
+    }
+}
+
+void animation::SampleClip(const sSkeleton& aSkeleton, const sAnimationClip& aClip, float aTime, sJointPose* apOutPose)
+{
+    std::copy(aSkeleton.RestPose.begin(), aSkeleton.RestPose.end(), apOutPose);
+
+    float Time = 0.0f;
+    if (aClip.Duration > 0.0f)
+    {
+        Time = std::fmod(aTime, aClip.Duration);
+        Time = Time < 0.0f ? Time + aClip.Duration : Time;
+    }
+
+    for (const sAnimationTrack& Track : aClip.Tracks)
+    {
+        assert(Track.Joint < aSkeleton.GetNumJoints() && !Track.Times.empty());
+
+        sJointPose& Pose = apOutPose[Track.Joint];
+        const glm::vec4 Value = SampleTrack(Track, Time);
+        switch (Track.Path)
+        {
+        case eAnimationPath::TRANSLATION:
+            Pose.Translation = Value;
+            break;
+        case eAnimationPath::ROTATION:
+            Pose.Rotation = Value;
+            break;
+        case eAnimationPath::SCALE:
+            Pose.Scale = Value;
+            break;
+        }
+    }
+}
+
+void animation::BlendPoses(const sJointPose* apPoseA, const sJointPose* apPoseB, float aWeight, uint32 aNumJoints, sJointPose* apOutPose)
+{
+#if SGS_ANIMATION_SIMD
+    const __m128 Weight = _mm_set1_ps(aWeight);
+    for (uint32 i = 0; i < aNumJoints; ++i)
+    {
+        const sJointPose& A = apPoseA[i];
+        const sJointPose& B = apPoseB[i];
+        const __m128 Rotation = NlerpQuat(Load(A.Rotation), Load(B.Rotation), Weight);
+        const __m128 Translation = Lerp(Load(A.Translation), Load(B.Translation), Weight);
+        const __m128 Scale = Lerp(Load(A.Scale), Load(B.Scale), Weight);
+
+        sJointPose& Out = apOutPose[i];
+        _mm_storeu_ps(&Out.Rotation.x, Rotation);
+        _mm_storeu_ps(&Out.Translation.x, Translation);
+        _mm_storeu_ps(&Out.Scale.x, Scale);
+    }
+#else
+    for (uint32 i = 0; i < aNumJoints; ++i)
+    {
+        const sJointPose& A = apPoseA[i];
+        const sJointPose& B = apPoseB[i];
+        sJointPose& Out = apOutPose[i];
+        Out.Rotation = NlerpQuatVector(A.Rotation, B.Rotation, aWeight);
+        Out.Translation = LerpVector(A.Translation, B.Translation, aWeight);
+        Out.Scale = LerpVector(A.Scale, B.Scale, aWeight);
+    }
+#endif
+}
+
+void animation::ComputeSkinningMatrices(const sSkeleton& aSkeleton, const sJointPose* apPose, glm::mat4* apOutMatrices)
+{
+    const uint32 NumJoints = aSkeleton.GetNumJoints();
+
+    // World transforms first. The parents come before their children, theirs are always ready.
+    for (uint32 i = 0; i < NumJoints; ++i)
+    {
+        const int32 Parent = aSkeleton.ParentIndices[i];
+        Multiply(Parent < 0 ? aSkeleton.RootTransform : apOutMatrices[Parent], ComposeMatrix(apPose[i]), apOutMatrices[i]);
+    }
+
+    // No child reads them anymore, they can be turned into skinning matrices in place.
+    for (uint32 i = 0; i < NumJoints; ++i)
+    {
+        Multiply(apOutMatrices[i], aSkeleton.InverseBindMatrices[i], apOutMatrices[i]);
+    }
+}
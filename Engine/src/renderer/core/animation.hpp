@@ -0,0 +1,108 @@
+#pragma once
+
+#include <core/defines.h>
+
+#include <glm/glm.hpp>
+
+#include <string>
+#include <vector>
+
+// SSE pose blending and matrix products, the scalar ones are used otherwise. Can be overridden at build time.
+#ifndef SGS_ANIMATION_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SGS_ANIMATION_SIMD 1
+#else
+#define SGS_ANIMATION_SIMD 0
+#endif
+#endif
+
+// Skins with more joints are not imported, it bounds the poses the animation system keeps on the stack.
+constexpr uint32 MAX_SKELETON_JOINTS = 256;
+
+/**
+ * @brief Transform of a joint relative to its parent. Rotation is a quaternion stored as (x, y, z, w), the w of
+ * Translation and Scale is unused. Every member is four floats, so poses are blended a vector at a time.
+ */
+struct alignas(16) sJointPose
+{
+    glm::vec4 Rotation = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    glm::vec4 Translation = glm::vec4(0.0f);
+    glm::vec4 Scale = glm::vec4(1.0f, 1.0f, 1.0f, 0.0f);
+};
+
+/**
+ * @brief Joint hierarchy of a skinned renderable. The joints are sorted so that parents come before their children,
+ * the joint indices of the vertices (sSkinVertex) are already remapped to this order.
+ *
+ * Matrices follow the glTF convention (world = parent * local), the skinning matrices bring the bind pose vertices to
+ * the space of the mesh node, whose transform is applied by the draw as for any other mesh.
+ */
+struct sSkeleton
+{
+    uint32 GetNumJoints() const { return static_cast<uint32>(ParentIndices.size()); }
+
+    // Index of the parent joint, -1 for the roots.
+    std::vector<int32> ParentIndices;
+    std::vector<glm::mat4> InverseBindMatrices;
+    // Pose of the joints the clips do not animate.
+    std::vector<sJointPose> RestPose;
+    std::vector<std::string> JointNames;
+    // Parent of the roots: the inverse world transform of the skinned mesh node times the world transform of the node
+    // the root joints hang from.
+    glm::mat4 RootTransform = glm::mat4(1.0f);
+};
+
+enum class eAnimationPath : uint8
+{
+    TRANSLATION = 0,
+    ROTATION,
+    SCALE
+};
+
+enum class eAnimationInterpolation : uint8
+{
+    STEP = 0,
+    LINEAR
+};
+
+/**
+ * @brief Keyframes of a property of a joint. Times are in seconds and ascending, Values holds one vector per time,
+ * laid out as the matching member of sJointPose.
+ */
+struct sAnimationTrack
+{
+    uint32 Joint = 0;
+    eAnimationPath Path = eAnimationPath::TRANSLATION;
+    eAnimationInterpolation Interpolation = eAnimationInterpolation::LINEAR;
+    std::vector<float> Times;
+    std::vector<glm::vec4> Values;
+};
+
+struct sAnimationClip
+{
+    std::string Name;
+    // Time of the last keyframe, the clip loops after it.
+    float Duration = 0.0f;
+    std::vector<sAnimationTrack> Tracks;
+};
+
+namespace animation
+{
+    /**
+     * @brief Samples aClip at aTime, wrapped to its duration, into apOutPose (one pose per joint). The joints the clip
+     * does not animate keep their rest pose.
+     */
+    void SampleClip(const sSkeleton& aSkeleton, const sAnimationClip& aClip, float aTime, sJointPose* apOutPose);
+
+    /**
+     * @brief Blends aNumJoints poses from apPoseA towards apPoseB by aWeight. Rotations are normalized lerps along the
+     * shortest arc. apOutPose may be either of the inputs.
+     */
+    void BlendPoses(const sJointPose* apPoseA, const sJointPose* apPoseB, float aWeight, uint32 aNumJoints, sJointPose* apOutPose);
+
+    /**
+     * @brief Skinning matrices of apPose (one per joint): the world transform of every joint times its inverse bind
+     * matrix, relative to the mesh node (see sSkeleton::RootTransform).
+     */
+    void ComputeSkinningMatrices(const sSkeleton& aSkeleton, const sJointPose* apPose, glm::mat4* apOutMatrices);
+}
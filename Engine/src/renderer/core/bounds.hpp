@@ -0,0 +1,113 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+#include <cfloat>
+#include <cstdint>
+
+/**
+ * @brief Axis aligned bounding box. Default constructed it is empty (Min > Max), so it can be grown with Union().
+ */
+struct sAABB
+{
+    glm::vec3 Min = glm::vec3(FLT_MAX);
+    glm::vec3 Max = glm::vec3(-FLT_MAX);
+
+    sAABB() = default;
+    sAABB(const glm::vec3& aMin, const glm::vec3& aMax) : Min(aMin), Max(aMax) {}
+
+    bool IsValid() const { return Min.x <= Max.x && Min.y <= Max.y && Min.z <= Max.z; }
+    glm::vec3 GetCenter() const { return (Min + Max) * 0.5f; }
+    glm::vec3 GetExtents() const { return (Max - Min) * 0.5f; }
+
+    float GetSurfaceArea() const
+    {
+        const glm::vec3 Size = Max - Min;
+        return 2.0f * (Size.x * Size.y + Size.y * Size.z + Size.z * Size.x);
+    }
+
+    bool Contains(const sAABB& aOther) const
+    {
+        return glm::all(glm::lessThanEqual(Min, aOther.Min)) && glm::all(glm::greaterThanEqual(Max, aOther.Max));
+    }
+
+    bool Overlaps(const sAABB& aOther) const
+    {
+        return glm::all(glm::lessThanEqual(Min, aOther.Max)) && glm::all(glm::greaterThanEqual(Max, aOther.Min));
+    }
+
+    sAABB Expanded(float aMargin) const { return sAABB(Min - glm::vec3(aMargin), Max + glm::vec3(aMargin)); }
+
+    static sAABB Union(const sAABB& aA, const sAABB& aB) { return sAABB(glm::min(aA.Min, aB.Min), glm::max(aA.Max, aB.Max)); }
+};
+
+struct sRay
+{
+    glm::vec3 Origin = glm::vec3(0.0f);
+    // Does not need to be normalized, distances are measured in multiples of it.
+    glm::vec3 Direction = glm::vec3(0.0f, 0.0f, -1.0f);
+    float MaxDistance = FLT_MAX;
+};
+
+enum class eIntersection : uint8_t
+{
+    OUTSIDE = 0,
+    INTERSECTS,
+    INSIDE
+};
+
+/**
+ * @brief Planes of a view frustum, pointing inwards. They are stored as a structure of arrays padded to 8 planes, so
+ * they can be tested 4 at a time.
+ */
+struct sFrustum
+{
+    static constexpr uint32_t NUM_PLANES = 6;
+    static constexpr uint32_t NUM_PADDED_PLANES = 8;
+
+    alignas(16) float NormalX[NUM_PADDED_PLANES];
+    alignas(16) float NormalY[NUM_PADDED_PLANES];
+    alignas(16) float NormalZ[NUM_PADDED_PLANES];
+    alignas(16) float Distance[NUM_PADDED_PLANES];
+
+    /**
+     * @brief Extracts the planes of aViewProj (Gribb-Hartmann). abZeroToOneDepth tells whether the clip space depth goes
+     * from 0 to 1 (Vulkan, D3D) or from -1 to 1 (glm default). With an infinite far plane, the far plane is degenerate and
+     * never culls anything.
+     */
+    static sFrustum FromViewProj(const glm::mat4& aViewProj, bool abZeroToOneDepth = true)
+    {
+        const glm::vec4 Row0(aViewProj[0][0], aViewProj[1][0], aViewProj[2][0], aViewProj[3][0]);
+        const glm::vec4 Row1(aViewProj[0][1], aViewProj[1][1], aViewProj[2][1], aViewProj[3][1]);
+        const glm::vec4 Row2(aViewProj[0][2], aViewProj[1][2], aViewProj[2][2], aViewProj[3][2]);
+        const glm::vec4 Row3(aViewProj[0][3], aViewProj[1][3], aViewProj[2][3], aViewProj[3][3]);
+
+        const glm::vec4 Planes[NUM_PLANES] =
+        {
+            Row3 + Row0,
+            Row3 - Row0,
+            Row3 + Row1,
+            Row3 - Row1,
+            abZeroToOneDepth ? Row2 : Row3 + Row2,
+            Row3 - Row2
+        };
+
+        sFrustum Frustum;
+        for (uint32_t i = 0; i < NUM_PADDED_PLANES; ++i)
+        {
+            // The padding planes have everything in front of them.
+            glm::vec4 Plane = i < NUM_PLANES ? Planes[i] : glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+            const float Length = glm::length(glm::vec3(Plane));
+            if (Length > 0.0f)
+            {
+                Plane /= Length;
+            }
+
+            Frustum.NormalX[i] = Plane.x;
+            Frustum.NormalY[i] = Plane.y;
+            Frustum.NormalZ[i] = Plane.z;
+            Frustum.Distance[i] = Plane.w;
+        }
+        return Frustum;
+    }
+};
@@ -0,0 +1,434 @@
+#include "bvh.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    // Number of buckets the centroids are binned in to evaluate the SAH splits.
+    constexpr uint32 NUM_SAH_BINS = 16;
+
+    // Below this depth the build falls back to median splits, which cannot degenerate.
+    constexpr uint32 MAX_SAH_BUILD_DEPTH = 48;
+}
+
+CBVH::CBVH() :
+    m_Root(BVH_NULL_NODE),
+    m_FreeList(BVH_NULL_NODE),
+    m_NumProxies(0)
+{
+}
+
+void CBVH::Build(const std::vector<sBuildItem>& aItems, std::vector<uint32>& aOutProxies)
+{
+    Clear();
+    m_Nodes.reserve(aItems.size() * 2);
+
+    aOutProxies.resize(aItems.size());
+    for (size_t i = 0; i < aItems.size(); ++i)
+    {
+        const uint32 Leaf = AllocateNode();
+        SetNodeBounds(Leaf, aItems[i].Bounds.Expanded(SGS_BVH_MARGIN));
+        m_Nodes[Leaf].Entity = aItems[i].Entity;
+        aOutProxies[i] = Leaf;
+    }
+    m_NumProxies = static_cast<uint32>(aItems.size());
+
+    if (!aItems.empty())
+    {
+        std::vector<uint32> Leaves = aOutProxies;
+        m_Root = BuildRecursive(Leaves, 0, static_cast<uint32>(Leaves.size()), 0);
+        m_Nodes[m_Root].Parent = BVH_NULL_NODE;
+    }
+}
+
+uint32 CBVH::BuildRecursive(std::vector<uint32>& aLeaves, uint32 aBegin, uint32 aEnd, uint32 aDepth)
+{
+    if (aEnd - aBegin == 1)
+    {
+        return aLeaves[aBegin];
+    }
+
+    sAABB CentroidBounds;
+    for (uint32 i = aBegin; i < aEnd; ++i)
+    {
+        const glm::vec3 Centroid = GetNodeBounds(aLeaves[i]).GetCenter();
+        CentroidBounds = sAABB::Union(CentroidBounds, sAABB(Centroid, Centroid));
+    }
+
+    const glm::vec3 CentroidSize = CentroidBounds.Max - CentroidBounds.Min;
+    const int32 Axis = CentroidSize.x > CentroidSize.y ? (CentroidSize.x > CentroidSize.z ? 0 : 2) : (CentroidSize.y > CentroidSize.z ? 1 : 2);
+    const float AxisMin = CentroidBounds.Min[Axis];
+    const float AxisSize = CentroidSize[Axis];
+
+    auto GetBin = [&](uint32 aLeaf)
+    {
+        const float Centroid = GetNodeBounds(aLeaf).GetCenter()[Axis];
+        return std::min(NUM_SAH_BINS - 1, static_cast<uint32>(NUM_SAH_BINS * (Centroid - AxisMin) / AxisSize));
+    };
+
+    uint32 Middle = aBegin;
+    if (AxisSize > 0.0f && aDepth < MAX_SAH_BUILD_DEPTH)
+    {
+        sAABB BinBounds[NUM_SAH_BINS];
+        uint32 BinCounts[NUM_SAH_BINS] = {};
+        for (uint32 i = aBegin; i < aEnd; ++i)
+        {
+            const uint32 Bin = GetBin(aLeaves[i]);
+            BinBounds[Bin] = sAABB::Union(BinBounds[Bin], GetNodeBounds(aLeaves[i]));
+            ++BinCounts[Bin];
+        }
+
+        // Cost of the leaves right of every split, swept from the right.
+        float RightCosts[NUM_SAH_BINS] = {};
+        sAABB Accumulated;
+        uint32 Count = 0;
+        for (uint32 Bin = NUM_SAH_BINS - 1; Bin > 0; --Bin)
+        {
+            Accumulated = sAABB::Union(Accumulated, BinBounds[Bin]);
+            Count += BinCounts[Bin];
+            RightCosts[Bin] = Count > 0 ? Accumulated.GetSurfaceArea() * Count : 0.0f;
+        }
+
+        // Split after BestBin, the one minimizing area * count on both sides.
+        float BestCost = FLT_MAX;
+        uint32 BestBin = 0;
+        Accumulated = sAABB();
+        Count = 0;
+        for (uint32 Bin = 0; Bin < NUM_SAH_BINS - 1; ++Bin)
+        {
+            Accumulated = sAABB::Union(Accumulated, BinBounds[Bin]);
+            Count += BinCounts[Bin];
+            const float Cost = (Count > 0 ? Accumulated.GetSurfaceArea() * Count : 0.0f) + RightCosts[Bin + 1];
+            if (Count > 0 && Count < aEnd - aBegin && Cost < BestCost)
+            {
+                BestCost = Cost;
+                BestBin = Bin;
+            }
+        }
+
+        if (BestCost < FLT_MAX)
+        {
+            Middle = static_cast<uint32>(std::partition(aLeaves.begin() + aBegin, aLeaves.begin() + aEnd,
+                [&](uint32 aLeaf) { return GetBin(aLeaf) <= BestBin; }) - aLeaves.begin());
+        }
+    }
+
+    // Every centroid in the same place, or too deep: split the leaves in two halves along the axis.
+    if (Middle == aBegin || Middle == aEnd)
+    {
+        Middle = aBegin + (aEnd - aBegin) / 2;
+        std::nth_element(aLeaves.begin() + aBegin, aLeaves.begin() + Middle, aLeaves.begin() + aEnd, [&](uint32 aA, uint32 aB)
+        {
+            return GetNodeBounds(aA).GetCenter()[Axis] < GetNodeBounds(aB).GetCenter()[Axis];
+        });
+    }
+
+    const uint32 Node = AllocateNode();
+    const uint32 Left = BuildRecursive(aLeaves, aBegin, Middle, aDepth + 1);
+    const uint32 Right = BuildRecursive(aLeaves, Middle, aEnd, aDepth + 1);
+
+    m_Nodes[Node].Children[0] = Left;
+    m_Nodes[Node].Children[1] = Right;
+    m_Nodes[Left].Parent = Node;
+    m_Nodes[Right].Parent = Node;
+    SetNodeBounds(Node, sAABB::Union(GetNodeBounds(Left), GetNodeBounds(Right)));
+    return Node;
+}
+
+uint32 CBVH::Insert(const sAABB& aBounds, sEntity aEntity)
+{
+    const uint32 Leaf = AllocateNode();
+    SetNodeBounds(Leaf, aBounds.Expanded(SGS_BVH_MARGIN));
+    m_Nodes[Leaf].Entity = aEntity;
+    InsertLeaf(Leaf);
+    ++m_NumProxies;
+    return Leaf;
+}
+
+void CBVH::Remove(uint32 aProxy)
+{
+    assert(aProxy < m_Nodes.size() && m_Nodes[aProxy].IsLeaf());
+    RemoveLeaf(aProxy);
+    FreeNode(aProxy);
+    --m_NumProxies;
+}
+
+bool CBVH::Update(uint32 aProxy, const sAABB& aBounds)
+{
+    const sAABB OldBounds = GetNodeBounds(aProxy);
+    if (OldBounds.Contains(aBounds))
+    {
+        return false;
+    }
+
+    const sAABB NewBounds = aBounds.Expanded(SGS_BVH_MARGIN);
+    if (NewBounds.Overlaps(OldBounds))
+    {
+        // Moved a little: the leaf keeps its place, its ancestors are refitted and rotated.
+        SetNodeBounds(aProxy, NewBounds);
+        RefitAncestors(m_Nodes[aProxy].Parent);
+    }
+    else
+    {
+        // Refitting after a teleport would stretch every ancestor, the leaf looks for a new place instead.
+        RemoveLeaf(aProxy);
+        SetNodeBounds(aProxy, NewBounds);
+        InsertLeaf(aProxy);
+    }
+    return true;
+}
+
+void CBVH::Clear()
+{
+    m_Nodes.clear();
+    m_Root = BVH_NULL_NODE;
+    m_FreeList = BVH_NULL_NODE;
+    m_NumProxies = 0;
+}
+
+uint32 CBVH::GetHeight() const
+{
+    if (m_Root == BVH_NULL_NODE)
+    {
+        return 0;
+    }
+
+    uint32 Height = 0;
+    std::vector<std::pair<uint32, uint32>> Stack = { { m_Root, 1 } };
+    while (!Stack.empty())
+    {
+        const std::pair<uint32, uint32> Entry = Stack.back();
+        Stack.pop_back();
+        Height = std::max(Height, Entry.second);
+
+        const sNode& Node = m_Nodes[Entry.first];
+        if (!Node.IsLeaf())
+        {
+            Stack.push_back({ Node.Children[0], Entry.second + 1 });
+            Stack.push_back({ Node.Children[1], Entry.second + 1 });
+        }
+    }
+    return Height;
+}
+
+float CBVH::GetSAHCost() const
+{
+    if (m_Root == BVH_NULL_NODE)
+    {
+        return 0.0f;
+    }
+
+    float InternalArea = 0.0f;
+    CTraversalStack Stack;
+    Stack.Push(m_Root);
+    while (!Stack.IsEmpty())
+    {
+        const uint32 NodeIndex = Stack.Pop();
+        const sNode& Node = m_Nodes[NodeIndex];
+        if (!Node.IsLeaf())
+        {
+            InternalArea += GetNodeBounds(NodeIndex).GetSurfaceArea();
+            Stack.Push(Node.Children[0]);
+            Stack.Push(Node.Children[1]);
+        }
+    }
+
+    const float RootArea = GetNodeBounds(m_Root).GetSurfaceArea();
+    return RootArea > 0.0f ? InternalArea / RootArea : 0.0f;
+}
+
+uint32 CBVH::AllocateNode()
+{
+    uint32 NodeIndex = m_FreeList;
+    if (NodeIndex != BVH_NULL_NODE)
+    {
+        m_FreeList = m_Nodes[NodeIndex].Parent;
+    }
+    else
+    {
+        NodeIndex = static_cast<uint32>(m_Nodes.size());
+        m_Nodes.emplace_back();
+    }
+
+    sNode& Node = m_Nodes[NodeIndex];
+    std::fill(std::begin(Node.Min), std::end(Node.Min), 0.0f);
+    std::fill(std::begin(Node.Max), std::end(Node.Max), 0.0f);
+    Node.Parent = BVH_NULL_NODE;
+    Node.Children[0] = BVH_NULL_NODE;
+    Node.Children[1] = BVH_NULL_NODE;
+    Node.Entity = INVALID_ENTITY;
+    return NodeIndex;
+}
+
+void CBVH::FreeNode(uint32 aNode)
+{
+    m_Nodes[aNode].Parent = m_FreeList;
+    m_Nodes[aNode].Entity = INVALID_ENTITY;
+    m_FreeList = aNode;
+}
+
+sAABB CBVH::GetNodeBounds(uint32 aNode) const
+{
+    const sNode& Node = m_Nodes[aNode];
+    return sAABB(glm::vec3(Node.Min[0], Node.Min[1], Node.Min[2]), glm::vec3(Node.Max[0], Node.Max[1], Node.Max[2]));
+}
+
+void CBVH::SetNodeBounds(uint32 aNode, const sAABB& aBounds)
+{
+    sNode& Node = m_Nodes[aNode];
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+        Node.Min[Axis] = aBounds.Min[Axis];
+        Node.Max[Axis] = aBounds.Max[Axis];
+    }
+}
+
+void CBVH::InsertLeaf(uint32 aLeaf)
+{
+    if (m_Root == BVH_NULL_NODE)
+    {
+        m_Root = aLeaf;
+        m_Nodes[aLeaf].Parent = BVH_NULL_NODE;
+        return;
+    }
+
+    // Descend towards the sibling whose parent would grow the tree the least.
+    const sAABB LeafBounds = GetNodeBounds(aLeaf);
+    uint32 Sibling = m_Root;
+    while (!m_Nodes[Sibling].IsLeaf())
+    {
+        const sAABB Bounds = GetNodeBounds(Sibling);
+        const float Area = Bounds.GetSurfaceArea();
+        const float CombinedArea = sAABB::Union(Bounds, LeafBounds).GetSurfaceArea();
+
+        // Cost of making the leaf the sibling of this node, and the minimum cost of going further down.
+        const float Cost = 2.0f * CombinedArea;
+        const float InheritanceCost = 2.0f * (CombinedArea - Area);
+
+        float ChildCosts[2];
+        for (uint32 i = 0; i < 2; ++i)
+        {
+            const uint32 Child = m_Nodes[Sibling].Children[i];
+            const sAABB ChildBounds = GetNodeBounds(Child);
+            const float ChildCombinedArea = sAABB::Union(ChildBounds, LeafBounds).GetSurfaceArea();
+            ChildCosts[i] = InheritanceCost + (m_Nodes[Child].IsLeaf() ? ChildCombinedArea : ChildCombinedArea - ChildBounds.GetSurfaceArea());
+        }
+
+        if (Cost < ChildCosts[0] && Cost < ChildCosts[1])
+        {
+            break;
+        }
+        Sibling = m_Nodes[Sibling].Children[ChildCosts[0] < ChildCosts[1] ? 0 : 1];
+    }
+
+    const uint32 OldParent = m_Nodes[Sibling].Parent;
+    const uint32 NewParent = AllocateNode();
+    m_Nodes[NewParent].Parent = OldParent;
+    m_Nodes[NewParent].Children[0] = Sibling;
+    m_Nodes[NewParent].Children[1] = aLeaf;
+    SetNodeBounds(NewParent, sAABB::Union(GetNodeBounds(Sibling), LeafBounds));
+
+    if (OldParent != BVH_NULL_NODE)
+    {
+        sNode& Parent = m_Nodes[OldParent];
+        Parent.Children[Parent.Children[0] == Sibling ? 0 : 1] = NewParent;
+    }
+    else
+    {
+        m_Root = NewParent;
+    }
+    m_Nodes[Sibling].Parent = NewParent;
+    m_Nodes[aLeaf].Parent = NewParent;
+
+    RefitAncestors(OldParent);
+}
+
+void CBVH::RemoveLeaf(uint32 aLeaf)
+{
+    if (aLeaf == m_Root)
+    {
+        m_Root = BVH_NULL_NODE;
+        return;
+    }
+
+    // The sibling takes the place of the parent.
+    const uint32 Parent = m_Nodes[aLeaf].Parent;
+    const uint32 GrandParent = m_Nodes[Parent].Parent;
+    const uint32 Sibling = m_Nodes[Parent].Children[m_Nodes[Parent].Children[0] == aLeaf ? 1 : 0];
+
+    m_Nodes[Sibling].Parent = GrandParent;
+    if (GrandParent != BVH_NULL_NODE)
+    {
+        sNode& Node = m_Nodes[GrandParent];
+        Node.Children[Node.Children[0] == Parent ? 0 : 1] = Sibling;
+    }
+    else
+    {
+        m_Root = Sibling;
+    }
+
+    FreeNode(Parent);
+    m_Nodes[aLeaf].Parent = BVH_NULL_NODE;
+    RefitAncestors(GrandParent);
+}
+
+void CBVH::RefitAncestors(uint32 aNode)
+{
+    // Rotations only shuffle the leaves below a node, its bounds are the same after them.
+    for (uint32 NodeIndex = aNode; NodeIndex != BVH_NULL_NODE; NodeIndex = m_Nodes[NodeIndex].Parent)
+    {
+        const sNode& Node = m_Nodes[NodeIndex];
+        SetNodeBounds(NodeIndex, sAABB::Union(GetNodeBounds(Node.Children[0]), GetNodeBounds(Node.Children[1])));
+        Rotate(NodeIndex);
+    }
+}
+
+void CBVH::Rotate(uint32 aNode)
+{
+    // Tries swapping a child of aNode with one of the children of the other child, keeping the swap that reduces the
+    // surface area of the modified child the most.
+    float BestReduction = 0.0f;
+    uint32 BestMoved = 0;
+    uint32 BestGrandChild = 0;
+
+    for (uint32 Moved = 0; Moved < 2; ++Moved)
+    {
+        const uint32 Other = m_Nodes[aNode].Children[1 - Moved];
+        if (m_Nodes[Other].IsLeaf())
+        {
+            continue;
+        }
+
+        const sAABB MovedBounds = GetNodeBounds(m_Nodes[aNode].Children[Moved]);
+        const float OtherArea = GetNodeBounds(Other).GetSurfaceArea();
+        for (uint32 GrandChild = 0; GrandChild < 2; ++GrandChild)
+        {
+            // The other child would bound the moved child and the grandchild that stays.
+            const uint32 Remaining = m_Nodes[Other].Children[1 - GrandChild];
+            const float Reduction = OtherArea - sAABB::Union(MovedBounds, GetNodeBounds(Remaining)).GetSurfaceArea();
+            if (Reduction > BestReduction)
+            {
+                BestReduction = Reduction;
+                BestMoved = Moved;
+                BestGrandChild = GrandChild;
+            }
+        }
+    }
+
+    if (BestReduction <= 0.0f)
+    {
+        return;
+    }
+
+    const uint32 Moved = m_Nodes[aNode].Children[BestMoved];
+    const uint32 Other = m_Nodes[aNode].Children[1 - BestMoved];
+    const uint32 GrandChild = m_Nodes[Other].Children[BestGrandChild];
+
+    m_Nodes[aNode].Children[BestMoved] = GrandChild;
+    m_Nodes[GrandChild].Parent = aNode;
+    m_Nodes[Other].Children[BestGrandChild] = Moved;
+    m_Nodes[Moved].Parent = Other;
+
+    const sNode& OtherNode = m_Nodes[Other];
+    SetNodeBounds(Other, sAABB::Union(GetNodeBounds(OtherNode.Children[0]), GetNodeBounds(OtherNode.Children[1])));
+}
@@ -0,0 +1,506 @@
+#pragma once
+
+#include "bounds.hpp"
+#include <core/ecs.hpp>
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// SSE node tests, the scalar ones are used otherwise. Can be overridden at build time.
+#ifndef SGS_BVH_SIMD
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define SGS_BVH_SIMD 1
+#else
+#define SGS_BVH_SIMD 0
+#endif
+#endif
+
+#if SGS_BVH_SIMD
+#include <emmintrin.h>
+#endif
+
+// Leaves are stored enlarged by this margin, objects moving inside it do not touch the tree.
+// Can be overridden at build time.
+#ifndef SGS_BVH_MARGIN
+#define SGS_BVH_MARGIN 0.1f
+#endif
+
+constexpr uint32 BVH_NULL_NODE = UINT32_MAX;
+
+/**
+ * @brief Dynamic bounding volume hierarchy of entity bounds. Every entity is a leaf (a proxy) of a binary tree whose
+ * internal nodes bound their children.
+ *
+ * Static content is best added at once with Build(), a top-down binned SAH build. Insert() descends the tree picking
+ * the sibling that increases the surface area the least, and every node refitted on the way up is rotated if swapping
+ * a child with a grandchild reduces the area, so the tree stays good while objects come and go. Moving objects are
+ * refitted in place with Update(), or reinserted when they moved further than their previous bounds.
+ *
+ * Queries call back for every leaf whose (enlarged) bounds pass the test, the caller does the exact test if needed.
+ * Not thread safe, but queries are const and can run concurrently while nothing modifies the tree.
+ */
+class CBVH
+{
+public:
+    struct sBuildItem
+    {
+        sAABB Bounds;
+        sEntity Entity;
+    };
+
+    CBVH();
+
+    /**
+     * @brief Replaces the content of the tree with aItems. aOutProxies receives the proxy of every item, in the same order.
+     */
+    void Build(const std::vector<sBuildItem>& aItems, std::vector<uint32>& aOutProxies);
+
+    uint32 Insert(const sAABB& aBounds, sEntity aEntity);
+    void Remove(uint32 aProxy);
+
+    /**
+     * @brief Moves aProxy to aBounds. Returns false when they are still inside the enlarged bounds of the proxy and
+     * the tree was left untouched.
+     */
+    bool Update(uint32 aProxy, const sAABB& aBounds);
+
+    void Clear();
+
+    sAABB GetBounds(uint32 aProxy) const { return GetNodeBounds(aProxy); }
+    sEntity GetEntity(uint32 aProxy) const { return m_Nodes[aProxy].Entity; }
+    uint32 GetNumProxies() const { return m_NumProxies; }
+
+    /**
+     * @brief Number of levels of the tree. Walks the whole tree, meant for debugging.
+     */
+    uint32 GetHeight() const;
+
+    /**
+     * @brief Sum of the surface areas of the internal nodes relative to the root, the cost the SAH minimizes. Lower is
+     * better, meant to compare the quality of the tree after updates with a fresh Build().
+     */
+    float GetSAHCost() const;
+
+    /**
+     * @brief aCallback(uint32 aProxy, sEntity aEntity) -> bool for every leaf overlapping aBounds. Returning false stops.
+     */
+    template<class F>
+    void QueryAABB(const sAABB& aBounds, F&& aCallback) const;
+
+    /**
+     * @brief Same as QueryAABB() for the leaves overlapping the sphere.
+     */
+    template<class F>
+    void QuerySphere(const glm::vec3& aCenter, float aRadius, F&& aCallback) const;
+
+    /**
+     * @brief Same as QueryAABB() for the leaves inside or intersecting aFrustum. Subtrees fully inside it are reported
+     * without testing their nodes.
+     */
+    template<class F>
+    void QueryFrustum(const sFrustum& aFrustum, F&& aCallback) const;
+
+    /**
+     * @brief aCallback(uint32 aProxy, sEntity aEntity, float aMaxDistance) -> float for every leaf hit by the ray before
+     * aMaxDistance. It returns the new maximum distance: the distance of the hit to only look for closer ones,
+     * aMaxDistance to ignore the leaf, or 0 to stop.
+     */
+    template<class F>
+    void Raycast(const sRay& aRay, F&& aCallback) const;
+
+private:
+    struct alignas(16) sNode
+    {
+        // w is always 0, so the bounds can be loaded in a single register.
+        float Min[4];
+        float Max[4];
+        // Next free node while the node is free.
+        uint32 Parent;
+        uint32 Children[2];
+        sEntity Entity;
+
+        bool IsLeaf() const { return Children[0] == BVH_NULL_NODE; }
+    };
+
+    // Stack of the nodes left to visit. Balanced trees fit in the inline storage, queries only allocate on very deep ones.
+    class CTraversalStack
+    {
+    public:
+        CTraversalStack() : m_Size(0) {}
+
+        void Push(uint32 aNode)
+        {
+            if (m_Size < INLINE_SIZE)
+            {
+                m_Inline[m_Size] = aNode;
+            }
+            else
+            {
+                m_Overflow.push_back(aNode);
+            }
+            ++m_Size;
+        }
+
+        uint32 Pop()
+        {
+            --m_Size;
+            if (m_Size < INLINE_SIZE)
+            {
+                return m_Inline[m_Size];
+            }
+
+            const uint32 Node = m_Overflow.back();
+            m_Overflow.pop_back();
+            return Node;
+        }
+
+        bool IsEmpty() const { return m_Size == 0; }
+
+    private:
+        static constexpr uint32 INLINE_SIZE = 64;
+        uint32 m_Inline[INLINE_SIZE];
+        std::vector<uint32> m_Overflow;
+        uint32 m_Size;
+    };
+
+    uint32 AllocateNode();
+    void FreeNode(uint32 aNode);
+
+    sAABB GetNodeBounds(uint32 aNode) const;
+    void SetNodeBounds(uint32 aNode, const sAABB& aBounds);
+
+    void InsertLeaf(uint32 aLeaf);
+    void RemoveLeaf(uint32 aLeaf);
+    void RefitAncestors(uint32 aNode);
+    void Rotate(uint32 aNode);
+
+    uint32 BuildRecursive(std::vector<uint32>& aLeaves, uint32 aBegin, uint32 aEnd, uint32 aDepth);
+
+    template<class F>
+    bool ReportSubtree(uint32 aNode, F& aCallback) const;
+
+    static bool TestAABB(const sNode& aNode, const sAABB& aBounds);
+    static bool TestSphere(const sNode& aNode, const glm::vec3& aCenter, float aRadiusSquared);
+    static eIntersection TestFrustum(const sNode& aNode, const sFrustum& aFrustum);
+    static bool TestRay(const sNode& aNode, const glm::vec3& aOrigin, const glm::vec3& aInvDirection, float aMaxDistance);
+
+    std::vector<sNode> m_Nodes;
+    uint32 m_Root;
+    uint32 m_FreeList;
+    uint32 m_NumProxies;
+};
+
+inline bool CBVH::TestAABB(const sNode& aNode, const sAABB& aBounds)
+{
+#if SGS_BVH_SIMD
+    const __m128 QueryMin = _mm_setr_ps(aBounds.Min.x, aBounds.Min.y, aBounds.Min.z, 0.0f);
+    const __m128 QueryMax = _mm_setr_ps(aBounds.Max.x, aBounds.Max.y, aBounds.Max.z, 0.0f);
+    const __m128 Overlaps = _mm_and_ps(_mm_cmple_ps(_mm_load_ps(aNode.Min), QueryMax), _mm_cmpge_ps(_mm_load_ps(aNode.Max), QueryMin));
+    return (_mm_movemask_ps(Overlaps) & 0x7) == 0x7;
+#else
+    return aNode.Min[0] <= aBounds.Max.x && aNode.Min[1] <= aBounds.Max.y && aNode.Min[2] <= aBounds.Max.z &&
+        aNode.Max[0] >= aBounds.Min.x && aNode.Max[1] >= aBounds.Min.y && aNode.Max[2] >= aBounds.Min.z;
+#endif
+}
+
+inline bool CBVH::TestSphere(const sNode& aNode, const glm::vec3& aCenter, float aRadiusSquared)
+{
+#if SGS_BVH_SIMD
+    // Distance from the center to the closest point of the box.
+    const __m128 Center = _mm_setr_ps(aCenter.x, aCenter.y, aCenter.z, 0.0f);
+    const __m128 Closest = _mm_max_ps(_mm_min_ps(Center, _mm_load_ps(aNode.Max)), _mm_load_ps(aNode.Min));
+    const __m128 Delta = _mm_sub_ps(Center, Closest);
+    __m128 Squared = _mm_mul_ps(Delta, Delta);
+    Squared = _mm_add_ps(Squared, _mm_movehl_ps(Squared, Squared));
+    Squared = _mm_add_ss(Squared, _mm_shuffle_ps(Squared, Squared, _MM_SHUFFLE(1, 1, 1, 1)));
+    return _mm_cvtss_f32(Squared) <= aRadiusSquared;
+#else
+    float DistanceSquared = 0.0f;
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+        const float Closest = glm::clamp(aCenter[Axis], aNode.Min[Axis], aNode.Max[Axis]);
+        DistanceSquared += (aCenter[Axis] - Closest) * (aCenter[Axis] - Closest);
+    }
+    return DistanceSquared <= aRadiusSquared;
+#endif
+}
+
+inline eIntersection CBVH::TestFrustum(const sNode& aNode, const sFrustum& aFrustum)
+{
+    // Distance from the center of the box to each plane, against the projection of the extents on its normal.
+#if SGS_BVH_SIMD
+    const __m128 Min = _mm_load_ps(aNode.Min);
+    const __m128 Max = _mm_load_ps(aNode.Max);
+    const __m128 Half = _mm_set1_ps(0.5f);
+    const __m128 Center = _mm_mul_ps(_mm_add_ps(Min, Max), Half);
+    const __m128 Extents = _mm_mul_ps(_mm_sub_ps(Max, Min), Half);
+    const __m128 CenterX = _mm_shuffle_ps(Center, Center, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 CenterY = _mm_shuffle_ps(Center, Center, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 CenterZ = _mm_shuffle_ps(Center, Center, _MM_SHUFFLE(2, 2, 2, 2));
+    const __m128 ExtentsX = _mm_shuffle_ps(Extents, Extents, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 ExtentsY = _mm_shuffle_ps(Extents, Extents, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 ExtentsZ = _mm_shuffle_ps(Extents, Extents, _MM_SHUFFLE(2, 2, 2, 2));
+    const __m128 AbsMask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+
+    int32 OutsideMask = 0;
+    int32 IntersectMask = 0;
+    for (uint32 i = 0; i < sFrustum::NUM_PADDED_PLANES; i += 4)
+    {
+        const __m128 NormalX = _mm_load_ps(&aFrustum.NormalX[i]);
+        const __m128 NormalY = _mm_load_ps(&aFrustum.NormalY[i]);
+        const __m128 NormalZ = _mm_load_ps(&aFrustum.NormalZ[i]);
+
+        __m128 Distance = _mm_load_ps(&aFrustum.Distance[i]);
+        Distance = _mm_add_ps(Distance, _mm_mul_ps(NormalX, CenterX));
+        Distance = _mm_add_ps(Distance, _mm_mul_ps(NormalY, CenterY));
+        Distance = _mm_add_ps(Distance, _mm_mul_ps(NormalZ, CenterZ));
+
+        __m128 Radius = _mm_mul_ps(_mm_and_ps(NormalX, AbsMask), ExtentsX);
+        Radius = _mm_add_ps(Radius, _mm_mul_ps(_mm_and_ps(NormalY, AbsMask), ExtentsY));
+        Radius = _mm_add_ps(Radius, _mm_mul_ps(_mm_and_ps(NormalZ, AbsMask), ExtentsZ));
+
+        OutsideMask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_add_ps(Distance, Radius), _mm_setzero_ps()));
+        IntersectMask |= _mm_movemask_ps(_mm_cmplt_ps(_mm_sub_ps(Distance, Radius), _mm_setzero_ps()));
+    }
+
+    if (OutsideMask != 0)
+    {
+        return eIntersection::OUTSIDE;
+    }
+    return IntersectMask != 0 ? eIntersection::INTERSECTS : eIntersection::INSIDE;
+#else
+    eIntersection Result = eIntersection::INSIDE;
+    for (uint32 i = 0; i < sFrustum::NUM_PLANES; ++i)
+    {
+        float Distance = aFrustum.Distance[i];
+        float Radius = 0.0f;
+        const float Normal[3] = { aFrustum.NormalX[i], aFrustum.NormalY[i], aFrustum.NormalZ[i] };
+        for (int32 Axis = 0; Axis < 3; ++Axis)
+        {
+            Distance += Normal[Axis] * (aNode.Min[Axis] + aNode.Max[Axis]) * 0.5f;
+            Radius += std::abs(Normal[Axis]) * (aNode.Max[Axis] - aNode.Min[Axis]) * 0.5f;
+        }
+
+        if (Distance + Radius < 0.0f)
+        {
+            return eIntersection::OUTSIDE;
+        }
+        if (Distance - Radius < 0.0f)
+        {
+            Result = eIntersection::INTERSECTS;
+        }
+    }
+    return Result;
+#endif
+}
+
+inline bool CBVH::TestRay(const sNode& aNode, const glm::vec3& aOrigin, const glm::vec3& aInvDirection, float aMaxDistance)
+{
+    // Slab test: the ray hits the box if it enters every slab before leaving any of them.
+#if SGS_BVH_SIMD
+    const __m128 Origin = _mm_setr_ps(aOrigin.x, aOrigin.y, aOrigin.z, 0.0f);
+    const __m128 InvDirection = _mm_setr_ps(aInvDirection.x, aInvDirection.y, aInvDirection.z, 0.0f);
+    const __m128 T1 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(aNode.Min), Origin), InvDirection);
+    const __m128 T2 = _mm_mul_ps(_mm_sub_ps(_mm_load_ps(aNode.Max), Origin), InvDirection);
+    const __m128 TNear = _mm_min_ps(T1, T2);
+    const __m128 TFar = _mm_max_ps(T1, T2);
+
+    // Only x, y and z take part, w is always 0.
+    __m128 Enter = _mm_max_ss(_mm_max_ss(TNear, _mm_shuffle_ps(TNear, TNear, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(TNear, TNear, _MM_SHUFFLE(2, 2, 2, 2)));
+    __m128 Exit = _mm_min_ss(_mm_min_ss(TFar, _mm_shuffle_ps(TFar, TFar, _MM_SHUFFLE(1, 1, 1, 1))), _mm_shuffle_ps(TFar, TFar, _MM_SHUFFLE(2, 2, 2, 2)));
+    Enter = _mm_max_ss(Enter, _mm_setzero_ps());
+    Exit = _mm_min_ss(Exit, _mm_set_ss(aMaxDistance));
+    return _mm_comile_ss(Enter, Exit) != 0;
+#else
+    float Enter = 0.0f;
+    float Exit = aMaxDistance;
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+        const float T1 = (aNode.Min[Axis] - aOrigin[Axis]) * aInvDirection[Axis];
+        const float T2 = (aNode.Max[Axis] - aOrigin[Axis]) * aInvDirection[Axis];
+        Enter = std::max(Enter, std::min(T1, T2));
+        Exit = std::min(Exit, std::max(T1, T2));
+    }
+    return Enter <= Exit;
+#endif
+}
+
+template<class F>
+bool CBVH::ReportSubtree(uint32 aNode, F& aCallback) const
+{
+    CTraversalStack Stack;
+    Stack.Push(aNode);
+    while (!Stack.IsEmpty())
+    {
+        const sNode& Node = m_Nodes[Stack.Pop()];
+        if (Node.IsLeaf())
+        {
+            if (!aCallback(static_cast<uint32>(&Node - m_Nodes.data()), Node.Entity))
+            {
+                return false;
+            }
+        }
+        else
+        {
+            Stack.Push(Node.Children[0]);
+            Stack.Push(Node.Children[1]);
+        }
+    }
+    return true;
+}
+
+template<class F>
+void CBVH::QueryAABB(const sAABB& aBounds, F&& aCallback) const
+{
+    if (m_Root == BVH_NULL_NODE)
+    {
+        return;
+    }
+
+    CTraversalStack Stack;
+    Stack.Push(m_Root);
+    while (!Stack.IsEmpty())
+    {
+        const uint32 NodeIndex = Stack.Pop();
+        const sNode& Node = m_Nodes[NodeIndex];
+        if (!TestAABB(Node, aBounds))
+        {
+            continue;
+        }
+
+        if (Node.IsLeaf())
+        {
+            if (!aCallback(NodeIndex, Node.Entity))
+            {
+                return;
+            }
+        }
+        else
+        {
+            Stack.Push(Node.Children[0]);
+            Stack.Push(Node.Children[1]);
+        }
+    }
+}
+
+template<class F>
+void CBVH::QuerySphere(const glm::vec3& aCenter, float aRadius, F&& aCallback) const
+{
+    if (m_Root == BVH_NULL_NODE)
+    {
+        return;
+    }
+
+    const float RadiusSquared = aRadius * aRadius;
+    CTraversalStack Stack;
+    Stack.Push(m_Root);
+    while (!Stack.IsEmpty())
+    {
+        const uint32 NodeIndex = Stack.Pop();
+        const sNode& Node = m_Nodes[NodeIndex];
+        if (!TestSphere(Node, aCenter, RadiusSquared))
+        {
+            continue;
+        }
+
+        if (Node.IsLeaf())
+        {
+            if (!aCallback(NodeIndex, Node.Entity))
+            {
+                return;
+            }
+        }
+        else
+        {
+            Stack.Push(Node.Children[0]);
+            Stack.Push(Node.Children[1]);
+        }
+    }
+}
+
+template<class F>
+void CBVH::QueryFrustum(const sFrustum& aFrustum, F&& aCallback) const
+{
+    if (m_Root == BVH_NULL_NODE)
+    {
+        return;
+    }
+
+    CTraversalStack Stack;
+    Stack.Push(m_Root);
+    while (!Stack.IsEmpty())
+    {
+        const uint32 NodeIndex = Stack.Pop();
+        const sNode& Node = m_Nodes[NodeIndex];
+        const eIntersection Intersection = TestFrustum(Node, aFrustum);
+        if (Intersection == eIntersection::OUTSIDE)
+        {
+            continue;
+        }
+
+        if (Node.IsLeaf())
+        {
+            if (!aCallback(NodeIndex, Node.Entity))
+            {
+                return;
+            }
+        }
+        else if (Intersection == eIntersection::INSIDE)
+        {
+            if (!ReportSubtree(NodeIndex, aCallback))
+            {
+                return;
+            }
+        }
+        else
+        {
+            Stack.Push(Node.Children[0]);
+            Stack.Push(Node.Children[1]);
+        }
+    }
+}
+
+template<class F>
+void CBVH::Raycast(const sRay& aRay, F&& aCallback) const
+{
+    if (m_Root == BVH_NULL_NODE)
+    {
+        return;
+    }
+
+    // Axis aligned rays would divide by zero, a tiny direction keeps the slab test finite.
+    glm::vec3 InvDirection;
+    for (int32 Axis = 0; Axis < 3; ++Axis)
+    {
+        const float Direction = std::abs(aRay.Direction[Axis]) > 1e-20f ? aRay.Direction[Axis] : 1e-20f;
+        InvDirection[Axis] = 1.0f / Direction;
+    }
+
+    float MaxDistance = aRay.MaxDistance;
+    CTraversalStack Stack;
+    Stack.Push(m_Root);
+    while (!Stack.IsEmpty())
+    {
+        const uint32 NodeIndex = Stack.Pop();
+        const sNode& Node = m_Nodes[NodeIndex];
+        if (!TestRay(Node, aRay.Origin, InvDirection, MaxDistance))
+        {
+            continue;
+        }
+
+        if (Node.IsLeaf())
+        {
+            MaxDistance = aCallback(NodeIndex, Node.Entity, MaxDistance);
+            if (MaxDistance <= 0.0f)
+            {
+                return;
+            }
+        }
+        else
+        {
+            Stack.Push(Node.Children[0]);
+            Stack.Push(Node.Children[1]);
+        }
+    }
+}
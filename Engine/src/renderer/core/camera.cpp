@@ -1,5 +1,6 @@
 #include "camera.hpp"
 #include "core/logger.h"
+#include "core/profiler.hpp"
 #include <engine.hpp>
 
 #include <glm/glm.hpp>
@@ -7,13 +8,18 @@
 #include <glm/gtx/quaternion.hpp>
 #include <GLFW/glfw3.h>
 
+#include <cmath>
+
 CCamera::CCamera(glm::vec3 aPosition, float aYaw, float aPitch, float aSpeed) :
-    m_Position(aPosition), m_Yaw(aYaw), m_Pitch(aPitch), m_Speed(aSpeed), m_Sensitivity(DEFAULT_CAMERA_SENSITIVITY)
+    m_Position(aPosition), m_Yaw(aYaw), m_Pitch(aPitch), m_Speed(aSpeed), m_Sensitivity(DEFAULT_CAMERA_SENSITIVITY),
+    m_FovY(glm::radians(DEFAULT_CAMERA_FOV_Y)), m_NearPlane(DEFAULT_CAMERA_NEAR_PLANE)
 {
 }
 
 void CCamera::Update()
 {
+    SGS_PROFILE_FUNCTION();
+
     glm::vec3 Velocity = glm::vec3(0.0f);
 
     if (glfwGetKey(CEngine::Get()->GetWindow(), GLFW_KEY_UP))
@@ -63,10 +69,18 @@ glm::mat4 CCamera::GetRotationMatrix() const
     return glm::toMat4(yawRotation) * glm::toMat4(pitchRotation);
 }
 
-glm::mat4 CCamera::GetProjection() const
+glm::mat4 CCamera::GetProjection(float aAspectRatio) const
 {
-    // TODO: Implement this.
-    return glm::mat4(1);
+    // Limit of the reversed-Z projection when the far plane goes to infinity: clip depth is the near plane and w is the
+    // view depth, so the depth is Near / ViewDepth.
+    const float Focal = 1.0f / std::tan(m_FovY * 0.5f);
+
+    glm::mat4 Projection(0.0f);
+    Projection[0][0] = Focal / aAspectRatio;
+    Projection[1][1] = Focal;
+    Projection[2][3] = -1.0f;
+    Projection[3][2] = m_NearPlane;
+    return Projection;
 }
 
 void CCamera::Rotate(float aXOfsset, float aYOffset, bool abConstraintPitch)
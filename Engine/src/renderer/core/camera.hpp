@@ -7,6 +7,8 @@ const float DEFAULT_CAMERA_YAW = 0.0f;
 const float DEFAULT_CAMERA_PITCH = 0.0f;
 const float DEFAULT_CAMERA_SPEED = 0.01f;
 const float DEFAULT_CAMERA_SENSITIVITY = 0.2f;
+const float DEFAULT_CAMERA_FOV_Y = 90.0f;
+const float DEFAULT_CAMERA_NEAR_PLANE = 0.1f;
 
 class CCamera
 {
@@ -19,10 +21,19 @@ public:
     float m_Pitch;
     float m_Speed;
     float m_Sensitivity;
+    // Vertical field of view, in radians.
+    float m_FovY;
+    float m_NearPlane;
 
     glm::vec3 GetPosition() const { return m_Position; }
     glm::mat4 GetViewMatrix() const;
-    glm::mat4 GetProjection() const;
+
+    /**
+     * @brief Reversed-Z perspective projection with an infinite far plane, to a [0, 1] clip space depth: the near plane
+     * is at depth 1 and the infinity at 0. Float depth buffers have most of their precision near 0, reversing the range
+     * spreads it almost evenly over the view distance, so there is no far plane to tune. Y points up, like in OpenGL.
+     */
+    glm::mat4 GetProjection(float aAspectRatio) const;
 
     void Update();
 
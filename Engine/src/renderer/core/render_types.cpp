@@ -4,6 +4,7 @@
 #include <core/logger.h>
 #include <engine.hpp>
 #include <renderer/vulkan/vk_types.hpp>
+#include <renderer/resources/asset_registry.hpp>
 
 #include <unordered_map>
 
@@ -45,8 +46,6 @@ sMeshData::sMeshData(const sMeshData& aMeshData)
     Indices16 = std::move(aMeshData.Indices16);
 }
 
-std::unordered_map<std::string, sMeshData*> sMeshData::LoadedMeshes;
-
 // TODO: Better way to differentiate between procedural and path meshes.
 // In the final engine, all meshes should have an ID and the engine should not care about the real path, 
 // since it should work with the IDs.
@@ -58,25 +57,19 @@ sMeshData* sMeshData::GetMeshData(const std::string& aFilename)
 
 sMeshData* sMeshData::GetMeshDataFromFile(const std::string& aFilename)
 {
-    const auto& FoundMesh = LoadedMeshes.find(aFilename);
-    if (FoundMesh != LoadedMeshes.cend())
-    {
-        return FoundMesh->second;
-    }
-    else 
+    return CAssetRegistry::GetMeshes().FindOrCreate(assets::Intern(aFilename), [&]() -> sMeshData*
     {
         sMeshData* MeshData = new sMeshData();
         if (renderutils::LoadMeshFromFile(aFilename, *MeshData))
         {
-            LoadedMeshes[aFilename] = MeshData;
-            return LoadedMeshes.at(aFilename);
+            return MeshData;
         }
         else
         {
             delete MeshData;
             return nullptr;
         }
-    }
+    });
 }
 
 // TODO: Right now the params are hardcoded.
@@ -123,8 +116,7 @@ sMeshData* sMeshData::GetMeshDataFromProceduralPrimitive(const std::string& aID)
 
 bool sMeshData::HasMeshData(const std::string& aFilename)
 {
-    const auto& FoundMeshData = LoadedMeshes.find(aFilename);
-	return FoundMeshData != LoadedMeshes.cend();
+    return CAssetRegistry::GetMeshes().FindIndex(assets::Intern(aFilename)) != INVALID_ASSET_INDEX;
 }
 
 CRenderable* CRenderable::Create()
@@ -179,7 +171,7 @@ CRenderable* CRenderable::Create(sMeshData* apMeshData)
 
 CMeshNode::CMeshNode() : 
     m_Name(""), m_bVisible(true), m_bOpaque(true), m_Model(glm::mat4(1)), 
-    m_WorldModel(glm::mat4(1)), m_pMeshData(nullptr), m_pParent(nullptr), m_Children()
+    m_WorldModel(glm::mat4(1)), m_pMeshData(nullptr), m_pParent(nullptr), m_pFirstChild(nullptr), m_pNextSibling(nullptr)
 {
 }
 
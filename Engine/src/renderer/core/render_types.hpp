@@ -4,6 +4,10 @@
 #define GLM_ENABLE_EXPERIMENTAL
 #include <glm/gtx/hash.hpp>
 
+#include <core/pool_allocator.hpp>
+#include <renderer/core/animation.hpp>
+
+#include <memory>
 #include <string>
 #include <vector>
 #include <unordered_map>
@@ -30,6 +34,16 @@ struct sVertex
     }
 };
 
+/**
+ * @brief Joints influencing a vertex of a skinned renderable and their weights, which add up to one. Vertices with no
+ * weights are not skinned. Laid out as the skin vertices of skinning.comp.
+ */
+struct sSkinVertex
+{
+    glm::uvec4 Joints = glm::uvec4(0);
+    glm::vec4 Weights = glm::vec4(0.0f);
+};
+
 namespace std {
 	template<> struct hash<sVertex> {
 		size_t operator()(sVertex const& Vertex) const {
@@ -87,18 +101,66 @@ public:
     }
 
 private:
-    static std::unordered_map<std::string, sMeshData*> LoadedMeshes;
-
     static sMeshData* GetMeshDataFromFile(const std::string& aFilename);
     static sMeshData* GetMeshDataFromProceduralPrimitive(const std::string& aID);
 
     std::vector<uint16_t> Indices16;
 };
 
+/**
+ * @brief Light infinitely far away, like the sun. It is the only light casting shadows.
+ */
+struct sDirectionalLight
+{
+    glm::vec3 Direction = glm::vec3(-0.3f, -1.0f, -0.2f);
+    float Intensity = 1.0f;
+    glm::vec3 Color = glm::vec3(1.0f);
+};
+
+/**
+ * @brief Light emitting in every direction. It has no influence further than Radius.
+ */
+struct sPointLight
+{
+    glm::vec3 Position = glm::vec3(0.0f);
+    float Radius = 10.0f;
+    glm::vec3 Color = glm::vec3(1.0f);
+    float Intensity = 1.0f;
+};
+
+/**
+ * @brief Light emitting in a cone. The angles are measured from the direction, in radians.
+ * The light fades between InnerAngle and OuterAngle.
+ */
+struct sSpotLight
+{
+    glm::vec3 Position = glm::vec3(0.0f);
+    float Radius = 10.0f;
+    glm::vec3 Direction = glm::vec3(0.0f, -1.0f, 0.0f);
+    float InnerAngle = 0.3f;
+    glm::vec3 Color = glm::vec3(1.0f);
+    float OuterAngle = 0.5f;
+    float Intensity = 1.0f;
+};
+
 enum class eRenderPath : uint8_t
 {
     FORWARD = 0,
     DEFERRED,
+    // Deferred with the G-Buffer and light passes as subpasses of a single render pass.
+    DEFERRED_SINGLE_PASS,
+    NUM
+};
+
+// How the swapchain queues the presented images. Falls back to FIFO, the only one always supported.
+enum class ePresentMode : uint8_t
+{
+    // V-Sync. Frames wait for the vertical blank in a queue, with several frames in flight they wait in it too.
+    FIFO = 0,
+    // V-Sync, but a new frame replaces the one waiting for the vertical blank instead of queuing behind it.
+    MAILBOX,
+    // No V-Sync, frames are shown right away and may tear.
+    IMMEDIATE,
     NUM
 };
 
@@ -117,7 +179,6 @@ class CMeshNode
 {
 public:
     CMeshNode();
-    ~CMeshNode();
 
     glm::mat4 GetWorldTransform(bool bFast = false);
 
@@ -127,9 +188,24 @@ public:
     glm::mat4 m_Model;
     glm::mat4 m_WorldModel;
 
+    // Owned by the sMeshStorage of the renderable, like the node.
     sMeshData* m_pMeshData;
     CMeshNode* m_pParent;
-    std::vector<CMeshNode*> m_Children;
+    // Children are linked through m_pNextSibling, in the order they were added:
+    // for (CMeshNode* pChild = pNode->m_pFirstChild; pChild; pChild = pChild->m_pNextSibling)
+    CMeshNode* m_pFirstChild;
+    CMeshNode* m_pNextSibling;
+};
+
+/**
+ * @brief Storage of the hierarchy of a renderable. Nodes, meshes and submeshes are allocated from slabs, so the
+ * hierarchy is contiguous in memory and destroying the renderable frees all of it at once instead of node by node.
+ */
+struct sMeshStorage
+{
+    CPool<CMeshNode> MeshNodes;
+    CPool<sMeshData> MeshDatas;
+    CPool<CSubMesh> SubMeshes;
 };
 
 class CRenderable
@@ -138,21 +214,33 @@ public:
     static CRenderable* Create();
     /**
      * @brief Creates a CRenderable with a node containing the info passed as sMeshData.
-     * @param apMeshData The apMeshData to create the node from.
+     * @param apMeshData The apMeshData to create the node from. It is copied, the caller keeps its ownership.
      * @return The new renderable.
      */
     static CRenderable* Create(sMeshData* apMeshData);
 
     CRenderable() = default;
     CRenderable(sMeshData* apMeshData);
-    ~CRenderable();
+    virtual ~CRenderable() = default;
 
     virtual void UploadToVRAM() = 0;
 
     std::string m_Name;
+    // Nodes, meshes and submeshes of m_pRoots.
+    sMeshStorage m_Storage;
     std::vector<CMeshNode*> m_pRoots;
     std::vector<sVertex> m_Vertices;
     std::vector<uint32_t> m_Indices;
     uint32_t m_VerticesCount;
     uint32_t m_IndicesCount;
+    // Static renderables never move after being added to the scene, their shadows are cached.
+    bool m_bIsStatic = true;
+
+    bool IsSkinned() const { return m_pSkeleton != nullptr; }
+
+    // Skeleton deforming every vertex of the renderable, null for the rigid ones. m_SkinVertices is parallel to
+    // m_Vertices and released with it on upload.
+    std::unique_ptr<sSkeleton> m_pSkeleton;
+    std::vector<sSkinVertex> m_SkinVertices;
+    std::vector<sAnimationClip> m_AnimationClips;
 };
\ No newline at end of file
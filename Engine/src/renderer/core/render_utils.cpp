@@ -1,11 +1,14 @@
 #include "render_utils.hpp"
 #include <core/logger.h>
+#include <core/profiler.hpp>
 
 #define TINYOBJLOADER_IMPLEMENTATION
 #include <tinyobjloader/tiny_obj_loader.h>
 
 bool renderutils::LoadMeshFromFile(const std::string& aFilename, sMeshData& aOutMesh)
 {
+	SGS_PROFILE_FUNCTION();
+
 	const auto& FoundMesh = sMeshData::HasMeshData(aFilename);
 	if (FoundMesh)
 	{
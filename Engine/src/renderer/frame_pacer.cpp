@@ -0,0 +1,134 @@
+#include "frame_pacer.hpp"
+#include "core/profiler.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <thread>
+
+namespace
+{
+    // Weight of the last frame in the smoothed frame interval and latency.
+    constexpr double INTERVAL_SMOOTHING = 0.1;
+    constexpr double LATENCY_SMOOTHING = 0.05;
+    // The CPU work estimate follows spikes right away and decays slowly, so one slow frame does not make the next
+    // ones late.
+    constexpr double WORK_RISE = 0.5;
+    constexpr double WORK_DECAY = 0.05;
+    // Frames further apart than this (loading, window dragged) restart the prediction.
+    constexpr uint64_t MAX_FRAME_INTERVAL_NS = 250'000'000;
+    // The OS sleeps are coarse, the last part of a wait spins.
+    constexpr uint64_t SPIN_NS = 2'000'000;
+
+    void SleepUntil(uint64_t aTimeNs)
+    {
+        uint64_t NowNs = profiler::GetTimeNs();
+        if (aTimeNs > NowNs + SPIN_NS)
+        {
+            std::this_thread::sleep_for(std::chrono::nanoseconds(aTimeNs - NowNs - SPIN_NS));
+        }
+
+        while (profiler::GetTimeNs() < aTimeNs)
+        {
+            std::this_thread::yield();
+        }
+    }
+}
+
+CFramePacer::CFramePacer() :
+    m_bHasReadyFrame(false),
+    m_LastReadyFrame(0),
+    m_LastReadyNs(0),
+    m_FrameIntervalNs(0.0),
+    m_WorkNs(0.0),
+    m_LatencyNs(0.0),
+    m_LastSleepNs(0)
+{
+}
+
+void CFramePacer::SetSettings(const sFramePacingSettings& aSettings)
+{
+    m_Settings = aSettings;
+
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    m_bHasReadyFrame = false;
+    m_FrameIntervalNs = 0.0;
+    m_WorkNs = 0.0;
+    m_LatencyNs = 0.0;
+    m_LastSleepNs = 0;
+}
+
+uint64_t CFramePacer::WaitForFrameStart(uint64_t aFrameNumber)
+{
+    SGS_PROFILE_FUNCTION();
+
+    uint64_t StartNs = 0;
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_LastSleepNs = 0;
+        if (!m_Settings.bLowLatency || !m_bHasReadyFrame || m_FrameIntervalNs <= 0.0 || aFrameNumber <= m_LastReadyFrame)
+        {
+            return profiler::GetTimeNs();
+        }
+
+        const double PredictedReadyNs = static_cast<double>(m_LastReadyNs) + static_cast<double>(aFrameNumber - m_LastReadyFrame) * m_FrameIntervalNs;
+        const double StartTimeNs = PredictedReadyNs - m_WorkNs - SGS_FRAME_PACING_MARGIN_MS * 1e6;
+        const uint64_t NowNs = profiler::GetTimeNs();
+        if (StartTimeNs <= static_cast<double>(NowNs))
+        {
+            return NowNs;
+        }
+
+        // A wrong prediction never stalls the main thread for more than a couple of frames.
+        const uint64_t MaxSleepNs = std::min(static_cast<uint64_t>(2.0 * m_FrameIntervalNs), MAX_FRAME_INTERVAL_NS);
+        m_LastSleepNs = std::min(static_cast<uint64_t>(StartTimeNs) - NowNs, MaxSleepNs);
+        StartNs = NowNs + m_LastSleepNs;
+    }
+
+    SleepUntil(StartNs);
+    return profiler::GetTimeNs();
+}
+
+void CFramePacer::ReportFrameReady(const sFramePacket& aFramePacket, uint64_t aWorkNs, uint64_t aReadyNs)
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+
+    if (m_bHasReadyFrame && aFramePacket.FrameNumber > m_LastReadyFrame && aReadyNs > m_LastReadyNs)
+    {
+        const double IntervalNs = static_cast<double>(aReadyNs - m_LastReadyNs) / static_cast<double>(aFramePacket.FrameNumber - m_LastReadyFrame);
+        if (IntervalNs < MAX_FRAME_INTERVAL_NS)
+        {
+            m_FrameIntervalNs = m_FrameIntervalNs > 0.0 ? m_FrameIntervalNs + (IntervalNs - m_FrameIntervalNs) * INTERVAL_SMOOTHING : IntervalNs;
+        }
+        else
+        {
+            m_FrameIntervalNs = 0.0;
+        }
+    }
+
+    const double WorkNs = static_cast<double>(aWorkNs);
+    m_WorkNs += (WorkNs - m_WorkNs) * (WorkNs > m_WorkNs ? WORK_RISE : WORK_DECAY);
+
+    m_bHasReadyFrame = true;
+    m_LastReadyFrame = aFramePacket.FrameNumber;
+    m_LastReadyNs = aReadyNs;
+}
+
+void CFramePacer::ReportLatency(uint64_t aLatencyNs)
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+
+    const double LatencyNs = static_cast<double>(aLatencyNs);
+    m_LatencyNs = m_LatencyNs > 0.0 ? m_LatencyNs + (LatencyNs - m_LatencyNs) * LATENCY_SMOOTHING : LatencyNs;
+}
+
+float CFramePacer::GetLatencyMs() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return static_cast<float>(m_LatencyNs * 1e-6);
+}
+
+float CFramePacer::GetSleepMs() const
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return static_cast<float>(m_LastSleepNs * 1e-6);
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include "frame_packet.hpp"
+
+#include <cstdint>
+#include <mutex>
+
+// Time a frame is started ahead of the predicted start, in milliseconds. Absorbs the jitter of the CPU work, too
+// small and the GPU idles waiting for the frame, too big and the input waits in the queue.
+#ifndef SGS_FRAME_PACING_MARGIN_MS
+#define SGS_FRAME_PACING_MARGIN_MS 1.0f
+#endif
+
+/**
+ * @brief Frame pacing options, applied by the backend when a frame packet carries different ones.
+ */
+struct sFramePacingSettings
+{
+    ePresentMode PresentMode = ePresentMode::FIFO;
+    // 1 to FRAME_OVERLAP. Fewer frames in flight queue less work ahead of the GPU, which lowers the latency, but
+    // leave less room to absorb spikes of the CPU work.
+    uint32_t FramesInFlight = 2;
+    // Delays the start of the frames so the input is sampled as late as possible, see CFramePacer.
+    bool bLowLatency = true;
+};
+
+/**
+ * @brief Sleeps the main thread before it samples the input, so a frame starts just in time for the GPU to take it
+ * instead of waiting in the packet ring and on the fence of its frame with an input that gets older meanwhile.
+ *
+ * The render thread reports when each frame could be recorded (the fence of its frame was signaled and it got a
+ * swapchain image) and the CPU work it took to get there. The next of those times is predicted from the last one
+ * and the average interval between frames, and the main thread sleeps until it minus the CPU work and
+ * SGS_FRAME_PACING_MARGIN_MS. A frame that arrives late reports a later time, which moves the next ones earlier.
+ *
+ * Also keeps the latency from the input of a frame to the end of its GPU work. Thread safe.
+ */
+class CFramePacer
+{
+public:
+    CFramePacer();
+
+    const sFramePacingSettings& GetSettings() const { return m_Settings; }
+
+    /**
+     * @brief Main thread only. Forgets the predictions, the frames do not pace the same way with other settings.
+     */
+    void SetSettings(const sFramePacingSettings& aSettings);
+
+    /**
+     * @brief Main thread. Sleeps until frame aFrameNumber should start, when the low latency mode is on.
+     * @return When the frame started, in profiler::GetTimeNs(). The input must be sampled right after.
+     */
+    uint64_t WaitForFrameStart(uint64_t aFrameNumber);
+
+    /**
+     * @brief Render thread. The frame of aFramePacket could be recorded at aReadyNs, after aWorkNs of CPU work since
+     * its input was sampled (waits excluded).
+     */
+    void ReportFrameReady(const sFramePacket& aFramePacket, uint64_t aWorkNs, uint64_t aReadyNs);
+
+    /**
+     * @brief Render thread. Time from the input of a frame to the end of its GPU work.
+     */
+    void ReportLatency(uint64_t aLatencyNs);
+
+    float GetLatencyMs() const;
+    float GetSleepMs() const;
+
+private:
+    // Main thread only.
+    sFramePacingSettings m_Settings;
+
+    mutable std::mutex m_Mutex;
+    bool m_bHasReadyFrame;
+    uint64_t m_LastReadyFrame;
+    uint64_t m_LastReadyNs;
+    // Smoothed, in nanoseconds.
+    double m_FrameIntervalNs;
+    double m_WorkNs;
+    double m_LatencyNs;
+    uint64_t m_LastSleepNs;
+};
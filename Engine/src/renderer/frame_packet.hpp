@@ -0,0 +1,67 @@
+#pragma once
+
+#include <renderer/core/render_types.hpp>
+
+#include <glm/mat4x4.hpp>
+#include <glm/vec3.hpp>
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief Skinned renderable of the frame and the first of its skinning matrices in sFramePacket::JointMatrices.
+ */
+struct sSkinningInstance
+{
+    CRenderable* pRenderable = nullptr;
+    uint32_t FirstJoint = 0;
+};
+
+/**
+ * @brief Snapshot of everything the renderer needs to draw a frame. The main thread fills it from the camera and
+ * the scene and hands it to the render thread (see CRenderThread), which never reads the live scene. Once submitted
+ * it is immutable until the render thread is done with it.
+ *
+ * Packets are reused frame after frame, so the vectors keep their capacity and filling them does not allocate.
+ */
+struct sFramePacket
+{
+    uint64_t FrameNumber = 0;
+
+    // Framebuffer size of the window when the packet was built, the swapchain follows it.
+    uint32_t FramebufferWidth = 0;
+    uint32_t FramebufferHeight = 0;
+
+    eRenderPath RenderPath = eRenderPath::FORWARD;
+
+    // Frame pacing settings, see sFramePacingSettings. Changing them waits for the GPU.
+    ePresentMode PresentMode = ePresentMode::FIFO;
+    uint32_t FramesInFlight = 2;
+
+    // Pacing times of the main thread, in profiler::GetTimeNs() (see CFramePacer). When the input of the frame was
+    // sampled, how long the main thread waited for a free packet and when the packet was submitted.
+    uint64_t InputTimeNs = 0;
+    uint64_t PacketWaitNs = 0;
+    uint64_t SubmitTimeNs = 0;
+
+    glm::mat4 View = glm::mat4(1.0f);
+    // Reversed-Z with an infinite far plane, see CCamera::GetProjection().
+    glm::mat4 Proj = glm::mat4(1.0f);
+    glm::vec3 CameraPosition = glm::vec3(0.0f);
+    float FovY = 0.0f;
+    float NearPlane = 0.0f;
+
+    sDirectionalLight DirectionalLight;
+    std::vector<sPointLight> PointLights;
+    std::vector<sSpotLight> SpotLights;
+
+    // World transform of every draw of the scene, indexed by the draw order of the renderables (see sMeshComponent::DrawIndex).
+    std::vector<glm::mat4> ObjectTransforms;
+    // 1 for the draws inside the view frustum, indexed like ObjectTransforms. Culled by the main thread with the scene
+    // BVH, only the camera passes skip the rest, the shadow casters can be outside of the view.
+    std::vector<uint8_t> VisibleDraws;
+
+    // Skinning matrices of the animated renderables, sampled and blended by the scene (see sAnimatorComponent).
+    std::vector<glm::mat4> JointMatrices;
+    std::vector<sSkinningInstance> SkinningInstances;
+};
@@ -1,9 +1,11 @@
 #include "render_module.hpp"
 #include "core/logger.h"
 #include "engine.hpp"
+#include <core/profiler.hpp>
 #include <renderer/resources/material.hpp>
 #include <renderer/resources/texture.hpp>
 #include <renderer/resources/loaders/glTFLoader.hpp>
+#include <renderer/vulkan/vulkan_device.hpp>
 
 #include <glm/gtx/transform.hpp>
 #include <GLFW/glfw3.h>
@@ -13,6 +15,7 @@
 CRenderModule::CRenderModule() :
     m_pMainCamera(nullptr),
     m_pDefaultScene(nullptr),
+    m_FrameStartNs(0),
     m_pVulkanBackend(nullptr),
     m_CurrentRenderPath(eRenderPath::FORWARD),
     m_RenderAPI(eRenderAPI::VULKAN)
@@ -30,31 +33,107 @@ bool CRenderModule::Initialize()
     }
 
     m_pVulkanBackend->Initialize();
+    m_pVulkanBackend->SetFramePacer(&m_FramePacer);
     CreateDefaultScene();
     m_pVulkanBackend->CreateRenderablesData(m_pDefaultScene->GetRenderObjects());
 
+    // From now on the backend is only driven through the frame packets.
+    m_RenderThread.Start([this](const sFramePacket& aFramePacket)
+    {
+        m_pVulkanBackend->Render(aFramePacket);
+    });
+
     return true;
 }
 
 void CRenderModule::Update()
 {
+    SGS_PROFILE_FUNCTION();
+
     m_pMainCamera->Update();
-    
-    // TODO: Release old render path resources.
-    // Initialize new render path resources.
-    // If something went wrong, initialize render module again.
+    m_pDefaultScene->Update(CEngine::Get()->GetDeltaTime());
+
+    // Every render path is kept alive by the backend, switching only selects which one renders the next packets.
     if (glfwGetKey(CEngine::Get()->GetWindow(), GLFW_KEY_SPACE) == GLFW_PRESS)
     {
-        m_CurrentRenderPath = m_CurrentRenderPath == eRenderPath::FORWARD ? eRenderPath::DEFERRED : eRenderPath::FORWARD;
-        SGSINFO("Switching RenderPath to: %s.", m_CurrentRenderPath == eRenderPath::FORWARD ? "FORWARD" : "DEFERRED");
-        m_pVulkanBackend->ChangeRenderPath();
+        static const char* RenderPathNames[] = { "FORWARD", "DEFERRED", "DEFERRED_SINGLE_PASS" };
+        static_assert(sizeof(RenderPathNames) / sizeof(RenderPathNames[0]) == static_cast<size_t>(eRenderPath::NUM), "Missing render path names.");
+
+        m_CurrentRenderPath = static_cast<eRenderPath>((static_cast<size_t>(m_CurrentRenderPath) + 1) % static_cast<size_t>(eRenderPath::NUM));
+        SGSINFO("Switching RenderPath to: %s.", RenderPathNames[static_cast<size_t>(m_CurrentRenderPath)]);
+    }
+
+    // F12 starts a profiler capture and, pressed again, writes it.
+    static bool bWasCaptureKeyPressed = false;
+    const bool bIsCaptureKeyPressed = glfwGetKey(CEngine::Get()->GetWindow(), GLFW_KEY_F12) == GLFW_PRESS;
+    if (bIsCaptureKeyPressed && !bWasCaptureKeyPressed)
+    {
+        if (profiler::IsCapturing())
+        {
+            profiler::EndCapture("profiler_capture.json");
+        }
+        else
+        {
+            profiler::BeginCapture();
+        }
+    }
+    bWasCaptureKeyPressed = bIsCaptureKeyPressed;
+
+    // F11 dumps where the GPU memory goes.
+    static bool bWasMemoryReportKeyPressed = false;
+    const bool bIsMemoryReportKeyPressed = glfwGetKey(CEngine::Get()->GetWindow(), GLFW_KEY_F11) == GLFW_PRESS;
+    if (bIsMemoryReportKeyPressed && !bWasMemoryReportKeyPressed)
+    {
+        m_pVulkanBackend->GetDevice()->m_MemoryAllocator.WriteReport("gpu_memory_report.json");
     }
+    bWasMemoryReportKeyPressed = bIsMemoryReportKeyPressed;
+
+    // F8 toggles the low latency mode, F9 cycles the present modes and F10 the frames in flight. The latency measured
+    // with the previous settings is logged to compare them.
+    static bool bWasLowLatencyKeyPressed = false;
+    static bool bWasPresentModeKeyPressed = false;
+    static bool bWasFramesInFlightKeyPressed = false;
+    const bool bIsLowLatencyKeyPressed = glfwGetKey(CEngine::Get()->GetWindow(), GLFW_KEY_F8) == GLFW_PRESS;
+    const bool bIsPresentModeKeyPressed = glfwGetKey(CEngine::Get()->GetWindow(), GLFW_KEY_F9) == GLFW_PRESS;
+    const bool bIsFramesInFlightKeyPressed = glfwGetKey(CEngine::Get()->GetWindow(), GLFW_KEY_F10) == GLFW_PRESS;
+    if ((bIsLowLatencyKeyPressed && !bWasLowLatencyKeyPressed) || (bIsPresentModeKeyPressed && !bWasPresentModeKeyPressed) ||
+        (bIsFramesInFlightKeyPressed && !bWasFramesInFlightKeyPressed))
+    {
+        static const char* PresentModeNames[] = { "FIFO", "MAILBOX", "IMMEDIATE" };
+        static_assert(sizeof(PresentModeNames) / sizeof(PresentModeNames[0]) == static_cast<size_t>(ePresentMode::NUM), "Missing present mode names.");
+
+        sFramePacingSettings Settings = m_FramePacer.GetSettings();
+        SGSINFO("Latency: %.2f ms. Sleep before the frame: %.2f ms.", m_FramePacer.GetLatencyMs(), m_FramePacer.GetSleepMs());
+
+        if (bIsLowLatencyKeyPressed && !bWasLowLatencyKeyPressed)
+        {
+            Settings.bLowLatency = !Settings.bLowLatency;
+        }
+        if (bIsPresentModeKeyPressed && !bWasPresentModeKeyPressed)
+        {
+            Settings.PresentMode = static_cast<ePresentMode>((static_cast<size_t>(Settings.PresentMode) + 1) % static_cast<size_t>(ePresentMode::NUM));
+        }
+        if (bIsFramesInFlightKeyPressed && !bWasFramesInFlightKeyPressed)
+        {
+            Settings.FramesInFlight = Settings.FramesInFlight % FRAME_OVERLAP + 1;
+        }
+
+        m_FramePacer.SetSettings(Settings);
+        SGSINFO("Frame pacing: low latency %s, present mode %s, %u frames in flight.", Settings.bLowLatency ? "ON" : "OFF",
+            PresentModeNames[static_cast<size_t>(Settings.PresentMode)], Settings.FramesInFlight);
+    }
+    bWasLowLatencyKeyPressed = bIsLowLatencyKeyPressed;
+    bWasPresentModeKeyPressed = bIsPresentModeKeyPressed;
+    bWasFramesInFlightKeyPressed = bIsFramesInFlightKeyPressed;
 
     Render();
 }
 
 bool CRenderModule::Shutdown()
 {
+    // The frames in flight are finished before the backend goes away.
+    m_RenderThread.Stop();
+
     delete m_pMainCamera;
     delete m_pDefaultScene;
     return m_pVulkanBackend->Shutdown();
@@ -65,6 +144,11 @@ void CRenderModule::HandleWindowResize()
     m_pVulkanBackend->HandleWindowResize();
 }
 
+void CRenderModule::PaceFrame()
+{
+    m_FrameStartNs = m_FramePacer.WaitForFrameStart(m_RenderThread.GetNumSubmitted());
+}
+
 eRenderPath CRenderModule::GetRenderPath()
 {
     return m_CurrentRenderPath;
@@ -72,8 +156,51 @@ eRenderPath CRenderModule::GetRenderPath()
 
 void CRenderModule::Render()
 {
-    // TODO: Should this pointer be checked?
-    m_pVulkanBackend->Render(m_pMainCamera);
+    SGS_PROFILE_FUNCTION();
+
+    int Width = 0;
+    int Height = 0;
+    glfwGetFramebufferSize(CEngine::Get()->GetWindow(), &Width, &Height);
+    if (Width == 0 || Height == 0)
+    {
+        // Minimized, there is no swapchain to render to until the window comes back.
+        glfwWaitEvents();
+        return;
+    }
+
+    // Blocks while the render thread is still busy with every other packet. The frame pacer keeps that wait short.
+    const uint64_t AcquireStartNs = profiler::GetTimeNs();
+    sFramePacket& FramePacket = m_RenderThread.AcquirePacket();
+    const uint64_t PacketWaitNs = profiler::GetTimeNs() - AcquireStartNs;
+
+    BuildFramePacket(FramePacket, static_cast<uint32_t>(Width), static_cast<uint32_t>(Height));
+    FramePacket.InputTimeNs = m_FrameStartNs;
+    FramePacket.PacketWaitNs = PacketWaitNs;
+    FramePacket.SubmitTimeNs = profiler::GetTimeNs();
+    m_RenderThread.SubmitPacket();
+}
+
+void CRenderModule::BuildFramePacket(sFramePacket& aFramePacket, uint32_t aFramebufferWidth, uint32_t aFramebufferHeight) const
+{
+    aFramePacket.FramebufferWidth = aFramebufferWidth;
+    aFramePacket.FramebufferHeight = aFramebufferHeight;
+    aFramePacket.RenderPath = m_CurrentRenderPath;
+    aFramePacket.PresentMode = m_FramePacer.GetSettings().PresentMode;
+    aFramePacket.FramesInFlight = m_FramePacer.GetSettings().FramesInFlight;
+
+    aFramePacket.View = m_pMainCamera->GetViewMatrix();
+    aFramePacket.Proj = m_pMainCamera->GetProjection(static_cast<float>(aFramebufferWidth) / static_cast<float>(aFramebufferHeight));
+    aFramePacket.CameraPosition = m_pMainCamera->GetPosition();
+    aFramePacket.FovY = m_pMainCamera->m_FovY;
+    aFramePacket.NearPlane = m_pMainCamera->m_NearPlane;
+
+    aFramePacket.DirectionalLight = m_pDefaultScene->GetDirectionalLight();
+    aFramePacket.PointLights = m_pDefaultScene->GetPointLights();
+    aFramePacket.SpotLights = m_pDefaultScene->GetSpotLights();
+
+    m_pDefaultScene->GatherDrawTransforms(aFramePacket.ObjectTransforms);
+    m_pDefaultScene->GatherVisibleDraws(sFrustum::FromViewProj(aFramePacket.Proj * aFramePacket.View), aFramePacket.VisibleDraws);
+    m_pDefaultScene->GatherSkinning(aFramePacket.JointMatrices, aFramePacket.SkinningInstances);
 }
 
 std::unordered_map<std::string, sRenderObjectInfo> CRenderModule::m_RenderObjectInfos{};
@@ -83,18 +210,23 @@ void CRenderModule::CreateDefaultScene()
     // Add materials.
     const auto& DefaultTexture = CTexture::Get<CTexture>("../Resources/Images/default_texture.png");
 
-    CMaterial* pDefaultMaterial = new CMaterial();
-    sMaterialProperties Props;
+    CMaterial* pDefaultMaterial = CMaterial::Create();
+    sMaterialProperties Props = {};
+    Props.MaterialConstants.Color = glm::vec4(1.0f);
+    Props.MaterialConstants.MetallicFactor = 1.0f;
+    Props.MaterialConstants.RoughnessFactor = 1.0f;
+    Props.MaterialConstants.TillingFactor = 1.0f;
     Props.pAlbedoTexture = DefaultTexture;
     Props.pMetallicRoughnessTexture = DefaultTexture;
     Props.pEmissiveTexture = DefaultTexture;
-    Props.pNormalTexture = DefaultTexture;
+    // No normal map, the backend gives it a flat one.
+    Props.pNormalTexture = nullptr;
     pDefaultMaterial->SetMaterialProperties(Props);
     pDefaultMaterial->SetID("default_material");
 
     CMaterial::RegisterMaterial(pDefaultMaterial);
 
-    CMaterial* pTestMaterial = new CMaterial();
+    CMaterial* pTestMaterial = CMaterial::Create();
     Props.MaterialConstants.Color = glm::vec4(0.0f, 1.0f, 0.0f, 1.0f);
     Props.MaterialConstants.EmissiveFactor = glm::vec4(1.0f, 1.0f, 1.0f, 1.0f);
     Props.MaterialConstants.MetallicFactor = 0.5f;
@@ -121,9 +253,43 @@ void CRenderModule::CreateDefaultScene()
     // pSphere->m_pRoots.push_back(pSphereNode);
 
     CRenderable* pPato = LoadGLTF("../Resources/Prefabs/Duck.glb", 0.1f);
-    pPato->UploadToVRAM();
 
     m_pDefaultScene = new CScene();
     //m_pDefaultScene->AddRenderable(pSphere);
+    // Added before the upload, the scene computes the bounds from the vertices.
     m_pDefaultScene->AddRenderable(pPato);
+    pPato->UploadToVRAM();
+
+    sDirectionalLight Sun;
+    Sun.Direction = glm::vec3(-0.4f, -1.0f, -0.3f);
+    Sun.Color = glm::vec3(1.0f, 0.95f, 0.85f);
+    Sun.Intensity = 2.0f;
+    m_pDefaultScene->SetDirectionalLight(Sun);
+
+    // A grid of small colored point lights around the duck and a couple of spot lights looking down at it.
+    const glm::vec3 LightColors[] = { {1.0f, 0.3f, 0.3f}, {0.3f, 1.0f, 0.3f}, {0.3f, 0.3f, 1.0f}, {1.0f, 1.0f, 0.5f} };
+    for (int32_t x = -4; x <= 4; ++x)
+    {
+        for (int32_t z = -4; z <= 4; ++z)
+        {
+            sPointLight PointLight;
+            PointLight.Position = glm::vec3(x * 2.0f, 1.0f, z * 2.0f);
+            PointLight.Radius = 3.0f;
+            PointLight.Color = LightColors[(x + z + 8) % 4];
+            PointLight.Intensity = 2.0f;
+            m_pDefaultScene->AddPointLight(PointLight);
+        }
+    }
+
+    sSpotLight SpotLight;
+    SpotLight.Position = glm::vec3(0.0f, 10.0f, 4.0f);
+    SpotLight.Radius = 30.0f;
+    SpotLight.Direction = glm::normalize(glm::vec3(0.0f, -10.0f, -4.0f));
+    SpotLight.Intensity = 4.0f;
+    m_pDefaultScene->AddSpotLight(SpotLight);
+
+    SpotLight.Position = glm::vec3(-6.0f, 8.0f, -6.0f);
+    SpotLight.Direction = glm::normalize(glm::vec3(6.0f, -8.0f, 6.0f));
+    SpotLight.Color = glm::vec3(1.0f, 0.8f, 0.6f);
+    m_pDefaultScene->AddSpotLight(SpotLight);
 }
@@ -3,6 +3,8 @@
 #include "vulkan/vulkan_backend.hpp"
 #include "vulkan/vulkan_device.hpp"
 #include "scene.hpp"
+#include "render_thread.hpp"
+#include "frame_pacer.hpp"
 #include "core/camera.hpp"
 #include <core/IModule.hpp>
 
@@ -26,6 +28,12 @@ public:
     virtual bool Shutdown() override;
 
     void HandleWindowResize();
+
+    /**
+     * @brief Sleeps until the next frame should start (see CFramePacer). Called at the start of the frame, right
+     * before the input is polled.
+     */
+    void PaceFrame();
     // TODO: Design a generic way to handle input. Use layers (if an input is consumed in a top layer, do not go to the next layer) and my own
     // enum to represent keys.
 
@@ -36,7 +44,11 @@ public:
     CVulkanDevice*  GetVulkanDevice() const { return m_pVulkanBackend->GetDevice(); }
 
 private:
+    /**
+     * @brief Builds the frame packet of the current frame and hands it to the render thread.
+     */
     void Render();
+    void BuildFramePacket(sFramePacket& aFramePacket, uint32_t aFramebufferWidth, uint32_t aFramebufferHeight) const;
 
     void CreateDefaultScene();
 
@@ -47,9 +59,17 @@ private:
     // TODO: An scene is fed to the renderer but should not be part of it. What should be part of it, is a processed scene (for scene graph use purposes for example).
     CScene* m_pDefaultScene;
 
+    // Outlives the backend, which reports the frames to it.
+    CFramePacer m_FramePacer;
+    // When the input of the current frame was sampled, in profiler::GetTimeNs().
+    uint64_t m_FrameStartNs;
+
     // TODO: This backend in the future, could be other graphics API.
     std::unique_ptr<CVulkanBackend> m_pVulkanBackend;
 
+    // Records and submits the frame packets built by Render().
+    CRenderThread m_RenderThread;
+
     eRenderPath m_CurrentRenderPath;
 
     eRenderAPI m_RenderAPI;
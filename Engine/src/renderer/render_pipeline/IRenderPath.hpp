@@ -1,6 +1,7 @@
 #pragma once
 
-class CCamera;
+struct sFramePacket;
+struct sJobCounter;
 
 /**
  * @brief Interface to interact a RenderPath and manage its resources and commands.
@@ -8,21 +9,29 @@ class CCamera;
 class IRenderPath
 {
 public:
+    virtual ~IRenderPath() = default;
+
     /**
      * @brief Creates all resources needed for the IRenderPath.
      */
     virtual void CreateResources() = 0;
 
+    /**
+     * @brief Queues the creation of the pipelines of the IRenderPath in the job system. Must be called after CreateResources.
+     * @param aCounter Counter to wait on before using the pipelines.
+     */
+    virtual void CreatePipelines(sJobCounter& aCounter) = 0;
+
     /**
      * @brief Destroy all resources owned by the IRenderPath.
      */
     virtual void DestroyResources() = 0;
 
     /**
-     * @brief Renders the scene.
-     * @param aCamera Point of view to render the scene from.
+     * @brief Records and submits a frame. Called from the render thread.
+     * @param aFramePacket Camera, lights and objects of the frame, built by the main thread.
      */
-    virtual void Render(const CCamera* const aCamera) = 0;
+    virtual void Render(const sFramePacket& aFramePacket) = 0;
 
     /**
      * @brief Updates the content of the buffers accessed by GPU, like uniform buffers.
@@ -34,4 +43,10 @@ public:
      * Useful to record new commands to adapt to the change.
      */
     virtual void HandleSceneChanged() = 0;
+
+    /**
+     * @brief Called after the swapchain has been recreated (e.g. window resize) to adapt the size dependent resources.
+     * The GPU is idle when this is called.
+     */
+    virtual void HandleSwapchainRecreated() = 0;
 };
\ No newline at end of file
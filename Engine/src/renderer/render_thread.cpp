@@ -0,0 +1,123 @@
+#include "render_thread.hpp"
+#include "core/logger.h"
+#include "core/profiler.hpp"
+
+#include <cassert>
+
+CRenderThread::CRenderThread() :
+    m_NumSubmitted(0),
+    m_NumRendered(0),
+    m_bStopRequested(false)
+{
+}
+
+CRenderThread::~CRenderThread()
+{
+    Stop();
+}
+
+void CRenderThread::Start(RenderFunction&& aRenderFunction)
+{
+    assert(!m_Thread.joinable());
+
+    m_RenderFunction = std::move(aRenderFunction);
+    m_bStopRequested = false;
+    m_Thread = std::thread(&CRenderThread::ThreadMain, this);
+}
+
+void CRenderThread::Stop()
+{
+    if (!m_Thread.joinable())
+    {
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        m_bStopRequested = true;
+    }
+    m_PacketSubmitted.notify_one();
+    m_Thread.join();
+}
+
+sFramePacket& CRenderThread::AcquirePacket()
+{
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    m_PacketRendered.wait(Lock, [this] { return m_NumSubmitted - m_NumRendered < SGS_NUM_FRAME_PACKETS || m_RenderError; });
+    RethrowRenderError();
+
+    sFramePacket& Packet = m_Packets[m_NumSubmitted % SGS_NUM_FRAME_PACKETS];
+    Packet.FrameNumber = m_NumSubmitted;
+    return Packet;
+}
+
+void CRenderThread::SubmitPacket()
+{
+    {
+        std::lock_guard<std::mutex> Lock(m_Mutex);
+        ++m_NumSubmitted;
+    }
+    m_PacketSubmitted.notify_one();
+}
+
+uint64_t CRenderThread::GetNumSubmitted()
+{
+    std::lock_guard<std::mutex> Lock(m_Mutex);
+    return m_NumSubmitted;
+}
+
+void CRenderThread::WaitIdle()
+{
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    m_PacketRendered.wait(Lock, [this] { return m_NumRendered == m_NumSubmitted || m_RenderError; });
+    RethrowRenderError();
+}
+
+void CRenderThread::RethrowRenderError()
+{
+    if (m_RenderError)
+    {
+        std::exception_ptr Error = m_RenderError;
+        m_RenderError = nullptr;
+        std::rethrow_exception(Error);
+    }
+}
+
+void CRenderThread::ThreadMain()
+{
+    SGSINFO("Render thread started.");
+    profiler::SetThreadName("Render Thread");
+
+    std::unique_lock<std::mutex> Lock(m_Mutex);
+    while (true)
+    {
+        // Stopping still renders what was submitted, the main thread may be waiting on it.
+        m_PacketSubmitted.wait(Lock, [this] { return m_NumRendered < m_NumSubmitted || m_bStopRequested; });
+        if (m_NumRendered == m_NumSubmitted)
+        {
+            break;
+        }
+
+        const sFramePacket& Packet = m_Packets[m_NumRendered % SGS_NUM_FRAME_PACKETS];
+        Lock.unlock();
+
+        try
+        {
+            m_RenderFunction(Packet);
+        }
+        catch (...)
+        {
+            Lock.lock();
+            m_RenderError = std::current_exception();
+            m_NumRendered = m_NumSubmitted;
+            m_PacketRendered.notify_all();
+            break;
+        }
+
+        Lock.lock();
+        ++m_NumRendered;
+        m_PacketRendered.notify_all();
+    }
+
+    SGSINFO("Render thread stopped.");
+}
@@ -0,0 +1,74 @@
+#pragma once
+
+#include "frame_packet.hpp"
+
+#include <array>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Frame packets in the ring between the main thread and the render thread. With 2 the main thread builds a frame
+// while the previous one is recorded and submitted. Can be overridden at build time (/DSGS_NUM_FRAME_PACKETS=3).
+#ifndef SGS_NUM_FRAME_PACKETS
+#define SGS_NUM_FRAME_PACKETS 2
+#endif
+
+/**
+ * @brief Thread that records and submits the frames, so the CPU work of the main thread for a frame overlaps with
+ * the submission of the previous one.
+ *
+ * The main thread acquires a packet, fills it and submits it. The render thread renders the packets in order and
+ * releases them. Acquiring blocks while every packet is queued or being rendered, which bounds how far ahead the
+ * main thread can run. An exception thrown while rendering stops the thread and is rethrown on the main thread.
+ */
+class CRenderThread
+{
+public:
+    using RenderFunction = std::function<void(const sFramePacket& aFramePacket)>;
+
+    CRenderThread();
+    ~CRenderThread();
+
+    void Start(RenderFunction&& aRenderFunction);
+
+    /**
+     * @brief Renders the packets already submitted and joins the thread.
+     */
+    void Stop();
+
+    /**
+     * @brief Packet to fill for the next frame. Must be followed by SubmitPacket().
+     */
+    sFramePacket& AcquirePacket();
+    void SubmitPacket();
+
+    /**
+     * @brief Packets submitted so far, the frame number of the next one.
+     */
+    uint64_t GetNumSubmitted();
+
+    /**
+     * @brief Blocks until every submitted packet has been rendered. The render thread does not touch any renderer
+     * state afterwards until a new packet is submitted.
+     */
+    void WaitIdle();
+
+private:
+    void ThreadMain();
+    void RethrowRenderError();
+
+    std::array<sFramePacket, SGS_NUM_FRAME_PACKETS> m_Packets;
+    RenderFunction m_RenderFunction;
+    std::thread m_Thread;
+
+    std::mutex m_Mutex;
+    std::condition_variable m_PacketSubmitted;
+    std::condition_variable m_PacketRendered;
+    // Total packets submitted and rendered. Packet N lives in m_Packets[N % SGS_NUM_FRAME_PACKETS].
+    uint64_t m_NumSubmitted;
+    uint64_t m_NumRendered;
+    bool m_bStopRequested;
+    std::exception_ptr m_RenderError;
+};
@@ -0,0 +1,19 @@
+#include "asset_registry.hpp"
+
+CAssetTable<CTexture>& CAssetRegistry::GetTextures()
+{
+    static CAssetTable<CTexture> Textures;
+    return Textures;
+}
+
+CAssetTable<CMaterial>& CAssetRegistry::GetMaterials()
+{
+    static CAssetTable<CMaterial> Materials;
+    return Materials;
+}
+
+CAssetTable<sMeshData>& CAssetRegistry::GetMeshes()
+{
+    static CAssetTable<sMeshData> Meshes;
+    return Meshes;
+}
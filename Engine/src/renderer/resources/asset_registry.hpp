@@ -0,0 +1,19 @@
+#pragma once
+
+#include <core/asset_table.hpp>
+
+class CTexture;
+class CMaterial;
+struct sMeshData;
+
+/**
+ * @brief Owner of the asset tables of the renderer. Assets are looked up by name (through its AssetID) only when
+ * they are loaded, the render paths use the dense index of every asset instead.
+ */
+class CAssetRegistry
+{
+public:
+    static CAssetTable<CTexture>& GetTextures();
+    static CAssetTable<CMaterial>& GetMaterials();
+    static CAssetTable<sMeshData>& GetMeshes();
+};
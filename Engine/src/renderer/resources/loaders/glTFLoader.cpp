@@ -4,113 +4,182 @@
 
 // TODO: What does this do?
 #define TINYGLTF_NO_STB_IMAGE_WRITE
+// Images are decoded by the loader itself (see DecodeImages).
+#define TINYGLTF_NO_STB_IMAGE
 #define STBI_MSC_SECURE_CRT
 #include <tinygltf/tiny_gltf.h>
+#include <stb_image/stb_image.h>
 
 #include <renderer/core/render_types.hpp>
 #include <renderer/resources/texture.hpp>
 #include <renderer/resources/material.hpp>
 #include <core/logger.h>
 #include <core/utils.hpp>
+#include <core/job_system.hpp>
+#include <core/profiler.hpp>
 
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/quaternion.hpp>
 #include <glm/gtc/type_ptr.hpp>
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <numeric>
 #include <vector>
 
-CMeshNode::~CMeshNode()
+/**
+ * @brief Range of the renderable vertex/index buffers that a glTF primitive is converted into.
+ */
+struct sGLTFPrimitiveRange
 {
-    for (CMeshNode* pMeshNode : m_Children)
+    const tinygltf::Primitive* pPrimitive;
+    uint32_t FirstVertex;
+    uint32_t VertexCount;
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    // The primitive belongs to a node deformed by the imported skin.
+    bool bSkinned;
+};
+
+/**
+ * @brief State of a single glTF import. Each LoadGLTF call owns its own context, so several files can be imported at the same time.
+ */
+struct sGLTFLoadContext
+{
+    std::string Filename;
+    // The hierarchy is built here and moved into the renderable once the file is loaded.
+    sMeshStorage Storage;
+    std::vector<CMeshNode*> Nodes;
+    std::vector<CTexture*> Textures;
+    std::vector<CMaterial*> Materials;
+    std::vector<sGLTFPrimitiveRange> Primitives;
+    uint32_t VertexCount = 0;
+    uint32_t IndexCount = 0;
+
+    // Only one skin is imported per file, see LoadSkin.
+    int32_t SkinIndex = -1;
+    std::unique_ptr<sSkeleton> pSkeleton;
+    // Joint of the skeleton of every joint index of the skin, and of every node (-1 for the nodes that are no joint).
+    std::vector<uint32_t> JointRemap;
+    std::vector<int32_t> NodeJoints;
+    std::vector<sAnimationClip> AnimationClips;
+};
+
+/**
+ * @brief tinygltf image callback. Only keeps the encoded bytes, images are decoded later in parallel by DecodeImages.
+ */
+static bool StoreEncodedImage(tinygltf::Image* apImage, const int aImageIndex, std::string* apError, std::string* apWarning,
+    int aRequiredWidth, int aRequiredHeight, const unsigned char* apBytes, int aSize, void* apUserData)
+{
+    apImage->image.assign(apBytes, apBytes + aSize);
+    apImage->width = -1;
+    apImage->height = -1;
+    apImage->component = -1;
+    return true;
+}
+
+static bool DecodeImage(tinygltf::Image& aGltfImage)
+{
+    if (aGltfImage.image.empty())
+    {
+        return false;
+    }
+
+    // Always ask for 4 channels, the textures are uploaded as RGBA.
+    int32_t Width, Height, Channels;
+    stbi_uc* Pixels = stbi_load_from_memory(aGltfImage.image.data(), static_cast<int>(aGltfImage.image.size()), &Width, &Height, &Channels, STBI_rgb_alpha);
+    if (!Pixels)
     {
-        delete pMeshNode;
+        SGSERROR("Failed to decode image %s: %s.", aGltfImage.name.c_str(), stbi_failure_reason());
+        aGltfImage.image.clear();
+        return false;
     }
 
-    delete m_pMeshData;
+    aGltfImage.width = Width;
+    aGltfImage.height = Height;
+    aGltfImage.component = 4;
+    aGltfImage.bits = 8;
+    aGltfImage.image.assign(Pixels, Pixels + static_cast<size_t>(Width) * Height * 4);
+    stbi_image_free(Pixels);
+
+    return true;
 }
 
-CRenderable::~CRenderable()
+static void DecodeImages(tinygltf::Model& aGltfModel)
 {
-    for (auto& Root : m_pRoots)
+    sJobCounter Counter;
+    jobs::Dispatch(Counter, static_cast<uint32_t>(aGltfModel.images.size()), 1, [&aGltfModel](uint32_t aImageIndex)
     {
-        delete Root;
-    }
+        DecodeImage(aGltfModel.images[aImageIndex]);
+    });
+    jobs::Wait(Counter);
 }
 
-struct sGLTFData
+static CTexture* TextureFromGLTFImage(const sGLTFLoadContext& aContext, const tinygltf::Image& aGltfImage, uint32_t aTextureIndex)
 {
-    std::string Filename;
-    std::vector<CMeshNode*> Nodes;
-    std::vector<CTexture*> Textures;
-    std::vector<CMaterial*> Materials;
-} LoadedData;
+    SGS_PROFILE_FUNCTION();
 
-static void TextureFromGLTFImage(tinygltf::Image& aGltfImage)
-{
-    unsigned char* Buffer = nullptr;
-	uint64_t BufferSize = 0;
-	bool bDeleteBuffer = false;
-
-	// Convert to rgba if it is rgb
-	if (aGltfImage.component == 3)
-	{
-		BufferSize = aGltfImage.width * aGltfImage.height * 4;
-		Buffer = new unsigned char[BufferSize];
-		unsigned char* rgba = Buffer;
-		unsigned char* rgb = &aGltfImage.image[0];
-		for (int32_t i = 0; i < aGltfImage.width * aGltfImage.height; ++i)
-		{
-			for (int32_t j = 0; j < 3; ++j)
-			{
-				rgba[j] = rgb[j];
-			}
-			rgba += 4;
-			rgb += 3;
-		}
-		bDeleteBuffer = true;
-	}
-	else
-	{
-		Buffer = &aGltfImage.image[0];
-		BufferSize = aGltfImage.image.size();
-	}
-
-    // Create and upload the image in the graphics API being used.
-    CTexture* pNewTexture = CTexture::Create(BufferSize, Buffer, aGltfImage.width, aGltfImage.height);
+    if (aGltfImage.image.empty())
+    {
+        return nullptr;
+    }
+
+    // Create and upload the image in the graphics API being used. Decoded images are always RGBA.
+    void* pPixels = const_cast<unsigned char*>(aGltfImage.image.data());
+    CTexture* pNewTexture = CTexture::Create(aGltfImage.image.size(), pPixels, aGltfImage.width, aGltfImage.height);
     std::string ID = aGltfImage.name;
     if (ID.empty())
     {
-        ID = LoadedData.Filename.append(std::to_string(LoadedData.Textures.size()));
+        ID = aContext.Filename + std::to_string(aTextureIndex);
     }
 
     pNewTexture->SetID(ID);
-    LoadedData.Textures.push_back(pNewTexture);
     CTexture::RegisterTexture(pNewTexture);
+
+    return pNewTexture;
 }
 
-static void LoadTextures(tinygltf::Model &aGltfModel)
+static void LoadTextures(sGLTFLoadContext& aContext, tinygltf::Model &aGltfModel)
 {
-    for(tinygltf::Texture &Tex : aGltfModel.textures) 
+    DecodeImages(aGltfModel);
+
+    // One texture per glTF texture, indexed as in the file so materials can reference them directly.
+    aContext.Textures.assign(aGltfModel.textures.size(), nullptr);
+
+    sJobCounter Counter;
+    jobs::Dispatch(Counter, static_cast<uint32_t>(aGltfModel.textures.size()), 1, [&aContext, &aGltfModel](uint32_t aTextureIndex)
     {
-        if (aGltfModel.images.size() <= 0) continue;
-        tinygltf::Image Image = aGltfModel.images[Tex.source];
+        const tinygltf::Texture& Tex = aGltfModel.textures[aTextureIndex];
+        if (Tex.source < 0 || Tex.source >= static_cast<int>(aGltfModel.images.size())) return;
         
-        TextureFromGLTFImage(Image);
+        aContext.Textures[aTextureIndex] = TextureFromGLTFImage(aContext, aGltfModel.images[Tex.source], aTextureIndex);
+    });
+    jobs::Wait(Counter);
+}
+
+static CTexture* GetContextTexture(const sGLTFLoadContext& aContext, int aTextureIndex)
+{
+    if (aTextureIndex < 0 || aTextureIndex >= static_cast<int>(aContext.Textures.size()))
+    {
+        return nullptr;
     }
+
+    return aContext.Textures[aTextureIndex];
 }
 
-static void LoadMaterials(tinygltf::Model &aGltfModel)
+static void LoadMaterials(sGLTFLoadContext& aContext, tinygltf::Model &aGltfModel)
 {
     for(tinygltf::Material &mat : aGltfModel.materials)
     {
-        CMaterial* pMaterial = new CMaterial();
+        CMaterial* pMaterial = CMaterial::Create();
         sMaterialProperties Props = {};
         if(mat.values.find("baseColorTexture") != mat.values.end()) {
-            CTexture* pAlbedoTexture = LoadedData.Textures[mat.values["baseColorTexture"].TextureIndex()];
-            Props.pAlbedoTexture = CTexture::Get<CTexture>(pAlbedoTexture->GetID());
+            Props.pAlbedoTexture = GetContextTexture(aContext, mat.values["baseColorTexture"].TextureIndex());
         }
         if(mat.values.find("metallicRoughnessTexture") != mat.values.end()) {
-            CTexture* pMetallicRoughnesTexture = LoadedData.Textures[mat.values["metallicRoughnessTexture"].TextureIndex()];
-            Props.pMetallicRoughnessTexture = CTexture::Get<CTexture>(pMetallicRoughnesTexture->GetID());
+            Props.pMetallicRoughnessTexture = GetContextTexture(aContext, mat.values["metallicRoughnessTexture"].TextureIndex());
         }
         if(mat.values.find("roughnessFactor") != mat.values.end()) {
             Props.MaterialConstants.RoughnessFactor = static_cast<float>(mat.values["roughnessFactor"].Factor());
@@ -122,12 +191,10 @@ static void LoadMaterials(tinygltf::Model &aGltfModel)
             Props.MaterialConstants.Color = glm::make_vec4(mat.values["baseColorFactor"].ColorFactor().data());
         }
         if(mat.additionalValues.find("normalTexture") != mat.additionalValues.end()) {
-            CTexture* pNormalTexture = LoadedData.Textures[mat.additionalValues["normalTexture"].TextureIndex()];
-            Props.pNormalTexture = CTexture::Get<CTexture>(pNormalTexture->GetID());
+            Props.pNormalTexture = GetContextTexture(aContext, mat.additionalValues["normalTexture"].TextureIndex());
         }
         if(mat.additionalValues.find("occlusionTexture") != mat.additionalValues.end()) {
-            CTexture* pOcclusionTexture = LoadedData.Textures[mat.additionalValues["occlusionTexture"].TextureIndex()];
-            Props.pOcclusionTexture = CTexture::Get<CTexture>(pOcclusionTexture->GetID());
+            Props.pOcclusionTexture = GetContextTexture(aContext, mat.additionalValues["occlusionTexture"].TextureIndex());
         }
         if(mat.additionalValues.find("emissiveFactor") != mat.additionalValues.end()) {
             Props.MaterialConstants.EmissiveFactor = glm::vec4(glm::make_vec3(mat.additionalValues["emissiveFactor"].ColorFactor().data()), 1.0f);
@@ -135,16 +202,14 @@ static void LoadMaterials(tinygltf::Model &aGltfModel)
 
         pMaterial->SetID(mat.name.c_str());
         pMaterial->SetMaterialProperties(Props);
-        LoadedData.Materials.push_back(pMaterial);
+        aContext.Materials.push_back(pMaterial);
         CMaterial::RegisterMaterial(pMaterial);
     }
 }
 
-static void LoadNode(CMeshNode* aParent, const tinygltf::Node &aNode, uint32_t aNodeIndex, const tinygltf::Model &aModel, 
-    std::vector<uint32_t>& aIndexBuffer, std::vector<sVertex>& aVertexBuffer, float aGlobalScale)
+static CMeshNode* LoadNode(sGLTFLoadContext& aContext, const tinygltf::Node &aNode, uint32_t aNodeIndex, const tinygltf::Model &aModel, float aGlobalScale)
 {
-    // TODO: find place where to delete this.
-    CMeshNode* pNewNode = new CMeshNode();
+    CMeshNode* pNewNode = aContext.Storage.MeshNodes.Create();
 
     // Generate local node matrix.
     glm::vec3 Translation = glm::vec3(0.0f);
@@ -170,143 +235,546 @@ static void LoadNode(CMeshNode* aParent, const tinygltf::Node &aNode, uint32_t a
         pNewNode->m_Model = glm::make_mat4x4(aNode.matrix.data());
     }
 
-    // Node with children.
-    if (aNode.children.size() > 0)
+    // Node with children, linked in the order of the file.
+    CMeshNode** ppNextChild = &pNewNode->m_pFirstChild;
+    for (size_t i = 0; i < aNode.children.size(); ++i)
     {
-        for (size_t i = 0; i < aNode.children.size(); ++i)
-        {
-            LoadNode(pNewNode, aModel.nodes[aNode.children[i]], aNode.children[i], aModel, aIndexBuffer, aVertexBuffer, aGlobalScale);
-        }
+        *ppNextChild = LoadNode(aContext, aModel.nodes[aNode.children[i]], aNode.children[i], aModel, aGlobalScale);
+        ppNextChild = &(*ppNextChild)->m_pNextSibling;
     }
 
-    // Node contains mesh data.
+    // Node contains mesh data. Only the ranges are reserved here, the data is converted later in parallel.
     if (aNode.mesh > -1)
     {
-        const tinygltf::Mesh Mesh = aModel.meshes[aNode.mesh];
-        sMeshData* pNewMesh = new sMeshData();
+        const tinygltf::Mesh& Mesh = aModel.meshes[aNode.mesh];
+        sMeshData* pNewMesh = aContext.Storage.MeshDatas.Create();
         for (size_t i = 0; i < Mesh.primitives.size(); ++i)
         {
             const tinygltf::Primitive& Primitive = Mesh.primitives[i];
-            const uint32_t IndexStart = static_cast<uint32_t>(aIndexBuffer.size());
-            const uint32_t VertexStart = static_cast<uint32_t>(aVertexBuffer.size());
-            uint32_t IndexCount = 0;
-            uint32_t VertexCount = 0;
-            glm::vec3 PosMin{};
-            glm::vec3 PosMax{};
-            bool bHasIndices = Primitive.indices > -1;
-            // Vertices.
-            {
-                const float* BufferPos = nullptr;
-                const float* BufferNormals = nullptr;
-                const float* BufferTexCoordSet0 = nullptr;
-
-                int PosByteStride;
-                int NormalByteStride;
-                int UV0ByteStride;
-
-                // Position attribute is required.
-                assert(Primitive.attributes.find("POSITION") != Primitive.attributes.end());
-
-                const tinygltf::Accessor& PosAccessor = aModel.accessors[Primitive.attributes.find("POSITION")->second];
-                const tinygltf::BufferView& PosView = aModel.bufferViews[PosAccessor.bufferView];
-                BufferPos = reinterpret_cast<const float*>(&aModel.buffers[PosView.buffer].data[PosAccessor.byteOffset + PosView.byteOffset]);
-                PosMin = glm::vec3(PosAccessor.minValues[0], PosAccessor.minValues[1], PosAccessor.minValues[2]);
-                PosMax = glm::vec3(PosAccessor.maxValues[0], PosAccessor.maxValues[1], PosAccessor.maxValues[2]);
-                VertexCount = static_cast<uint32_t>(PosAccessor.count);
-                PosByteStride = PosAccessor.ByteStride(PosView) ? (PosAccessor.ByteStride(PosView) / sizeof(float)) : TINYGLTF_TYPE_VEC3 * 4;
-
-                if(Primitive.attributes.find("NORMAL") != Primitive.attributes.end())
-                {
-                    const tinygltf::Accessor& NormAccessor = aModel.accessors[Primitive.attributes.find("NORMAL")->second];
-                    const tinygltf::BufferView& NormView = aModel.bufferViews[NormAccessor.bufferView];
-                    BufferNormals = reinterpret_cast<const float*>(&(aModel.buffers[NormView.buffer].data[NormAccessor.byteOffset + NormView.byteOffset]));
-                    NormalByteStride = NormAccessor.ByteStride(NormView) ? (NormAccessor.ByteStride(NormView) / sizeof(float)) : TINYGLTF_TYPE_VEC3 * 4;
-                }
-
-                if(Primitive.attributes.find("TEXCOORD_0") != Primitive.attributes.end())
-                {
-                    const tinygltf::Accessor& UVAccessor = aModel.accessors[Primitive.attributes.find("TEXCOORD_0")->second];
-                    const tinygltf::BufferView& UVView = aModel.bufferViews[UVAccessor.bufferView];
-                    BufferTexCoordSet0 = reinterpret_cast<const float*>(&(aModel.buffers[UVView.buffer].data[UVAccessor.byteOffset + UVView.byteOffset]));
-                    UV0ByteStride = UVAccessor.ByteStride(UVView) ? (UVAccessor.ByteStride(UVView) / sizeof(float)) : TINYGLTF_TYPE_VEC2 * 4;
-                }
-
-                for(size_t v = 0; v < PosAccessor.count; v++)
-                {
-                    sVertex Vert{};
-
-                    Vert.Position = glm::vec4(glm::make_vec3(&BufferPos[v * PosByteStride]), 1.0f);
-                    Vert.Normal = glm::normalize(glm::vec3(BufferNormals ? glm::make_vec3(&BufferNormals[v * NormalByteStride]) : glm::vec3(0.0f)));
-                    Vert.UV = BufferTexCoordSet0 ? glm::make_vec2(&BufferTexCoordSet0[v * UV0ByteStride]) : glm::vec3(0.0f);
-
-                    aVertexBuffer.push_back(Vert);
-                }
-            }
 
-            // Indices.
-            if(bHasIndices)
-            {
-                const tinygltf::Accessor& Accessor = aModel.accessors[Primitive.indices > -1 ? Primitive.indices : 0];
-                const tinygltf::BufferView& BufferView = aModel.bufferViews[Accessor.bufferView];
-                const tinygltf::Buffer& buffer = aModel.buffers[BufferView.buffer];
-
-                IndexCount = static_cast<uint32_t>(Accessor.count);
-                const void* dataPtr = &(buffer.data[Accessor.byteOffset + BufferView.byteOffset]);
-
-                switch(Accessor.componentType)
-                {
-                case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT: {
-                    const uint32_t* Buf = static_cast<const uint32_t*>(dataPtr);
-                    for(size_t index = 0; index < Accessor.count; index++) {
-                        aIndexBuffer.push_back(Buf[index] + VertexStart);
-                    }
-                    break;
-                }
-                case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT: {
-                    const uint16_t* Buf = static_cast<const uint16_t*>(dataPtr);
-                    for(size_t index = 0; index < Accessor.count; index++) {
-                        aIndexBuffer.push_back(Buf[index] + VertexStart);
-                    }
-                    break;
-                }
-                case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE: {
-                    const uint8_t* Buf = static_cast<const uint8_t*>(dataPtr);
-                    for(size_t index = 0; index < Accessor.count; index++) {
-                        aIndexBuffer.push_back(Buf[index] + VertexStart);
-                    }
-                    break;
-                }
-                default:
-                    SGSERROR("Index component type %d not supported!", Accessor.componentType)
-                    return;
-                }
-            }
+            // Position attribute is required.
+            assert(Primitive.attributes.find("POSITION") != Primitive.attributes.end());
+
+            sGLTFPrimitiveRange Range;
+            Range.pPrimitive = &Primitive;
+            Range.FirstVertex = aContext.VertexCount;
+            Range.VertexCount = static_cast<uint32_t>(aModel.accessors[Primitive.attributes.find("POSITION")->second].count);
+            Range.FirstIndex = aContext.IndexCount;
+            Range.IndexCount = Primitive.indices > -1 ? static_cast<uint32_t>(aModel.accessors[Primitive.indices].count) : 0;
+            Range.bSkinned = aNode.skin > -1 && aNode.skin == aContext.SkinIndex;
 
-            CSubMesh* pNewPrimitive = new CSubMesh(VertexStart, IndexStart, IndexCount, VertexCount, Primitive.material > -1 ? LoadedData.Materials[Primitive.material] : nullptr); // TODO: Default material instead of "nullptr".
+            aContext.VertexCount += Range.VertexCount;
+            aContext.IndexCount += Range.IndexCount;
+            aContext.Primitives.push_back(Range);
+
+            CSubMesh* pNewPrimitive = aContext.Storage.SubMeshes.Create(Range.FirstVertex, Range.FirstIndex, Range.IndexCount, Range.VertexCount, 
+                Primitive.material > -1 ? aContext.Materials[Primitive.material] : nullptr); // TODO: Default material instead of "nullptr".
             pNewMesh->SubMeshes.push_back(pNewPrimitive);
         }
 
         pNewNode->m_pMeshData = pNewMesh;
     }
 
-    if (aParent)
+    return pNewNode;
+}
+
+/**
+ * @brief Strided view over the data of an accessor.
+ */
+struct sGLTFAccessorView
+{
+    const uint8_t* pData = nullptr;
+    size_t Stride = 0;
+    size_t ElementSize = 0;
+    size_t Count = 0;
+    int ComponentType = -1;
+};
+
+static bool GetAccessorView(const tinygltf::Model& aModel, int aAccessorIndex, sGLTFAccessorView& aOutView)
+{
+    if (aAccessorIndex < 0 || aAccessorIndex >= static_cast<int>(aModel.accessors.size()))
+    {
+        return false;
+    }
+
+    const tinygltf::Accessor& Accessor = aModel.accessors[aAccessorIndex];
+    if (Accessor.bufferView < 0)
     {
-        aParent->m_Children.push_back(pNewNode);
+        // Sparse/zero-initialized accessors are not supported.
+        return false;
     }
-    else
+
+    const tinygltf::BufferView& View = aModel.bufferViews[Accessor.bufferView];
+    const int ByteStride = Accessor.ByteStride(View);
+    if (ByteStride <= 0)
     {
-        LoadedData.Nodes.push_back(pNewNode);
+        return false;
+    }
+
+    aOutView.pData = &aModel.buffers[View.buffer].data[Accessor.byteOffset + View.byteOffset];
+    aOutView.Stride = static_cast<size_t>(ByteStride);
+    aOutView.ElementSize = tinygltf::GetComponentSizeInBytes(Accessor.componentType) * tinygltf::GetNumComponentsInType(Accessor.type);
+    aOutView.Count = Accessor.count;
+    aOutView.ComponentType = Accessor.componentType;
+    return true;
+}
+
+static bool FindAttributeView(const tinygltf::Model& aModel, const tinygltf::Primitive& aPrimitive, const char* aAttribute, sGLTFAccessorView& aOutView)
+{
+    const auto& FoundAttribute = aPrimitive.attributes.find(aAttribute);
+    return FoundAttribute != aPrimitive.attributes.cend() && GetAccessorView(aModel, FoundAttribute->second, aOutView);
+}
+
+/**
+ * @brief Finds a float attribute of the primitive.
+ */
+static bool GetAttributeView(const tinygltf::Model& aModel, const tinygltf::Primitive& aPrimitive, const char* aAttribute, sGLTFAccessorView& aOutView)
+{
+    if (!FindAttributeView(aModel, aPrimitive, aAttribute, aOutView))
+    {
+        return false;
+    }
+
+    if (aOutView.ComponentType != TINYGLTF_COMPONENT_TYPE_FLOAT)
+    {
+        SGSWARN("Attribute %s with component type %d not supported!", aAttribute, aOutView.ComponentType);
+        return false;
+    }
+
+    return true;
+}
+
+/**
+ * @brief Copies aCount elements of aElementSize bytes between two strided ranges. Tightly packed ranges are copied with a single memcpy.
+ */
+static void CopyStrided(const uint8_t* apSrc, size_t aSrcStride, uint8_t* apDst, size_t aDstStride, size_t aElementSize, size_t aCount)
+{
+    if (aSrcStride == aElementSize && aDstStride == aElementSize)
+    {
+        memcpy(apDst, apSrc, aElementSize * aCount);
+        return;
+    }
+
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        memcpy(apDst + i * aDstStride, apSrc + i * aSrcStride, aElementSize);
+    }
+}
+
+/**
+ * @brief True if the attribute has an element for every vertex of the primitive. Shorter ones are not copied, the vertices keep the sVertex defaults.
+ */
+static bool HasEveryVertex(const sGLTFAccessorView& aView, const sGLTFPrimitiveRange& aRange, const char* aAttribute)
+{
+    if (aView.Count < aRange.VertexCount)
+    {
+        SGSWARN("Attribute %s has %u elements for %u vertices, it is ignored.", aAttribute, static_cast<uint32_t>(aView.Count), aRange.VertexCount);
+        return false;
+    }
+
+    return true;
+}
+
+template<typename T>
+static void WidenIndices(const sGLTFAccessorView& aView, uint32_t* apDst, size_t aCount)
+{
+    for (size_t i = 0; i < aCount; ++i)
+    {
+        T Index;
+        memcpy(&Index, aView.pData + i * aView.Stride, sizeof(T));
+        apDst[i] = Index;
+    }
+}
+
+/**
+ * @brief Converts a primitive into its preallocated range. Indices are local to the primitive, the draw passes m_FirstVertex as vertex offset.
+ */
+static void ConvertPrimitive(const tinygltf::Model& aModel, const sGLTFPrimitiveRange& aRange, sVertex* apVertices, uint32_t* apIndices)
+{
+    const tinygltf::Primitive& Primitive = *aRange.pPrimitive;
+
+    // Vertices. Every attribute is copied straight from its accessor into the interleaved sVertex range.
+    // Missing attributes keep the sVertex defaults.
+    {
+        uint8_t* pVertices = reinterpret_cast<uint8_t*>(apVertices + aRange.FirstVertex);
+
+        sGLTFAccessorView View;
+        if (GetAttributeView(aModel, Primitive, "POSITION", View))
+        {
+            CopyStrided(View.pData, View.Stride, pVertices + offsetof(sVertex, Position), sizeof(sVertex), sizeof(glm::vec3), aRange.VertexCount);
+        }
+
+        if (GetAttributeView(aModel, Primitive, "NORMAL", View) && HasEveryVertex(View, aRange, "NORMAL"))
+        {
+            CopyStrided(View.pData, View.Stride, pVertices + offsetof(sVertex, Normal), sizeof(sVertex), sizeof(glm::vec3), aRange.VertexCount);
+
+            sVertex* pFirst = apVertices + aRange.FirstVertex;
+            for (sVertex* pVertex = pFirst; pVertex != pFirst + aRange.VertexCount; ++pVertex)
+            {
+                pVertex->Normal = glm::normalize(pVertex->Normal);
+            }
+        }
+
+        if (GetAttributeView(aModel, Primitive, "TEXCOORD_0", View) && HasEveryVertex(View, aRange, "TEXCOORD_0"))
+        {
+            CopyStrided(View.pData, View.Stride, pVertices + offsetof(sVertex, UV), sizeof(sVertex), sizeof(glm::vec2), aRange.VertexCount);
+        }
+    }
+
+    // Indices.
+    if(aRange.IndexCount > 0)
+    {
+        uint32_t* pIndices = apIndices + aRange.FirstIndex;
+
+        sGLTFAccessorView View;
+        if (!GetAccessorView(aModel, Primitive.indices, View))
+        {
+            SGSERROR("Invalid index accessor %d!", Primitive.indices);
+            std::fill(pIndices, pIndices + aRange.IndexCount, 0u);
+            return;
+        }
+
+        switch(View.ComponentType)
+        {
+        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_INT:
+            CopyStrided(View.pData, View.Stride, reinterpret_cast<uint8_t*>(pIndices), sizeof(uint32_t), sizeof(uint32_t), aRange.IndexCount);
+            break;
+        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_SHORT:
+            WidenIndices<uint16_t>(View, pIndices, aRange.IndexCount);
+            break;
+        case TINYGLTF_PARAMETER_TYPE_UNSIGNED_BYTE:
+            WidenIndices<uint8_t>(View, pIndices, aRange.IndexCount);
+            break;
+        default:
+            SGSERROR("Index component type %d not supported!", View.ComponentType)
+            std::fill(pIndices, pIndices + aRange.IndexCount, 0u);
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Copies a float accessor with aNumComponents components per element into aOutValues, tightly packed.
+ */
+static bool ReadFloatAccessor(const tinygltf::Model& aModel, int aAccessorIndex, uint32_t aNumComponents, std::vector<float>& aOutValues)
+{
+    sGLTFAccessorView View;
+    if (!GetAccessorView(aModel, aAccessorIndex, View) || View.ComponentType != TINYGLTF_COMPONENT_TYPE_FLOAT ||
+        View.ElementSize != aNumComponents * sizeof(float))
+    {
+        return false;
+    }
+
+    aOutValues.resize(View.Count * aNumComponents);
+    CopyStrided(View.pData, View.Stride, reinterpret_cast<uint8_t*>(aOutValues.data()), View.ElementSize, View.ElementSize, View.Count);
+    return true;
+}
+
+/**
+ * @brief Reads the four components of an element of a float, unsigned byte or unsigned short accessor. abNormalized
+ * maps the integers to [0, 1].
+ */
+static bool ReadVec4(const sGLTFAccessorView& aView, size_t aElement, bool abNormalized, glm::vec4& aOutValue)
+{
+    const uint8_t* pElement = aView.pData + aElement * aView.Stride;
+    for (int32_t Component = 0; Component < 4; ++Component)
+    {
+        switch (aView.ComponentType)
+        {
+        case TINYGLTF_COMPONENT_TYPE_FLOAT:
+        {
+            float Value;
+            memcpy(&Value, pElement + Component * sizeof(float), sizeof(float));
+            aOutValue[Component] = Value;
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+        {
+            uint16_t Value;
+            memcpy(&Value, pElement + Component * sizeof(uint16_t), sizeof(uint16_t));
+            aOutValue[Component] = abNormalized ? Value / 65535.0f : static_cast<float>(Value);
+            break;
+        }
+        case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+            aOutValue[Component] = abNormalized ? pElement[Component] / 255.0f : static_cast<float>(pElement[Component]);
+            break;
+        default:
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * @brief Local transform of a node as a joint pose. Matrices are decomposed, they are assumed to have no shear.
+ */
+static sJointPose GetNodePose(const tinygltf::Node& aNode)
+{
+    sJointPose Pose;
+    if (aNode.matrix.size() == 16)
+    {
+        const glm::mat4 Matrix = glm::make_mat4x4(aNode.matrix.data());
+        const glm::vec3 Scale(glm::length(glm::vec3(Matrix[0])), glm::length(glm::vec3(Matrix[1])), glm::length(glm::vec3(Matrix[2])));
+        const glm::quat Rotation = glm::quat_cast(glm::mat3(glm::vec3(Matrix[0]) / Scale.x, glm::vec3(Matrix[1]) / Scale.y, glm::vec3(Matrix[2]) / Scale.z));
+        Pose.Rotation = glm::vec4(Rotation.x, Rotation.y, Rotation.z, Rotation.w);
+        Pose.Translation = glm::vec4(glm::vec3(Matrix[3]), 0.0f);
+        Pose.Scale = glm::vec4(Scale, 0.0f);
+        return Pose;
+    }
+
+    // glTF quaternions are (x, y, z, w) like sJointPose.
+    if (aNode.translation.size() == 3)
+    {
+        Pose.Translation = glm::vec4(glm::vec3(glm::make_vec3(aNode.translation.data())), 0.0f);
+    }
+    if (aNode.rotation.size() == 4)
+    {
+        Pose.Rotation = glm::vec4(glm::make_vec4(aNode.rotation.data()));
+    }
+    if (aNode.scale.size() == 3)
+    {
+        Pose.Scale = glm::vec4(glm::vec3(glm::make_vec3(aNode.scale.data())), 0.0f);
+    }
+    return Pose;
+}
+
+/**
+ * @brief World transform of a node with the glTF convention (world = parent * local), which the skeletons follow.
+ */
+static glm::mat4 GetNodeWorldMatrix(const tinygltf::Model& aModel, const std::vector<int32_t>& aParents, int32_t aNodeIndex)
+{
+    glm::mat4 World(1.0f);
+    for (int32_t Node = aNodeIndex; Node >= 0; Node = aParents[Node])
+    {
+        const sJointPose Pose = GetNodePose(aModel.nodes[Node]);
+        const glm::quat Rotation(Pose.Rotation.w, Pose.Rotation.x, Pose.Rotation.y, Pose.Rotation.z);
+        const glm::mat4 Local = glm::translate(glm::mat4(1.0f), glm::vec3(Pose.Translation)) * glm::mat4_cast(Rotation) *
+            glm::scale(glm::mat4(1.0f), glm::vec3(Pose.Scale));
+        World = Local * World;
+    }
+    return World;
+}
+
+/**
+ * @brief Loads the skin of the first skinned mesh node of the file. The joints are sorted so that parents come first,
+ * aContext.JointRemap maps the joint indices of the file to the sorted ones.
+ */
+static void LoadSkin(sGLTFLoadContext& aContext, const tinygltf::Model& aModel)
+{
+    const auto& FoundMeshNode = std::find_if(aModel.nodes.begin(), aModel.nodes.end(), [](const tinygltf::Node& aNode)
+    {
+        return aNode.mesh > -1 && aNode.skin > -1;
+    });
+    if (FoundMeshNode == aModel.nodes.end() || FoundMeshNode->skin >= static_cast<int>(aModel.skins.size()))
+    {
+        return;
+    }
+
+    const int32_t MeshNode = static_cast<int32_t>(FoundMeshNode - aModel.nodes.begin());
+    const int32_t SkinIndex = FoundMeshNode->skin;
+    const tinygltf::Skin& Skin = aModel.skins[SkinIndex];
+    const uint32_t NumJoints = static_cast<uint32_t>(Skin.joints.size());
+    if (NumJoints == 0 || NumJoints > MAX_SKELETON_JOINTS)
+    {
+        SGSWARN("Skin %s of %s has %u joints, up to %u are supported. It is ignored.", Skin.name.c_str(), aContext.Filename.c_str(), NumJoints, MAX_SKELETON_JOINTS);
+        return;
+    }
+    if (aModel.skins.size() > 1)
+    {
+        SGSWARN("%s has %zu skins, only %s is imported. The meshes of the others are not skinned.", aContext.Filename.c_str(), aModel.skins.size(), Skin.name.c_str());
+    }
+
+    std::vector<int32_t> Parents(aModel.nodes.size(), -1);
+    for (size_t Node = 0; Node < aModel.nodes.size(); ++Node)
+    {
+        for (int Child : aModel.nodes[Node].children)
+        {
+            Parents[Child] = static_cast<int32_t>(Node);
+        }
+    }
+
+    // Sorted by depth in the node hierarchy, every joint comes after its parent.
+    std::vector<uint32_t> Depths(NumJoints, 0);
+    for (uint32_t i = 0; i < NumJoints; ++i)
+    {
+        for (int32_t Node = Parents[Skin.joints[i]]; Node >= 0; Node = Parents[Node])
+        {
+            ++Depths[i];
+        }
+    }
+    std::vector<uint32_t> Order(NumJoints);
+    std::iota(Order.begin(), Order.end(), 0u);
+    std::stable_sort(Order.begin(), Order.end(), [&Depths](uint32_t aA, uint32_t aB) { return Depths[aA] < Depths[aB]; });
+
+    aContext.JointRemap.resize(NumJoints);
+    aContext.NodeJoints.assign(aModel.nodes.size(), -1);
+    for (uint32_t Joint = 0; Joint < NumJoints; ++Joint)
+    {
+        aContext.JointRemap[Order[Joint]] = Joint;
+        aContext.NodeJoints[Skin.joints[Order[Joint]]] = static_cast<int32_t>(Joint);
+    }
+
+    std::vector<float> InverseBindMatrices;
+    const bool bHasInverseBindMatrices = Skin.inverseBindMatrices > -1 &&
+        ReadFloatAccessor(aModel, Skin.inverseBindMatrices, 16, InverseBindMatrices) && InverseBindMatrices.size() >= NumJoints * 16;
+
+    std::unique_ptr<sSkeleton> pSkeleton = std::make_unique<sSkeleton>();
+    pSkeleton->ParentIndices.resize(NumJoints);
+    pSkeleton->InverseBindMatrices.resize(NumJoints);
+    pSkeleton->RestPose.resize(NumJoints);
+    pSkeleton->JointNames.resize(NumJoints);
+    for (uint32_t Joint = 0; Joint < NumJoints; ++Joint)
+    {
+        const int32_t Node = Skin.joints[Order[Joint]];
+        pSkeleton->ParentIndices[Joint] = Parents[Node] >= 0 ? aContext.NodeJoints[Parents[Node]] : -1;
+        pSkeleton->InverseBindMatrices[Joint] = bHasInverseBindMatrices ? glm::make_mat4x4(&InverseBindMatrices[Order[Joint] * 16]) : glm::mat4(1.0f);
+        pSkeleton->RestPose[Joint] = GetNodePose(aModel.nodes[Node]);
+        pSkeleton->JointNames[Joint] = aModel.nodes[Node].name;
+    }
+
+    // The roots are assumed to hang from the same node.
+    const int32_t RootParent = Parents[Skin.joints[Order[0]]];
+    pSkeleton->RootTransform = glm::inverse(GetNodeWorldMatrix(aModel, Parents, MeshNode)) *
+        (RootParent >= 0 ? GetNodeWorldMatrix(aModel, Parents, RootParent) : glm::mat4(1.0f));
+
+    aContext.SkinIndex = SkinIndex;
+    aContext.pSkeleton = std::move(pSkeleton);
+}
+
+/**
+ * @brief Converts JOINTS_0 and WEIGHTS_0 of a skinned primitive into its range of skin vertices. The joints are
+ * remapped to the sorted skeleton and the weights normalized. Vertices without them keep no weights and stay rigid.
+ */
+static void ConvertSkinAttributes(const sGLTFLoadContext& aContext, const tinygltf::Model& aModel, const sGLTFPrimitiveRange& aRange, sSkinVertex* apSkinVertices)
+{
+    sGLTFAccessorView JointsView;
+    sGLTFAccessorView WeightsView;
+    if (!FindAttributeView(aModel, *aRange.pPrimitive, "JOINTS_0", JointsView) || !FindAttributeView(aModel, *aRange.pPrimitive, "WEIGHTS_0", WeightsView) ||
+        JointsView.Count < aRange.VertexCount || WeightsView.Count < aRange.VertexCount)
+    {
+        SGSWARN("Skinned primitive of %s without valid JOINTS_0/WEIGHTS_0, it is not skinned.", aContext.Filename.c_str());
+        return;
+    }
+
+    const uint32_t NumJoints = static_cast<uint32_t>(aContext.JointRemap.size());
+    sSkinVertex* pSkinVertices = apSkinVertices + aRange.FirstVertex;
+    for (uint32_t i = 0; i < aRange.VertexCount; ++i)
+    {
+        glm::vec4 Joints;
+        glm::vec4 Weights;
+        if (!ReadVec4(JointsView, i, false, Joints) || !ReadVec4(WeightsView, i, true, Weights))
+        {
+            SGSWARN("Skinned primitive of %s with unsupported JOINTS_0/WEIGHTS_0 types, it is not skinned.", aContext.Filename.c_str());
+            std::fill(pSkinVertices, pSkinVertices + aRange.VertexCount, sSkinVertex());
+            return;
+        }
+
+        sSkinVertex& SkinVertex = pSkinVertices[i];
+        for (int32_t Influence = 0; Influence < 4; ++Influence)
+        {
+            const uint32_t Joint = static_cast<uint32_t>(Joints[Influence]);
+            const bool bValid = Joint < NumJoints && Weights[Influence] > 0.0f;
+            SkinVertex.Joints[Influence] = bValid ? aContext.JointRemap[Joint] : 0;
+            SkinVertex.Weights[Influence] = bValid ? Weights[Influence] : 0.0f;
+        }
+
+        const float TotalWeight = SkinVertex.Weights.x + SkinVertex.Weights.y + SkinVertex.Weights.z + SkinVertex.Weights.w;
+        if (TotalWeight > 0.0f)
+        {
+            SkinVertex.Weights /= TotalWeight;
+        }
+    }
+}
+
+/**
+ * @brief Loads the channels of every animation of the file that target a joint of the skeleton. The channels of other
+ * nodes and morph target weights are ignored.
+ */
+static void LoadAnimations(sGLTFLoadContext& aContext, const tinygltf::Model& aModel)
+{
+    if (!aContext.pSkeleton)
+    {
+        return;
+    }
+
+    for (const tinygltf::Animation& Animation : aModel.animations)
+    {
+        sAnimationClip Clip;
+        Clip.Name = Animation.name;
+
+        for (const tinygltf::AnimationChannel& Channel : Animation.channels)
+        {
+            if (Channel.target_node < 0 || Channel.target_node >= static_cast<int>(aContext.NodeJoints.size()) || aContext.NodeJoints[Channel.target_node] < 0 ||
+                Channel.sampler < 0 || Channel.sampler >= static_cast<int>(Animation.samplers.size()))
+            {
+                continue;
+            }
+
+            sAnimationTrack Track;
+            Track.Joint = static_cast<uint32_t>(aContext.NodeJoints[Channel.target_node]);
+
+            uint32_t NumComponents = 3;
+            if (Channel.target_path == "translation")
+            {
+                Track.Path = eAnimationPath::TRANSLATION;
+            }
+            else if (Channel.target_path == "rotation")
+            {
+                Track.Path = eAnimationPath::ROTATION;
+                NumComponents = 4;
+            }
+            else if (Channel.target_path == "scale")
+            {
+                Track.Path = eAnimationPath::SCALE;
+            }
+            else
+            {
+                continue;
+            }
+
+            // Cubic spline keyframes are (in tangent, value, out tangent), only the values are kept and interpolated linearly.
+            const tinygltf::AnimationSampler& Sampler = Animation.samplers[Channel.sampler];
+            const bool bCubicSpline = Sampler.interpolation == "CUBICSPLINE";
+            const size_t ValuesPerKey = bCubicSpline ? 3 : 1;
+            Track.Interpolation = Sampler.interpolation == "STEP" ? eAnimationInterpolation::STEP : eAnimationInterpolation::LINEAR;
+
+            std::vector<float> Values;
+            if (!ReadFloatAccessor(aModel, Sampler.input, 1, Track.Times) || !ReadFloatAccessor(aModel, Sampler.output, NumComponents, Values) ||
+                Track.Times.empty() || Values.size() != Track.Times.size() * ValuesPerKey * NumComponents)
+            {
+                SGSWARN("Channel of animation %s of %s with unsupported data, it is ignored.", Animation.name.c_str(), aContext.Filename.c_str());
+                continue;
+            }
+
+            Track.Values.resize(Track.Times.size());
+            for (size_t Key = 0; Key < Track.Times.size(); ++Key)
+            {
+                const float* pValue = &Values[(Key * ValuesPerKey + (bCubicSpline ? 1 : 0)) * NumComponents];
+                Track.Values[Key] = glm::vec4(pValue[0], pValue[1], pValue[2], NumComponents == 4 ? pValue[3] : 0.0f);
+            }
+
+            Clip.Duration = std::max(Clip.Duration, Track.Times.back());
+            Clip.Tracks.push_back(std::move(Track));
+        }
+
+        if (!Clip.Tracks.empty())
+        {
+            aContext.AnimationClips.push_back(std::move(Clip));
+        }
     }
 }
 
 CRenderable* LoadGLTF(const std::string& aFilePath, float aScale)
 {
+    SGS_PROFILE_FUNCTION();
+
     tinygltf::Model gltfModel;
     tinygltf::TinyGLTF gltfContext;
     std::string Error;
     std::string Warning;
 
-    LoadedData.Filename = utils::GetFileName(aFilePath);
+    sGLTFLoadContext Context;
+    Context.Filename = utils::GetFileName(aFilePath);
 
     bool bBinary = false;
     size_t ExtPos = aFilePath.rfind('.', aFilePath.length());
@@ -315,43 +783,100 @@ CRenderable* LoadGLTF(const std::string& aFilePath, float aScale)
         bBinary = (aFilePath.substr(ExtPos + 1, aFilePath.length() - ExtPos) == "glb");
     }
 
+    // Images are decoded in parallel after parsing.
+    gltfContext.SetImageLoader(StoreEncodedImage, nullptr);
+
     bool bFileLoaded = bBinary ? gltfContext.LoadBinaryFromFile(&gltfModel, &Error, &Warning, aFilePath.c_str()) : 
         gltfContext.LoadASCIIFromFile(&gltfModel, &Error, &Warning, aFilePath.c_str());
 
+    if (!Warning.empty())
+    {
+        SGSWARN("%s: %s", aFilePath.c_str(), Warning.c_str());
+    }
+
     std::vector<uint32_t> IndexBuffer;
     std::vector<sVertex> VertexBuffer;
+    std::vector<sSkinVertex> SkinVertexBuffer;
 
     if(bFileLoaded)
     {
-        LoadTextures(gltfModel);
-        LoadMaterials(gltfModel);
+        LoadTextures(Context, gltfModel);
+        LoadMaterials(Context, gltfModel);
+        // Before the nodes, which tell the primitives it deforms.
+        LoadSkin(Context, gltfModel);
 
         const tinygltf::Scene& Scene = gltfModel.scenes[gltfModel.defaultScene > -1 ? gltfModel.defaultScene : 0];
         for (size_t i = 0; i < Scene.nodes.size(); ++i)
         {
-            const tinygltf::Node Node = gltfModel.nodes[Scene.nodes[i]];
-            LoadNode(nullptr, Node, Scene.nodes[i], gltfModel, IndexBuffer, VertexBuffer, aScale);
+            const tinygltf::Node& Node = gltfModel.nodes[Scene.nodes[i]];
+            Context.Nodes.push_back(LoadNode(Context, Node, Scene.nodes[i], gltfModel, aScale));
         }
 
-        if (LoadedData.Nodes.size() == 0)
+        if (Context.Nodes.size() == 0)
         {
             SGSERROR("No Nodes where found while loading %s!!!", aFilePath.c_str());
             return nullptr;
         }
 
+        // First pass (LoadNode) counted every accessor, so the buffers are allocated once with their exact size
+        // and the primitives are converted in parallel into their own ranges.
+        VertexBuffer.resize(Context.VertexCount);
+        IndexBuffer.resize(Context.IndexCount);
+        if (Context.pSkeleton)
+        {
+            SkinVertexBuffer.resize(Context.VertexCount);
+        }
+
+        sJobCounter Counter;
+        jobs::Dispatch(Counter, static_cast<uint32_t>(Context.Primitives.size()), 1, [&](uint32_t aPrimitiveIndex)
+        {
+            const sGLTFPrimitiveRange& Range = Context.Primitives[aPrimitiveIndex];
+            ConvertPrimitive(gltfModel, Range, VertexBuffer.data(), IndexBuffer.data());
+            if (Range.bSkinned)
+            {
+                ConvertSkinAttributes(Context, gltfModel, Range, SkinVertexBuffer.data());
+            }
+        });
+        jobs::Wait(Counter);
+
+        LoadAnimations(Context, gltfModel);
+
         CRenderable* pRenderable = CRenderable::Create();
-        pRenderable->m_pRoots = LoadedData.Nodes;
-        pRenderable->m_Vertices = VertexBuffer;
-        pRenderable->m_Indices = IndexBuffer;
         pRenderable->m_VerticesCount = static_cast<uint32_t>(VertexBuffer.size());
         pRenderable->m_IndicesCount = static_cast<uint32_t>(IndexBuffer.size());
+        pRenderable->m_Storage = std::move(Context.Storage);
+        pRenderable->m_pRoots = std::move(Context.Nodes);
+        pRenderable->m_Vertices = std::move(VertexBuffer);
+        pRenderable->m_Indices = std::move(IndexBuffer);
 
-        LoadedData.Textures.clear();
-        LoadedData.Materials.clear();
-        LoadedData.Nodes.clear();
+        if (Context.pSkeleton)
+        {
+            pRenderable->m_pSkeleton = std::move(Context.pSkeleton);
+            pRenderable->m_SkinVertices = std::move(SkinVertexBuffer);
+            pRenderable->m_AnimationClips = std::move(Context.AnimationClips);
+            // Animated every frame, its shadows cannot be cached.
+            pRenderable->m_bIsStatic = false;
+        }
 
         return pRenderable;
     }
 
+    SGSERROR("Failed to load %s: %s", aFilePath.c_str(), Error.c_str());
     return nullptr;
+}
+
+std::vector<CRenderable*> LoadGLTFs(const std::vector<std::string>& aFilePaths, float aScale)
+{
+    SGS_PROFILE_FUNCTION();
+
+    std::vector<CRenderable*> Renderables(aFilePaths.size(), nullptr);
+
+    sJobCounter Counter;
+    jobs::Dispatch(Counter, static_cast<uint32_t>(aFilePaths.size()), 1, [&](uint32_t aFileIndex)
+    {
+        Renderables[aFileIndex] = LoadGLTF(aFilePaths[aFileIndex], aScale);
+    });
+    jobs::Wait(Counter);
+
+    return Renderables;
 }
\ No newline at end of file
@@ -1,7 +1,16 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 class CRenderable;
 
-CRenderable* LoadGLTF(const std::string& aFilePath, float aScale);
\ No newline at end of file
+/**
+ * @brief Imports a glTF/glb file. Safe to call from several threads at the same time.
+ */
+CRenderable* LoadGLTF(const std::string& aFilePath, float aScale);
+
+/**
+ * @brief Imports several glTF/glb files concurrently. The result keeps the order of aFilePaths (nullptr for the files that failed).
+ */
+std::vector<CRenderable*> LoadGLTFs(const std::vector<std::string>& aFilePaths, float aScale);
\ No newline at end of file
@@ -2,15 +2,26 @@
 
 #include <core/logger.h>
 
-std::unordered_map<std::string, CMaterial*> CMaterial::m_LoadedMaterials;
+#include <mutex>
+
+namespace
+{
+    // Materials live until the program exits, the pool is never cleared before.
+    CPool<CMaterial>& GetMaterialPool()
+    {
+        static CPool<CMaterial> Materials;
+        return Materials;
+    }
+
+    std::mutex MaterialPoolMutex;
+}
 
 CMaterial* CMaterial::Get(const std::string& aID)
 {
-    // Check if we already have the file stored in m_LoadedMaterials.
-    const auto& FoundMaterial = m_LoadedMaterials.find(aID);
-    if (FoundMaterial != m_LoadedMaterials.cend())
+    CMaterial* pMaterial = CAssetRegistry::GetMaterials().Find(assets::Intern(aID));
+    if (pMaterial)
     {
-        return FoundMaterial->second;
+        return pMaterial;
     }
     else
     {
@@ -19,6 +30,24 @@ CMaterial* CMaterial::Get(const std::string& aID)
     }
 }
 
+CMaterial* CMaterial::Create()
+{
+    std::lock_guard<std::mutex> Lock(MaterialPoolMutex);
+    return GetMaterialPool().Create();
+}
+
+CMaterial* CMaterial::Get(sPoolHandle aHandle)
+{
+    std::lock_guard<std::mutex> Lock(MaterialPoolMutex);
+    return GetMaterialPool().Get(aHandle);
+}
+
+sPoolHandle CMaterial::GetHandle() const
+{
+    std::lock_guard<std::mutex> Lock(MaterialPoolMutex);
+    return GetMaterialPool().GetHandle(this);
+}
+
 void CMaterial::RegisterMaterial(CMaterial* apMaterial)
 {
     const std::string MaterialID = apMaterial->m_ID;
@@ -28,32 +57,32 @@ void CMaterial::RegisterMaterial(CMaterial* apMaterial)
     }
     else
     {
-        const auto& FoundMaterial = m_LoadedMaterials.find(MaterialID);
-        if (FoundMaterial != m_LoadedMaterials.cend())
+        const AssetID ID = assets::Intern(MaterialID);
+        const uint32_t Index = CAssetRegistry::GetMaterials().Register(ID, apMaterial);
+        if (Index == INVALID_ASSET_INDEX)
         {
             SGSWARN("The material with ID: %s is already registered!", MaterialID.c_str());
         }
         else
         {
-            m_LoadedMaterials.insert({MaterialID, apMaterial});
+            apMaterial->m_AssetID = ID;
+            apMaterial->m_Index = Index;
         }
     }
 }
     
 void CMaterial::SetID(const std::string& aID)
 {
-    if (!m_ID.empty())
+    // A registered material keeps its index, only the ID it is found with changes.
+    if (m_Index != INVALID_ASSET_INDEX)
     {
-        auto NodeHandler = m_LoadedMaterials.extract(m_ID);
-        if (!NodeHandler.empty())
-        {
-            NodeHandler.key() = aID;
-            m_LoadedMaterials.insert(std::move(NodeHandler));
-        }
-        else
+        const AssetID NewAssetID = assets::Intern(aID);
+        if (!CAssetRegistry::GetMaterials().Rename(m_AssetID, NewAssetID))
         {
-            m_LoadedMaterials.insert({aID, this});
+            SGSWARN("Can't change the ID of material %s, the ID %s is already registered!", m_ID.c_str(), aID.c_str());
+            return;
         }
+        m_AssetID = NewAssetID;
     }
 
     m_ID = aID;
@@ -1,19 +1,22 @@
 #pragma once
 
+#include "asset_registry.hpp"
+#include <core/pool_allocator.hpp>
 #include "glm/gtc/matrix_transform.hpp"
 
 #include <string>
-#include <unordered_map>
 
 class CTexture;
 
+// Uniform buffer of the materials, laid out as MaterialConstants (std140) in the shaders.
 struct sMaterialConstants
 {
     glm::vec4 Color;
     float RoughnessFactor;
     float MetallicFactor;
     float TillingFactor;
-    glm::vec3 EmissiveFactor;
+    // vec3 members start at 16 bytes in std140.
+    alignas(16) glm::vec3 EmissiveFactor;
     bool bIsTransparent;
 };
  
@@ -35,16 +38,36 @@ public:
     static CMaterial* Get(const std::string& aID);
     static void RegisterMaterial(CMaterial* apMaterial);
 
+    /**
+     * @brief Allocates a material from the material pool, so the materials are contiguous and freed at once on exit.
+     * Thread safe, the loaders create materials from jobs.
+     */
+    static CMaterial* Create();
+
+    /**
+     * @brief The material referenced by aHandle, nullptr if it was destroyed.
+     */
+    static CMaterial* Get(sPoolHandle aHandle);
+
+    /**
+     * @brief Handle of a material allocated with Create().
+     */
+    sPoolHandle GetHandle() const;
+
     CMaterial() = default;
     void SetID(const std::string& aID);
-    std::string GetID() const { return m_ID; }
+    const std::string& GetID() const { return m_ID; }
+    /**
+     * @brief Dense index of the material in CAssetRegistry::GetMaterials(), INVALID_ASSET_INDEX until it is registered.
+     */
+    uint32_t GetIndex() const { return m_Index; }
     void SetMaterialProperties(const sMaterialProperties& aMaterialProperties);
     sMaterialProperties GetMaterialProperties() const { return m_MaterialProperties; }
     sMaterialConstants GetMaterialConstatns() const { return m_MaterialProperties.MaterialConstants; }
 
 private:
-    static std::unordered_map<std::string, CMaterial*> m_LoadedMaterials;
-
     std::string m_ID;
+    AssetID m_AssetID = INVALID_ASSET_ID;
+    uint32_t m_Index = INVALID_ASSET_INDEX;
     sMaterialProperties m_MaterialProperties;
 };
\ No newline at end of file
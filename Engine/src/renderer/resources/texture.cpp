@@ -3,8 +3,6 @@
 #include <renderer/render_module.hpp>
 #include <renderer/core/render_types.hpp>
 
-std::unordered_map<std::string, CTexture*> CTexture::m_LoadedTextures; 
-
 CTexture* CTexture::Create(const uint64_t aImageSize, void *aPixel_Ptr, int32_t aTexWidth, int32_t aTexHeight)
 {
     const eRenderAPI RenderAPI = CEngine::Get()->GetRenderModule()->GetRenderAPI();
@@ -64,14 +62,16 @@ void CTexture::RegisterTexture(CTexture* apTexture)
     }
     else
     {
-        const auto& FoundFile = m_LoadedTextures.find(TextureID);
-        if (FoundFile != m_LoadedTextures.cend())
+        const AssetID ID = assets::Intern(TextureID);
+        const uint32_t Index = CAssetRegistry::GetTextures().Register(ID, apTexture);
+        if (Index == INVALID_ASSET_INDEX)
         {
             SGSWARN("Texture with ID: %s is already registered!", TextureID.c_str());
         }
         else
         {
-            m_LoadedTextures.insert({ TextureID, apTexture});
+            apTexture->m_AssetID = ID;
+            apTexture->m_Index = Index;
         }
     }
 }
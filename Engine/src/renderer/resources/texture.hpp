@@ -1,58 +1,69 @@
 #pragma once
 
+#include "asset_registry.hpp"
 #include <engine.hpp>
 #include <core/logger.h>
 
 #include <string>
-#include <unordered_map>
 
 class CTexture
 {
 public:
-    static std::unordered_map<std::string, CTexture*> m_LoadedTextures; 
-
+    /**
+     * @brief Texture registered with the ID aFilePath, loaded from the file if there is none. Can be called from
+     * loading jobs, different files are decoded and uploaded in parallel and each one is only loaded once.
+     */
     template<class T>
     static T* Get(const std::string& aFilePath)
     {
-        // Check if we already have the file stored in m_LoadedTextures and is of the requested type.
-        const auto& FoundFile = m_LoadedTextures.find(aFilePath);
-        if (FoundFile != m_LoadedTextures.cend())
+        const AssetID ID = assets::Intern(aFilePath);
+        CTexture* pTexture = CAssetRegistry::GetTextures().FindOrCreate(ID, [&]() -> CTexture*
         {
-            T* Texture = dynamic_cast<T*>(FoundFile->second);
-            if (Texture == nullptr)
+            T* pCreatedTexture = CTexture::Create<T>(aFilePath);
+            if (pCreatedTexture)
             {
-                SGSERROR("Texture casted to wrong type!");
+                pCreatedTexture->m_Filename = aFilePath;
+                pCreatedTexture->m_ID = aFilePath;
+                pCreatedTexture->m_AssetID = ID;
             }
+            return pCreatedTexture;
+        },
+        [](CTexture* apTexture, uint32_t aIndex)
+        {
+            apTexture->m_Index = aIndex;
+        });
 
-            return Texture;
-        }
-
-        T* pCreatedTexture = CTexture::Create<T>(std::move(aFilePath));
-        pCreatedTexture->m_Filename = aFilePath;
-        pCreatedTexture->m_ID = aFilePath;
-        if (pCreatedTexture)
+        T* pFoundTexture = dynamic_cast<T*>(pTexture);
+        if (pTexture && pFoundTexture == nullptr)
         {
-            m_LoadedTextures.insert({ aFilePath, pCreatedTexture});
+            SGSERROR("Texture casted to wrong type!");
         }
 
-        return pCreatedTexture;
+        return pFoundTexture;
     }
 
     static CTexture* Create(const uint64_t aImageSize, void *aPixel_Ptr, int32_t aTexWidth, int32_t aTexHeight);
     static void RegisterTexture(CTexture* apTexture);
 
     CTexture() = default;
+    virtual ~CTexture() = default;
 
     virtual uint32_t GetWidth() const = 0;
     virtual uint32_t GetHeight() const = 0;
 
     void SetID(const std::string& aID) { m_ID = aID; }
-    std::string GetID() const { return m_ID; }
+    const std::string& GetID() const { return m_ID; }
     const std::string& GetFilename() const { return m_Filename; }
+    /**
+     * @brief Dense index of the texture in CAssetRegistry::GetTextures(), INVALID_ASSET_INDEX until it is registered.
+     */
+    uint32_t GetIndex() const { return m_Index; }
 
 protected:
     std::string m_ID;
     std::string m_Filename;
+    AssetID m_AssetID = INVALID_ASSET_ID;
+    uint32_t m_Index = INVALID_ASSET_INDEX;
 
 private:
     template<class T>
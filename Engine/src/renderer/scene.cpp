@@ -1,4 +1,12 @@
 #include "scene.hpp"
+#include <renderer/resources/material.hpp>
+#include <core/logger.h>
+#include <core/profiler.hpp>
+
+#include <glm/common.hpp>
+
+#include <algorithm>
+#include <cmath>
 
 sRenderObjectInfo::sRenderObjectInfo(const std::string& aMeshPath, const std::string& aTexturePath) :
     MeshPath(std::move(aMeshPath)), TexturePath(std::move(aTexturePath))
@@ -6,7 +14,12 @@ sRenderObjectInfo::sRenderObjectInfo(const std::string& aMeshPath, const std::st
 }
 
 CScene::CScene() :
-    m_Renderables()
+    m_NumDraws(0),
+    m_MaxDepth(0),
+    m_Renderables(),
+    m_PointLights(),
+    m_SpotLights(),
+    m_DirectionalLight()
 {
 }
 
@@ -21,4 +34,274 @@ CScene::~CScene()
 void CScene::AddRenderable(CRenderable* const apRenderable)
 {
     m_Renderables.emplace_back(apRenderable);
+
+    if (apRenderable->m_Vertices.empty())
+    {
+        SGSWARN("Renderable %s was added to the scene after its upload, it has no bounds.", apRenderable->m_Name.c_str());
+    }
+
+    for (CMeshNode* pRoot : apRenderable->m_pRoots)
+    {
+        CreateNodeEntities(apRenderable, pRoot, INVALID_ENTITY, 0);
+    }
+
+    if (apRenderable->IsSkinned())
+    {
+        sAnimatorComponent& Animator = m_Registry.AddComponent<sAnimatorComponent>(m_Registry.CreateEntity());
+        Animator.pRenderable = apRenderable;
+        Animator.FirstJoint = static_cast<uint32_t>(m_JointMatrices.size());
+        m_JointMatrices.resize(m_JointMatrices.size() + apRenderable->m_pSkeleton->GetNumJoints(), glm::mat4(1.0f));
+    }
+}
+
+void CScene::CreateNodeEntities(CRenderable* apRenderable, CMeshNode* apMeshNode, sEntity aParent, uint32_t aDepth)
+{
+    const sEntity NodeEntity = m_Registry.CreateEntity();
+    sTransformComponent& NodeTransform = m_Registry.AddComponent<sTransformComponent>(NodeEntity);
+    NodeTransform.Local = apMeshNode->m_Model;
+    NodeTransform.Parent = aParent;
+    NodeTransform.Depth = aDepth;
+
+    // Same order CVulkanRenderable::DrawNode() records the draws in: children first.
+    for (CMeshNode* pChild = apMeshNode->m_pFirstChild; pChild; pChild = pChild->m_pNextSibling)
+    {
+        CreateNodeEntities(apRenderable, pChild, NodeEntity, aDepth + 1);
+    }
+
+    if (apMeshNode->m_pMeshData == nullptr)
+    {
+        m_MaxDepth = std::max(m_MaxDepth, aDepth);
+        return;
+    }
+
+    for (CSubMesh* pSubMesh : apMeshNode->m_pMeshData->SubMeshes)
+    {
+        const sEntity DrawEntity = m_Registry.CreateEntity();
+
+        sTransformComponent& Transform = m_Registry.AddComponent<sTransformComponent>(DrawEntity);
+        Transform.Parent = NodeEntity;
+        Transform.Depth = aDepth + 1;
+
+        sMeshComponent& Mesh = m_Registry.AddComponent<sMeshComponent>(DrawEntity);
+        Mesh.pRenderable = apRenderable;
+        Mesh.SubMesh = apRenderable->m_Storage.SubMeshes.GetHandle(pSubMesh);
+        Mesh.DrawIndex = m_NumDraws++;
+        if (apRenderable->IsSkinned())
+        {
+            m_SkinnedDraws.push_back(Mesh.DrawIndex);
+        }
+
+        sMaterialComponent& Material = m_Registry.AddComponent<sMaterialComponent>(DrawEntity);
+        if (pSubMesh->m_Material)
+        {
+            Material.Material = pSubMesh->m_Material->GetHandle();
+        }
+
+        sBoundsComponent& Bounds = m_Registry.AddComponent<sBoundsComponent>(DrawEntity);
+        const std::vector<sVertex>& Vertices = apRenderable->m_Vertices;
+        const size_t LastVertex = std::min(static_cast<size_t>(pSubMesh->m_FirstVertex + pSubMesh->m_VertexCount), Vertices.size());
+        if (pSubMesh->m_FirstVertex < LastVertex)
+        {
+            Bounds.LocalMin = Vertices[pSubMesh->m_FirstVertex].Position;
+            Bounds.LocalMax = Bounds.LocalMin;
+            for (size_t i = pSubMesh->m_FirstVertex + 1; i < LastVertex; ++i)
+            {
+                Bounds.LocalMin = glm::min(Bounds.LocalMin, Vertices[i].Position);
+                Bounds.LocalMax = glm::max(Bounds.LocalMax, Vertices[i].Position);
+            }
+        }
+    }
+    m_MaxDepth = std::max(m_MaxDepth, aDepth + 1);
+}
+
+void CScene::Update(float aDeltaTime)
+{
+    SGS_PROFILE_FUNCTION();
+
+    UpdateAnimations(aDeltaTime);
+    UpdateTransforms();
+    UpdateBounds();
+    UpdateBVH();
+}
+
+void CScene::UpdateAnimations(float aDeltaTime)
+{
+    SGS_PROFILE_FUNCTION();
+
+    // Every animator writes its own range of the joint matrices, they run in parallel.
+    glm::mat4* pJointMatrices = m_JointMatrices.data();
+    m_Registry.ParallelForEach<sAnimatorComponent>([pJointMatrices, aDeltaTime](sEntity, sAnimatorComponent& aAnimator)
+    {
+        const sSkeleton& Skeleton = *aAnimator.pRenderable->m_pSkeleton;
+        const std::vector<sAnimationClip>& Clips = aAnimator.pRenderable->m_AnimationClips;
+
+        // Kept within the clips, the precision of the times would drop the longer they play.
+        const auto Advance = [&Clips, aDeltaTime, &aAnimator](uint32_t aClip, float aTime)
+        {
+            const float Time = aTime + aDeltaTime * aAnimator.Speed;
+            return aClip < Clips.size() && Clips[aClip].Duration > 0.0f ? std::fmod(Time, Clips[aClip].Duration) : Time;
+        };
+        aAnimator.Time = Advance(aAnimator.Clip, aAnimator.Time);
+        aAnimator.BlendTime = Advance(aAnimator.BlendClip, aAnimator.BlendTime);
+
+        sJointPose Pose[MAX_SKELETON_JOINTS];
+        if (aAnimator.Clip < Clips.size())
+        {
+            animation::SampleClip(Skeleton, Clips[aAnimator.Clip], aAnimator.Time, Pose);
+        }
+        else
+        {
+            std::copy(Skeleton.RestPose.begin(), Skeleton.RestPose.end(), Pose);
+        }
+
+        if (aAnimator.BlendWeight > 0.0f && aAnimator.BlendClip < Clips.size())
+        {
+            sJointPose BlendPose[MAX_SKELETON_JOINTS];
+            animation::SampleClip(Skeleton, Clips[aAnimator.BlendClip], aAnimator.BlendTime, BlendPose);
+            animation::BlendPoses(Pose, BlendPose, std::min(aAnimator.BlendWeight, 1.0f), Skeleton.GetNumJoints(), Pose);
+        }
+
+        animation::ComputeSkinningMatrices(Skeleton, Pose, pJointMatrices + aAnimator.FirstJoint);
+    }, 16);
+}
+
+void CScene::UpdateTransforms()
+{
+    SGS_PROFILE_FUNCTION();
+
+    // One pass per level of the hierarchies, the parents of a level were all computed by the previous pass.
+    CComponentArray<sTransformComponent>& Transforms = m_Registry.GetComponents<sTransformComponent>();
+    for (uint32_t Depth = 0; Depth <= m_MaxDepth; ++Depth)
+    {
+        m_Registry.ParallelForEach<sTransformComponent>([&Transforms, Depth](sEntity, sTransformComponent& aTransform)
+        {
+            if (aTransform.Depth != Depth)
+            {
+                return;
+            }
+
+            // Same convention as CMeshNode::GetWorldTransform().
+            const sTransformComponent* pParent = Transforms.Get(aTransform.Parent);
+            aTransform.World = pParent ? aTransform.Local * pParent->World : aTransform.Local;
+        });
+    }
+}
+
+void CScene::UpdateBounds()
+{
+    SGS_PROFILE_FUNCTION();
+
+    m_Registry.ParallelForEach<sBoundsComponent, sTransformComponent>([](sEntity, sBoundsComponent& aBounds, const sTransformComponent& aTransform)
+    {
+        // Transforms the center and the extents, instead of the eight corners.
+        const glm::vec3 Center = (aBounds.LocalMin + aBounds.LocalMax) * 0.5f;
+        const glm::vec3 Extents = (aBounds.LocalMax - aBounds.LocalMin) * 0.5f;
+
+        const glm::vec3 WorldCenter = glm::vec3(aTransform.World * glm::vec4(Center, 1.0f));
+        glm::vec3 WorldExtents(0.0f);
+        for (int32_t Axis = 0; Axis < 3; ++Axis)
+        {
+            WorldExtents += glm::abs(glm::vec3(aTransform.World[Axis])) * Extents[Axis];
+        }
+
+        aBounds.WorldMin = WorldCenter - WorldExtents;
+        aBounds.WorldMax = WorldCenter + WorldExtents;
+    });
+}
+
+void CScene::UpdateBVH()
+{
+    SGS_PROFILE_FUNCTION();
+
+    // The first entities, usually the static content loaded with the level, get a SAH build. The rest are inserted.
+    std::vector<CBVH::sBuildItem> NewItems;
+    std::vector<sBoundsComponent*> NewBounds;
+    m_Registry.ForEach<sBoundsComponent>([&](sEntity aEntity, sBoundsComponent& aBounds)
+    {
+        const sAABB WorldBounds(aBounds.WorldMin, aBounds.WorldMax);
+        if (aBounds.BVHProxy != BVH_NULL_NODE)
+        {
+            m_BVH.Update(aBounds.BVHProxy, WorldBounds);
+        }
+        else if (m_BVH.GetNumProxies() == 0)
+        {
+            NewItems.push_back({ WorldBounds, aEntity });
+            NewBounds.push_back(&aBounds);
+        }
+        else
+        {
+            aBounds.BVHProxy = m_BVH.Insert(WorldBounds, aEntity);
+        }
+    });
+
+    if (!NewItems.empty())
+    {
+        std::vector<uint32> Proxies;
+        m_BVH.Build(NewItems, Proxies);
+        for (size_t i = 0; i < Proxies.size(); ++i)
+        {
+            NewBounds[i]->BVHProxy = Proxies[i];
+        }
+    }
+}
+
+void CScene::GatherDrawTransforms(std::vector<glm::mat4>& aTransforms)
+{
+    SGS_PROFILE_FUNCTION();
+
+    aTransforms.resize(m_NumDraws);
+    glm::mat4* pTransforms = aTransforms.data();
+    m_Registry.ParallelForEach<sMeshComponent, sTransformComponent>([pTransforms](sEntity, const sMeshComponent& aMesh, const sTransformComponent& aTransform)
+    {
+        pTransforms[aMesh.DrawIndex] = aTransform.World;
+    });
+}
+
+void CScene::GatherVisibleDraws(const sFrustum& aFrustum, std::vector<uint8_t>& aVisibleDraws) const
+{
+    SGS_PROFILE_FUNCTION();
+
+    aVisibleDraws.assign(m_NumDraws, 0);
+    uint8_t* pVisibleDraws = aVisibleDraws.data();
+    m_BVH.QueryFrustum(aFrustum, [this, pVisibleDraws](uint32, sEntity aEntity)
+    {
+        // The leaves are the draws, every entity with bounds has a mesh.
+        const sMeshComponent* pMesh = m_Registry.GetComponent<sMeshComponent>(aEntity);
+        if (pMesh)
+        {
+            pVisibleDraws[pMesh->DrawIndex] = 1;
+        }
+        return true;
+    });
+
+    for (uint32_t DrawIndex : m_SkinnedDraws)
+    {
+        pVisibleDraws[DrawIndex] = 1;
+    }
+}
+
+void CScene::GatherSkinning(std::vector<glm::mat4>& aJointMatrices, std::vector<sSkinningInstance>& aInstances)
+{
+    SGS_PROFILE_FUNCTION();
+
+    aJointMatrices.assign(m_JointMatrices.begin(), m_JointMatrices.end());
+
+    aInstances.clear();
+    m_Registry.ForEach<sAnimatorComponent>([&aInstances](sEntity, const sAnimatorComponent& aAnimator)
+    {
+        sSkinningInstance Instance;
+        Instance.pRenderable = aAnimator.pRenderable;
+        Instance.FirstJoint = aAnimator.FirstJoint;
+        aInstances.push_back(Instance);
+    });
+}
+
+void CScene::AddPointLight(const sPointLight& aLight)
+{
+    m_PointLights.push_back(aLight);
+}
+
+void CScene::AddSpotLight(const sSpotLight& aLight)
+{
+    m_SpotLights.push_back(aLight);
 }
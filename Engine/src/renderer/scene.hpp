@@ -1,6 +1,9 @@
 #pragma once
 
 #include <renderer/core/render_types.hpp>
+#include <renderer/core/bvh.hpp>
+#include <renderer/frame_packet.hpp>
+#include <core/ecs.hpp>
 
 #include <glm/mat4x4.hpp>
 
@@ -39,9 +42,79 @@ struct sRenderObject
     sRenderObjectInfo* pRenderObjectInfo;
 };
 
+/**
+ * @brief Transform of a scene entity. World is computed by the transform system from Local and the World of Parent,
+ * so parents always have a lower Depth than their children.
+ */
+struct sTransformComponent
+{
+    glm::mat4 Local = glm::mat4(1.0f);
+    glm::mat4 World = glm::mat4(1.0f);
+    sEntity Parent;
+    uint32_t Depth = 0;
+};
+
+/**
+ * @brief Axis aligned box around the vertices of the mesh, in local space and, once updated, in world space.
+ */
+struct sBoundsComponent
+{
+    glm::vec3 LocalMin = glm::vec3(0.0f);
+    glm::vec3 LocalMax = glm::vec3(0.0f);
+    glm::vec3 WorldMin = glm::vec3(0.0f);
+    glm::vec3 WorldMax = glm::vec3(0.0f);
+    // Leaf of the entity in the scene BVH.
+    uint32_t BVHProxy = BVH_NULL_NODE;
+};
+
+/**
+ * @brief Submesh drawn by the entity. DrawIndex is the position of the draw in the order the renderables record them,
+ * it indexes sFramePacket::ObjectTransforms.
+ *
+ * The submesh is owned by the storage of the renderable, the component keeps a handle that resolves to nullptr once
+ * it is destroyed instead of a pointer.
+ */
+struct sMeshComponent
+{
+    CRenderable* pRenderable = nullptr;
+    sPoolHandle SubMesh;
+    uint32_t DrawIndex = 0;
+
+    CSubMesh* GetSubMesh() const { return pRenderable ? pRenderable->m_Storage.SubMeshes.Get(SubMesh) : nullptr; }
+};
+
+/**
+ * @brief Material of the submesh, a handle in the material pool (see CMaterial::Get()).
+ */
+struct sMaterialComponent
+{
+    sPoolHandle Material;
+};
+
+/**
+ * @brief Plays the animation clips of a skinned renderable. Clip is played at Time and, while BlendWeight is above zero,
+ * blended towards BlendClip at BlendTime, for transitions and mixes. Both times advance by Speed every update.
+ */
+struct sAnimatorComponent
+{
+    CRenderable* pRenderable = nullptr;
+    uint32_t Clip = 0;
+    float Time = 0.0f;
+    uint32_t BlendClip = 0;
+    float BlendTime = 0.0f;
+    float BlendWeight = 0.0f;
+    float Speed = 1.0f;
+    // First skinning matrix of the renderable in the joint matrices of the scene.
+    uint32_t FirstJoint = 0;
+};
+
 /**
  * @brief Class that represents a rendering scene. It includes all the objects to be renderer and will
  * include all lighting configuration.
+ *
+ * The objects are entities of a CEntityRegistry: every mesh node of a renderable gets an entity with its transform and
+ * every submesh an entity parented to it with the mesh, material and bounds. Skinned renderables also get an animator.
+ * The renderables are kept for the backend, which owns their GPU buffers and draws them.
  */
 class CScene
 {
@@ -49,10 +122,79 @@ public:
     CScene();
     ~CScene();
 
+    /**
+     * @brief Takes ownership of apRenderable and creates the entities of its hierarchy. Must be called before
+     * CRenderable::UploadToVRAM(), the bounds are computed from the vertices.
+     */
     void AddRenderable(CRenderable* const apRenderable);
 
+    /**
+     * @brief Advances the animators, runs the transform and bounds systems and refits the BVH.
+     */
+    void Update(float aDeltaTime);
+
+    /**
+     * @brief Fills aTransforms with the world transform of every draw, indexed by sMeshComponent::DrawIndex.
+     */
+    void GatherDrawTransforms(std::vector<glm::mat4>& aTransforms);
+
+    /**
+     * @brief Fills aVisibleDraws with 1 for every draw whose bounds are inside or intersect aFrustum and 0 for the rest,
+     * indexed by sMeshComponent::DrawIndex. Queries the BVH, so it must be called after Update(). The draws of skinned
+     * renderables are always visible, their bounds are the ones of the rest pose.
+     */
+    void GatherVisibleDraws(const sFrustum& aFrustum, std::vector<uint8_t>& aVisibleDraws) const;
+
+    /**
+     * @brief Fills aJointMatrices with the skinning matrices of every animator and aInstances with where each renderable
+     * finds its own.
+     */
+    void GatherSkinning(std::vector<glm::mat4>& aJointMatrices, std::vector<sSkinningInstance>& aInstances);
+
+    /**
+     * @brief Adds a light to the scene. Lights can be modified at any time through GetPointLights()/GetSpotLights(),
+     * they are uploaded every frame.
+     */
+    void AddPointLight(const sPointLight& aLight);
+    void AddSpotLight(const sSpotLight& aLight);
+    void SetDirectionalLight(const sDirectionalLight& aLight) { m_DirectionalLight = aLight; }
+
+    CEntityRegistry& GetRegistry() { return m_Registry; }
+
+    /**
+     * @brief Spatial index of the world bounds of the entities, for culling and gameplay queries. Up to date after Update().
+     */
+    const CBVH& GetBVH() const { return m_BVH; }
+    uint32_t GetNumDraws() const { return m_NumDraws; }
+
     const std::vector<CRenderable*>& GetRenderObjects() { return m_Renderables; }
+    std::vector<sPointLight>& GetPointLights() { return m_PointLights; }
+    const std::vector<sPointLight>& GetPointLights() const { return m_PointLights; }
+    std::vector<sSpotLight>& GetSpotLights() { return m_SpotLights; }
+    const std::vector<sSpotLight>& GetSpotLights() const { return m_SpotLights; }
+    const sDirectionalLight& GetDirectionalLight() const { return m_DirectionalLight; }
 
 private:
+    void CreateNodeEntities(CRenderable* apRenderable, CMeshNode* apMeshNode, sEntity aParent, uint32_t aDepth);
+
+    void UpdateAnimations(float aDeltaTime);
+    void UpdateTransforms();
+    void UpdateBounds();
+    void UpdateBVH();
+
+    CEntityRegistry m_Registry;
+    CBVH m_BVH;
+    uint32_t m_NumDraws;
+    uint32_t m_MaxDepth;
+
+    // Draws of the skinned renderables, never culled.
+    std::vector<uint32_t> m_SkinnedDraws;
+
+    // Skinning matrices of the animators, each owns a range starting at its FirstJoint.
+    std::vector<glm::mat4> m_JointMatrices;
+
     std::vector<CRenderable*> m_Renderables;
+    std::vector<sPointLight> m_PointLights;
+    std::vector<sSpotLight> m_SpotLights;
+    sDirectionalLight m_DirectionalLight;
 };
\ No newline at end of file